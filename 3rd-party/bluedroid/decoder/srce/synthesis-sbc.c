@@ -248,6 +248,14 @@ typedef void (*SYNTH_FRAME)(OI_CODEC_SBC_DECODER_CONTEXT *context, OI_INT16 *pcm
 #define DCT2_8(dst, src) dct2_8(dst, src)
 #endif
 
+/* BK4BTSTACK_CHANGE START */
+/* SSE2 windowing of four blocks at once, used by default if the compiler targets SSE2 (e.g. x86-64),
+ * define DISABLE_SBC_SSE2 to use the C implementation. Not used if the platform provides its own SYNTH80 */
+#if defined(__SSE2__) && !defined(DISABLE_SBC_SSE2) && !defined(SYNTH80)
+#define SBC_SYNTH_SSE2
+#endif
+/* BK4BTSTACK_CHANGE END */
+
 #ifndef SYNTH80
 #define SYNTH80 SynthWindow80_generated
 #endif
@@ -256,6 +264,170 @@ typedef void (*SYNTH_FRAME)(OI_CODEC_SBC_DECODER_CONTEXT *context, OI_INT16 *pcm
 #define SYNTH112 SynthWindow112_generated
 #endif
 
+/* BK4BTSTACK_CHANGE START */
+#ifdef SBC_SYNTH_SSE2
+#include <emmintrin.h>
+
+/* Number of blocks windowed at once, one per 32 bit lane */
+#define SYNTH_SSE2_BLOCKS 4
+
+/* Coefficient split into two 16 bit halves, which are multiplied with the same sample and summed by pmaddwd.
+ * This allows for coefficients larger than 16 bit as used by dec_window_4 */
+#define SYNTH_SSE2_COEFFICIENT(_c) ((int)(((OI_UINT32)((_c) - (_c) / 2) << 16) | ((OI_UINT32)((_c) / 2) & 0xffff)))
+
+/* sum += (coefficient * buffer[index]) shifted left (shift > 0) or right (shift < 0), for all blocks */
+#define SYNTH_SSE2_ADD(_sum, _index, _c, _shift) do { \
+    __m128i _product = _mm_madd_epi16(samples[_index], _mm_set1_epi32(SYNTH_SSE2_COEFFICIENT(_c))); \
+    _product = (_shift) > 0 ? _mm_slli_epi32(_product, (_shift) > 0 ? (_shift) : 0) : _mm_srai_epi32(_product, (_shift) < 0 ? -(_shift) : 0); \
+    _sum = _mm_add_epi32(_sum, _product); \
+} while (0)
+
+/* sum / 32768, rounding towards zero, as in SynthWindow80_generated */
+#define SYNTH_SSE2_STORE_80(_i) SynthStore_4Blocks_SSE2(pcm, _mm_srai_epi32(_mm_add_epi32(sum, _mm_and_si128(_mm_srai_epi32(sum, 31), _mm_set1_epi32(32767))), 15), _i, 8, strideShift)
+
+/* SCALE(-sum, 15), as in SynthWindow40_int32_int32_symmetry_with_sum */
+#define SYNTH_SSE2_STORE_40(_i) SynthStore_4Blocks_SSE2(pcm, _mm_srai_epi32(_mm_sub_epi32(_mm_set1_epi32(1 << 14), sum), 15), _i, 4, strideShift)
+
+PRIVATE void SynthWindow80_4Blocks_SSE2(OI_INT16 *pcm, SBC_BUFFER_T const *buffer, OI_UINT strideShift);
+PRIVATE void SynthWindow40_4Blocks_SSE2(OI_INT16 *pcm, SBC_BUFFER_T const *buffer, OI_UINT strideShift);
+
+/* samples[i] holds buffer[i] of each block, duplicated in both 16 bit halves of the 32 bit lane.
+ * The filter buffer of block n starts at buffer + 8 * (3 - n) */
+static void SynthTranspose_4Blocks_SSE2(__m128i samples[80], SBC_BUFFER_T const *buffer)
+{
+    OI_UINT i;
+    for (i = 0; i < 80; i += 8) {
+        __m128i b0 = _mm_loadu_si128((const __m128i *) &buffer[24 + i]);
+        __m128i b1 = _mm_loadu_si128((const __m128i *) &buffer[16 + i]);
+        __m128i b2 = _mm_loadu_si128((const __m128i *) &buffer[ 8 + i]);
+        __m128i b3 = _mm_loadu_si128((const __m128i *) &buffer[     i]);
+        __m128i t0 = _mm_unpacklo_epi16(b0, b1);
+        __m128i t1 = _mm_unpacklo_epi16(b2, b3);
+        __m128i t2 = _mm_unpackhi_epi16(b0, b1);
+        __m128i t3 = _mm_unpackhi_epi16(b2, b3);
+        __m128i u0 = _mm_unpacklo_epi32(t0, t1);
+        __m128i u1 = _mm_unpackhi_epi32(t0, t1);
+        __m128i u2 = _mm_unpacklo_epi32(t2, t3);
+        __m128i u3 = _mm_unpackhi_epi32(t2, t3);
+        samples[i + 0] = _mm_unpacklo_epi16(u0, u0);
+        samples[i + 1] = _mm_unpackhi_epi16(u0, u0);
+        samples[i + 2] = _mm_unpacklo_epi16(u1, u1);
+        samples[i + 3] = _mm_unpackhi_epi16(u1, u1);
+        samples[i + 4] = _mm_unpacklo_epi16(u2, u2);
+        samples[i + 5] = _mm_unpackhi_epi16(u2, u2);
+        samples[i + 6] = _mm_unpacklo_epi16(u3, u3);
+        samples[i + 7] = _mm_unpackhi_epi16(u3, u3);
+    }
+}
+
+/* CLIP_INT16 by saturation, output sample i of each block */
+static void SynthStore_4Blocks_SSE2(OI_INT16 *pcm, __m128i sum, OI_UINT i, OI_UINT nrof_subbands, OI_UINT strideShift)
+{
+    __m128i pcm4 = _mm_packs_epi32(sum, sum);
+    pcm[(0 * nrof_subbands + i) << strideShift] = (OI_INT16) _mm_extract_epi16(pcm4, 0);
+    pcm[(1 * nrof_subbands + i) << strideShift] = (OI_INT16) _mm_extract_epi16(pcm4, 1);
+    pcm[(2 * nrof_subbands + i) << strideShift] = (OI_INT16) _mm_extract_epi16(pcm4, 2);
+    pcm[(3 * nrof_subbands + i) << strideShift] = (OI_INT16) _mm_extract_epi16(pcm4, 3);
+}
+
+/**
+ * SynthWindow80_generated for four consecutive blocks, each 32 bit lane computes the same sum for one block.
+ * The DCT output of all four blocks has to be in the filter buffer already.
+ *
+ * @param pcm            output of first block, the other blocks follow
+ * @param buffer         filter buffer of last block
+ * @param strideShift    1 for interleaved stereo output
+ */
+PRIVATE void SynthWindow80_4Blocks_SSE2(OI_INT16 *pcm, SBC_BUFFER_T const *buffer, OI_UINT strideShift)
+{
+    __m128i samples[80];
+    __m128i sum;
+
+    SynthTranspose_4Blocks_SSE2(samples, buffer);
+
+    sum = _mm_setzero_si128();
+    SYNTH_SSE2_ADD(sum, 12,   8235, -3); SYNTH_SSE2_ADD(sum, 20, -23167, -3); SYNTH_SSE2_ADD(sum, 28,  26479, -2);
+    SYNTH_SSE2_ADD(sum, 36, -17397,  1); SYNTH_SSE2_ADD(sum, 44,   9399,  3); SYNTH_SSE2_ADD(sum, 52,  17397,  1);
+    SYNTH_SSE2_ADD(sum, 60,  26479, -2); SYNTH_SSE2_ADD(sum, 68,  23167, -3); SYNTH_SSE2_ADD(sum, 76,   8235, -3);
+    SYNTH_SSE2_STORE_80(0);
+    sum = _mm_setzero_si128();
+    SYNTH_SSE2_ADD(sum,  5,  -3263, -5); SYNTH_SSE2_ADD(sum, 11,  29293, -5); SYNTH_SSE2_ADD(sum, 21,  -5229,  0);
+    SYNTH_SSE2_ADD(sum, 27,  30835, -3); SYNTH_SSE2_ADD(sum, 37, -27021,  1); SYNTH_SSE2_ADD(sum, 43,  31633,  1);
+    SYNTH_SSE2_ADD(sum, 53,  17319,  1); SYNTH_SSE2_ADD(sum, 59,  26663, -2); SYNTH_SSE2_ADD(sum, 69,   4555, -1);
+    SYNTH_SSE2_ADD(sum, 75,  12419, -4);
+    SYNTH_SSE2_STORE_80(1);
+    sum = _mm_setzero_si128();
+    SYNTH_SSE2_ADD(sum,  6, -10385, -6); SYNTH_SSE2_ADD(sum, 10,  24995, -5); SYNTH_SSE2_ADD(sum, 22,   -309,  4);
+    SYNTH_SSE2_ADD(sum, 26,   9161, -3); SYNTH_SSE2_ADD(sum, 38, -23063,  1); SYNTH_SSE2_ADD(sum, 42,  27561,  1);
+    SYNTH_SSE2_ADD(sum, 54,   2309,  3); SYNTH_SSE2_ADD(sum, 58,  12705, -1); SYNTH_SSE2_ADD(sum, 70,   6239, -3);
+    SYNTH_SSE2_ADD(sum, 74,   9251, -4);
+    SYNTH_SSE2_STORE_80(2);
+    sum = _mm_setzero_si128();
+    SYNTH_SSE2_ADD(sum,  7, -16457, -6); SYNTH_SSE2_ADD(sum,  9,  19083, -5); SYNTH_SSE2_ADD(sum, 23, -23641, -2);
+    SYNTH_SSE2_ADD(sum, 25, -29015, -4); SYNTH_SSE2_ADD(sum, 39, -12889,  2); SYNTH_SSE2_ADD(sum, 41,   6145,  3);
+    SYNTH_SSE2_ADD(sum, 55,  24211, -1); SYNTH_SSE2_ADD(sum, 57,  23469, -2); SYNTH_SSE2_ADD(sum, 71,  21223, -8);
+    SYNTH_SSE2_ADD(sum, 73,  26913, -6);
+    SYNTH_SSE2_STORE_80(3);
+    sum = _mm_setzero_si128();
+    SYNTH_SSE2_ADD(sum,  8,  10445, -4); SYNTH_SSE2_ADD(sum, 24,  -5297,  1); SYNTH_SSE2_ADD(sum, 40,  22299,  2);
+    SYNTH_SSE2_ADD(sum, 56,  10603,  0); SYNTH_SSE2_ADD(sum, 72,   9539, -4);
+    SYNTH_SSE2_STORE_80(4);
+    sum = _mm_setzero_si128();
+    SYNTH_SSE2_ADD(sum,  7,  16913, -5); SYNTH_SSE2_ADD(sum,  9,  -8443, -7); SYNTH_SSE2_ADD(sum, 23,   3687,  1);
+    SYNTH_SSE2_ADD(sum, 25,   -301,  5); SYNTH_SSE2_ADD(sum, 39,  15447,  2); SYNTH_SSE2_ADD(sum, 41,  10255,  2);
+    SYNTH_SSE2_ADD(sum, 55, -18233, -3); SYNTH_SSE2_ADD(sum, 57,   9405, -1); SYNTH_SSE2_ADD(sum, 71,   1499, -1);
+    SYNTH_SSE2_ADD(sum, 73,  26189, -7);
+    SYNTH_SSE2_STORE_80(5);
+    sum = _mm_setzero_si128();
+    SYNTH_SSE2_ADD(sum,  6,  11167, -4); SYNTH_SSE2_ADD(sum, 10, -10337, -4); SYNTH_SSE2_ADD(sum, 22,   1917,  2);
+    SYNTH_SSE2_ADD(sum, 26, -30605, -1); SYNTH_SSE2_ADD(sum, 38,   8317,  3); SYNTH_SSE2_ADD(sum, 42,   9553,  2);
+    SYNTH_SSE2_ADD(sum, 54,  22117, -4); SYNTH_SSE2_ADD(sum, 58,  16383, -2); SYNTH_SSE2_ADD(sum, 70,   7543, -3);
+    SYNTH_SSE2_ADD(sum, 74,   8603, -6);
+    SYNTH_SSE2_STORE_80(6);
+    sum = _mm_setzero_si128();
+    SYNTH_SSE2_ADD(sum,  5,   9293, -3); SYNTH_SSE2_ADD(sum, 11,  -6087, -2); SYNTH_SSE2_ADD(sum, 21,   1247,  3);
+    SYNTH_SSE2_ADD(sum, 27,  -2893,  3); SYNTH_SSE2_ADD(sum, 37,  23671,  2); SYNTH_SSE2_ADD(sum, 43,  18055,  1);
+    SYNTH_SSE2_ADD(sum, 53,  11537, -1); SYNTH_SSE2_ADD(sum, 59,   1747,  1); SYNTH_SSE2_ADD(sum, 69,    685,  1);
+    SYNTH_SSE2_ADD(sum, 75,   8721, -7);
+    SYNTH_SSE2_STORE_80(7);
+}
+
+/**
+ * SynthWindow40_int32_int32_symmetry_with_sum for four consecutive blocks, see SynthWindow80_4Blocks_SSE2.
+ * Coefficients from dec_window_4, buffer[2 + 8 * n] is always zero
+ */
+PRIVATE void SynthWindow40_4Blocks_SSE2(OI_INT16 *pcm, SBC_BUFFER_T const *buffer, OI_UINT strideShift)
+{
+    __m128i samples[80];
+    __m128i sum;
+
+    SynthTranspose_4Blocks_SSE2(samples, buffer);
+
+    sum = _mm_setzero_si128();
+    SYNTH_SSE2_ADD(sum, 12,    694,  0); SYNTH_SSE2_ADD(sum, 76,    694,  0); SYNTH_SSE2_ADD(sum, 16,   1974,  0);
+    SYNTH_SSE2_ADD(sum, 64,  -1974,  0); SYNTH_SSE2_ADD(sum, 28,   4681,  0); SYNTH_SSE2_ADD(sum, 60,   4681,  0);
+    SYNTH_SSE2_ADD(sum, 32,  24529,  0); SYNTH_SSE2_ADD(sum, 48, -24529,  0); SYNTH_SSE2_ADD(sum, 44,  53243,  0);
+    SYNTH_SSE2_STORE_40(0);
+    sum = _mm_setzero_si128();
+    SYNTH_SSE2_ADD(sum,  1,     97,  0); SYNTH_SSE2_ADD(sum, 77,    495,  0); SYNTH_SSE2_ADD(sum, 13,    704,  0);
+    SYNTH_SSE2_ADD(sum, 65,   -554,  0); SYNTH_SSE2_ADD(sum, 17,   3697,  0); SYNTH_SSE2_ADD(sum, 61,   5824,  0);
+    SYNTH_SSE2_ADD(sum, 29,   1109,  0); SYNTH_SSE2_ADD(sum, 49, -14047,  0); SYNTH_SSE2_ADD(sum, 33,  35274,  0);
+    SYNTH_SSE2_ADD(sum, 45,  50984,  0);
+    SYNTH_SSE2_STORE_40(1);
+    sum = _mm_setzero_si128();
+    SYNTH_SSE2_ADD(sum, 78,    270,  0); SYNTH_SSE2_ADD(sum, 14,    338,  0); SYNTH_SSE2_ADD(sum, 62,   5224,  0);
+    SYNTH_SSE2_ADD(sum, 30,  -5214,  0); SYNTH_SSE2_ADD(sum, 46,  44618,  0);
+    SYNTH_SSE2_STORE_40(2);
+    sum = _mm_setzero_si128();
+    SYNTH_SSE2_ADD(sum, 79,     97,  0); SYNTH_SSE2_ADD(sum,  3,    495,  0); SYNTH_SSE2_ADD(sum, 67,    704,  0);
+    SYNTH_SSE2_ADD(sum, 15,   -554,  0); SYNTH_SSE2_ADD(sum, 63,   3697,  0); SYNTH_SSE2_ADD(sum, 19,   5824,  0);
+    SYNTH_SSE2_ADD(sum, 51,   1109,  0); SYNTH_SSE2_ADD(sum, 31, -14047,  0); SYNTH_SSE2_ADD(sum, 47,  35274,  0);
+    SYNTH_SSE2_ADD(sum, 35,  50984,  0);
+    SYNTH_SSE2_STORE_40(3);
+}
+#endif
+/* BK4BTSTACK_CHANGE END */
+
 PRIVATE void OI_SBC_SynthFrame_80(OI_CODEC_SBC_DECODER_CONTEXT *context, OI_INT16 *pcm, OI_UINT blkstart, OI_UINT blkcount);
 PRIVATE void OI_SBC_SynthFrame_80(OI_CODEC_SBC_DECODER_CONTEXT *context, OI_INT16 *pcm, OI_UINT blkstart, OI_UINT blkcount)
 {
@@ -268,6 +440,25 @@ PRIVATE void OI_SBC_SynthFrame_80(OI_CODEC_SBC_DECODER_CONTEXT *context, OI_INT1
     OI_UINT blkstop = blkstart + blkcount;
 
     for (blk = blkstart; blk < blkstop; blk++) {
+        /* BK4BTSTACK_CHANGE START */
+#ifdef SBC_SYNTH_SSE2
+        if ((blkstop - blk >= SYNTH_SSE2_BLOCKS) && (offset >= 8 * SYNTH_SSE2_BLOCKS)) {
+            /* filter buffer does not wrap around within the next four blocks */
+            OI_UINT i;
+            for (ch = 0; ch < nrof_channels; ch++) {
+                for (i = 0; i < SYNTH_SSE2_BLOCKS; i++) {
+                    DCT2_8(context->common.filterBuffer[ch] + offset - 8 * (i + 1), s + 8 * (nrof_channels * i + ch));
+                }
+                SynthWindow80_4Blocks_SSE2(pcm + ch, context->common.filterBuffer[ch] + offset - 8 * SYNTH_SSE2_BLOCKS, pcmStrideShift);
+            }
+            offset -= 8 * SYNTH_SSE2_BLOCKS;
+            s += 8 * nrof_channels * SYNTH_SSE2_BLOCKS;
+            pcm += (8 * SYNTH_SSE2_BLOCKS) << pcmStrideShift;
+            blk += SYNTH_SSE2_BLOCKS - 1;
+            continue;
+        }
+#endif
+        /* BK4BTSTACK_CHANGE END */
         if (offset == 0) {
             COPY_BACKWARD_32BIT_ALIGNED_72_HALFWORDS(context->common.filterBuffer[0] + context->common.filterBufferLen - 72, context->common.filterBuffer[0]);
             if (nrof_channels == 2) {
@@ -300,6 +491,25 @@ PRIVATE void OI_SBC_SynthFrame_4SB(OI_CODEC_SBC_DECODER_CONTEXT *context, OI_INT
     OI_UINT blkstop = blkstart + blkcount;
 
     for (blk = blkstart; blk < blkstop; blk++) {
+        /* BK4BTSTACK_CHANGE START */
+#ifdef SBC_SYNTH_SSE2
+        if ((blkstop - blk >= SYNTH_SSE2_BLOCKS) && (offset >= 8 * SYNTH_SSE2_BLOCKS)) {
+            /* filter buffer does not wrap around within the next four blocks */
+            OI_UINT i;
+            for (ch = 0; ch < nrof_channels; ch++) {
+                for (i = 0; i < SYNTH_SSE2_BLOCKS; i++) {
+                    cosineModulateSynth4(context->common.filterBuffer[ch] + offset - 8 * (i + 1), s + 4 * (nrof_channels * i + ch));
+                }
+                SynthWindow40_4Blocks_SSE2(pcm + ch, context->common.filterBuffer[ch] + offset - 8 * SYNTH_SSE2_BLOCKS, pcmStrideShift);
+            }
+            offset -= 8 * SYNTH_SSE2_BLOCKS;
+            s += 4 * nrof_channels * SYNTH_SSE2_BLOCKS;
+            pcm += (4 * SYNTH_SSE2_BLOCKS) << pcmStrideShift;
+            blk += SYNTH_SSE2_BLOCKS - 1;
+            continue;
+        }
+#endif
+        /* BK4BTSTACK_CHANGE END */
         if (offset == 0) {
             COPY_BACKWARD_32BIT_ALIGNED_72_HALFWORDS(context->common.filterBuffer[0] + context->common.filterBufferLen - 72,context->common.filterBuffer[0]);
             if (nrof_channels == 2) {
@@ -113,6 +113,22 @@
 #define SBC_IS_64_MULT_IN_WINDOW_ACCU  FALSE
 #endif /*SBC_IS_64_MULT_IN_WINDOW_ACCU */
 
+/* BK4BTSTACK_CHANGE START */
+/* Set SBC_SSE2_OPT to TRUE to compute the windowing with SSE2, same result as the SBC_IPAQ_OPT 32 bit windowing */
+/* -> used by default if the compiler targets SSE2 (e.g. x86-64), define DISABLE_SBC_SSE2 to use the C implementation */
+#ifndef SBC_SSE2_OPT
+#if defined(__SSE2__) && !defined(DISABLE_SBC_SSE2) && (SBC_ARM_ASM_OPT == FALSE) && (SBC_IPAQ_OPT == TRUE) && (SBC_IS_64_MULT_IN_WINDOW_ACCU == FALSE)
+#define SBC_SSE2_OPT TRUE
+#else
+#define SBC_SSE2_OPT FALSE
+#endif
+#endif /*SBC_SSE2_OPT */
+
+#if (SBC_SSE2_OPT == TRUE) && ((SBC_ARM_ASM_OPT == TRUE) || (SBC_IPAQ_OPT == FALSE) || (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE))
+#error "SBC_SSE2_OPT requires SBC_IPAQ_OPT without SBC_ARM_ASM_OPT and SBC_IS_64_MULT_IN_WINDOW_ACCU"
+#endif
+/* BK4BTSTACK_CHANGE END */
+
 /* Set SBC_IS_64_MULT_IN_IDCT to TRUE to use 64 bits multiplication in the DCT of Matrixing */
 /* -> more MIPS required for a better audio quality. comparasion with the SIG utilities shows a division by 10 of the RMS */
 /* CAUTION: It only apply in the if SBC_FAST_DCT is set to TRUE */
@@ -196,6 +212,10 @@ typedef struct SBC_ENC_PARAMS_TAG
     UINT16 u16PacketLength;
     /* BK4BTSTACK_CHANGE START */
     UINT8  mSBCEnabled;
+    /* analysis filter state per encoder instance instead of globals */
+    SINT32 s32X[ENC_VX_BUFFER_SIZE/2];              /* s16X must be 32 bits aligned cf SHIFTUP_X8_2 */
+    SINT16 s16ShiftCounter;
+    SINT16 s16EncMaxShiftCounter;
     /* BK4BTSTACK_CHANGE END */
 }SBC_ENC_PARAMS;
 
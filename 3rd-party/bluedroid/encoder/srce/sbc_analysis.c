@@ -153,15 +153,9 @@
 #define WIND_8_SUBBANDS_8_2 (SINT16)0x12CF  /* 40 = 0x12CF6C75 */
 #endif
 
-#if (SBC_USE_ARM_PRAGMA==TRUE)
-#pragma arm section zidata = "sbc_s32_analysis_section"
-#endif
-static SINT32   s32DCTY[16]  = {0};
-static SINT32   s32X[ENC_VX_BUFFER_SIZE/2];
-static SINT16   *s16X=(SINT16*) s32X;      /* s16X must be 32 bits aligned cf  SHIFTUP_X8_2*/
-#if (SBC_USE_ARM_PRAGMA==TRUE)
-#pragma arm section zidata
-#endif
+/* BK4BTSTACK_CHANGE START */
+/* s32DCTY is local to the analysis filter, s32X and ShiftCounter are stored in SBC_ENC_PARAMS */
+/* BK4BTSTACK_CHANGE END */
 
 /* This macro is for 4 subbands */
 #define SHIFTUP_X4                                                               \
@@ -897,8 +891,70 @@ static SINT16   *s16X=(SINT16*) s32X;      /* s16X must be 32 bits aligned cf  S
 #endif
 #endif
 
-static SINT16 ShiftCounter=0;
-extern SINT16 EncMaxShiftCounter;
+/* BK4BTSTACK_CHANGE START */
+#if (SBC_SSE2_OPT == TRUE)
+#include <emmintrin.h>
+
+/* Coefficients of the SBC_IPAQ_OPT windowing per tap: s32DCTY[k] = sum over j of coeff[j][k] * s16X[ChOffset+k+j*2*SubBands] */
+static const SINT16 gas16WindowFor4SBs[5][8] = {
+    {                   0, WIND_4_SUBBANDS_1_0, WIND_4_SUBBANDS_2_0, WIND_4_SUBBANDS_3_0, WIND_4_SUBBANDS_4_0, WIND_4_SUBBANDS_3_4, WIND_4_SUBBANDS_2_4, WIND_4_SUBBANDS_1_4 },
+    { WIND_4_SUBBANDS_0_1, WIND_4_SUBBANDS_1_1, WIND_4_SUBBANDS_2_1, WIND_4_SUBBANDS_3_1, WIND_4_SUBBANDS_4_1, WIND_4_SUBBANDS_3_3, WIND_4_SUBBANDS_2_3, WIND_4_SUBBANDS_1_3 },
+    { WIND_4_SUBBANDS_0_2, WIND_4_SUBBANDS_1_2, WIND_4_SUBBANDS_2_2, WIND_4_SUBBANDS_3_2, WIND_4_SUBBANDS_4_2, WIND_4_SUBBANDS_3_2, WIND_4_SUBBANDS_2_2, WIND_4_SUBBANDS_1_2 },
+    {-WIND_4_SUBBANDS_0_2, WIND_4_SUBBANDS_1_3, WIND_4_SUBBANDS_2_3, WIND_4_SUBBANDS_3_3, WIND_4_SUBBANDS_4_1, WIND_4_SUBBANDS_3_1, WIND_4_SUBBANDS_2_1, WIND_4_SUBBANDS_1_1 },
+    {-WIND_4_SUBBANDS_0_1, WIND_4_SUBBANDS_1_4, WIND_4_SUBBANDS_2_4, WIND_4_SUBBANDS_3_4, WIND_4_SUBBANDS_4_0, WIND_4_SUBBANDS_3_0, WIND_4_SUBBANDS_2_0, WIND_4_SUBBANDS_1_0 },
+};
+
+static const SINT16 gas16WindowFor8SBs[5][16] = {
+    {                   0, WIND_8_SUBBANDS_1_0, WIND_8_SUBBANDS_2_0, WIND_8_SUBBANDS_3_0, WIND_8_SUBBANDS_4_0, WIND_8_SUBBANDS_5_0, WIND_8_SUBBANDS_6_0, WIND_8_SUBBANDS_7_0,
+      WIND_8_SUBBANDS_8_0, WIND_8_SUBBANDS_7_4, WIND_8_SUBBANDS_6_4, WIND_8_SUBBANDS_5_4, WIND_8_SUBBANDS_4_4, WIND_8_SUBBANDS_3_4, WIND_8_SUBBANDS_2_4, WIND_8_SUBBANDS_1_4 },
+    { WIND_8_SUBBANDS_0_1, WIND_8_SUBBANDS_1_1, WIND_8_SUBBANDS_2_1, WIND_8_SUBBANDS_3_1, WIND_8_SUBBANDS_4_1, WIND_8_SUBBANDS_5_1, WIND_8_SUBBANDS_6_1, WIND_8_SUBBANDS_7_1,
+      WIND_8_SUBBANDS_8_1, WIND_8_SUBBANDS_7_3, WIND_8_SUBBANDS_6_3, WIND_8_SUBBANDS_5_3, WIND_8_SUBBANDS_4_3, WIND_8_SUBBANDS_3_3, WIND_8_SUBBANDS_2_3, WIND_8_SUBBANDS_1_3 },
+    { WIND_8_SUBBANDS_0_2, WIND_8_SUBBANDS_1_2, WIND_8_SUBBANDS_2_2, WIND_8_SUBBANDS_3_2, WIND_8_SUBBANDS_4_2, WIND_8_SUBBANDS_5_2, WIND_8_SUBBANDS_6_2, WIND_8_SUBBANDS_7_2,
+      WIND_8_SUBBANDS_8_2, WIND_8_SUBBANDS_7_2, WIND_8_SUBBANDS_6_2, WIND_8_SUBBANDS_5_2, WIND_8_SUBBANDS_4_2, WIND_8_SUBBANDS_3_2, WIND_8_SUBBANDS_2_2, WIND_8_SUBBANDS_1_2 },
+    {-WIND_8_SUBBANDS_0_2, WIND_8_SUBBANDS_1_3, WIND_8_SUBBANDS_2_3, WIND_8_SUBBANDS_3_3, WIND_8_SUBBANDS_4_3, WIND_8_SUBBANDS_5_3, WIND_8_SUBBANDS_6_3, WIND_8_SUBBANDS_7_3,
+      WIND_8_SUBBANDS_8_1, WIND_8_SUBBANDS_7_1, WIND_8_SUBBANDS_6_1, WIND_8_SUBBANDS_5_1, WIND_8_SUBBANDS_4_1, WIND_8_SUBBANDS_3_1, WIND_8_SUBBANDS_2_1, WIND_8_SUBBANDS_1_1 },
+    {-WIND_8_SUBBANDS_0_1, WIND_8_SUBBANDS_1_4, WIND_8_SUBBANDS_2_4, WIND_8_SUBBANDS_3_4, WIND_8_SUBBANDS_4_4, WIND_8_SUBBANDS_5_4, WIND_8_SUBBANDS_6_4, WIND_8_SUBBANDS_7_4,
+      WIND_8_SUBBANDS_8_0, WIND_8_SUBBANDS_7_0, WIND_8_SUBBANDS_6_0, WIND_8_SUBBANDS_5_0, WIND_8_SUBBANDS_4_0, WIND_8_SUBBANDS_3_0, WIND_8_SUBBANDS_2_0, WIND_8_SUBBANDS_1_0 },
+};
+
+/* 8 outputs per iteration, pmaddwd sums the products of two taps, 16x16 bit products and 32 bit sums as in WINDOW_ACCU */
+static void SbcWindowSse2(SINT32 *ps32DCTY, const SINT16 *ps16X, const SINT16 *ps16Coeff, SINT32 s32NumOfOutputs)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i x0, x1, x2, x3, x4, c0, c1, c2, c3, c4, lo, hi;
+    SINT32 k;
+    for (k = 0; k < s32NumOfOutputs; k += 8)
+    {
+        x0 = _mm_loadu_si128((const __m128i *) &ps16X[k]);
+        x1 = _mm_loadu_si128((const __m128i *) &ps16X[k + s32NumOfOutputs]);
+        x2 = _mm_loadu_si128((const __m128i *) &ps16X[k + s32NumOfOutputs * 2]);
+        x3 = _mm_loadu_si128((const __m128i *) &ps16X[k + s32NumOfOutputs * 3]);
+        x4 = _mm_loadu_si128((const __m128i *) &ps16X[k + s32NumOfOutputs * 4]);
+        c0 = _mm_loadu_si128((const __m128i *) &ps16Coeff[k]);
+        c1 = _mm_loadu_si128((const __m128i *) &ps16Coeff[k + s32NumOfOutputs]);
+        c2 = _mm_loadu_si128((const __m128i *) &ps16Coeff[k + s32NumOfOutputs * 2]);
+        c3 = _mm_loadu_si128((const __m128i *) &ps16Coeff[k + s32NumOfOutputs * 3]);
+        c4 = _mm_loadu_si128((const __m128i *) &ps16Coeff[k + s32NumOfOutputs * 4]);
+
+        lo = _mm_madd_epi16(_mm_unpacklo_epi16(x0, x1), _mm_unpacklo_epi16(c0, c1));
+        lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(x2, x3), _mm_unpacklo_epi16(c2, c3)));
+        lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(x4, zero), _mm_unpacklo_epi16(c4, zero)));
+        hi = _mm_madd_epi16(_mm_unpackhi_epi16(x0, x1), _mm_unpackhi_epi16(c0, c1));
+        hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(x2, x3), _mm_unpackhi_epi16(c2, c3)));
+        hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(x4, zero), _mm_unpackhi_epi16(c4, zero)));
+
+        _mm_storeu_si128((__m128i *) &ps32DCTY[k], lo);
+        _mm_storeu_si128((__m128i *) &ps32DCTY[k + 4], hi);
+    }
+}
+
+#undef WINDOW_PARTIAL_4
+#undef WINDOW_PARTIAL_8
+#define WINDOW_PARTIAL_4 SbcWindowSse2(s32DCTY, &s16X[ChOffset], &gas16WindowFor4SBs[0][0], SUB_BANDS_4 * 2);
+#define WINDOW_PARTIAL_8 SbcWindowSse2(s32DCTY, &s16X[ChOffset], &gas16WindowFor8SBs[0][0], SUB_BANDS_8 * 2);
+#endif
+/* BK4BTSTACK_CHANGE END */
+
 /****************************************************************************
 * SbcAnalysisFilter - performs Analysis of the input audio stream
 *
@@ -919,7 +975,11 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS *pstrEncParams)
 #if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
     register SINT64 s64Temp,s64Temp2;
 #else
+    /* BK4BTSTACK_CHANGE START */
+#if (SBC_SSE2_OPT == FALSE)
 	register SINT32 s32Temp,s32Temp2;
+#endif
+    /* BK4BTSTACK_CHANGE END */
 #endif
 #else
 
@@ -930,6 +990,13 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS *pstrEncParams)
 #endif
 #endif
 
+    /* BK4BTSTACK_CHANGE START */
+    SINT32  s32DCTY[16];
+    SINT16 *s16X = (SINT16*) pstrEncParams->s32X;
+    SINT16  ShiftCounter = pstrEncParams->s16ShiftCounter;
+    SINT16  EncMaxShiftCounter = pstrEncParams->s16EncMaxShiftCounter;
+    /* BK4BTSTACK_CHANGE END */
+
     s32NumOfChannels = pstrEncParams->s16NumOfChannels;
     s32NumOfBlocks   = pstrEncParams->s16NumOfBlocks;
 
@@ -995,6 +1062,9 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS *pstrEncParams)
             }
         }
     }
+    /* BK4BTSTACK_CHANGE START */
+    pstrEncParams->s16ShiftCounter = ShiftCounter;
+    /* BK4BTSTACK_CHANGE END */
 }
 
 /* //////////////////////////////////////////////////////////////////////////////////////////////////////////////////// */
@@ -1014,7 +1084,11 @@ void SbcAnalysisFilter8 (SBC_ENC_PARAMS *pstrEncParams)
 #if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
     register SINT64 s64Temp,s64Temp2;
 #else
+    /* BK4BTSTACK_CHANGE START */
+#if (SBC_SSE2_OPT == FALSE)
 	register SINT32 s32Temp,s32Temp2;
+#endif
+    /* BK4BTSTACK_CHANGE END */
 #endif
 #else
 #if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
@@ -1022,6 +1096,12 @@ void SbcAnalysisFilter8 (SBC_ENC_PARAMS *pstrEncParams)
 #endif
 #endif
 #endif
+    /* BK4BTSTACK_CHANGE START */
+    SINT32  s32DCTY[16];
+    SINT16 *s16X = (SINT16*) pstrEncParams->s32X;
+    SINT16  ShiftCounter = pstrEncParams->s16ShiftCounter;
+    SINT16  EncMaxShiftCounter = pstrEncParams->s16EncMaxShiftCounter;
+    /* BK4BTSTACK_CHANGE END */
 
     s32NumOfChannels = pstrEncParams->s16NumOfChannels;
     s32NumOfBlocks   = pstrEncParams->s16NumOfBlocks;
@@ -1099,10 +1179,15 @@ void SbcAnalysisFilter8 (SBC_ENC_PARAMS *pstrEncParams)
             }
         }
     }
+    /* BK4BTSTACK_CHANGE START */
+    pstrEncParams->s16ShiftCounter = ShiftCounter;
+    /* BK4BTSTACK_CHANGE END */
 }
 
-void SbcAnalysisInit (void)
+/* BK4BTSTACK_CHANGE START */
+void SbcAnalysisInit (SBC_ENC_PARAMS *pstrEncParams)
 {
-    memset(s16X,0,ENC_VX_BUFFER_SIZE*sizeof(SINT16));
-    ShiftCounter=0;
+    memset(pstrEncParams->s32X,0,ENC_VX_BUFFER_SIZE*sizeof(SINT16));
+    pstrEncParams->s16ShiftCounter=0;
 }
+/* BK4BTSTACK_CHANGE END */
@@ -264,10 +264,8 @@ static void playback_handler(int16_t * buffer, uint16_t num_samples){
     request_samples = num_samples;
     while (request_samples && btstack_ring_buffer_bytes_available(&sbc_frame_ring_buffer) >= sbc_frame_size){
         // log_info("buffer %06u bytes -- need %d", btstack_ring_buffer_bytes_available(&sbc_frame_ring_buffer), request_samples);
-        // decode frame
-        uint8_t frame[MAX_SBC_FRAME_SIZE];
-        btstack_ring_buffer_read(&sbc_frame_ring_buffer, frame, sbc_frame_size, &bytes_read);
-        btstack_sbc_decoder_process_data(&state, 0, frame, sbc_frame_size);
+        // decode frame directly from ring buffer
+        if (btstack_sbc_decoder_process_ring_buffer(&state, &sbc_frame_ring_buffer, 1) == 0) break;
     }
 }
 
@@ -92,7 +92,7 @@ typedef struct {
     uint8_t  stream_opened;
     uint16_t avrcp_cid;
 
-    uint32_t time_audio_data_sent; // ms
+    uint64_t time_audio_data_sent; // us
     uint32_t acc_num_missed_samples;
     uint32_t samples_ready;
     btstack_timer_source_t audio_timer;
@@ -295,7 +295,7 @@ static int a2dp_source_and_avrcp_services_init(void){
 /* LISTING_END */
 
 static void a2dp_demo_send_media_packet(void){
-    int num_bytes_in_frame = btstack_sbc_encoder_sbc_buffer_length();
+    int num_bytes_in_frame = btstack_sbc_encoder_sbc_buffer_length(&sbc_encoder_state);
     int bytes_in_storage = media_tracker.sbc_storage_count;
     uint8_t num_frames = bytes_in_storage / num_bytes_in_frame;
     a2dp_source_stream_send_media_payload(media_tracker.a2dp_cid, media_tracker.local_seid, media_tracker.sbc_storage, bytes_in_storage, num_frames, 0);
@@ -345,17 +345,17 @@ static void produce_audio(int16_t * pcm_buffer, int num_samples){
 static int a2dp_demo_fill_sbc_audio_buffer(a2dp_media_sending_context_t * context){
     // perform sbc encodin
     int total_num_bytes_read = 0;
-    unsigned int num_audio_samples_per_sbc_buffer = btstack_sbc_encoder_num_audio_frames();
+    unsigned int num_audio_samples_per_sbc_buffer = btstack_sbc_encoder_num_audio_frames(&sbc_encoder_state);
     while (context->samples_ready >= num_audio_samples_per_sbc_buffer
-        && (context->max_media_payload_size - context->sbc_storage_count) >= btstack_sbc_encoder_sbc_buffer_length()){
+        && (context->max_media_payload_size - context->sbc_storage_count) >= btstack_sbc_encoder_sbc_buffer_length(&sbc_encoder_state)){
 
         int16_t pcm_frame[256*NUM_CHANNELS];
 
         produce_audio(pcm_frame, num_audio_samples_per_sbc_buffer);
-        btstack_sbc_encoder_process_data(pcm_frame);
+        btstack_sbc_encoder_process_data(&sbc_encoder_state, pcm_frame);
         
-        uint16_t sbc_frame_size = btstack_sbc_encoder_sbc_buffer_length(); 
-        uint8_t * sbc_frame = btstack_sbc_encoder_sbc_buffer();
+        uint16_t sbc_frame_size = btstack_sbc_encoder_sbc_buffer_length(&sbc_encoder_state); 
+        uint8_t * sbc_frame = btstack_sbc_encoder_sbc_buffer(&sbc_encoder_state);
         
         total_num_bytes_read += num_audio_samples_per_sbc_buffer;
         memcpy(&context->sbc_storage[context->sbc_storage_count], sbc_frame, sbc_frame_size);
@@ -369,19 +369,20 @@ static void a2dp_demo_audio_timeout_handler(btstack_timer_source_t * timer){
     a2dp_media_sending_context_t * context = (a2dp_media_sending_context_t *) btstack_run_loop_get_timer_context(timer);
     btstack_run_loop_set_timer(&context->audio_timer, AUDIO_TIMEOUT_MS); 
     btstack_run_loop_add_timer(&context->audio_timer);
-    uint32_t now = btstack_run_loop_get_time_ms();
+    // use microsecond time if provided by run loop to avoid jitter from ms truncation
+    uint64_t now = btstack_run_loop_get_time_us();
 
-    uint32_t update_period_ms = AUDIO_TIMEOUT_MS;
+    uint64_t update_period_us = AUDIO_TIMEOUT_MS * 1000;
     if (context->time_audio_data_sent > 0){
-        update_period_ms = now - context->time_audio_data_sent;
+        update_period_us = now - context->time_audio_data_sent;
     } 
 
-    uint32_t num_samples = (update_period_ms * A2DP_SAMPLE_RATE) / 1000;
-    context->acc_num_missed_samples += (update_period_ms * A2DP_SAMPLE_RATE) % 1000;
+    uint32_t num_samples = (uint32_t) ((update_period_us * A2DP_SAMPLE_RATE) / 1000000);
+    context->acc_num_missed_samples += (uint32_t) ((update_period_us * A2DP_SAMPLE_RATE) % 1000000);
     
-    while (context->acc_num_missed_samples >= 1000){
+    while (context->acc_num_missed_samples >= 1000000){
         num_samples++;
-        context->acc_num_missed_samples -= 1000;
+        context->acc_num_missed_samples -= 1000000;
     }
     context->time_audio_data_sent = now;
     context->samples_ready += num_samples;
@@ -390,7 +391,7 @@ static void a2dp_demo_audio_timeout_handler(btstack_timer_source_t * timer){
 
     a2dp_demo_fill_sbc_audio_buffer(context);
 
-    if ((context->sbc_storage_count + btstack_sbc_encoder_sbc_buffer_length()) > context->max_media_payload_size){
+    if ((context->sbc_storage_count + btstack_sbc_encoder_sbc_buffer_length(&sbc_encoder_state)) > context->max_media_payload_size){
         // schedule sending
         context->sbc_ready_to_send = 1;
         a2dp_source_stream_endpoint_request_can_send_now(context->a2dp_cid, context->local_seid);
@@ -70,6 +70,7 @@
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #endif
  
@@ -570,8 +571,13 @@ void socket_connection_send_packet(connection_t *conn, uint16_t type, uint16_t c
     res = send(conn->socket_fd, (const char *) header, 6, flags);
     res = send(conn->socket_fd, (const char *) packet, size, flags);
 #else
-    res = write(conn->socket_fd, header, 6);
-    res = write(conn->socket_fd, packet, size);
+    // send header and packet with single system call
+    struct iovec iov[2];
+    iov[0].iov_base = header;
+    iov[0].iov_len  = 6;
+    iov[1].iov_base = packet;
+    iov[1].iov_len  = size;
+    res = writev(conn->socket_fd, iov, 2);
 #endif
     UNUSED(res);
 }
@@ -83,7 +83,7 @@ static const btstack_run_loop_t btstack_run_loop_embedded;
 static btstack_linked_list_t data_sources;
 
 #ifdef TIMER_SUPPORT
-static btstack_linked_list_t timers;
+static btstack_timer_queue_t timers;
 #endif
 
 #ifdef HAVE_EMBEDDED_TICK
@@ -119,55 +119,15 @@ static void btstack_run_loop_embedded_set_timer(btstack_timer_source_t *ts, uint
 #endif
 }
 
-// under the assumption that a tick value is +/- 2^30 away from now, calculate the upper bits of the tick value
-static int btstack_run_loop_embedded_reconstruct_higher_bits(uint32_t now, uint32_t ticks){
-    int32_t delta = ticks - now;
-    if (delta >= 0){
-        if (ticks >= now) {
-            return 0;
-        } else {
-            return 1;
-        }
-    } else {
-        if (ticks < now) {
-            return 0;
-        } else {
-            return -1;
-        }
-    }
-}
-
 /**
- * Add timer to run_loop (keep list sorted)
+ * Add timer to run_loop
  */
 static void btstack_run_loop_embedded_add_timer(btstack_timer_source_t *ts){
 #ifdef TIMER_SUPPORT
-
-#ifdef HAVE_EMBEDDED_TICK
-    uint32_t now = system_ticks;
-#endif
-#ifdef HAVE_EMBEDDED_TIME_MS
-    uint32_t now = hal_time_ms();
-#endif
-
-    uint32_t new_low = ts->timeout;
-    int     new_high = btstack_run_loop_embedded_reconstruct_higher_bits(now, new_low);
-
-    btstack_linked_item_t *it;
-    for (it = (btstack_linked_item_t *) &timers; it->next ; it = it->next){
-        // don't add timer that's already in there
-        if ((btstack_timer_source_t *) it->next == ts){
-            log_error( "btstack_run_loop_timer_add error: timer to add already in list!");
-            return;
-        }
-        uint32_t next_low  = ((btstack_timer_source_t *) it->next)->timeout;
-        int      next_high = btstack_run_loop_embedded_reconstruct_higher_bits(now, next_low);
-        if (new_high < next_high || ((new_high == next_high) && (new_low < next_low))){
-            break;
-        }
+    // timer queue compares timeouts relative to each other, which handles wrap-around of the tick/ms counter
+    if (!btstack_timer_queue_add(&timers, ts)){
+        log_error( "btstack_run_loop_timer_add error: timer to add already in list!");
     }
-    ts->item.next = it->next;
-    it->next = (btstack_linked_item_t *) ts;
 #endif
 }
 
@@ -176,7 +136,7 @@ static void btstack_run_loop_embedded_add_timer(btstack_timer_source_t *ts){
  */
 static int btstack_run_loop_embedded_remove_timer(btstack_timer_source_t *ts){
 #ifdef TIMER_SUPPORT
-    return btstack_linked_list_remove(&timers, (btstack_linked_item_t *) ts);
+    return btstack_timer_queue_remove(&timers, ts);
 #else
     return 0;
 #endif
@@ -185,12 +145,7 @@ static int btstack_run_loop_embedded_remove_timer(btstack_timer_source_t *ts){
 static void btstack_run_loop_embedded_dump_timer(void){
 #ifdef TIMER_SUPPORT
 #ifdef ENABLE_LOG_INFO 
-    btstack_linked_item_t *it;
-    int i = 0;
-    for (it = (btstack_linked_item_t *) timers; it ; it = it->next){
-        btstack_timer_source_t *ts = (btstack_timer_source_t*) it;
-        log_info("timer %u, timeout %u\n", i, (unsigned int) ts->timeout);
-    }
+    btstack_timer_queue_dump(&timers);
 #endif
 #endif
 }
@@ -228,11 +183,10 @@ void btstack_run_loop_embedded_execute_once(void) {
 #endif
 
     // process timers
-    while (timers) {
-        btstack_timer_source_t *ts = (btstack_timer_source_t *) timers;
-        uint32_t timeout_low = ts->timeout;
-        int      timeout_high = btstack_run_loop_embedded_reconstruct_higher_bits(now, timeout_low);
-        if (timeout_high > 0 || ((timeout_high == 0) && (timeout_low > now))) break;
+    while (1) {
+        btstack_timer_source_t *ts = btstack_timer_queue_first(&timers);
+        if (ts == NULL) break;
+        if ((int32_t)(ts->timeout - now) > 0) break;
         btstack_run_loop_embedded_remove_timer(ts);
         ts->process(ts);
     }
@@ -294,7 +248,7 @@ static void btstack_run_loop_embedded_init(void){
     data_sources = NULL;
 
 #ifdef TIMER_SUPPORT
-    timers = NULL;
+    btstack_timer_queue_init(&timers);
 #endif
 
 #ifdef HAVE_EMBEDDED_TICK
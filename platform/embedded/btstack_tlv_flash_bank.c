@@ -140,7 +140,8 @@ static int btstack_tlv_flash_bank_iterator_has_next(btstack_tlv_flash_bank_t * s
 
 static void tlv_iterator_fetch_next(btstack_tlv_flash_bank_t * self, tlv_iterator_t * it){
 	it->offset += 8 + btstack_tlv_flash_bank_align_size(self, it->len);
-	if (it->offset >= self->hal_flash_bank_impl->get_size(self->hal_flash_bank_context)) {
+	// no space for another entry header after last entry
+	if ((it->offset + 8) > self->hal_flash_bank_impl->get_size(self->hal_flash_bank_context)) {
 		it->tag = 0xffffffff;
 		it->len = 0;
 		return;
@@ -148,6 +149,58 @@ static void tlv_iterator_fetch_next(btstack_tlv_flash_bank_t * self, tlv_iterato
 	btstack_tlv_flash_bank_iterator_fetch_tag_len(self, it);
 }
 
+// optional RAM index: tag -> offset and len of valid entry in current bank
+
+#ifdef ENABLE_TLV_FLASH_BANK_INDEX
+
+static btstack_tlv_flash_bank_index_entry_t * btstack_tlv_flash_bank_index_find(btstack_tlv_flash_bank_t * self, uint32_t tag){
+	int i;
+	for (i=0;i<self->index_count;i++){
+		if (self->index[i].tag == tag) return &self->index[i];
+	}
+	return NULL;
+}
+
+static void btstack_tlv_flash_bank_index_reset(btstack_tlv_flash_bank_t * self){
+	self->index_count = 0;
+	self->index_complete = 1;
+}
+
+static void btstack_tlv_flash_bank_index_set(btstack_tlv_flash_bank_t * self, uint32_t tag, uint32_t offset, uint32_t len){
+	btstack_tlv_flash_bank_index_entry_t * entry = btstack_tlv_flash_bank_index_find(self, tag);
+	if (entry == NULL){
+		if (self->index_count >= TLV_FLASH_BANK_INDEX_SIZE){
+			log_info("index full, tag '%x' not indexed", tag);
+			self->index_complete = 0;
+			return;
+		}
+		entry = &self->index[self->index_count++];
+		entry->tag = tag;
+	}
+	entry->offset = offset;
+	entry->len    = len;
+}
+
+static void btstack_tlv_flash_bank_index_remove(btstack_tlv_flash_bank_t * self, btstack_tlv_flash_bank_index_entry_t * entry){
+	*entry = self->index[--self->index_count];
+}
+
+static void btstack_tlv_flash_bank_index_build(btstack_tlv_flash_bank_t * self){
+	btstack_tlv_flash_bank_index_reset(self);
+	tlv_iterator_t it;
+	btstack_tlv_flash_bank_iterator_init(self, &it, self->current_bank);
+	while (btstack_tlv_flash_bank_iterator_has_next(self, &it)){
+		// skip deleted entries
+		if (it.tag){
+			btstack_tlv_flash_bank_index_set(self, it.tag, it.offset, it.len);
+		}
+		tlv_iterator_fetch_next(self, &it);
+	}
+	log_info("index: %u tags, complete %u", self->index_count, self->index_complete);
+}
+
+#endif
+
 //
 
 // check both banks for headers and pick the one with the higher epoch % 4
@@ -217,6 +270,10 @@ static void btstack_tlv_flash_bank_migrate(btstack_tlv_flash_bank_t * self){
 	btstack_tlv_flash_bank_erase_bank(self, next_bank);
 	int next_write_pos = 8;
 
+#ifdef ENABLE_TLV_FLASH_BANK_INDEX
+	btstack_tlv_flash_bank_index_reset(self);
+#endif
+
 	tlv_iterator_t it;
 	btstack_tlv_flash_bank_iterator_init(self, &it, self->current_bank);
 	while (btstack_tlv_flash_bank_iterator_has_next(self, &it)){
@@ -228,6 +285,9 @@ static void btstack_tlv_flash_bank_migrate(btstack_tlv_flash_bank_t * self){
 			// copy
 			int bytes_to_copy = 8 + tag_len;
 			log_info("migrate pos %u, tag '%x' len %u -> new pos %u", tag_index, it.tag, bytes_to_copy, next_write_pos);
+#ifdef ENABLE_TLV_FLASH_BANK_INDEX
+			btstack_tlv_flash_bank_index_set(self, it.tag, next_write_pos, tag_len);
+#endif
 			uint8_t copy_buffer[32];
 			while (bytes_to_copy){
 				int bytes_this_iteration = btstack_min(bytes_to_copy, sizeof(copy_buffer));
@@ -250,6 +310,20 @@ static void btstack_tlv_flash_bank_migrate(btstack_tlv_flash_bank_t * self){
 }
 
 static void btstack_tlv_flash_bank_delete_tag_until_offset(btstack_tlv_flash_bank_t * self, uint32_t tag, uint32_t offset){
+#ifdef ENABLE_TLV_FLASH_BANK_INDEX
+	// only a single valid entry per tag, no need to scan if it's indexed or index is complete
+	btstack_tlv_flash_bank_index_entry_t * entry = btstack_tlv_flash_bank_index_find(self, tag);
+	if (entry != NULL){
+		if (entry->offset < offset){
+			log_info("Erase tag '%x' at position %u", tag, entry->offset);
+			uint32_t zero_tag = 0;
+			btstack_tlv_flash_bank_write(self, self->current_bank, entry->offset, (uint8_t*) &zero_tag, sizeof(zero_tag));
+			btstack_tlv_flash_bank_index_remove(self, entry);
+		}
+		return;
+	}
+	if (self->index_complete) return;
+#endif
 	tlv_iterator_t it;
 	btstack_tlv_flash_bank_iterator_init(self, &it, self->current_bank);
 	while (btstack_tlv_flash_bank_iterator_has_next(self, &it) && it.offset < offset){
@@ -263,6 +337,21 @@ static void btstack_tlv_flash_bank_delete_tag_until_offset(btstack_tlv_flash_ban
 	}
 }
 
+// find valid entry for tag in current bank
+static void btstack_tlv_flash_bank_get_tag_scan(btstack_tlv_flash_bank_t * self, uint32_t tag, uint32_t * tag_index, uint32_t * tag_len){
+	tlv_iterator_t it;
+	btstack_tlv_flash_bank_iterator_init(self, &it, self->current_bank);
+	while (btstack_tlv_flash_bank_iterator_has_next(self, &it)){
+		if (it.tag == tag){
+			log_info("Found tag '%x' at position %u", tag, it.offset);
+			*tag_index = it.offset;
+			*tag_len   = it.len;
+			return;
+		}
+		tlv_iterator_fetch_next(self, &it);
+	}
+}
+
 /**
  * Get Value for Tag
  * @param tag
@@ -276,17 +365,18 @@ static int btstack_tlv_flash_bank_get_tag(void * context, uint32_t tag, uint8_t
 
 	uint32_t tag_index = 0;
 	uint32_t tag_len   = 0;
-	tlv_iterator_t it;
-	btstack_tlv_flash_bank_iterator_init(self, &it, self->current_bank);
-	while (btstack_tlv_flash_bank_iterator_has_next(self, &it)){
-		if (it.tag == tag){
-			log_info("Found tag '%x' at position %u", tag, it.offset);
-			tag_index = it.offset;
-			tag_len   = it.len;
-			break;
-		}
-		tlv_iterator_fetch_next(self, &it);
+#ifdef ENABLE_TLV_FLASH_BANK_INDEX
+	btstack_tlv_flash_bank_index_entry_t * entry = btstack_tlv_flash_bank_index_find(self, tag);
+	if (entry != NULL){
+		tag_index = entry->offset;
+		tag_len   = entry->len;
+	} else if (!self->index_complete) {
+		// tag might not be indexed
+		btstack_tlv_flash_bank_get_tag_scan(self, tag, &tag_index, &tag_len);
 	}
+#else
+	btstack_tlv_flash_bank_get_tag_scan(self, tag, &tag_index, &tag_len);
+#endif
 	if (tag_index == 0) return 0;
 	if (!buffer) return tag_len;
 	int copy_size = btstack_min(buffer_size, tag_len);
@@ -330,6 +420,10 @@ static int btstack_tlv_flash_bank_store_tag(void * context, uint32_t tag, const
 	// overwrite old entries (if exists)
 	btstack_tlv_flash_bank_delete_tag_until_offset(self, tag, self->write_offset);
 
+#ifdef ENABLE_TLV_FLASH_BANK_INDEX
+	btstack_tlv_flash_bank_index_set(self, tag, self->write_offset, data_size);
+#endif
+
 	// done
 	self->write_offset += sizeof(entry) + btstack_tlv_flash_bank_align_size(self, data_size);
 
@@ -358,6 +452,11 @@ const btstack_tlv_t * btstack_tlv_flash_bank_init_instance(btstack_tlv_flash_ban
 
 	self->hal_flash_bank_impl    = hal_flash_bank_impl;
 	self->hal_flash_bank_context = hal_flash_bank_context;
+#ifdef ENABLE_TLV_FLASH_BANK_INDEX
+	// not valid until bank has been scanned
+	self->index_count = 0;
+	self->index_complete = 0;
+#endif
 
 	// try to find current bank
 	self->current_bank = btstack_tlv_flash_bank_get_latest_bank(self);
@@ -405,6 +504,10 @@ const btstack_tlv_t * btstack_tlv_flash_bank_init_instance(btstack_tlv_flash_ban
 		self->write_offset = 8;
 	}
 
+#ifdef ENABLE_TLV_FLASH_BANK_INDEX
+	btstack_tlv_flash_bank_index_build(self);
+#endif
+
 	log_info("write offset %u", self->write_offset);
 	return &btstack_tlv_flash_bank;
 }
@@ -40,6 +40,7 @@
 #define __BTSTACK_TLV_FLASH_BANK_H
 
 #include <stdint.h>
+#include "btstack_config.h"
 #include "btstack_tlv.h"
 #include "hal_flash_bank.h"
 
@@ -47,11 +48,34 @@
 extern "C" {
 #endif
 
+// max number of tags in the optional RAM index, lookups of other tags fall back to scanning the bank
+#ifdef ENABLE_TLV_FLASH_BANK_INDEX
+#ifndef TLV_FLASH_BANK_INDEX_SIZE
+#define TLV_FLASH_BANK_INDEX_SIZE 16
+#endif
+#if TLV_FLASH_BANK_INDEX_SIZE < 1
+#error TLV_FLASH_BANK_INDEX_SIZE must be at least 1
+#endif
+
+typedef struct {
+	uint32_t tag;
+	uint32_t offset;
+	uint32_t len;
+} btstack_tlv_flash_bank_index_entry_t;
+#endif
+
 typedef struct {
 	const hal_flash_bank_t * hal_flash_bank_impl;
 	void * hal_flash_bank_context;
 	int current_bank;
 	int write_offset;
+#ifdef ENABLE_TLV_FLASH_BANK_INDEX
+	// valid entries in current bank
+	btstack_tlv_flash_bank_index_entry_t index[TLV_FLASH_BANK_INDEX_SIZE];
+	uint16_t index_count;
+	// set if all valid entries of current bank are in index
+	uint8_t  index_complete;
+#endif
 } btstack_tlv_flash_bank_t;
 
 /**
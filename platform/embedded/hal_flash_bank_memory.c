@@ -91,10 +91,10 @@ static void hal_flash_bank_memory_write(void * context, int bank, uint32_t offse
 		// write 0xff doesn't change anything
 		if (data[i] == 0xff) continue;
 		// writing something other than 0x00 is only allowed once
-		if (self->banks[bank][offset] != 0xff && data[i] != 0x00){
+		if (self->banks[bank][offset+i] != 0xff && data[i] != 0x00){
 			log_error("Error: offset %u written twice. Data: 0x%02x!", offset+i, data[i]);
 		} else {
-			self->banks[bank][offset++] = data[i];
+			self->banks[bank][offset+i] = data[i];
 		}
 	}
 }
@@ -77,7 +77,7 @@ static EventGroupHandle_t   btstack_run_loop_event_group;
 #define EVENT_GROUP_FLAG_RUN_LOOP 1
 
 // the run loop
-static btstack_linked_list_t timers;
+static btstack_timer_queue_t timers;
 static btstack_linked_list_t data_sources;
 
 static uint32_t btstack_run_loop_freertos_get_time_ms(void){
@@ -90,39 +90,24 @@ static void btstack_run_loop_freertos_set_timer(btstack_timer_source_t *ts, uint
 }
 
 /**
- * Add timer to run_loop (keep list sorted)
+ * Add timer to run_loop
  */
 static void btstack_run_loop_freertos_add_timer(btstack_timer_source_t *ts){
-    btstack_linked_item_t *it;
-    for (it = (btstack_linked_item_t *) &timers; it->next ; it = it->next){
-        // don't add timer that's already in there
-        if ((btstack_timer_source_t *) it->next == ts){
-            log_error( "btstack_run_loop_timer_add error: timer to add already in list!");
-            return;
-        }
-        if (ts->timeout < ((btstack_timer_source_t *) it->next)->timeout) {
-            break;
-        }
+    if (!btstack_timer_queue_add(&timers, ts)){
+        log_error( "btstack_run_loop_timer_add error: timer to add already in list!");
     }
-    ts->item.next = it->next;
-    it->next = (btstack_linked_item_t *) ts;
 }
 
 /**
  * Remove timer from run loop
  */
 static int btstack_run_loop_freertos_remove_timer(btstack_timer_source_t *ts){
-    return btstack_linked_list_remove(&timers, (btstack_linked_item_t *) ts);
+    return btstack_timer_queue_remove(&timers, ts);
 }
 
 static void btstack_run_loop_freertos_dump_timer(void){
 #ifdef ENABLE_LOG_INFO 
-    btstack_linked_item_t *it;
-    int i = 0;
-    for (it = (btstack_linked_item_t *) timers; it ; it = it->next){
-        btstack_timer_source_t *ts = (btstack_timer_source_t*) it;
-        log_info("timer %u, timeout %u\n", i, (unsigned int) ts->timeout);
-    }
+    btstack_timer_queue_dump(&timers);
 #endif
 }
 
@@ -204,8 +189,9 @@ static void btstack_run_loop_freertos_execute(void) {
         // process timers and get et next timeout
         uint32_t timeout_ms = portMAX_DELAY;
         log_debug("RL: portMAX_DELAY %u", portMAX_DELAY);
-        while (timers) {
-            btstack_timer_source_t * ts = (btstack_timer_source_t *) timers;
+        while (1) {
+            btstack_timer_source_t * ts = btstack_timer_queue_first(&timers);
+            if (ts == NULL) break;
             uint32_t now = btstack_run_loop_freertos_get_time_ms();
             log_debug("RL: now %u, expires %u", now, ts->timeout);
             if (ts->timeout > now){
@@ -245,7 +231,7 @@ static void btstack_run_loop_freertos_disable_data_source_callbacks(btstack_data
 }
 
 static void btstack_run_loop_freertos_init(void){
-    timers = NULL;
+    btstack_timer_queue_init(&timers);
 
     // queue to receive events: up to 2 calls from transport, up to 3 for app
     btstack_run_loop_queue = xQueueCreate(20, sizeof(function_call_t));
@@ -0,0 +1,379 @@
+/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define __BTSTACK_FILE__ "btstack_run_loop_epoll.c"
+
+/*
+ *  btstack_run_loop_epoll.c
+ *
+ *  Linux run loop based on epoll: file descriptors are registered with the kernel once
+ *  when a data source is added or its callbacks change, and only ready data sources are
+ *  dispatched. Time is taken from CLOCK_MONOTONIC, timers are implemented with a timerfd
+ *  to provide microsecond resolution.
+ */
+
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_epoll.h"
+#include "btstack_linked_list.h"
+#include "btstack_debug.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef HAVE_POSIX_TIME
+#error "epoll run loop requires HAVE_POSIX_TIME in btstack_config.h"
+#endif
+
+// number of ready events fetched per epoll_wait call
+#ifndef BTSTACK_RUN_LOOP_EPOLL_MAX_EVENTS
+#define BTSTACK_RUN_LOOP_EPOLL_MAX_EVENTS 32
+#endif
+
+// internal flag stored in data source flags: data source has been added to the run loop
+#define DATA_SOURCE_FLAG_EPOLL_ADDED (1 << 15)
+
+#define DATA_SOURCE_CALLBACK_READ_WRITE (DATA_SOURCE_CALLBACK_READ | DATA_SOURCE_CALLBACK_WRITE)
+
+static void btstack_run_loop_epoll_dump_timer(void);
+
+// the run loop
+static int epoll_fd = -1;
+// timerfd armed for the earliest timer
+static int timer_fd = -1;
+static uint64_t timer_fd_deadline_us;
+static int timer_fd_armed;
+static btstack_timer_queue_t timers;
+// events returned by last epoll_wait call, entries are cleared if data source gets removed during dispatch
+static struct epoll_event ready_events[BTSTACK_RUN_LOOP_EPOLL_MAX_EVENTS];
+static int num_ready_events;
+// start time. tv_nsec = 0
+static struct timespec init_ts;
+
+static uint32_t btstack_run_loop_epoll_events_for_flags(uint16_t flags){
+    uint32_t events = 0;
+    if (flags & DATA_SOURCE_CALLBACK_READ){
+        events |= EPOLLIN;
+    }
+    if (flags & DATA_SOURCE_CALLBACK_WRITE){
+        events |= EPOLLOUT;
+    }
+    return events;
+}
+
+// sync kernel registration with enabled callbacks. fds are only registered while read or write is enabled
+// to avoid being woken up by EPOLLHUP/EPOLLERR for data sources without enabled callbacks
+static void btstack_run_loop_epoll_update_registration(btstack_data_source_t * ds, uint16_t old_flags){
+    if ((ds->flags & DATA_SOURCE_FLAG_EPOLL_ADDED) == 0) return;
+    if (ds->source.fd < 0) return;
+
+    uint16_t old_callbacks = old_flags & DATA_SOURCE_CALLBACK_READ_WRITE;
+    uint16_t new_callbacks = ds->flags & DATA_SOURCE_CALLBACK_READ_WRITE;
+    if (old_callbacks == new_callbacks) return;
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events   = btstack_run_loop_epoll_events_for_flags(new_callbacks);
+    event.data.ptr = ds;
+
+    int op;
+    if (old_callbacks == 0){
+        op = EPOLL_CTL_ADD;
+    } else if (new_callbacks == 0){
+        op = EPOLL_CTL_DEL;
+    } else {
+        op = EPOLL_CTL_MOD;
+    }
+    int res = epoll_ctl(epoll_fd, op, ds->source.fd, &event);
+    if (res < 0){
+        log_error("btstack_run_loop_epoll: epoll_ctl op %u for fd %u failed, errno %u", op, ds->source.fd, errno);
+    }
+}
+
+/**
+ * Add data_source to run_loop
+ */
+static void btstack_run_loop_epoll_add_data_source(btstack_data_source_t *ds){
+    if (ds->flags & DATA_SOURCE_FLAG_EPOLL_ADDED) return;
+    // log_info("btstack_run_loop_epoll_add_data_source %x with fd %u\n", (int) ds, ds->source.fd);
+    ds->flags |= DATA_SOURCE_FLAG_EPOLL_ADDED;
+    btstack_run_loop_epoll_update_registration(ds, DATA_SOURCE_FLAG_EPOLL_ADDED);
+}
+
+/**
+ * Remove data_source from run loop
+ */
+static int btstack_run_loop_epoll_remove_data_source(btstack_data_source_t *ds){
+    if ((ds->flags & DATA_SOURCE_FLAG_EPOLL_ADDED) == 0) return 0;
+    // log_info("btstack_run_loop_epoll_remove_data_source %x\n", (int) ds);
+    if ((ds->flags & DATA_SOURCE_CALLBACK_READ_WRITE) && (ds->source.fd >= 0)){
+        // fd might already be closed, which removes it from the epoll set
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, ds->source.fd, &event);
+    }
+    ds->flags &= ~DATA_SOURCE_FLAG_EPOLL_ADDED;
+    // drop pending events for this data source, including the one currently dispatched
+    int i;
+    for (i=0;i<num_ready_events;i++){
+        if (ready_events[i].data.ptr == ds){
+            ready_events[i].data.ptr = NULL;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Add timer to run_loop
+ */
+static void btstack_run_loop_epoll_add_timer(btstack_timer_source_t *ts){
+    if (!btstack_timer_queue_add(&timers, ts)){
+        log_error( "btstack_run_loop_timer_add error: timer to add already in list!");
+        return;
+    }
+    log_debug("Added timer %p at %u\n", ts, ts->timeout);
+}
+
+/**
+ * Remove timer from run loop
+ */
+static int btstack_run_loop_epoll_remove_timer(btstack_timer_source_t *ts){
+    return btstack_timer_queue_remove(&timers, ts);
+}
+
+static void btstack_run_loop_epoll_dump_timer(void){
+    btstack_timer_queue_dump(&timers);
+}
+
+static void btstack_run_loop_epoll_enable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
+    uint16_t old_flags = ds->flags;
+    ds->flags |= callback_types;
+    btstack_run_loop_epoll_update_registration(ds, old_flags);
+}
+
+static void btstack_run_loop_epoll_disable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
+    uint16_t old_flags = ds->flags;
+    ds->flags &= ~callback_types;
+    btstack_run_loop_epoll_update_registration(ds, old_flags);
+}
+
+/**
+ * @brief Queries the current time in us since start
+ */
+static uint64_t btstack_run_loop_epoll_get_time_us(void){
+    struct timespec now_ts;
+    clock_gettime(CLOCK_MONOTONIC, &now_ts);
+    uint64_t time_us = ((uint64_t)(now_ts.tv_sec - init_ts.tv_sec)) * 1000000 + (now_ts.tv_nsec / 1000);
+    return time_us;
+}
+
+/**
+ * @brief Queries the current time in ms since start
+ */
+static uint32_t btstack_run_loop_epoll_get_time_ms(void){
+    uint32_t time_ms = (uint32_t)(btstack_run_loop_epoll_get_time_us() / 1000);
+    log_debug("btstack_run_loop_epoll_get_time_ms: %u", time_ms);
+    return time_ms;
+}
+
+// arm timerfd for earliest timer, or disarm it if there are no timers
+static void btstack_run_loop_epoll_update_timer_fd(void){
+    btstack_timer_source_t * ts = btstack_timer_queue_first(&timers);
+    if (ts == NULL){
+        if (!timer_fd_armed) return;
+        timer_fd_armed = 0;
+    } else {
+        if (timer_fd_armed && (timer_fd_deadline_us == ts->timeout_us)) return;
+        timer_fd_armed = 1;
+        timer_fd_deadline_us = ts->timeout_us;
+    }
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    if (timer_fd_armed){
+        // absolute time, init_ts.tv_nsec is 0
+        spec.it_value.tv_sec  = init_ts.tv_sec + (time_t) (timer_fd_deadline_us / 1000000);
+        spec.it_value.tv_nsec = (long) (timer_fd_deadline_us % 1000000) * 1000;
+        // an all-zero value would disarm the timer
+        if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0){
+            spec.it_value.tv_nsec = 1;
+        }
+    }
+    if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, NULL) < 0){
+        log_error("btstack_run_loop_epoll: timerfd_settime failed, errno %u", errno);
+    }
+}
+
+// ready event gets cleared if its data source is removed, ds must not be accessed afterwards as it might have been freed
+static void btstack_run_loop_epoll_dispatch(struct epoll_event * ready_event){
+    btstack_data_source_t * ds = (btstack_data_source_t *) ready_event->data.ptr;
+    uint32_t events = ready_event->events;
+    if ((events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && (ds->flags & DATA_SOURCE_CALLBACK_READ)){
+        log_debug("btstack_run_loop_epoll_execute: process read ds %p with fd %u\n", ds, ds->source.fd);
+        ds->process(ds, DATA_SOURCE_CALLBACK_READ);
+    }
+    // data source might have been removed by read callback
+    if (ready_event->data.ptr == NULL) return;
+    if ((events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) && (ds->flags & DATA_SOURCE_CALLBACK_WRITE)){
+        log_debug("btstack_run_loop_epoll_execute: process write ds %p with fd %u\n", ds, ds->source.fd);
+        ds->process(ds, DATA_SOURCE_CALLBACK_WRITE);
+    }
+}
+
+/**
+ * Execute run_loop
+ */
+static void btstack_run_loop_epoll_execute(void) {
+    btstack_timer_source_t *ts;
+    uint64_t now_us;
+
+    while (1) {
+        // get next timeout
+        btstack_run_loop_epoll_update_timer_fd();
+
+        // wait for ready FDs or timerfd
+        int res = epoll_wait(epoll_fd, ready_events, BTSTACK_RUN_LOOP_EPOLL_MAX_EVENTS, -1);
+        if (res < 0){
+            if (errno != EINTR){
+                log_error("btstack_run_loop_epoll_execute: epoll_wait failed, errno %u", errno);
+            }
+            res = 0;
+        }
+
+        // dispatch ready data sources. entries are cleared if a data source gets removed by a callback
+        num_ready_events = res;
+        int i;
+        for (i=0;i<num_ready_events;i++){
+            if (ready_events[i].data.ptr == &timer_fd){
+                uint64_t expirations;
+                if (read(timer_fd, &expirations, sizeof(expirations)) < 0){
+                    log_debug("btstack_run_loop_epoll_execute: timerfd read, errno %u", errno);
+                }
+                continue;
+            }
+            if (ready_events[i].data.ptr == NULL) continue;
+            btstack_run_loop_epoll_dispatch(&ready_events[i]);
+        }
+        num_ready_events = 0;
+
+        // process timers
+        now_us = btstack_run_loop_epoll_get_time_us();
+        while (1) {
+            ts = btstack_timer_queue_first(&timers);
+            if (ts == NULL) break;
+            if (ts->timeout_us > now_us) break;
+            log_debug("btstack_run_loop_epoll_execute: process timer %p\n", ts);
+
+            // remove timer before processing it to allow handler to re-register with run loop
+            btstack_run_loop_epoll_remove_timer(ts);
+            ts->process(ts);
+        }
+    }
+}
+
+// set timer
+static void btstack_run_loop_epoll_set_timer_us(btstack_timer_source_t *a, uint32_t timeout_in_us){
+    uint64_t time_us = btstack_run_loop_epoll_get_time_us();
+    a->timeout_us = time_us + timeout_in_us;
+    a->timeout    = (uint32_t) (a->timeout_us / 1000);
+    log_debug("btstack_run_loop_epoll_set_timer_us to %u ms (timeout %u us)", a->timeout, timeout_in_us);
+}
+
+static void btstack_run_loop_epoll_set_timer(btstack_timer_source_t *a, uint32_t timeout_in_ms){
+    uint64_t time_us = btstack_run_loop_epoll_get_time_us();
+    a->timeout_us = time_us + ((uint64_t) timeout_in_ms) * 1000;
+    a->timeout    = (uint32_t) (a->timeout_us / 1000);
+    log_debug("btstack_run_loop_epoll_set_timer to %u ms (timeout %u)", a->timeout, timeout_in_ms);
+}
+
+static void btstack_run_loop_epoll_init(void){
+    btstack_timer_queue_init(&timers);
+    num_ready_events = 0;
+    if (epoll_fd >= 0){
+        close(epoll_fd);
+    }
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0){
+        log_error("btstack_run_loop_epoll_init: epoll_create1 failed, errno %u", errno);
+    }
+    if (timer_fd >= 0){
+        close(timer_fd);
+    }
+    timer_fd_armed = 0;
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd < 0){
+        log_error("btstack_run_loop_epoll_init: timerfd_create failed, errno %u", errno);
+    } else {
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events   = EPOLLIN;
+        event.data.ptr = &timer_fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &event);
+    }
+    // just assume that we started at tv_nsec == 0
+    clock_gettime(CLOCK_MONOTONIC, &init_ts);
+    init_ts.tv_nsec = 0;
+    log_debug("btstack_run_loop_epoll_init at %u/%u", (int) init_ts.tv_sec, 0);
+}
+
+
+static const btstack_run_loop_t btstack_run_loop_epoll = {
+    &btstack_run_loop_epoll_init,
+    &btstack_run_loop_epoll_add_data_source,
+    &btstack_run_loop_epoll_remove_data_source,
+    &btstack_run_loop_epoll_enable_data_source_callbacks,
+    &btstack_run_loop_epoll_disable_data_source_callbacks,
+    &btstack_run_loop_epoll_set_timer,
+    &btstack_run_loop_epoll_add_timer,
+    &btstack_run_loop_epoll_remove_timer,
+    &btstack_run_loop_epoll_execute,
+    &btstack_run_loop_epoll_dump_timer,
+    &btstack_run_loop_epoll_get_time_ms,
+    &btstack_run_loop_epoll_set_timer_us,
+    &btstack_run_loop_epoll_get_time_us,
+};
+
+/**
+ * Provide btstack_run_loop_epoll instance
+ */
+const btstack_run_loop_t * btstack_run_loop_epoll_get_instance(void){
+    return &btstack_run_loop_epoll;
+}
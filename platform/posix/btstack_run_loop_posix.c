@@ -57,15 +57,20 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/time.h>
+#include <time.h>
+
+#ifndef HAVE_POSIX_TIME
+#error "POSIX run loop requires HAVE_POSIX_TIME in btstack_config.h"
+#endif
 
 static void btstack_run_loop_posix_dump_timer(void);
 
 // the run loop
 static btstack_linked_list_t data_sources;
 static int data_sources_modified;
-static btstack_linked_list_t timers;
-// start time. tv_usec = 0
-static struct timeval init_tv;
+static btstack_timer_queue_t timers;
+// start time. tv_nsec = 0
+static struct timespec init_ts;
 
 /**
  * Add data_source to run_loop
@@ -86,24 +91,14 @@ static int btstack_run_loop_posix_remove_data_source(btstack_data_source_t *ds){
 }
 
 /**
- * Add timer to run_loop (keep list sorted)
+ * Add timer to run_loop
  */
 static void btstack_run_loop_posix_add_timer(btstack_timer_source_t *ts){
-    btstack_linked_item_t *it;
-    for (it = (btstack_linked_item_t *) &timers; it->next ; it = it->next){
-        btstack_timer_source_t * next = (btstack_timer_source_t *) it->next;
-        if (next == ts){
-            log_error( "btstack_run_loop_timer_add error: timer to add already in list!");
-            return;
-        }
-        if (next->timeout > ts->timeout) {
-            break;
-        }
+    if (!btstack_timer_queue_add(&timers, ts)){
+        log_error( "btstack_run_loop_timer_add error: timer to add already in list!");
+        return;
     }
-    ts->item.next = it->next;
-    it->next = (btstack_linked_item_t *) ts;
     log_debug("Added timer %p at %u\n", ts, ts->timeout);
-    // btstack_run_loop_posix_dump_timer();
 }
 
 /**
@@ -112,16 +107,11 @@ static void btstack_run_loop_posix_add_timer(btstack_timer_source_t *ts){
 static int btstack_run_loop_posix_remove_timer(btstack_timer_source_t *ts){
     // log_info("Removed timer %x at %u\n", (int) ts, (unsigned int) ts->timeout.tv_sec);
     // btstack_run_loop_posix_dump_timer();
-    return btstack_linked_list_remove(&timers, (btstack_linked_item_t *) ts);
+    return btstack_timer_queue_remove(&timers, ts);
 }
 
 static void btstack_run_loop_posix_dump_timer(void){
-    btstack_linked_item_t *it;
-    int i = 0;
-    for (it = (btstack_linked_item_t *) timers; it ; it = it->next){
-        btstack_timer_source_t *ts = (btstack_timer_source_t*) it;
-        log_info("timer %u, timeout %u\n", i, ts->timeout);
-    }
+    btstack_timer_queue_dump(&timers);
 }
 
 static void btstack_run_loop_posix_enable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
@@ -132,14 +122,22 @@ static void btstack_run_loop_posix_disable_data_source_callbacks(btstack_data_so
     ds->flags &= ~callback_types;
 }
 
+/**
+ * @brief Queries the current time in us since start, based on monotonic clock
+ */
+static uint64_t btstack_run_loop_posix_get_time_us(void){
+    struct timespec now_ts;
+    clock_gettime(CLOCK_MONOTONIC, &now_ts);
+    uint64_t time_us = ((uint64_t)(now_ts.tv_sec - init_ts.tv_sec)) * 1000000 + (now_ts.tv_nsec / 1000);
+    return time_us;
+}
+
 /**
  * @brief Queries the current time in ms since start
  */
 static uint32_t btstack_run_loop_posix_get_time_ms(void){
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    uint32_t time_ms = (uint32_t)((tv.tv_sec  - init_tv.tv_sec) * 1000) + (tv.tv_usec / 1000);
-    log_debug("btstack_run_loop_posix_get_time_ms: %u <- %u / %u", time_ms, (int) tv.tv_sec, (int) tv.tv_usec);
+    uint32_t time_ms = (uint32_t)(btstack_run_loop_posix_get_time_us() / 1000);
+    log_debug("btstack_run_loop_posix_get_time_ms: %u", time_ms);
     return time_ms;
 }
 
@@ -154,7 +152,7 @@ static void btstack_run_loop_posix_execute(void) {
     btstack_linked_list_iterator_t it;
     struct timeval * timeout;
     struct timeval tv;
-    uint32_t now_ms;
+    uint64_t now_us;
 
     while (1) {
         // collect FDs
@@ -183,17 +181,17 @@ static void btstack_run_loop_posix_execute(void) {
         
         // get next timeout
         timeout = NULL;
-        if (timers) {
-            ts = (btstack_timer_source_t *) timers;
+        ts = btstack_timer_queue_first(&timers);
+        if (ts) {
             timeout = &tv;
-            now_ms = btstack_run_loop_posix_get_time_ms();
-            int delta = ts->timeout - now_ms;
-            if (delta < 0){
-                delta = 0;
+            now_us = btstack_run_loop_posix_get_time_us();
+            uint64_t delta_us = 0;
+            if (ts->timeout_us > now_us){
+                delta_us = ts->timeout_us - now_us;
             }
-            tv.tv_sec  = delta / 1000;
-            tv.tv_usec = (int) (delta - (tv.tv_sec * 1000)) * 1000;
-            log_debug("btstack_run_loop_execute next timeout in %u ms", delta);
+            tv.tv_sec  = (time_t) (delta_us / 1000000);
+            tv.tv_usec = (suseconds_t) (delta_us % 1000000);
+            log_debug("btstack_run_loop_execute next timeout in %u us", (unsigned int) delta_us);
         }
                 
         // wait for ready FDs
@@ -218,10 +216,11 @@ static void btstack_run_loop_posix_execute(void) {
         log_debug("btstack_run_loop_posix_execute: after ds check\n");
         
         // process timers
-        now_ms = btstack_run_loop_posix_get_time_ms();
-        while (timers) {
-            ts = (btstack_timer_source_t *) timers;
-            if (ts->timeout > now_ms) break;
+        now_us = btstack_run_loop_posix_get_time_us();
+        while (1) {
+            ts = btstack_timer_queue_first(&timers);
+            if (ts == NULL) break;
+            if (ts->timeout_us > now_us) break;
             log_debug("btstack_run_loop_posix_execute: process timer %p\n", ts);
             
             // remove timer before processing it to allow handler to re-register with run loop
@@ -232,19 +231,27 @@ static void btstack_run_loop_posix_execute(void) {
 }
 
 // set timer
+static void btstack_run_loop_posix_set_timer_us(btstack_timer_source_t *a, uint32_t timeout_in_us){
+    uint64_t time_us = btstack_run_loop_posix_get_time_us();
+    a->timeout_us = time_us + timeout_in_us;
+    a->timeout    = (uint32_t) (a->timeout_us / 1000);
+    log_debug("btstack_run_loop_posix_set_timer_us to %u ms (timeout %u us)", a->timeout, timeout_in_us);
+}
+
 static void btstack_run_loop_posix_set_timer(btstack_timer_source_t *a, uint32_t timeout_in_ms){
-    uint32_t time_ms = btstack_run_loop_posix_get_time_ms();
-    a->timeout = time_ms + timeout_in_ms;
-    log_debug("btstack_run_loop_posix_set_timer to %u ms (now %u, timeout %u)", a->timeout, time_ms, timeout_in_ms);
+    uint64_t time_us = btstack_run_loop_posix_get_time_us();
+    a->timeout_us = time_us + ((uint64_t) timeout_in_ms) * 1000;
+    a->timeout    = (uint32_t) (a->timeout_us / 1000);
+    log_debug("btstack_run_loop_posix_set_timer to %u ms (timeout %u)", a->timeout, timeout_in_ms);
 }
 
 static void btstack_run_loop_posix_init(void){
     data_sources = NULL;
-    timers = NULL;
-    // just assume that we started at tv_usec == 0
-    gettimeofday(&init_tv, NULL);
-    init_tv.tv_usec = 0;
-    log_debug("btstack_run_loop_posix_init at %u/%u", (int) init_tv.tv_sec, 0);
+    btstack_timer_queue_init(&timers);
+    // just assume that we started at tv_nsec == 0
+    clock_gettime(CLOCK_MONOTONIC, &init_ts);
+    init_ts.tv_nsec = 0;
+    log_debug("btstack_run_loop_posix_init at %u/%u", (int) init_ts.tv_sec, 0);
 }
 
 
@@ -260,6 +267,8 @@ static const btstack_run_loop_t btstack_run_loop_posix = {
     &btstack_run_loop_posix_execute,
     &btstack_run_loop_posix_dump_timer,
     &btstack_run_loop_posix_get_time_ms,
+    &btstack_run_loop_posix_set_timer_us,
+    &btstack_run_loop_posix_get_time_us,
 };
 
 /**
@@ -35,61 +35,334 @@
 #include "btstack_tlv_posix.h"
 #include "btstack_debug.h"
 #include "btstack_util.h"
-#include "btstack_debug.h"
-#include "string.h"
 
 #include <stdlib.h>
 #include <string.h>
-
+#include <fcntl.h>
+#include <unistd.h>
 
 // Header:
 // - Magic: 'BTstack'
 // - Status:
 //   - bits 765432: reserved
+//   - bit  2:      records with CRC-32
 //	 - bits 10:     epoch
 
 // Entries
 // - Tag: 32 bit
 // - Len: 32 bit
 // - Value: Len in bytes
+// - CRC-32 over Tag, Len, and Value (if bit 2 in status set)
+// Len = 0 marks deleted tag
 
 #define BTSTACK_TLV_HEADER_LEN 8
+#define BTSTACK_TLV_STATUS_CRC 0x04
 static const char * btstack_tlv_header_magic = "BTstack";
 
+#define BTSTACK_TLV_RECORD_HEADER_LEN 8
+#define BTSTACK_TLV_RECORD_CRC_LEN    4
+#define BTSTACK_TLV_RECORD_OVERHEAD   (BTSTACK_TLV_RECORD_HEADER_LEN + BTSTACK_TLV_RECORD_CRC_LEN)
+
+// arbitrary safety check: values < 1000 bytes each
+#define BTSTACK_TLV_MAX_VALUE_LEN 1000
+
+// compaction when outdated records use more than half of the file and file is larger than this
+#ifndef BTSTACK_TLV_POSIX_COMPACTION_MIN_FILE_SIZE
+#define BTSTACK_TLV_POSIX_COMPACTION_MIN_FILE_SIZE 16384
+#endif
+
+#define BTSTACK_TLV_INITIAL_BUCKETS 64
+
 #define DUMMY_SIZE 4
 typedef struct tlv_entry {
-	void   * next;
+	struct tlv_entry * next;
 	uint32_t tag;
 	uint32_t len;
 	uint8_t  value[DUMMY_SIZE];	// dummy size
 } tlv_entry_t;
 
-static int btstack_tlv_posix_append_tag(btstack_tlv_posix_t * self, uint32_t tag, const uint8_t * data, uint32_t data_size){
+// CRC-32 (IEEE 802.3), 4 bit table
+static const uint32_t btstack_tlv_posix_crc32_table[16] = {
+	0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+	0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+};
 
-	if (!self->file) return 1;
+static uint32_t btstack_tlv_posix_crc32_update(uint32_t crc, const uint8_t * data, uint32_t size){
+	uint32_t i;
+	for (i=0;i<size;i++){
+		crc ^= data[i];
+		crc = (crc >> 4) ^ btstack_tlv_posix_crc32_table[crc & 0x0f];
+		crc = (crc >> 4) ^ btstack_tlv_posix_crc32_table[crc & 0x0f];
+	}
+	return crc;
+}
 
-	log_info("append tag %04x, len %u", tag, data_size);
+static uint32_t btstack_tlv_posix_record_crc(const uint8_t * header, const uint8_t * data, uint32_t data_size){
+	uint32_t crc = btstack_tlv_posix_crc32_update(0xffffffff, header, BTSTACK_TLV_RECORD_HEADER_LEN);
+	crc = btstack_tlv_posix_crc32_update(crc, data, data_size);
+	return ~crc;
+}
+
+static uint32_t btstack_tlv_posix_record_size(uint32_t data_size){
+	return BTSTACK_TLV_RECORD_OVERHEAD + data_size;
+}
+
+// hash index
+
+static tlv_entry_t ** btstack_tlv_posix_bucket(btstack_tlv_posix_t * self, uint32_t tag){
+	uint32_t hash = tag * 0x9e3779b1;
+	hash ^= hash >> 16;
+	return (tlv_entry_t **) &self->entry_buckets[hash & (self->num_buckets - 1)];
+}
+
+// returns pointer to link to entry with tag, or to NULL link at end of bucket
+static tlv_entry_t ** btstack_tlv_posix_find_link(btstack_tlv_posix_t * self, uint32_t tag){
+	tlv_entry_t ** link = btstack_tlv_posix_bucket(self, tag);
+	while (*link && ((*link)->tag != tag)){
+		link = &(*link)->next;
+	}
+	return link;
+}
+
+static tlv_entry_t * btstack_tlv_posix_find_entry(btstack_tlv_posix_t * self, uint32_t tag){
+	if (!self->entry_buckets) return NULL;
+	return *btstack_tlv_posix_find_link(self, tag);
+}
+
+static int btstack_tlv_posix_resize_index(btstack_tlv_posix_t * self, uint32_t num_buckets){
+	void ** old_buckets = self->entry_buckets;
+	uint32_t old_num_buckets = self->num_buckets;
+	void ** new_buckets = (void **) calloc(num_buckets, sizeof(void *));
+	if (!new_buckets) return 1;
+	self->entry_buckets = new_buckets;
+	self->num_buckets = num_buckets;
+	uint32_t i;
+	for (i=0;i<old_num_buckets;i++){
+		tlv_entry_t * entry = (tlv_entry_t *) old_buckets[i];
+		while (entry){
+			tlv_entry_t * next = entry->next;
+			tlv_entry_t ** bucket = btstack_tlv_posix_bucket(self, entry->tag);
+			entry->next = *bucket;
+			*bucket = entry;
+			entry = next;
+		}
+	}
+	free(old_buckets);
+	return 0;
+}
+
+// add entry or replace entry with same tag
+static void btstack_tlv_posix_index_put(btstack_tlv_posix_t * self, tlv_entry_t * new_entry){
+	tlv_entry_t ** link = btstack_tlv_posix_find_link(self, new_entry->tag);
+	tlv_entry_t * old_entry = *link;
+	if (old_entry){
+		new_entry->next = old_entry->next;
+		self->live_size -= btstack_tlv_posix_record_size(old_entry->len);
+		free(old_entry);
+	} else {
+		new_entry->next = NULL;
+		self->num_entries++;
+	}
+	*link = new_entry;
+	self->live_size += btstack_tlv_posix_record_size(new_entry->len);
+
+	// keep load factor <= 1
+	if (self->num_entries > self->num_buckets){
+		if (btstack_tlv_posix_resize_index(self, self->num_buckets * 2)){
+			log_error("TLV: resize index failed");
+		}
+	}
+}
+
+static void btstack_tlv_posix_index_remove(btstack_tlv_posix_t * self, uint32_t tag){
+	tlv_entry_t ** link = btstack_tlv_posix_find_link(self, tag);
+	tlv_entry_t * entry = *link;
+	if (!entry) return;
+	*link = entry->next;
+	self->num_entries--;
+	self->live_size -= btstack_tlv_posix_record_size(entry->len);
+	free(entry);
+}
+
+static tlv_entry_t * btstack_tlv_posix_create_entry(uint32_t tag, const uint8_t * data, uint32_t data_size){
+	uint32_t entry_size = sizeof(tlv_entry_t) - DUMMY_SIZE + data_size;
+	tlv_entry_t * new_entry = (tlv_entry_t *) malloc(entry_size);
+	if (!new_entry) return NULL;
+	memset(new_entry, 0, entry_size);
+	new_entry->tag = tag;
+	new_entry->len = data_size;
+	if (data_size){
+		memcpy(&new_entry->value[0], data, data_size);
+	}
+	return new_entry;
+}
+
+static void btstack_tlv_posix_free_entries(btstack_tlv_posix_t * self){
+	uint32_t i;
+	for (i=0;i<self->num_buckets;i++){
+		tlv_entry_t * entry = (tlv_entry_t *) self->entry_buckets[i];
+		while (entry){
+			tlv_entry_t * next = entry->next;
+			free(entry);
+			entry = next;
+		}
+	}
+	free(self->entry_buckets);
+	self->entry_buckets = NULL;
+	self->num_buckets = 0;
+	self->num_entries = 0;
+	self->live_size = 0;
+}
+
+// file access
 
-	uint8_t header[8];
+// returns 0 on success
+static int btstack_tlv_posix_write_record(FILE * file, uint32_t tag, const uint8_t * data, uint32_t data_size){
+	uint8_t header[BTSTACK_TLV_RECORD_HEADER_LEN];
+	uint8_t crc[BTSTACK_TLV_RECORD_CRC_LEN];
 	big_endian_store_32(header, 0, tag);
 	big_endian_store_32(header, 4, data_size);
-	size_t written_header = fwrite(header, 1, sizeof(header), self->file);
+	big_endian_store_32(crc, 0, btstack_tlv_posix_record_crc(header, data, data_size));
+	size_t written_header = fwrite(header, 1, sizeof(header), file);
 	if (written_header != sizeof(header)) return 1;
-	size_t written_value = fwrite(data, 1, data_size, self->file);
-	if (written_value != data_size) return 1;
-	 fflush(self->file);
-	return 1;
+	if (data_size){
+		size_t written_value = fwrite(data, 1, data_size, file);
+		if (written_value != data_size) return 1;
+	}
+	size_t written_crc = fwrite(crc, 1, sizeof(crc), file);
+	if (written_crc != sizeof(crc)) return 1;
+	return 0;
 }
 
-static tlv_entry_t * btstack_tlv_posix_find_entry(btstack_tlv_posix_t * self, uint32_t tag){
-	btstack_linked_list_iterator_t it;
-	btstack_linked_list_iterator_init(&it, &self->entry_list);
-	while (btstack_linked_list_iterator_has_next(&it)){
-		tlv_entry_t * entry = (tlv_entry_t*) btstack_linked_list_iterator_next(&it);
-		if (entry->tag != tag) continue;
-		return entry;
+static void btstack_tlv_posix_sync(btstack_tlv_posix_t * self){
+	self->commit_pending = 0;
+	if (!self->file) return;
+	fflush(self->file);
+	fsync(fileno(self->file));
+}
+
+static void btstack_tlv_posix_commit_timer_handler(btstack_timer_source_t * ts){
+	btstack_tlv_posix_t * self = (btstack_tlv_posix_t *) btstack_run_loop_get_timer_context(ts);
+	btstack_tlv_posix_sync(self);
+}
+
+static void btstack_tlv_posix_commit(btstack_tlv_posix_t * self){
+	if (self->group_commit_ms == 0){
+		btstack_tlv_posix_sync(self);
+		return;
+	}
+	if (self->commit_pending) return;
+	self->commit_pending = 1;
+	btstack_run_loop_set_timer_handler(&self->commit_timer, &btstack_tlv_posix_commit_timer_handler);
+	btstack_run_loop_set_timer_context(&self->commit_timer, self);
+	btstack_run_loop_set_timer(&self->commit_timer, self->group_commit_ms);
+	btstack_run_loop_add_timer(&self->commit_timer);
+}
+
+static void btstack_tlv_posix_sync_directory(const char * path){
+	const char * last_slash = strrchr(path, '/');
+	int fd;
+	if (last_slash){
+		uint32_t dir_len = last_slash - path + 1;
+		char * dir_path = (char *) malloc(dir_len + 1);
+		if (!dir_path) return;
+		memcpy(dir_path, path, dir_len);
+		dir_path[dir_len] = 0;
+		fd = open(dir_path, O_RDONLY);
+		free(dir_path);
+	} else {
+		fd = open(".", O_RDONLY);
 	}
-	return NULL;
+	if (fd < 0) return;
+	fsync(fd);
+	close(fd);
+}
+
+int btstack_tlv_posix_compact(btstack_tlv_posix_t * self){
+	// write header and current values into temp file
+	uint32_t path_len = strlen(self->db_path);
+	char * temp_path = (char *) malloc(path_len + 5);
+	if (!temp_path) return 1;
+	memcpy(temp_path, self->db_path, path_len);
+	strcpy(&temp_path[path_len], ".tmp");
+
+	FILE * file = fopen(temp_path, "w+");
+	if (!file){
+		log_error("TLV: cannot create %s", temp_path);
+		free(temp_path);
+		return 1;
+	}
+	uint8_t header[BTSTACK_TLV_HEADER_LEN];
+	memset(header, 0, sizeof(header));
+	strcpy((char *)header, btstack_tlv_header_magic);
+	header[7] = BTSTACK_TLV_STATUS_CRC;
+	int err = fwrite(header, 1, sizeof(header), file) != sizeof(header);
+	uint32_t i;
+	for (i=0;i<self->num_buckets && !err;i++){
+		tlv_entry_t * entry = (tlv_entry_t *) self->entry_buckets[i];
+		for (; entry && !err ; entry = entry->next){
+			err = btstack_tlv_posix_write_record(file, entry->tag, &entry->value[0], entry->len);
+		}
+	}
+	if (!err){
+		err = fflush(file) != 0;
+	}
+	if (!err){
+		err = fsync(fileno(file)) != 0;
+	}
+	if (err){
+		log_error("TLV: writing %s failed", temp_path);
+		fclose(file);
+		unlink(temp_path);
+		free(temp_path);
+		return 1;
+	}
+
+	// replace db
+	if (rename(temp_path, self->db_path) != 0){
+		log_error("TLV: cannot replace %s", self->db_path);
+		fclose(file);
+		unlink(temp_path);
+		free(temp_path);
+		return 1;
+	}
+	btstack_tlv_posix_sync_directory(self->db_path);
+	free(temp_path);
+
+	// continue with new file
+	if (self->file){
+		fclose(self->file);
+	}
+	self->file = file;
+	self->file_size = BTSTACK_TLV_HEADER_LEN + self->live_size;
+	if (self->commit_pending){
+		btstack_run_loop_remove_timer(&self->commit_timer);
+		self->commit_pending = 0;
+	}
+	log_info("TLV: compacted %s, %u entries, %u bytes", self->db_path, self->num_entries, self->file_size);
+	return 0;
+}
+
+static int btstack_tlv_posix_compaction_needed(btstack_tlv_posix_t * self){
+	if (self->file_size < BTSTACK_TLV_POSIX_COMPACTION_MIN_FILE_SIZE) return 0;
+	return (self->file_size - BTSTACK_TLV_HEADER_LEN - self->live_size) > self->live_size;
+}
+
+static int btstack_tlv_posix_append_tag(btstack_tlv_posix_t * self, uint32_t tag, const uint8_t * data, uint32_t data_size){
+
+	if (!self->file) return 1;
+
+	log_info("append tag %04x, len %u", tag, data_size);
+
+	int err = btstack_tlv_posix_write_record(self->file, tag, data, data_size);
+	if (err) return 1;
+	self->file_size += btstack_tlv_posix_record_size(data_size);
+
+	if (btstack_tlv_posix_compaction_needed(self)){
+		if (btstack_tlv_posix_compact(self) == 0) return 0;
+	}
+	btstack_tlv_posix_commit(self);
+	return 0;
 }
 
 /**
@@ -98,15 +371,9 @@ static tlv_entry_t * btstack_tlv_posix_find_entry(btstack_tlv_posix_t * self, ui
  */
 static void btstack_tlv_posix_delete_tag(void * context, uint32_t tag){
 	btstack_tlv_posix_t * self = (btstack_tlv_posix_t *) context;
-	btstack_linked_list_iterator_t it;
-	btstack_linked_list_iterator_init(&it, &self->entry_list);
-	while (btstack_linked_list_iterator_has_next(&it)){
-		tlv_entry_t * entry = (tlv_entry_t*) btstack_linked_list_iterator_next(&it);
-		if (entry->tag != tag) continue;
-		btstack_linked_list_iterator_remove(&it);
-		btstack_tlv_posix_append_tag(self, tag, NULL, 0);
-		return;
-	}
+	if (!btstack_tlv_posix_find_entry(self, tag)) return;
+	btstack_tlv_posix_index_remove(self, tag);
+	btstack_tlv_posix_append_tag(self, tag, NULL, 0);
 }
 
 /**
@@ -138,29 +405,80 @@ static int btstack_tlv_posix_get_tag(void * context, uint32_t tag, uint8_t * buf
 static int btstack_tlv_posix_store_tag(void * context, uint32_t tag, const uint8_t * data, uint32_t data_size){
 	btstack_tlv_posix_t * self = (btstack_tlv_posix_t *) context;
 
-	// remove old entry
-	tlv_entry_t * old_entry = btstack_tlv_posix_find_entry(self, tag);
-	if (old_entry){
-		btstack_linked_list_remove(&self->entry_list, (btstack_linked_item_t *) old_entry);
-		free(old_entry);
+	if (!self->entry_buckets) return 1;
+
+	// deleted tags are stored with len 0
+	if (data_size == 0){
+		btstack_tlv_posix_delete_tag(context, tag);
+		return 0;
+	}
+
+	if (data_size > BTSTACK_TLV_MAX_VALUE_LEN){
+		log_error("TLV: value too large, tag %04x, len %u", tag, data_size);
+		return 1;
 	}
 
+	// skip write if value didn't change
+	tlv_entry_t * old_entry = btstack_tlv_posix_find_entry(self, tag);
+	if (old_entry && (old_entry->len == data_size) && (memcmp(&old_entry->value[0], data, data_size) == 0)) return 0;
+
 	// create new entry
-	uint32_t entry_size = sizeof(tlv_entry_t) - DUMMY_SIZE + data_size;
-	tlv_entry_t * new_entry = (tlv_entry_t *) malloc(entry_size);
-	if (!new_entry) return 0;
-	memset(new_entry, 0, entry_size);
-	new_entry->tag = tag;
-	new_entry->len = data_size;
-	memcpy(&new_entry->value[0], data, data_size);
+	tlv_entry_t * new_entry = btstack_tlv_posix_create_entry(tag, data, data_size);
+	if (!new_entry) return 1;
 
-	// append new entry
-	btstack_linked_list_add(&self->entry_list, (btstack_linked_item_t *) new_entry);
+	// replace old entry
+	btstack_tlv_posix_index_put(self, new_entry);
 
 	// write new tag
-	btstack_tlv_posix_append_tag(self, tag, data, data_size);
+	return btstack_tlv_posix_append_tag(self, tag, data, data_size);
+}
 
-	return 0;
+// read records after header, returns 0 if complete file is valid
+static int btstack_tlv_posix_read_records(btstack_tlv_posix_t * self, int with_crc){
+	uint8_t value[BTSTACK_TLV_MAX_VALUE_LEN];
+	while (1){
+		uint8_t header[BTSTACK_TLV_RECORD_HEADER_LEN];
+		size_t 	header_read = fread(header, 1, sizeof(header), self->file);
+		if (header_read == 0){
+			// EOF, we're good
+			return 0;
+		}
+		if (header_read != sizeof(header)) return 1;
+		uint32_t tag = big_endian_read_32(header, 0);
+		uint32_t len = big_endian_read_32(header, 4);
+		if (len > BTSTACK_TLV_MAX_VALUE_LEN) return 1;
+		size_t value_read = fread(value, 1, len, self->file);
+		if (value_read != len) return 1;
+		uint32_t record_size = BTSTACK_TLV_RECORD_HEADER_LEN + len;
+		if (with_crc){
+			uint8_t crc[BTSTACK_TLV_RECORD_CRC_LEN];
+			size_t crc_read = fread(crc, 1, sizeof(crc), self->file);
+			if (crc_read != sizeof(crc)) return 1;
+			if (big_endian_read_32(crc, 0) != btstack_tlv_posix_record_crc(header, value, len)){
+				log_error("TLV: CRC error for tag %04x", tag);
+				return 1;
+			}
+			record_size += BTSTACK_TLV_RECORD_CRC_LEN;
+		}
+		self->file_size += record_size;
+
+		// deleted tag
+		if (len == 0){
+			btstack_tlv_posix_index_remove(self, tag);
+			continue;
+		}
+
+		// same size: update value in place
+		tlv_entry_t * entry = btstack_tlv_posix_find_entry(self, tag);
+		if (entry && entry->len == len){
+			memcpy(&entry->value[0], value, len);
+			continue;
+		}
+
+		entry = btstack_tlv_posix_create_entry(tag, value, len);
+		if (!entry) return 1;
+		btstack_tlv_posix_index_put(self, entry);
+	}
 }
 
 // returns 0 on success
@@ -168,66 +486,32 @@ static int btstack_tlv_posix_read_db(btstack_tlv_posix_t * self){
 	// open file
 	log_info("open db %s", self->db_path);
     self->file = fopen(self->db_path,"r+");
-    uint8_t header[BTSTACK_TLV_HEADER_LEN];
+    int file_valid = 0;
+    int with_crc = 0;
     if (self->file){
     	// checker header
+    	uint8_t header[BTSTACK_TLV_HEADER_LEN];
 	    size_t objects_read = fread(header, 1, BTSTACK_TLV_HEADER_LEN, self->file );
-	    int file_valid = 0;
 	    if (objects_read == BTSTACK_TLV_HEADER_LEN){
 	    	if (memcmp(header, btstack_tlv_header_magic, strlen(btstack_tlv_header_magic)) == 0){
 		    	log_info("BTstack Magic Header found");
+		    	with_crc = (header[7] & BTSTACK_TLV_STATUS_CRC) != 0;
+		    	self->file_size = BTSTACK_TLV_HEADER_LEN;
 		    	// read entries
-		    	while (1){
-					uint8_t entry[8];
-					size_t 	entries_read = fread(entry, 1, sizeof(entry), self->file);
-					if (entries_read == 0){
-						// EOF, we're good
-						file_valid = 1;
-						break;
-					}
-					if (entries_read == sizeof(entry)){
-						uint32_t tag = big_endian_read_32(entry, 0);
-						uint32_t len = big_endian_read_32(entry, 4);
-						// arbitrary safetly check: values < 1000 bytes each
-						if (len > 1000) break;
-						tlv_entry_t * new_entry = (tlv_entry_t *) malloc(sizeof(tlv_entry_t) - DUMMY_SIZE + len);
-						if (!new_entry) return 0;
-						new_entry->tag = tag;
-						new_entry->len = len;
-						// read 
-						size_t 	value_read = fread(&new_entry->value[0], 1, len, self->file);
-						if (value_read == len){
-							// append new entry
-							btstack_linked_list_add(&self->entry_list, (btstack_linked_item_t *) new_entry);
-						} else {
-							// fail
-							free(new_entry);
-							break;
-						}
-					}	    		
-		    	}
+		    	file_valid = btstack_tlv_posix_read_records(self, with_crc) == 0;
 	    	}
 	    }
+	    log_info("%u entries, %u of %u bytes used", self->num_entries, self->live_size, self->file_size);
 	    if (!file_valid) {
 	    	log_info("file invalid, re-create");
-    		fclose(self->file);
-    		self->file = NULL;
 	    }
     }
-    if (!self->file){
-    	// create truncate file
-	    self->file = fopen(self->db_path,"w+");
-	    memset(header, 0, sizeof(header));
-	    strcpy((char *)header, btstack_tlv_header_magic);
-	    fwrite(header, 1, sizeof(header), self->file);
-	    // write out all valid entries (if any)
-		btstack_linked_list_iterator_t it;
-		btstack_linked_list_iterator_init(&it, &self->entry_list);
-		while (btstack_linked_list_iterator_has_next(&it)){
-			tlv_entry_t * entry = (tlv_entry_t*) btstack_linked_list_iterator_next(&it);
-			btstack_tlv_posix_append_tag(self, entry->tag, &entry->value[0], entry->len);
-		}
+    // create new file with valid entries (if any) if file was missing, invalid, without CRC, or mostly outdated
+    if (!file_valid || !with_crc || btstack_tlv_posix_compaction_needed(self)){
+    	return btstack_tlv_posix_compact(self);
     }
+    // append at end of file
+    fseek(self->file, 0, SEEK_END);
 	return 0;
 }
 
@@ -244,8 +528,33 @@ const btstack_tlv_t * btstack_tlv_posix_init_instance(btstack_tlv_posix_t * self
 	memset(self, 0, sizeof(btstack_tlv_posix_t));
 	self->db_path = db_path;
 
+	if (btstack_tlv_posix_resize_index(self, BTSTACK_TLV_INITIAL_BUCKETS)){
+		log_error("TLV: cannot allocate index");
+	}
+
 	// read DB
 	btstack_tlv_posix_read_db(self);
 	return &btstack_tlv_posix;
 }
 
+void btstack_tlv_posix_set_group_commit(btstack_tlv_posix_t * self, uint32_t delay_ms){
+	self->group_commit_ms = delay_ms;
+	if (delay_ms == 0){
+		btstack_tlv_posix_flush(self);
+	}
+}
+
+void btstack_tlv_posix_flush(btstack_tlv_posix_t * self){
+	if (!self->commit_pending) return;
+	btstack_run_loop_remove_timer(&self->commit_timer);
+	btstack_tlv_posix_sync(self);
+}
+
+void btstack_tlv_posix_deinit(btstack_tlv_posix_t * self){
+	btstack_tlv_posix_flush(self);
+	if (self->file){
+		fclose(self->file);
+		self->file = NULL;
+	}
+	btstack_tlv_posix_free_entries(self);
+}
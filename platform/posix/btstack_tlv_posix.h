@@ -42,25 +42,64 @@
 #include <stdint.h>
 #include <stdio.h>
 #include "btstack_tlv.h"
-#include "btstack_linked_list.h"
+#include "btstack_run_loop.h"
 
 #if defined __cplusplus
 extern "C" {
 #endif
 
 typedef struct {
-	btstack_linked_list_t entry_list;
+	// hash index of current values
+	void  ** entry_buckets;
+	uint32_t num_buckets;
+	uint32_t num_entries;
 	const char * db_path;
 	FILE * file;
+	// size of file and size of records for current values, used to trigger compaction
+	uint32_t file_size;
+	uint32_t live_size;
+	// group commit
+	uint32_t group_commit_ms;
+	int      commit_pending;
+	btstack_timer_source_t commit_timer;
 } btstack_tlv_posix_t;
 
 /**
  * Init Tag Length Value Store
+ * @note Records are protected by CRC-32. Files from earlier versions are converted on first use.
+ *       File is compacted when more than half of it contains outdated values
  * @param context btstack_tlv_posix_t 
  * @param db_path on disc
  */
 const btstack_tlv_t * btstack_tlv_posix_init_instance(btstack_tlv_posix_t * context, const char * db_path);
 
+/**
+ * Enable group commit: writes within delay are flushed and synced to disc together
+ * @note requires run loop, default: 0 = each write is flushed and synced before store_tag returns
+ * @param context btstack_tlv_posix_t
+ * @param delay_ms
+ */
+void btstack_tlv_posix_set_group_commit(btstack_tlv_posix_t * context, uint32_t delay_ms);
+
+/**
+ * Flush and sync pending writes to disc
+ * @param context btstack_tlv_posix_t
+ */
+void btstack_tlv_posix_flush(btstack_tlv_posix_t * context);
+
+/**
+ * Rewrite file with current values only. File is replaced atomically
+ * @param context btstack_tlv_posix_t
+ * @returns 0 on success
+ */
+int btstack_tlv_posix_compact(btstack_tlv_posix_t * context);
+
+/**
+ * Flush pending writes, close file and free all entries
+ * @param context btstack_tlv_posix_t
+ */
+void btstack_tlv_posix_deinit(btstack_tlv_posix_t * context);
+
 #if defined __cplusplus
 }
 #endif
@@ -53,6 +53,7 @@
 #include <unistd.h>   /* UNIX standard function definitions */
 #include <string.h>
 #include <errno.h>
+#include <sys/uio.h>  /* writev */
 #ifdef __APPLE__
 #include <sys/ioctl.h>
 #include <IOKit/serial/ioss.h>
@@ -64,17 +65,27 @@ static const btstack_uart_config_t * uart_config;
 // data source for integration with BTstack Runloop
 static btstack_data_source_t transport_data_source;
 
-// block write
+// max number of segments for send_block_iov
+#ifndef BTSTACK_UART_POSIX_IOV_MAX
+#define BTSTACK_UART_POSIX_IOV_MAX 8
+#endif
+
+// block write, single block uses first segment
 static int             write_bytes_len;
-static const uint8_t * write_bytes_data;
+static struct iovec    write_iov[BTSTACK_UART_POSIX_IOV_MAX];
+static int             write_iov_pos;
+static int             write_iov_count;
+static int             write_dropped;
 
 // block read
 static uint16_t  read_bytes_len;
 static uint8_t * read_bytes_data;
+static int       read_available;
 
 // callbacks
 static void (*block_sent)(void);
 static void (*block_received)(void);
+static void (*data_received)(uint16_t len);
 
 
 static int btstack_uart_posix_init(const btstack_uart_config_t * config){
@@ -84,12 +95,22 @@ static int btstack_uart_posix_init(const btstack_uart_config_t * config){
 
 static void btstack_uart_posix_process_write(btstack_data_source_t *ds) {
     
+    // block that could not be sent is reported as done, so that the transport does not wait forever
+    if (write_dropped){
+        write_dropped = 0;
+        btstack_run_loop_disable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_WRITE);
+        if (block_sent){
+            block_sent();
+        }
+        return;
+    }
+
     if (write_bytes_len == 0) return;
 
     uint32_t start = btstack_run_loop_get_time_ms();
 
-    // write up to write_bytes_len to fd
-    int bytes_written = (int) write(ds->source.fd, write_bytes_data, write_bytes_len);
+    // write up to write_bytes_len to fd, gathered from remaining segments
+    int bytes_written = (int) writev(ds->source.fd, &write_iov[write_iov_pos], write_iov_count - write_iov_pos);
     uint32_t end = btstack_run_loop_get_time_ms();
     if (end - start > 10){
         log_info("write took %u ms", end - start);
@@ -104,8 +125,19 @@ static void btstack_uart_posix_process_write(btstack_data_source_t *ds) {
         return;
     }
 
-    write_bytes_data += bytes_written;
-    write_bytes_len  -= bytes_written;
+    write_bytes_len -= bytes_written;
+
+    // skip fully written segments and adjust partially written one
+    while (bytes_written > 0){
+        struct iovec * iov = &write_iov[write_iov_pos];
+        if ((size_t) bytes_written < iov->iov_len){
+            iov->iov_base = ((uint8_t *) iov->iov_base) + bytes_written;
+            iov->iov_len -= bytes_written;
+            break;
+        }
+        bytes_written -= iov->iov_len;
+        write_iov_pos++;
+    }
 
     if (write_bytes_len){
         btstack_run_loop_enable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_WRITE);
@@ -145,6 +177,16 @@ static void btstack_uart_posix_process_read(btstack_data_source_t *ds) {
         return;
     }
 
+    // streaming receive: report whatever has been read
+    if (read_available){
+        read_bytes_len = 0;
+        btstack_run_loop_disable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_READ);
+        if (data_received){
+            data_received((uint16_t) bytes_read);
+        }
+        return;
+    }
+
     read_bytes_len   -= bytes_read;
     read_bytes_data  += bytes_read;
     if (read_bytes_len > 0) return;
@@ -380,25 +422,63 @@ static void btstack_uart_posix_set_block_sent( void (*block_handler)(void)){
     block_sent = block_handler;
 }
 
+static void btstack_uart_posix_set_data_received( void (*data_handler)(uint16_t len)){
+    data_received = data_handler;
+}
+
 static void btstack_uart_posix_send_block(const uint8_t *data, uint16_t size){
     // setup async write
-    write_bytes_data = data;
-    write_bytes_len  = size;
+    write_iov[0].iov_base = (void *) data;
+    write_iov[0].iov_len  = size;
+    write_iov_pos   = 0;
+    write_iov_count = 1;
+    write_bytes_len = size;
 
     // go
     // btstack_uart_posix_process_write(&transport_data_source);
     btstack_run_loop_enable_data_source_callbacks(&transport_data_source, DATA_SOURCE_CALLBACK_WRITE);
 }
 
+static void btstack_uart_posix_send_block_iov(const btstack_iovec_t * iov, int iovcnt){
+    if (iovcnt > BTSTACK_UART_POSIX_IOV_MAX){
+        log_error("send_block_iov: %u segments > BTSTACK_UART_POSIX_IOV_MAX, block dropped", iovcnt);
+        write_bytes_len = 0;
+        write_dropped = 1;
+        btstack_run_loop_enable_data_source_callbacks(&transport_data_source, DATA_SOURCE_CALLBACK_WRITE);
+        return;
+    }
+    // setup async write
+    write_bytes_len = 0;
+    int i;
+    for (i = 0; i < iovcnt; i++){
+        write_iov[i].iov_base = (void *) iov[i].data;
+        write_iov[i].iov_len  = iov[i].len;
+        write_bytes_len += iov[i].len;
+    }
+    write_iov_pos   = 0;
+    write_iov_count = iovcnt;
+
+    // go
+    btstack_run_loop_enable_data_source_callbacks(&transport_data_source, DATA_SOURCE_CALLBACK_WRITE);
+}
+
 static void btstack_uart_posix_receive_block(uint8_t *buffer, uint16_t len){
     read_bytes_data = buffer;
     read_bytes_len = len;
+    read_available = 0;
     btstack_run_loop_enable_data_source_callbacks(&transport_data_source, DATA_SOURCE_CALLBACK_READ);
 
     // go
     // btstack_uart_posix_process_read(&transport_data_source);
 }
 
+static void btstack_uart_posix_receive_available(uint8_t *buffer, uint16_t max_len){
+    read_bytes_data = buffer;
+    read_bytes_len = max_len;
+    read_available = 1;
+    btstack_run_loop_enable_data_source_callbacks(&transport_data_source, DATA_SOURCE_CALLBACK_READ);
+}
+
 // static void btstack_uart_posix_set_sleep(uint8_t sleep){
 // }
 // static void btstack_uart_posix_set_csr_irq_handler( void (*csr_irq_handler)(void)){
@@ -418,6 +498,9 @@ static const btstack_uart_block_t btstack_uart_posix = {
     /* int (*get_supported_sleep_modes); */                           NULL,
     /* void (*set_sleep)(btstack_uart_sleep_mode_t sleep_mode); */    NULL,
     /* void (*set_wakeup_handler)(void (*handler)(void)); */          NULL,
+    /* void (*receive_available)(uint8_t *buffer, uint16_t max_len); */ &btstack_uart_posix_receive_available,
+    /* void (*set_data_received)(void (*handler)(uint16_t len)); */   &btstack_uart_posix_set_data_received,
+    /* void (*send_block_iov)(const btstack_iovec_t * iov, int iovcnt); */ &btstack_uart_posix_send_block_iov,
 };
 
 const btstack_uart_block_t * btstack_uart_block_posix_instance(void){
@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY MATTHIAS RINGWALD AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#define __BTSTACK_FILE__ "hci_dump_reader_posix.c"
+
+/*
+ *  hci_dump_reader_posix.c
+ *
+ *  Read packet logs in Apple PacketLogger or BlueZ hcidump format
+ */
+
+#include "hci_dump_reader_posix.h"
+
+#include "bluetooth.h"
+#include "btstack_debug.h"
+#include "btstack_defines.h"
+#include "btstack_util.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define HCIDUMP_HDR_SIZE 13
+#define PKTLOG_HDR_SIZE  13
+
+// number of records checked to detect format
+#define HCI_DUMP_READER_DETECT_RECORDS 8
+
+// PacketLogger record type to packet type and direction
+static int hci_dump_reader_packetlogger_type(uint8_t type, uint8_t * packet_type, uint8_t * in){
+    switch (type){
+        case 0x00:
+            *packet_type = HCI_COMMAND_DATA_PACKET;
+            *in = 0;
+            return 1;
+        case 0x01:
+            *packet_type = HCI_EVENT_PACKET;
+            *in = 1;
+            return 1;
+        case 0x02:
+        case 0x03:
+            *packet_type = HCI_ACL_DATA_PACKET;
+            *in = type & 1;
+            return 1;
+        case 0x08:
+        case 0x09:
+            *packet_type = HCI_SCO_DATA_PACKET;
+            *in = type & 1;
+            return 1;
+        case 0xfc:
+            *packet_type = LOG_MESSAGE_PACKET;
+            *in = 0;
+            return 1;
+        default:
+            // other PacketLogger notes
+            *packet_type = 0;
+            *in = 0;
+            return 0;
+    }
+}
+
+// parse record at pos, returns record size or 0 if record is invalid or incomplete
+static uint32_t hci_dump_reader_parse(uint8_t * data, size_t size, size_t pos, hci_dump_format_t format, hci_dump_record_t * record){
+    if ((size - pos) < HCIDUMP_HDR_SIZE) return 0;
+    uint8_t * header = &data[pos];
+    uint32_t record_size;
+    switch (format){
+        case HCI_DUMP_PACKETLOGGER:
+            record_size = 4 + big_endian_read_32(header, 0);
+            if (record_size < PKTLOG_HDR_SIZE) return 0;
+            if (record_size > (PKTLOG_HDR_SIZE + 0xffff)) return 0;
+            record->ts_sec  = big_endian_read_32(header, 4);
+            record->ts_usec = big_endian_read_32(header, 8);
+            hci_dump_reader_packetlogger_type(header[12], &record->packet_type, &record->in);
+            break;
+        case HCI_DUMP_BLUEZ:
+            record_size = HCIDUMP_HDR_SIZE - 1 + little_endian_read_16(header, 0);
+            if (record_size < HCIDUMP_HDR_SIZE) return 0;
+            record->in      = header[2];
+            record->ts_sec  = little_endian_read_32(header, 4);
+            record->ts_usec = little_endian_read_32(header, 8);
+            record->packet_type = header[12];
+            break;
+        default:
+            return 0;
+    }
+    if (record_size > (size - pos)) return 0;
+    record->packet = &header[HCIDUMP_HDR_SIZE];
+    record->size   = (uint16_t) (record_size - HCIDUMP_HDR_SIZE);
+    return record_size;
+}
+
+// check that first records are well-formed
+static int hci_dump_reader_format_valid(uint8_t * data, size_t size, hci_dump_format_t format){
+    size_t pos = 0;
+    int i;
+    for (i = 0; i < HCI_DUMP_READER_DETECT_RECORDS && pos < size; i++){
+        hci_dump_record_t record;
+        uint32_t record_size = hci_dump_reader_parse(data, size, pos, format, &record);
+        if (record_size == 0){
+            // incomplete last record, e.g. log file was not closed, is ok
+            if (i == 0) return 0;
+            if ((size - pos) < HCIDUMP_HDR_SIZE) return 1;
+            uint32_t declared_size;
+            if (format == HCI_DUMP_PACKETLOGGER){
+                declared_size = 4 + big_endian_read_32(data, pos);
+            } else {
+                declared_size = HCIDUMP_HDR_SIZE - 1 + little_endian_read_16(data, pos);
+            }
+            return declared_size > (size - pos);
+        }
+        if (format == HCI_DUMP_PACKETLOGGER){
+            uint8_t packet_type;
+            uint8_t in;
+            if (!hci_dump_reader_packetlogger_type(data[pos + 12], &packet_type, &in)) return 0;
+        } else {
+            if (data[pos + 2] > 1) return 0;
+            if (data[pos + 3] != 0) return 0;
+            switch (record.packet_type){
+                case HCI_COMMAND_DATA_PACKET:
+                case HCI_ACL_DATA_PACKET:
+                case HCI_SCO_DATA_PACKET:
+                case HCI_EVENT_PACKET:
+                case LOG_MESSAGE_PACKET:
+                    break;
+                default:
+                    return 0;
+            }
+        }
+        pos += record_size;
+    }
+    return 1;
+}
+
+int hci_dump_reader_posix_open(hci_dump_reader_posix_t * reader, const char * path){
+    memset(reader, 0, sizeof(hci_dump_reader_posix_t));
+    reader->format = HCI_DUMP_PACKETLOGGER;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0){
+        log_error("hci_dump_reader: cannot open %s", path);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0){
+        close(fd);
+        return -1;
+    }
+    reader->size = (size_t) st.st_size;
+    if (reader->size == 0){
+        close(fd);
+        return 0;
+    }
+    // private writable mapping: packets can be passed to HCI layers that modify them in place
+    void * data = mmap(NULL, reader->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    // mapping stays valid after close
+    close(fd);
+    if (data == MAP_FAILED){
+        log_error("hci_dump_reader: cannot map %s", path);
+        reader->size = 0;
+        return -1;
+    }
+    reader->data = (uint8_t *) data;
+#ifdef MADV_SEQUENTIAL
+    madvise(data, reader->size, MADV_SEQUENTIAL);
+#endif
+
+    if (hci_dump_reader_format_valid(reader->data, reader->size, HCI_DUMP_PACKETLOGGER)){
+        reader->format = HCI_DUMP_PACKETLOGGER;
+    } else if (hci_dump_reader_format_valid(reader->data, reader->size, HCI_DUMP_BLUEZ)){
+        reader->format = HCI_DUMP_BLUEZ;
+    } else {
+        log_error("hci_dump_reader: unknown format %s", path);
+        hci_dump_reader_posix_close(reader);
+        return -1;
+    }
+    return 0;
+}
+
+hci_dump_format_t hci_dump_reader_posix_get_format(hci_dump_reader_posix_t * reader){
+    return reader->format;
+}
+
+int hci_dump_reader_posix_next(hci_dump_reader_posix_t * reader, hci_dump_record_t * record){
+    if (reader->pos >= reader->size) return 0;
+    uint32_t record_size = hci_dump_reader_parse(reader->data, reader->size, reader->pos, reader->format, record);
+    if (record_size == 0){
+        log_info("hci_dump_reader: incomplete record at offset %u", (unsigned int) reader->pos);
+        reader->pos = reader->size;
+        return 0;
+    }
+    reader->pos += record_size;
+    return 1;
+}
+
+void hci_dump_reader_posix_rewind(hci_dump_reader_posix_t * reader){
+    reader->pos = 0;
+}
+
+void hci_dump_reader_posix_close(hci_dump_reader_posix_t * reader){
+    if (reader->data != NULL){
+        munmap((void *) reader->data, reader->size);
+    }
+    reader->data = NULL;
+    reader->size = 0;
+    reader->pos  = 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY MATTHIAS RINGWALD AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ *  hci_dump_reader_posix.h
+ *
+ *  Read packet logs in Apple PacketLogger or BlueZ hcidump format as written by hci_dump.
+ *  The file is memory mapped copy-on-write and records point directly into the mapping.
+ */
+
+#ifndef __HCI_DUMP_READER_POSIX_H
+#define __HCI_DUMP_READER_POSIX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "hci_dump.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    // HCI_COMMAND_DATA_PACKET, HCI_EVENT_PACKET, HCI_ACL_DATA_PACKET, HCI_SCO_DATA_PACKET, LOG_MESSAGE_PACKET, or 0 for other records
+    uint8_t  packet_type;
+    // 1 for Controller to Host
+    uint8_t  in;
+    uint32_t ts_sec;
+    uint32_t ts_usec;
+    // points into mapped file, valid until hci_dump_reader_posix_close. Changes are not written back
+    uint8_t * packet;
+    uint16_t size;
+} hci_dump_record_t;
+
+typedef struct {
+    uint8_t * data;
+    size_t size;
+    size_t pos;
+    hci_dump_format_t format;
+} hci_dump_reader_posix_t;
+
+/* API_START */
+
+/**
+ * @brief Map packet log and detect format
+ * @param reader
+ * @param path
+ * @return 0 on success
+ */
+int hci_dump_reader_posix_open(hci_dump_reader_posix_t * reader, const char * path);
+
+/**
+ * @brief Get format of opened packet log
+ * @param reader
+ * @return HCI_DUMP_PACKETLOGGER or HCI_DUMP_BLUEZ
+ */
+hci_dump_format_t hci_dump_reader_posix_get_format(hci_dump_reader_posix_t * reader);
+
+/**
+ * @brief Get next record
+ * @param reader
+ * @param record
+ * @return 1 if record was read, 0 at end of file or if the last record is incomplete
+ */
+int hci_dump_reader_posix_next(hci_dump_reader_posix_t * reader, hci_dump_record_t * record);
+
+/**
+ * @brief Continue with first record
+ * @param reader
+ */
+void hci_dump_reader_posix_rewind(hci_dump_reader_posix_t * reader);
+
+/**
+ * @brief Unmap packet log
+ * @param reader
+ */
+void hci_dump_reader_posix_close(hci_dump_reader_posix_t * reader);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // __HCI_DUMP_READER_POSIX_H
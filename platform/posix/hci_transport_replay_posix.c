@@ -0,0 +1,276 @@
+/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY MATTHIAS RINGWALD AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#define __BTSTACK_FILE__ "hci_transport_replay_posix.c"
+
+/*
+ *  hci_transport_replay_posix.c
+ *
+ *  HCI Transport that replays Controller to Host packets from a packet log
+ */
+
+#include "hci_transport_replay_posix.h"
+
+#include "bluetooth.h"
+#include "btstack_debug.h"
+#include "btstack_defines.h"
+#include "btstack_run_loop.h"
+
+#include <string.h>
+
+// packets delivered per run loop iteration in fast mode
+#define HCI_TRANSPORT_REPLAY_BATCH 32
+
+// deliver Command Complete / Status anyway if host doesn't send the command
+#define HCI_TRANSPORT_REPLAY_COMMAND_TIMEOUT_MS 1000
+
+static hci_dump_reader_posix_t * replay_reader;
+static int replay_timing_accurate;
+static void (*replay_packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
+static void (*replay_done_handler)(void);
+static btstack_timer_source_t replay_timer;
+
+// next Controller to Host record
+static hci_dump_record_t replay_record;
+static int      replay_record_valid;
+static int      replay_active;
+static int      replay_waiting_for_command;
+
+// HCI Commands in packet log before next record
+static uint32_t replay_log_commands;
+
+// time base for timing accurate replay and duration
+static int      replay_time_base_valid;
+static uint64_t replay_log_start_us;
+static uint64_t replay_start_us;
+
+static hci_transport_replay_posix_stats_t replay_stats;
+
+static uint64_t hci_transport_replay_record_time_us(const hci_dump_record_t * record){
+    return ((uint64_t) record->ts_sec) * 1000000 + record->ts_usec;
+}
+
+// read ahead to next Controller to Host packet, count HCI Commands in between
+static int hci_transport_replay_fetch_record(void){
+    while (hci_dump_reader_posix_next(replay_reader, &replay_record)){
+        switch (replay_record.packet_type){
+            case HCI_COMMAND_DATA_PACKET:
+                replay_log_commands++;
+                break;
+            case HCI_EVENT_PACKET:
+            case HCI_ACL_DATA_PACKET:
+            case HCI_SCO_DATA_PACKET:
+                if (replay_record.in) return 1;
+                break;
+            default:
+                break;
+        }
+    }
+    return 0;
+}
+
+static int hci_transport_replay_waits_for_command(void){
+    if (replay_record.packet_type != HCI_EVENT_PACKET) return 0;
+    if (replay_record.size < 1) return 0;
+    switch (replay_record.packet[0]){
+        case HCI_EVENT_COMMAND_COMPLETE:
+        case HCI_EVENT_COMMAND_STATUS:
+            return replay_stats.num_host_commands < replay_log_commands;
+        default:
+            return 0;
+    }
+}
+
+static void hci_transport_replay_deliver(void){
+    switch (replay_record.packet_type){
+        case HCI_EVENT_PACKET:
+            replay_stats.num_events++;
+            break;
+        case HCI_ACL_DATA_PACKET:
+            replay_stats.num_acl_packets++;
+            break;
+        default:
+            replay_stats.num_sco_packets++;
+            break;
+    }
+    replay_stats.num_bytes += replay_record.size;
+    replay_stats.duration_us = btstack_run_loop_get_time_us() - replay_start_us;
+    replay_record_valid = 0;
+    (*replay_packet_handler)(replay_record.packet_type, replay_record.packet, replay_record.size);
+}
+
+static void hci_transport_replay_schedule(uint32_t timeout_us){
+    btstack_run_loop_remove_timer(&replay_timer);
+    btstack_run_loop_set_timer_us(&replay_timer, timeout_us);
+    btstack_run_loop_add_timer(&replay_timer);
+}
+
+static void hci_transport_replay_timer_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    int num_delivered = 0;
+    while (replay_active){
+        if (!replay_record_valid){
+            replay_record_valid = hci_transport_replay_fetch_record();
+            if (!replay_record_valid){
+                replay_active = 0;
+                log_info("hci_transport_replay: done");
+                if (replay_done_handler){
+                    (*replay_done_handler)();
+                }
+                return;
+            }
+            if (!replay_time_base_valid){
+                replay_time_base_valid = 1;
+                replay_start_us = btstack_run_loop_get_time_us();
+                replay_log_start_us = hci_transport_replay_record_time_us(&replay_record);
+            }
+        }
+
+        if (hci_transport_replay_waits_for_command()){
+            if (replay_waiting_for_command){
+                // timeout
+                replay_stats.num_command_timeouts++;
+            } else {
+                replay_waiting_for_command = 1;
+                hci_transport_replay_schedule(HCI_TRANSPORT_REPLAY_COMMAND_TIMEOUT_MS * 1000);
+                return;
+            }
+        }
+        replay_waiting_for_command = 0;
+
+        if (replay_timing_accurate){
+            uint64_t due_us = replay_start_us + (hci_transport_replay_record_time_us(&replay_record) - replay_log_start_us);
+            uint64_t now_us = btstack_run_loop_get_time_us();
+            if (due_us > now_us){
+                hci_transport_replay_schedule((uint32_t) (due_us - now_us));
+                return;
+            }
+        }
+
+        if (!replay_timing_accurate && num_delivered == HCI_TRANSPORT_REPLAY_BATCH){
+            // let run loop process other timers and data sources
+            hci_transport_replay_schedule(0);
+            return;
+        }
+
+        hci_transport_replay_deliver();
+        num_delivered++;
+    }
+}
+
+static void hci_transport_replay_init(const void * transport_config){
+    UNUSED(transport_config);
+    memset(&replay_stats, 0, sizeof(replay_stats));
+}
+
+static int hci_transport_replay_open(void){
+    hci_dump_reader_posix_rewind(replay_reader);
+    memset(&replay_stats, 0, sizeof(replay_stats));
+    replay_log_commands = 0;
+    replay_record_valid = 0;
+    replay_waiting_for_command = 0;
+    replay_time_base_valid = 0;
+    replay_active = 1;
+    btstack_run_loop_set_timer_handler(&replay_timer, &hci_transport_replay_timer_handler);
+    hci_transport_replay_schedule(0);
+    return 0;
+}
+
+static int hci_transport_replay_close(void){
+    replay_active = 0;
+    btstack_run_loop_remove_timer(&replay_timer);
+    return 0;
+}
+
+static void hci_transport_replay_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    replay_packet_handler = handler;
+}
+
+static int hci_transport_replay_send_packet(uint8_t packet_type, uint8_t * packet, int size){
+    UNUSED(packet);
+    UNUSED(size);
+    switch (packet_type){
+        case HCI_COMMAND_DATA_PACKET:
+            replay_stats.num_host_commands++;
+            // continue without waiting for timeout
+            if (replay_waiting_for_command && !hci_transport_replay_waits_for_command()){
+                hci_transport_replay_schedule(0);
+            }
+            break;
+        case HCI_ACL_DATA_PACKET:
+            replay_stats.num_host_acl_packets++;
+            break;
+        case HCI_SCO_DATA_PACKET:
+            replay_stats.num_host_sco_packets++;
+            break;
+        default:
+            break;
+    }
+    return 0;
+}
+
+static int hci_transport_replay_send_packet_iov(uint8_t packet_type, const btstack_iovec_t * iov, int iovcnt){
+    UNUSED(iov);
+    UNUSED(iovcnt);
+    return hci_transport_replay_send_packet(packet_type, NULL, 0);
+}
+
+// synchronous transport: can_send_packet_now not set, packets are sent by send_packet
+static const hci_transport_t hci_transport_replay = {
+    /* const char * name; */                                        "REPLAY",
+    /* void   (*init) (const void *transport_config); */            &hci_transport_replay_init,
+    /* int    (*open)(void); */                                     &hci_transport_replay_open,
+    /* int    (*close)(void); */                                    &hci_transport_replay_close,
+    /* void   (*register_packet_handler)(void (*handler)(...); */   &hci_transport_replay_register_packet_handler,
+    /* int    (*can_send_packet_now)(uint8_t packet_type); */       NULL,
+    /* int    (*send_packet)(...); */                               &hci_transport_replay_send_packet,
+    /* int    (*set_baudrate)(uint32_t baudrate); */                NULL,
+    /* void   (*reset_link)(void); */                               NULL,
+    /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+    /* int    (*send_packet_iov)(...); */                           &hci_transport_replay_send_packet_iov,
+};
+
+const hci_transport_t * hci_transport_replay_posix_instance(hci_dump_reader_posix_t * reader){
+    replay_reader = reader;
+    return &hci_transport_replay;
+}
+
+void hci_transport_replay_posix_set_timing_accurate(int timing_accurate){
+    replay_timing_accurate = timing_accurate;
+}
+
+void hci_transport_replay_posix_register_done_handler(void (*done_handler)(void)){
+    replay_done_handler = done_handler;
+}
+
+void hci_transport_replay_posix_get_stats(hci_transport_replay_posix_stats_t * stats){
+    *stats = replay_stats;
+}
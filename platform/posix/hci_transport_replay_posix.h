@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY MATTHIAS RINGWALD AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ *  hci_transport_replay_posix.h
+ *
+ *  HCI Transport that replays Controller to Host packets from a packet log, e.g. to reproduce
+ *  issues or to benchmark packet processing without a Bluetooth Controller.
+ *
+ *  Host to Controller packets are discarded. A Command Complete or Command Status event is
+ *  only delivered after the host has sent as many HCI Commands as were logged before it.
+ */
+
+#ifndef __HCI_TRANSPORT_REPLAY_POSIX_H
+#define __HCI_TRANSPORT_REPLAY_POSIX_H
+
+#include <stdint.h>
+#include "hci_transport.h"
+#include "hci_dump_reader_posix.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t num_events;
+    uint32_t num_acl_packets;
+    uint32_t num_sco_packets;
+    uint32_t num_bytes;
+    // packets sent by host
+    uint32_t num_host_commands;
+    uint32_t num_host_acl_packets;
+    uint32_t num_host_sco_packets;
+    // events delivered without matching HCI Command from host
+    uint32_t num_command_timeouts;
+    // from first to last delivered packet
+    uint64_t duration_us;
+} hci_transport_replay_posix_stats_t;
+
+/* API_START */
+
+/**
+ * @brief Setup HCI Transport that replays packet log opened by reader
+ * @param reader
+ * @return transport
+ */
+const hci_transport_t * hci_transport_replay_posix_instance(hci_dump_reader_posix_t * reader);
+
+/**
+ * @brief Deliver packets with the time differences of the packet log or as fast as possible
+ * @param timing_accurate, default: 0 = as fast as possible
+ */
+void hci_transport_replay_posix_set_timing_accurate(int timing_accurate);
+
+/**
+ * @brief Register handler called after the last packet has been delivered
+ * @param done_handler
+ */
+void hci_transport_replay_posix_register_done_handler(void (*done_handler)(void));
+
+/**
+ * @brief Get replay statistics
+ * @param stats
+ */
+void hci_transport_replay_posix_get_stats(hci_transport_replay_posix_stats_t * stats);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // __HCI_TRANSPORT_REPLAY_POSIX_H
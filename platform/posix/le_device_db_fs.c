@@ -239,6 +239,18 @@ exit:
     fclose(wFile);
 }
 
+static void (*le_device_db_change_callback)(void);
+
+void le_device_db_set_change_callback(void (*callback)(void)){
+    le_device_db_change_callback = callback;
+}
+
+static void le_device_db_notify_change(void){
+    if (le_device_db_change_callback){
+        (*le_device_db_change_callback)();
+    }
+}
+
 void le_device_db_init(void){
     int i;
     for (i=0;i<LE_DEVICE_MEMORY_SIZE;i++){
@@ -272,6 +284,7 @@ int le_device_db_max_count(void){
 void le_device_db_remove(int index){
     le_devices[index].addr_type = INVALID_ENTRY_ADDR_TYPE;
     le_device_db_store();
+    le_device_db_notify_change();
 }
 
 int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
@@ -299,6 +312,7 @@ int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
 #endif
     le_device_db_store();
 
+    le_device_db_notify_change();
     return index;
 }
 
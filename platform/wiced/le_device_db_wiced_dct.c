@@ -174,6 +174,18 @@ void le_device_db_wiced_dct_set_start_address(uint32_t start_address){
 	start_of_le_device_db = start_address;
 }
 
+static void (*le_device_db_change_callback)(void);
+
+void le_device_db_set_change_callback(void (*callback)(void)){
+    le_device_db_change_callback = callback;
+}
+
+static void le_device_db_notify_change(void){
+    if (le_device_db_change_callback){
+        (*le_device_db_change_callback)();
+    }
+}
+
 void le_device_db_init(void){
 }
 
@@ -211,6 +223,7 @@ void le_device_db_remove(int device_index){
 	le_device_nvm_t entry;
 	memset(&entry, 0, sizeof(le_device_nvm_t));
 	le_device_db_entry_write(absolute_index, &entry);
+	le_device_db_notify_change();
 }
 
 // custom function
@@ -221,6 +234,7 @@ void le_device_db_wiced_dct_delete_all(void){
 	for (i=0;i<NVM_NUM_LE_DEVICES;i++){
 		le_device_db_entry_write(i, &entry);
 	}
+	le_device_db_notify_change();
 }
 
 int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
@@ -239,6 +253,7 @@ int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
     memcpy(entry.irk, irk, 16);
 
     le_device_db_entry_write(absolute_index, &entry);
+    le_device_db_notify_change();
 
     return absolute_index;
 }
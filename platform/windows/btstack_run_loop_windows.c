@@ -56,7 +56,7 @@ static void btstack_run_loop_windows_dump_timer(void);
 // the run loop
 static btstack_linked_list_t data_sources;
 static int data_sources_modified;
-static btstack_linked_list_t timers;
+static btstack_timer_queue_t timers;
 // start time. 
 static ULARGE_INTEGER start_time;
 
@@ -79,24 +79,14 @@ static int btstack_run_loop_windows_remove_data_source(btstack_data_source_t *ds
 }
 
 /**
- * Add timer to run_loop (keep list sorted)
+ * Add timer to run_loop
  */
 static void btstack_run_loop_windows_add_timer(btstack_timer_source_t *ts){
-    btstack_linked_item_t *it;
-    for (it = (btstack_linked_item_t *) &timers; it->next ; it = it->next){
-        btstack_timer_source_t * next = (btstack_timer_source_t *) it->next;
-        if (next == ts){
-            log_error( "btstack_run_loop_timer_add error: timer to add already in list!");
-            return;
-        }
-        if (next->timeout > ts->timeout) {
-            break;
-        }
+    if (!btstack_timer_queue_add(&timers, ts)){
+        log_error( "btstack_run_loop_timer_add error: timer to add already in list!");
+        return;
     }
-    ts->item.next = it->next;
-    it->next = (btstack_linked_item_t *) ts;
     log_debug("Added timer %p at %u\n", ts, ts->timeout);
-    // btstack_run_loop_windows_dump_timer();
 }
 
 /**
@@ -105,16 +95,11 @@ static void btstack_run_loop_windows_add_timer(btstack_timer_source_t *ts){
 static int btstack_run_loop_windows_remove_timer(btstack_timer_source_t *ts){
     // log_info("Removed timer %x at %u\n", (int) ts, (unsigned int) ts->timeout.tv_sec);
     // btstack_run_loop_windows_dump_timer();
-    return btstack_linked_list_remove(&timers, (btstack_linked_item_t *) ts);
+    return btstack_timer_queue_remove(&timers, ts);
 }
 
 static void btstack_run_loop_windows_dump_timer(void){
-    btstack_linked_item_t *it;
-    int i = 0;
-    for (it = (btstack_linked_item_t *) timers; it ; it = it->next){
-        btstack_timer_source_t *ts = (btstack_timer_source_t*) it;
-        log_info("timer %u, timeout %u\n", i, ts->timeout);
-    }
+    btstack_timer_queue_dump(&timers);
 }
 
 static void btstack_run_loop_windows_enable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
@@ -168,8 +153,8 @@ static void btstack_run_loop_windows_execute(void) {
 
         // get next timeout
         int32_t timeout_ms = INFINITE;
-        if (timers) {
-            ts = (btstack_timer_source_t *) timers;
+        ts = btstack_timer_queue_first(&timers);
+        if (ts) {
             uint32_t now_ms = btstack_run_loop_windows_get_time_ms();
             timeout_ms = ts->timeout - now_ms;
             if (timeout_ms < 0){
@@ -210,8 +195,9 @@ static void btstack_run_loop_windows_execute(void) {
 
         // process timers
         uint32_t now_ms = btstack_run_loop_windows_get_time_ms();
-        while (timers) {
-            ts = (btstack_timer_source_t *) timers;
+        while (1) {
+            ts = btstack_timer_queue_first(&timers);
+            if (ts == NULL) break;
             if (ts->timeout > now_ms) break;
             log_debug("btstack_run_loop_windows_execute: process timer %p\n", ts);
             
@@ -231,7 +217,7 @@ static void btstack_run_loop_windows_set_timer(btstack_timer_source_t *a, uint32
 
 static void btstack_run_loop_windows_init(void){
     data_sources = NULL;
-    timers = NULL;
+    btstack_timer_queue_init(&timers);
 
     // store start time
     FILETIME    file_time;
@@ -45,17 +45,17 @@ OBJECTDIR=build/${CND_CONF}/${IMAGE_TYPE}
 DISTDIR=dist/${CND_CONF}/${IMAGE_TYPE}
 
 # Source Files Quoted if spaced
-SOURCEFILES_QUOTED_IF_SPACED=../src/system_config/bt_audio_dk/system_init.c ../src/system_config/bt_audio_dk/system_tasks.c ../src/btstack_port.c ../src/app_debug.c ../src/app.c ../src/main.c ../../../example/spp_and_le_counter.c ../../../3rd-party/bluedroid/decoder/srce/alloc.c ../../../3rd-party/bluedroid/decoder/srce/bitalloc-sbc.c ../../../3rd-party/bluedroid/decoder/srce/bitalloc.c ../../../3rd-party/bluedroid/decoder/srce/bitstream-decode.c ../../../3rd-party/bluedroid/decoder/srce/decoder-oina.c ../../../3rd-party/bluedroid/decoder/srce/decoder-private.c ../../../3rd-party/bluedroid/decoder/srce/decoder-sbc.c ../../../3rd-party/bluedroid/decoder/srce/dequant.c ../../../3rd-party/bluedroid/decoder/srce/framing-sbc.c ../../../3rd-party/bluedroid/decoder/srce/framing.c ../../../3rd-party/bluedroid/decoder/srce/oi_codec_version.c ../../../3rd-party/bluedroid/decoder/srce/synthesis-8-generated.c ../../../3rd-party/bluedroid/decoder/srce/synthesis-dct8.c ../../../3rd-party/bluedroid/decoder/srce/synthesis-sbc.c ../../../3rd-party/bluedroid/encoder/srce/sbc_analysis.c ../../../3rd-party/bluedroid/encoder/srce/sbc_dct.c ../../../3rd-party/bluedroid/encoder/srce/sbc_dct_coeffs.c ../../../3rd-party/bluedroid/encoder/srce/sbc_enc_bit_alloc_mono.c ../../../3rd-party/bluedroid/encoder/srce/sbc_enc_bit_alloc_ste.c ../../../3rd-party/bluedroid/encoder/srce/sbc_enc_coeffs.c ../../../3rd-party/bluedroid/encoder/srce/sbc_encoder.c ../../../3rd-party/bluedroid/encoder/srce/sbc_packing.c ../../../3rd-party/hxcmod-player/mods/nao-deceased_by_disease.c ../../../3rd-party/hxcmod-player/hxcmod.c ../../../3rd-party/micro-ecc/uECC.c ../../../chipset/csr/btstack_chipset_csr.c ../../../platform/embedded/btstack_run_loop_embedded.c ../../../platform/embedded/btstack_uart_block_embedded.c ../../../src/ble/gatt-service/battery_service_server.c ../../../src/ble/gatt-service/device_information_service_server.c ../../../src/ble/gatt-service/hids_device.c ../../../src/ble/att_db.c ../../../src/ble/att_dispatch.c ../../../src/ble/att_server.c ../../../src/ble/le_device_db_memory.c ../../../src/ble/sm.c ../../../src/ble/ancs_client.c ../../../src/ble/gatt_client.c ../../../src/classic/btstack_link_key_db_memory.c ../../../src/classic/sdp_client.c ../../../src/classic/sdp_client_rfcomm.c ../../../src/classic/sdp_server.c ../../../src/classic/sdp_util.c ../../../src/classic/spp_server.c ../../../src/classic/a2dp_sink.c ../../../src/classic/a2dp_source.c ../../../src/classic/avdtp.c ../../../src/classic/avdtp_acceptor.c ../../../src/classic/avdtp_initiator.c ../../../src/classic/avdtp_sink.c ../../../src/classic/avdtp_source.c ../../../src/classic/avdtp_util.c ../../../src/classic/avrcp.c ../../../src/classic/avrcp_browsing_controller.c ../../../src/classic/avrcp_controller.c ../../../src/classic/avrcp_media_item_iterator.c ../../../src/classic/avrcp_target.c ../../../src/classic/bnep.c ../../../src/classic/btstack_cvsd_plc.c ../../../src/classic/btstack_sbc_decoder_bluedroid.c ../../../src/classic/btstack_sbc_encoder_bluedroid.c ../../../src/classic/btstack_sbc_plc.c ../../../src/classic/device_id_server.c ../../../src/classic/goep_client.c ../../../src/classic/hfp.c ../../../src/classic/hfp_ag.c ../../../src/classic/hfp_gsm_model.c ../../../src/classic/hfp_hf.c ../../../src/classic/hfp_msbc.c ../../../src/classic/hid_device.c ../../../src/classic/hsp_ag.c ../../../src/classic/hsp_hs.c ../../../src/classic/obex_iterator.c ../../../src/classic/pan.c ../../../src/classic/pbap_client.c ../../../src/btstack_memory.c ../../../src/hci.c ../../../src/hci_cmd.c ../../../src/hci_dump.c ../../../src/l2cap.c ../../../src/l2cap_signaling.c ../../../src/btstack_linked_list.c ../../../src/btstack_memory_pool.c ../../../src/classic/rfcomm.c ../../../src/btstack_run_loop.c ../../../src/btstack_util.c ../../../src/hci_transport_h4.c ../../../src/hci_transport_h5.c ../../../src/btstack_slip.c ../../../src/ad_parser.c ../../../src/btstack_tlv.c ../../../../driver/tmr/src/dynamic/drv_tmr.c ../../../../system/clk/src/sys_clk.c ../../../../system/clk/src/sys_clk_pic32mx.c ../../../../system/devcon/src/sys_devcon.c ../../../../system/devcon/src/sys_devcon_pic32mx.c ../../../../system/int/src/sys_int_pic32.c ../../../../system/ports/src/sys_ports.c ../../../src/btstack_crypto.c
+SOURCEFILES_QUOTED_IF_SPACED=../src/system_config/bt_audio_dk/system_init.c ../src/system_config/bt_audio_dk/system_tasks.c ../src/btstack_port.c ../src/app_debug.c ../src/app.c ../src/main.c ../../../example/spp_and_le_counter.c ../../../3rd-party/bluedroid/decoder/srce/alloc.c ../../../3rd-party/bluedroid/decoder/srce/bitalloc-sbc.c ../../../3rd-party/bluedroid/decoder/srce/bitalloc.c ../../../3rd-party/bluedroid/decoder/srce/bitstream-decode.c ../../../3rd-party/bluedroid/decoder/srce/decoder-oina.c ../../../3rd-party/bluedroid/decoder/srce/decoder-private.c ../../../3rd-party/bluedroid/decoder/srce/decoder-sbc.c ../../../3rd-party/bluedroid/decoder/srce/dequant.c ../../../3rd-party/bluedroid/decoder/srce/framing-sbc.c ../../../3rd-party/bluedroid/decoder/srce/framing.c ../../../3rd-party/bluedroid/decoder/srce/oi_codec_version.c ../../../3rd-party/bluedroid/decoder/srce/synthesis-8-generated.c ../../../3rd-party/bluedroid/decoder/srce/synthesis-dct8.c ../../../3rd-party/bluedroid/decoder/srce/synthesis-sbc.c ../../../3rd-party/bluedroid/encoder/srce/sbc_analysis.c ../../../3rd-party/bluedroid/encoder/srce/sbc_dct.c ../../../3rd-party/bluedroid/encoder/srce/sbc_dct_coeffs.c ../../../3rd-party/bluedroid/encoder/srce/sbc_enc_bit_alloc_mono.c ../../../3rd-party/bluedroid/encoder/srce/sbc_enc_bit_alloc_ste.c ../../../3rd-party/bluedroid/encoder/srce/sbc_enc_coeffs.c ../../../3rd-party/bluedroid/encoder/srce/sbc_encoder.c ../../../3rd-party/bluedroid/encoder/srce/sbc_packing.c ../../../3rd-party/hxcmod-player/mods/nao-deceased_by_disease.c ../../../3rd-party/hxcmod-player/hxcmod.c ../../../3rd-party/micro-ecc/uECC.c ../../../chipset/csr/btstack_chipset_csr.c ../../../platform/embedded/btstack_run_loop_embedded.c ../../../platform/embedded/btstack_uart_block_embedded.c ../../../src/ble/gatt-service/battery_service_server.c ../../../src/ble/gatt-service/device_information_service_server.c ../../../src/ble/gatt-service/hids_device.c ../../../src/ble/att_db.c ../../../src/ble/att_dispatch.c ../../../src/ble/att_server.c ../../../src/ble/le_device_db_memory.c ../../../src/ble/sm.c ../../../src/ble/ancs_client.c ../../../src/ble/gatt_client.c ../../../src/classic/btstack_link_key_db_memory.c ../../../src/classic/sdp_client.c ../../../src/classic/sdp_client_rfcomm.c ../../../src/classic/sdp_server.c ../../../src/classic/sdp_util.c ../../../src/classic/spp_server.c ../../../src/classic/a2dp_sink.c ../../../src/classic/a2dp_source.c ../../../src/classic/avdtp.c ../../../src/classic/avdtp_acceptor.c ../../../src/classic/avdtp_initiator.c ../../../src/classic/avdtp_sink.c ../../../src/classic/avdtp_source.c ../../../src/classic/avdtp_util.c ../../../src/classic/avrcp.c ../../../src/classic/avrcp_browsing_controller.c ../../../src/classic/avrcp_controller.c ../../../src/classic/avrcp_media_item_iterator.c ../../../src/classic/avrcp_target.c ../../../src/classic/bnep.c ../../../src/classic/btstack_cvsd_plc.c ../../../src/classic/btstack_sbc_decoder_bluedroid.c ../../../src/classic/btstack_sbc_encoder_bluedroid.c ../../../src/classic/btstack_sbc_plc.c ../../../src/classic/device_id_server.c ../../../src/classic/goep_client.c ../../../src/classic/hfp.c ../../../src/classic/hfp_ag.c ../../../src/classic/hfp_gsm_model.c ../../../src/classic/hfp_hf.c ../../../src/classic/hfp_msbc.c ../../../src/classic/hid_device.c ../../../src/classic/hsp_ag.c ../../../src/classic/hsp_hs.c ../../../src/classic/obex_iterator.c ../../../src/classic/pan.c ../../../src/classic/pbap_client.c ../../../src/btstack_memory.c ../../../src/hci.c ../../../src/hci_cmd.c ../../../src/hci_dump.c ../../../src/l2cap.c ../../../src/l2cap_signaling.c ../../../src/btstack_linked_list.c ../../../src/btstack_memory_pool.c ../../../src/classic/rfcomm.c ../../../src/btstack_run_loop.c ../../../src/btstack_util.c ../../../src/btstack_ring_buffer.c ../../../src/hci_transport_h4.c ../../../src/hci_transport_h5.c ../../../src/btstack_slip.c ../../../src/ad_parser.c ../../../src/btstack_tlv.c ../../../../driver/tmr/src/dynamic/drv_tmr.c ../../../../system/clk/src/sys_clk.c ../../../../system/clk/src/sys_clk_pic32mx.c ../../../../system/devcon/src/sys_devcon.c ../../../../system/devcon/src/sys_devcon_pic32mx.c ../../../../system/int/src/sys_int_pic32.c ../../../../system/ports/src/sys_ports.c ../../../src/btstack_crypto.c
 
 # Object Files Quoted if spaced
-OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/_ext/101891878/system_init.o ${OBJECTDIR}/_ext/101891878/system_tasks.o ${OBJECTDIR}/_ext/1360937237/btstack_port.o ${OBJECTDIR}/_ext/1360937237/app_debug.o ${OBJECTDIR}/_ext/1360937237/app.o ${OBJECTDIR}/_ext/1360937237/main.o ${OBJECTDIR}/_ext/97075643/spp_and_le_counter.o ${OBJECTDIR}/_ext/770672057/alloc.o ${OBJECTDIR}/_ext/770672057/bitalloc-sbc.o ${OBJECTDIR}/_ext/770672057/bitalloc.o ${OBJECTDIR}/_ext/770672057/bitstream-decode.o ${OBJECTDIR}/_ext/770672057/decoder-oina.o ${OBJECTDIR}/_ext/770672057/decoder-private.o ${OBJECTDIR}/_ext/770672057/decoder-sbc.o ${OBJECTDIR}/_ext/770672057/dequant.o ${OBJECTDIR}/_ext/770672057/framing-sbc.o ${OBJECTDIR}/_ext/770672057/framing.o ${OBJECTDIR}/_ext/770672057/oi_codec_version.o ${OBJECTDIR}/_ext/770672057/synthesis-8-generated.o ${OBJECTDIR}/_ext/770672057/synthesis-dct8.o ${OBJECTDIR}/_ext/770672057/synthesis-sbc.o ${OBJECTDIR}/_ext/1907061729/sbc_analysis.o ${OBJECTDIR}/_ext/1907061729/sbc_dct.o ${OBJECTDIR}/_ext/1907061729/sbc_dct_coeffs.o ${OBJECTDIR}/_ext/1907061729/sbc_enc_bit_alloc_mono.o ${OBJECTDIR}/_ext/1907061729/sbc_enc_bit_alloc_ste.o ${OBJECTDIR}/_ext/1907061729/sbc_enc_coeffs.o ${OBJECTDIR}/_ext/1907061729/sbc_encoder.o ${OBJECTDIR}/_ext/1907061729/sbc_packing.o ${OBJECTDIR}/_ext/968912543/nao-deceased_by_disease.o ${OBJECTDIR}/_ext/835724193/hxcmod.o ${OBJECTDIR}/_ext/34712644/uECC.o ${OBJECTDIR}/_ext/1768064806/btstack_chipset_csr.o ${OBJECTDIR}/_ext/993942601/btstack_run_loop_embedded.o ${OBJECTDIR}/_ext/993942601/btstack_uart_block_embedded.o ${OBJECTDIR}/_ext/524132624/battery_service_server.o ${OBJECTDIR}/_ext/524132624/device_information_service_server.o ${OBJECTDIR}/_ext/524132624/hids_device.o ${OBJECTDIR}/_ext/534563071/att_db.o ${OBJECTDIR}/_ext/534563071/att_dispatch.o ${OBJECTDIR}/_ext/534563071/att_server.o ${OBJECTDIR}/_ext/534563071/le_device_db_memory.o ${OBJECTDIR}/_ext/534563071/sm.o ${OBJECTDIR}/_ext/534563071/ancs_client.o ${OBJECTDIR}/_ext/534563071/gatt_client.o ${OBJECTDIR}/_ext/1386327864/btstack_link_key_db_memory.o ${OBJECTDIR}/_ext/1386327864/sdp_client.o ${OBJECTDIR}/_ext/1386327864/sdp_client_rfcomm.o ${OBJECTDIR}/_ext/1386327864/sdp_server.o ${OBJECTDIR}/_ext/1386327864/sdp_util.o ${OBJECTDIR}/_ext/1386327864/spp_server.o ${OBJECTDIR}/_ext/1386327864/a2dp_sink.o ${OBJECTDIR}/_ext/1386327864/a2dp_source.o ${OBJECTDIR}/_ext/1386327864/avdtp.o ${OBJECTDIR}/_ext/1386327864/avdtp_acceptor.o ${OBJECTDIR}/_ext/1386327864/avdtp_initiator.o ${OBJECTDIR}/_ext/1386327864/avdtp_sink.o ${OBJECTDIR}/_ext/1386327864/avdtp_source.o ${OBJECTDIR}/_ext/1386327864/avdtp_util.o ${OBJECTDIR}/_ext/1386327864/avrcp.o ${OBJECTDIR}/_ext/1386327864/avrcp_browsing_controller.o ${OBJECTDIR}/_ext/1386327864/avrcp_controller.o ${OBJECTDIR}/_ext/1386327864/avrcp_media_item_iterator.o ${OBJECTDIR}/_ext/1386327864/avrcp_target.o ${OBJECTDIR}/_ext/1386327864/bnep.o ${OBJECTDIR}/_ext/1386327864/btstack_cvsd_plc.o ${OBJECTDIR}/_ext/1386327864/btstack_sbc_decoder_bluedroid.o ${OBJECTDIR}/_ext/1386327864/btstack_sbc_encoder_bluedroid.o ${OBJECTDIR}/_ext/1386327864/btstack_sbc_plc.o ${OBJECTDIR}/_ext/1386327864/device_id_server.o ${OBJECTDIR}/_ext/1386327864/goep_client.o ${OBJECTDIR}/_ext/1386327864/hfp.o ${OBJECTDIR}/_ext/1386327864/hfp_ag.o ${OBJECTDIR}/_ext/1386327864/hfp_gsm_model.o ${OBJECTDIR}/_ext/1386327864/hfp_hf.o ${OBJECTDIR}/_ext/1386327864/hfp_msbc.o ${OBJECTDIR}/_ext/1386327864/hid_device.o ${OBJECTDIR}/_ext/1386327864/hsp_ag.o ${OBJECTDIR}/_ext/1386327864/hsp_hs.o ${OBJECTDIR}/_ext/1386327864/obex_iterator.o ${OBJECTDIR}/_ext/1386327864/pan.o ${OBJECTDIR}/_ext/1386327864/pbap_client.o ${OBJECTDIR}/_ext/1386528437/btstack_memory.o ${OBJECTDIR}/_ext/1386528437/hci.o ${OBJECTDIR}/_ext/1386528437/hci_cmd.o ${OBJECTDIR}/_ext/1386528437/hci_dump.o ${OBJECTDIR}/_ext/1386528437/l2cap.o ${OBJECTDIR}/_ext/1386528437/l2cap_signaling.o ${OBJECTDIR}/_ext/1386528437/btstack_linked_list.o ${OBJECTDIR}/_ext/1386528437/btstack_memory_pool.o ${OBJECTDIR}/_ext/1386327864/rfcomm.o ${OBJECTDIR}/_ext/1386528437/btstack_run_loop.o ${OBJECTDIR}/_ext/1386528437/btstack_util.o ${OBJECTDIR}/_ext/1386528437/hci_transport_h4.o ${OBJECTDIR}/_ext/1386528437/hci_transport_h5.o ${OBJECTDIR}/_ext/1386528437/btstack_slip.o ${OBJECTDIR}/_ext/1386528437/ad_parser.o ${OBJECTDIR}/_ext/1386528437/btstack_tlv.o ${OBJECTDIR}/_ext/1880736137/drv_tmr.o ${OBJECTDIR}/_ext/1112166103/sys_clk.o ${OBJECTDIR}/_ext/1112166103/sys_clk_pic32mx.o ${OBJECTDIR}/_ext/1510368962/sys_devcon.o ${OBJECTDIR}/_ext/1510368962/sys_devcon_pic32mx.o ${OBJECTDIR}/_ext/2087176412/sys_int_pic32.o ${OBJECTDIR}/_ext/2147153351/sys_ports.o ${OBJECTDIR}/_ext/1386528437/btstack_crypto.o
-POSSIBLE_DEPFILES=${OBJECTDIR}/_ext/101891878/system_init.o.d ${OBJECTDIR}/_ext/101891878/system_tasks.o.d ${OBJECTDIR}/_ext/1360937237/btstack_port.o.d ${OBJECTDIR}/_ext/1360937237/app_debug.o.d ${OBJECTDIR}/_ext/1360937237/app.o.d ${OBJECTDIR}/_ext/1360937237/main.o.d ${OBJECTDIR}/_ext/97075643/spp_and_le_counter.o.d ${OBJECTDIR}/_ext/770672057/alloc.o.d ${OBJECTDIR}/_ext/770672057/bitalloc-sbc.o.d ${OBJECTDIR}/_ext/770672057/bitalloc.o.d ${OBJECTDIR}/_ext/770672057/bitstream-decode.o.d ${OBJECTDIR}/_ext/770672057/decoder-oina.o.d ${OBJECTDIR}/_ext/770672057/decoder-private.o.d ${OBJECTDIR}/_ext/770672057/decoder-sbc.o.d ${OBJECTDIR}/_ext/770672057/dequant.o.d ${OBJECTDIR}/_ext/770672057/framing-sbc.o.d ${OBJECTDIR}/_ext/770672057/framing.o.d ${OBJECTDIR}/_ext/770672057/oi_codec_version.o.d ${OBJECTDIR}/_ext/770672057/synthesis-8-generated.o.d ${OBJECTDIR}/_ext/770672057/synthesis-dct8.o.d ${OBJECTDIR}/_ext/770672057/synthesis-sbc.o.d ${OBJECTDIR}/_ext/1907061729/sbc_analysis.o.d ${OBJECTDIR}/_ext/1907061729/sbc_dct.o.d ${OBJECTDIR}/_ext/1907061729/sbc_dct_coeffs.o.d ${OBJECTDIR}/_ext/1907061729/sbc_enc_bit_alloc_mono.o.d ${OBJECTDIR}/_ext/1907061729/sbc_enc_bit_alloc_ste.o.d ${OBJECTDIR}/_ext/1907061729/sbc_enc_coeffs.o.d ${OBJECTDIR}/_ext/1907061729/sbc_encoder.o.d ${OBJECTDIR}/_ext/1907061729/sbc_packing.o.d ${OBJECTDIR}/_ext/968912543/nao-deceased_by_disease.o.d ${OBJECTDIR}/_ext/835724193/hxcmod.o.d ${OBJECTDIR}/_ext/34712644/uECC.o.d ${OBJECTDIR}/_ext/1768064806/btstack_chipset_csr.o.d ${OBJECTDIR}/_ext/993942601/btstack_run_loop_embedded.o.d ${OBJECTDIR}/_ext/993942601/btstack_uart_block_embedded.o.d ${OBJECTDIR}/_ext/524132624/battery_service_server.o.d ${OBJECTDIR}/_ext/524132624/device_information_service_server.o.d ${OBJECTDIR}/_ext/524132624/hids_device.o.d ${OBJECTDIR}/_ext/534563071/att_db.o.d ${OBJECTDIR}/_ext/534563071/att_dispatch.o.d ${OBJECTDIR}/_ext/534563071/att_server.o.d ${OBJECTDIR}/_ext/534563071/le_device_db_memory.o.d ${OBJECTDIR}/_ext/534563071/sm.o.d ${OBJECTDIR}/_ext/534563071/ancs_client.o.d ${OBJECTDIR}/_ext/534563071/gatt_client.o.d ${OBJECTDIR}/_ext/1386327864/btstack_link_key_db_memory.o.d ${OBJECTDIR}/_ext/1386327864/sdp_client.o.d ${OBJECTDIR}/_ext/1386327864/sdp_client_rfcomm.o.d ${OBJECTDIR}/_ext/1386327864/sdp_server.o.d ${OBJECTDIR}/_ext/1386327864/sdp_util.o.d ${OBJECTDIR}/_ext/1386327864/spp_server.o.d ${OBJECTDIR}/_ext/1386327864/a2dp_sink.o.d ${OBJECTDIR}/_ext/1386327864/a2dp_source.o.d ${OBJECTDIR}/_ext/1386327864/avdtp.o.d ${OBJECTDIR}/_ext/1386327864/avdtp_acceptor.o.d ${OBJECTDIR}/_ext/1386327864/avdtp_initiator.o.d ${OBJECTDIR}/_ext/1386327864/avdtp_sink.o.d ${OBJECTDIR}/_ext/1386327864/avdtp_source.o.d ${OBJECTDIR}/_ext/1386327864/avdtp_util.o.d ${OBJECTDIR}/_ext/1386327864/avrcp.o.d ${OBJECTDIR}/_ext/1386327864/avrcp_browsing_controller.o.d ${OBJECTDIR}/_ext/1386327864/avrcp_controller.o.d ${OBJECTDIR}/_ext/1386327864/avrcp_media_item_iterator.o.d ${OBJECTDIR}/_ext/1386327864/avrcp_target.o.d ${OBJECTDIR}/_ext/1386327864/bnep.o.d ${OBJECTDIR}/_ext/1386327864/btstack_cvsd_plc.o.d ${OBJECTDIR}/_ext/1386327864/btstack_sbc_decoder_bluedroid.o.d ${OBJECTDIR}/_ext/1386327864/btstack_sbc_encoder_bluedroid.o.d ${OBJECTDIR}/_ext/1386327864/btstack_sbc_plc.o.d ${OBJECTDIR}/_ext/1386327864/device_id_server.o.d ${OBJECTDIR}/_ext/1386327864/goep_client.o.d ${OBJECTDIR}/_ext/1386327864/hfp.o.d ${OBJECTDIR}/_ext/1386327864/hfp_ag.o.d ${OBJECTDIR}/_ext/1386327864/hfp_gsm_model.o.d ${OBJECTDIR}/_ext/1386327864/hfp_hf.o.d ${OBJECTDIR}/_ext/1386327864/hfp_msbc.o.d ${OBJECTDIR}/_ext/1386327864/hid_device.o.d ${OBJECTDIR}/_ext/1386327864/hsp_ag.o.d ${OBJECTDIR}/_ext/1386327864/hsp_hs.o.d ${OBJECTDIR}/_ext/1386327864/obex_iterator.o.d ${OBJECTDIR}/_ext/1386327864/pan.o.d ${OBJECTDIR}/_ext/1386327864/pbap_client.o.d ${OBJECTDIR}/_ext/1386528437/btstack_memory.o.d ${OBJECTDIR}/_ext/1386528437/hci.o.d ${OBJECTDIR}/_ext/1386528437/hci_cmd.o.d ${OBJECTDIR}/_ext/1386528437/hci_dump.o.d ${OBJECTDIR}/_ext/1386528437/l2cap.o.d ${OBJECTDIR}/_ext/1386528437/l2cap_signaling.o.d ${OBJECTDIR}/_ext/1386528437/btstack_linked_list.o.d ${OBJECTDIR}/_ext/1386528437/btstack_memory_pool.o.d ${OBJECTDIR}/_ext/1386327864/rfcomm.o.d ${OBJECTDIR}/_ext/1386528437/btstack_run_loop.o.d ${OBJECTDIR}/_ext/1386528437/btstack_util.o.d ${OBJECTDIR}/_ext/1386528437/hci_transport_h4.o.d ${OBJECTDIR}/_ext/1386528437/hci_transport_h5.o.d ${OBJECTDIR}/_ext/1386528437/btstack_slip.o.d ${OBJECTDIR}/_ext/1386528437/ad_parser.o.d ${OBJECTDIR}/_ext/1386528437/btstack_tlv.o.d ${OBJECTDIR}/_ext/1880736137/drv_tmr.o.d ${OBJECTDIR}/_ext/1112166103/sys_clk.o.d ${OBJECTDIR}/_ext/1112166103/sys_clk_pic32mx.o.d ${OBJECTDIR}/_ext/1510368962/sys_devcon.o.d ${OBJECTDIR}/_ext/1510368962/sys_devcon_pic32mx.o.d ${OBJECTDIR}/_ext/2087176412/sys_int_pic32.o.d ${OBJECTDIR}/_ext/2147153351/sys_ports.o.d ${OBJECTDIR}/_ext/1386528437/btstack_crypto.o.d
+OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/_ext/101891878/system_init.o ${OBJECTDIR}/_ext/101891878/system_tasks.o ${OBJECTDIR}/_ext/1360937237/btstack_port.o ${OBJECTDIR}/_ext/1360937237/app_debug.o ${OBJECTDIR}/_ext/1360937237/app.o ${OBJECTDIR}/_ext/1360937237/main.o ${OBJECTDIR}/_ext/97075643/spp_and_le_counter.o ${OBJECTDIR}/_ext/770672057/alloc.o ${OBJECTDIR}/_ext/770672057/bitalloc-sbc.o ${OBJECTDIR}/_ext/770672057/bitalloc.o ${OBJECTDIR}/_ext/770672057/bitstream-decode.o ${OBJECTDIR}/_ext/770672057/decoder-oina.o ${OBJECTDIR}/_ext/770672057/decoder-private.o ${OBJECTDIR}/_ext/770672057/decoder-sbc.o ${OBJECTDIR}/_ext/770672057/dequant.o ${OBJECTDIR}/_ext/770672057/framing-sbc.o ${OBJECTDIR}/_ext/770672057/framing.o ${OBJECTDIR}/_ext/770672057/oi_codec_version.o ${OBJECTDIR}/_ext/770672057/synthesis-8-generated.o ${OBJECTDIR}/_ext/770672057/synthesis-dct8.o ${OBJECTDIR}/_ext/770672057/synthesis-sbc.o ${OBJECTDIR}/_ext/1907061729/sbc_analysis.o ${OBJECTDIR}/_ext/1907061729/sbc_dct.o ${OBJECTDIR}/_ext/1907061729/sbc_dct_coeffs.o ${OBJECTDIR}/_ext/1907061729/sbc_enc_bit_alloc_mono.o ${OBJECTDIR}/_ext/1907061729/sbc_enc_bit_alloc_ste.o ${OBJECTDIR}/_ext/1907061729/sbc_enc_coeffs.o ${OBJECTDIR}/_ext/1907061729/sbc_encoder.o ${OBJECTDIR}/_ext/1907061729/sbc_packing.o ${OBJECTDIR}/_ext/968912543/nao-deceased_by_disease.o ${OBJECTDIR}/_ext/835724193/hxcmod.o ${OBJECTDIR}/_ext/34712644/uECC.o ${OBJECTDIR}/_ext/1768064806/btstack_chipset_csr.o ${OBJECTDIR}/_ext/993942601/btstack_run_loop_embedded.o ${OBJECTDIR}/_ext/993942601/btstack_uart_block_embedded.o ${OBJECTDIR}/_ext/524132624/battery_service_server.o ${OBJECTDIR}/_ext/524132624/device_information_service_server.o ${OBJECTDIR}/_ext/524132624/hids_device.o ${OBJECTDIR}/_ext/534563071/att_db.o ${OBJECTDIR}/_ext/534563071/att_dispatch.o ${OBJECTDIR}/_ext/534563071/att_server.o ${OBJECTDIR}/_ext/534563071/le_device_db_memory.o ${OBJECTDIR}/_ext/534563071/sm.o ${OBJECTDIR}/_ext/534563071/ancs_client.o ${OBJECTDIR}/_ext/534563071/gatt_client.o ${OBJECTDIR}/_ext/1386327864/btstack_link_key_db_memory.o ${OBJECTDIR}/_ext/1386327864/sdp_client.o ${OBJECTDIR}/_ext/1386327864/sdp_client_rfcomm.o ${OBJECTDIR}/_ext/1386327864/sdp_server.o ${OBJECTDIR}/_ext/1386327864/sdp_util.o ${OBJECTDIR}/_ext/1386327864/spp_server.o ${OBJECTDIR}/_ext/1386327864/a2dp_sink.o ${OBJECTDIR}/_ext/1386327864/a2dp_source.o ${OBJECTDIR}/_ext/1386327864/avdtp.o ${OBJECTDIR}/_ext/1386327864/avdtp_acceptor.o ${OBJECTDIR}/_ext/1386327864/avdtp_initiator.o ${OBJECTDIR}/_ext/1386327864/avdtp_sink.o ${OBJECTDIR}/_ext/1386327864/avdtp_source.o ${OBJECTDIR}/_ext/1386327864/avdtp_util.o ${OBJECTDIR}/_ext/1386327864/avrcp.o ${OBJECTDIR}/_ext/1386327864/avrcp_browsing_controller.o ${OBJECTDIR}/_ext/1386327864/avrcp_controller.o ${OBJECTDIR}/_ext/1386327864/avrcp_media_item_iterator.o ${OBJECTDIR}/_ext/1386327864/avrcp_target.o ${OBJECTDIR}/_ext/1386327864/bnep.o ${OBJECTDIR}/_ext/1386327864/btstack_cvsd_plc.o ${OBJECTDIR}/_ext/1386327864/btstack_sbc_decoder_bluedroid.o ${OBJECTDIR}/_ext/1386327864/btstack_sbc_encoder_bluedroid.o ${OBJECTDIR}/_ext/1386327864/btstack_sbc_plc.o ${OBJECTDIR}/_ext/1386327864/device_id_server.o ${OBJECTDIR}/_ext/1386327864/goep_client.o ${OBJECTDIR}/_ext/1386327864/hfp.o ${OBJECTDIR}/_ext/1386327864/hfp_ag.o ${OBJECTDIR}/_ext/1386327864/hfp_gsm_model.o ${OBJECTDIR}/_ext/1386327864/hfp_hf.o ${OBJECTDIR}/_ext/1386327864/hfp_msbc.o ${OBJECTDIR}/_ext/1386327864/hid_device.o ${OBJECTDIR}/_ext/1386327864/hsp_ag.o ${OBJECTDIR}/_ext/1386327864/hsp_hs.o ${OBJECTDIR}/_ext/1386327864/obex_iterator.o ${OBJECTDIR}/_ext/1386327864/pan.o ${OBJECTDIR}/_ext/1386327864/pbap_client.o ${OBJECTDIR}/_ext/1386528437/btstack_memory.o ${OBJECTDIR}/_ext/1386528437/hci.o ${OBJECTDIR}/_ext/1386528437/hci_cmd.o ${OBJECTDIR}/_ext/1386528437/hci_dump.o ${OBJECTDIR}/_ext/1386528437/l2cap.o ${OBJECTDIR}/_ext/1386528437/l2cap_signaling.o ${OBJECTDIR}/_ext/1386528437/btstack_linked_list.o ${OBJECTDIR}/_ext/1386528437/btstack_memory_pool.o ${OBJECTDIR}/_ext/1386327864/rfcomm.o ${OBJECTDIR}/_ext/1386528437/btstack_run_loop.o ${OBJECTDIR}/_ext/1386528437/btstack_util.o ${OBJECTDIR}/_ext/1386528437/btstack_ring_buffer.o ${OBJECTDIR}/_ext/1386528437/hci_transport_h4.o ${OBJECTDIR}/_ext/1386528437/hci_transport_h5.o ${OBJECTDIR}/_ext/1386528437/btstack_slip.o ${OBJECTDIR}/_ext/1386528437/ad_parser.o ${OBJECTDIR}/_ext/1386528437/btstack_tlv.o ${OBJECTDIR}/_ext/1880736137/drv_tmr.o ${OBJECTDIR}/_ext/1112166103/sys_clk.o ${OBJECTDIR}/_ext/1112166103/sys_clk_pic32mx.o ${OBJECTDIR}/_ext/1510368962/sys_devcon.o ${OBJECTDIR}/_ext/1510368962/sys_devcon_pic32mx.o ${OBJECTDIR}/_ext/2087176412/sys_int_pic32.o ${OBJECTDIR}/_ext/2147153351/sys_ports.o ${OBJECTDIR}/_ext/1386528437/btstack_crypto.o
+POSSIBLE_DEPFILES=${OBJECTDIR}/_ext/101891878/system_init.o.d ${OBJECTDIR}/_ext/101891878/system_tasks.o.d ${OBJECTDIR}/_ext/1360937237/btstack_port.o.d ${OBJECTDIR}/_ext/1360937237/app_debug.o.d ${OBJECTDIR}/_ext/1360937237/app.o.d ${OBJECTDIR}/_ext/1360937237/main.o.d ${OBJECTDIR}/_ext/97075643/spp_and_le_counter.o.d ${OBJECTDIR}/_ext/770672057/alloc.o.d ${OBJECTDIR}/_ext/770672057/bitalloc-sbc.o.d ${OBJECTDIR}/_ext/770672057/bitalloc.o.d ${OBJECTDIR}/_ext/770672057/bitstream-decode.o.d ${OBJECTDIR}/_ext/770672057/decoder-oina.o.d ${OBJECTDIR}/_ext/770672057/decoder-private.o.d ${OBJECTDIR}/_ext/770672057/decoder-sbc.o.d ${OBJECTDIR}/_ext/770672057/dequant.o.d ${OBJECTDIR}/_ext/770672057/framing-sbc.o.d ${OBJECTDIR}/_ext/770672057/framing.o.d ${OBJECTDIR}/_ext/770672057/oi_codec_version.o.d ${OBJECTDIR}/_ext/770672057/synthesis-8-generated.o.d ${OBJECTDIR}/_ext/770672057/synthesis-dct8.o.d ${OBJECTDIR}/_ext/770672057/synthesis-sbc.o.d ${OBJECTDIR}/_ext/1907061729/sbc_analysis.o.d ${OBJECTDIR}/_ext/1907061729/sbc_dct.o.d ${OBJECTDIR}/_ext/1907061729/sbc_dct_coeffs.o.d ${OBJECTDIR}/_ext/1907061729/sbc_enc_bit_alloc_mono.o.d ${OBJECTDIR}/_ext/1907061729/sbc_enc_bit_alloc_ste.o.d ${OBJECTDIR}/_ext/1907061729/sbc_enc_coeffs.o.d ${OBJECTDIR}/_ext/1907061729/sbc_encoder.o.d ${OBJECTDIR}/_ext/1907061729/sbc_packing.o.d ${OBJECTDIR}/_ext/968912543/nao-deceased_by_disease.o.d ${OBJECTDIR}/_ext/835724193/hxcmod.o.d ${OBJECTDIR}/_ext/34712644/uECC.o.d ${OBJECTDIR}/_ext/1768064806/btstack_chipset_csr.o.d ${OBJECTDIR}/_ext/993942601/btstack_run_loop_embedded.o.d ${OBJECTDIR}/_ext/993942601/btstack_uart_block_embedded.o.d ${OBJECTDIR}/_ext/524132624/battery_service_server.o.d ${OBJECTDIR}/_ext/524132624/device_information_service_server.o.d ${OBJECTDIR}/_ext/524132624/hids_device.o.d ${OBJECTDIR}/_ext/534563071/att_db.o.d ${OBJECTDIR}/_ext/534563071/att_dispatch.o.d ${OBJECTDIR}/_ext/534563071/att_server.o.d ${OBJECTDIR}/_ext/534563071/le_device_db_memory.o.d ${OBJECTDIR}/_ext/534563071/sm.o.d ${OBJECTDIR}/_ext/534563071/ancs_client.o.d ${OBJECTDIR}/_ext/534563071/gatt_client.o.d ${OBJECTDIR}/_ext/1386327864/btstack_link_key_db_memory.o.d ${OBJECTDIR}/_ext/1386327864/sdp_client.o.d ${OBJECTDIR}/_ext/1386327864/sdp_client_rfcomm.o.d ${OBJECTDIR}/_ext/1386327864/sdp_server.o.d ${OBJECTDIR}/_ext/1386327864/sdp_util.o.d ${OBJECTDIR}/_ext/1386327864/spp_server.o.d ${OBJECTDIR}/_ext/1386327864/a2dp_sink.o.d ${OBJECTDIR}/_ext/1386327864/a2dp_source.o.d ${OBJECTDIR}/_ext/1386327864/avdtp.o.d ${OBJECTDIR}/_ext/1386327864/avdtp_acceptor.o.d ${OBJECTDIR}/_ext/1386327864/avdtp_initiator.o.d ${OBJECTDIR}/_ext/1386327864/avdtp_sink.o.d ${OBJECTDIR}/_ext/1386327864/avdtp_source.o.d ${OBJECTDIR}/_ext/1386327864/avdtp_util.o.d ${OBJECTDIR}/_ext/1386327864/avrcp.o.d ${OBJECTDIR}/_ext/1386327864/avrcp_browsing_controller.o.d ${OBJECTDIR}/_ext/1386327864/avrcp_controller.o.d ${OBJECTDIR}/_ext/1386327864/avrcp_media_item_iterator.o.d ${OBJECTDIR}/_ext/1386327864/avrcp_target.o.d ${OBJECTDIR}/_ext/1386327864/bnep.o.d ${OBJECTDIR}/_ext/1386327864/btstack_cvsd_plc.o.d ${OBJECTDIR}/_ext/1386327864/btstack_sbc_decoder_bluedroid.o.d ${OBJECTDIR}/_ext/1386327864/btstack_sbc_encoder_bluedroid.o.d ${OBJECTDIR}/_ext/1386327864/btstack_sbc_plc.o.d ${OBJECTDIR}/_ext/1386327864/device_id_server.o.d ${OBJECTDIR}/_ext/1386327864/goep_client.o.d ${OBJECTDIR}/_ext/1386327864/hfp.o.d ${OBJECTDIR}/_ext/1386327864/hfp_ag.o.d ${OBJECTDIR}/_ext/1386327864/hfp_gsm_model.o.d ${OBJECTDIR}/_ext/1386327864/hfp_hf.o.d ${OBJECTDIR}/_ext/1386327864/hfp_msbc.o.d ${OBJECTDIR}/_ext/1386327864/hid_device.o.d ${OBJECTDIR}/_ext/1386327864/hsp_ag.o.d ${OBJECTDIR}/_ext/1386327864/hsp_hs.o.d ${OBJECTDIR}/_ext/1386327864/obex_iterator.o.d ${OBJECTDIR}/_ext/1386327864/pan.o.d ${OBJECTDIR}/_ext/1386327864/pbap_client.o.d ${OBJECTDIR}/_ext/1386528437/btstack_memory.o.d ${OBJECTDIR}/_ext/1386528437/hci.o.d ${OBJECTDIR}/_ext/1386528437/hci_cmd.o.d ${OBJECTDIR}/_ext/1386528437/hci_dump.o.d ${OBJECTDIR}/_ext/1386528437/l2cap.o.d ${OBJECTDIR}/_ext/1386528437/l2cap_signaling.o.d ${OBJECTDIR}/_ext/1386528437/btstack_linked_list.o.d ${OBJECTDIR}/_ext/1386528437/btstack_memory_pool.o.d ${OBJECTDIR}/_ext/1386327864/rfcomm.o.d ${OBJECTDIR}/_ext/1386528437/btstack_run_loop.o.d ${OBJECTDIR}/_ext/1386528437/btstack_util.o.d ${OBJECTDIR}/_ext/1386528437/btstack_ring_buffer.o.d ${OBJECTDIR}/_ext/1386528437/hci_transport_h4.o.d ${OBJECTDIR}/_ext/1386528437/hci_transport_h5.o.d ${OBJECTDIR}/_ext/1386528437/btstack_slip.o.d ${OBJECTDIR}/_ext/1386528437/ad_parser.o.d ${OBJECTDIR}/_ext/1386528437/btstack_tlv.o.d ${OBJECTDIR}/_ext/1880736137/drv_tmr.o.d ${OBJECTDIR}/_ext/1112166103/sys_clk.o.d ${OBJECTDIR}/_ext/1112166103/sys_clk_pic32mx.o.d ${OBJECTDIR}/_ext/1510368962/sys_devcon.o.d ${OBJECTDIR}/_ext/1510368962/sys_devcon_pic32mx.o.d ${OBJECTDIR}/_ext/2087176412/sys_int_pic32.o.d ${OBJECTDIR}/_ext/2147153351/sys_ports.o.d ${OBJECTDIR}/_ext/1386528437/btstack_crypto.o.d
 
 # Object Files
-OBJECTFILES=${OBJECTDIR}/_ext/101891878/system_init.o ${OBJECTDIR}/_ext/101891878/system_tasks.o ${OBJECTDIR}/_ext/1360937237/btstack_port.o ${OBJECTDIR}/_ext/1360937237/app_debug.o ${OBJECTDIR}/_ext/1360937237/app.o ${OBJECTDIR}/_ext/1360937237/main.o ${OBJECTDIR}/_ext/97075643/spp_and_le_counter.o ${OBJECTDIR}/_ext/770672057/alloc.o ${OBJECTDIR}/_ext/770672057/bitalloc-sbc.o ${OBJECTDIR}/_ext/770672057/bitalloc.o ${OBJECTDIR}/_ext/770672057/bitstream-decode.o ${OBJECTDIR}/_ext/770672057/decoder-oina.o ${OBJECTDIR}/_ext/770672057/decoder-private.o ${OBJECTDIR}/_ext/770672057/decoder-sbc.o ${OBJECTDIR}/_ext/770672057/dequant.o ${OBJECTDIR}/_ext/770672057/framing-sbc.o ${OBJECTDIR}/_ext/770672057/framing.o ${OBJECTDIR}/_ext/770672057/oi_codec_version.o ${OBJECTDIR}/_ext/770672057/synthesis-8-generated.o ${OBJECTDIR}/_ext/770672057/synthesis-dct8.o ${OBJECTDIR}/_ext/770672057/synthesis-sbc.o ${OBJECTDIR}/_ext/1907061729/sbc_analysis.o ${OBJECTDIR}/_ext/1907061729/sbc_dct.o ${OBJECTDIR}/_ext/1907061729/sbc_dct_coeffs.o ${OBJECTDIR}/_ext/1907061729/sbc_enc_bit_alloc_mono.o ${OBJECTDIR}/_ext/1907061729/sbc_enc_bit_alloc_ste.o ${OBJECTDIR}/_ext/1907061729/sbc_enc_coeffs.o ${OBJECTDIR}/_ext/1907061729/sbc_encoder.o ${OBJECTDIR}/_ext/1907061729/sbc_packing.o ${OBJECTDIR}/_ext/968912543/nao-deceased_by_disease.o ${OBJECTDIR}/_ext/835724193/hxcmod.o ${OBJECTDIR}/_ext/34712644/uECC.o ${OBJECTDIR}/_ext/1768064806/btstack_chipset_csr.o ${OBJECTDIR}/_ext/993942601/btstack_run_loop_embedded.o ${OBJECTDIR}/_ext/993942601/btstack_uart_block_embedded.o ${OBJECTDIR}/_ext/524132624/battery_service_server.o ${OBJECTDIR}/_ext/524132624/device_information_service_server.o ${OBJECTDIR}/_ext/524132624/hids_device.o ${OBJECTDIR}/_ext/534563071/att_db.o ${OBJECTDIR}/_ext/534563071/att_dispatch.o ${OBJECTDIR}/_ext/534563071/att_server.o ${OBJECTDIR}/_ext/534563071/le_device_db_memory.o ${OBJECTDIR}/_ext/534563071/sm.o ${OBJECTDIR}/_ext/534563071/ancs_client.o ${OBJECTDIR}/_ext/534563071/gatt_client.o ${OBJECTDIR}/_ext/1386327864/btstack_link_key_db_memory.o ${OBJECTDIR}/_ext/1386327864/sdp_client.o ${OBJECTDIR}/_ext/1386327864/sdp_client_rfcomm.o ${OBJECTDIR}/_ext/1386327864/sdp_server.o ${OBJECTDIR}/_ext/1386327864/sdp_util.o ${OBJECTDIR}/_ext/1386327864/spp_server.o ${OBJECTDIR}/_ext/1386327864/a2dp_sink.o ${OBJECTDIR}/_ext/1386327864/a2dp_source.o ${OBJECTDIR}/_ext/1386327864/avdtp.o ${OBJECTDIR}/_ext/1386327864/avdtp_acceptor.o ${OBJECTDIR}/_ext/1386327864/avdtp_initiator.o ${OBJECTDIR}/_ext/1386327864/avdtp_sink.o ${OBJECTDIR}/_ext/1386327864/avdtp_source.o ${OBJECTDIR}/_ext/1386327864/avdtp_util.o ${OBJECTDIR}/_ext/1386327864/avrcp.o ${OBJECTDIR}/_ext/1386327864/avrcp_browsing_controller.o ${OBJECTDIR}/_ext/1386327864/avrcp_controller.o ${OBJECTDIR}/_ext/1386327864/avrcp_media_item_iterator.o ${OBJECTDIR}/_ext/1386327864/avrcp_target.o ${OBJECTDIR}/_ext/1386327864/bnep.o ${OBJECTDIR}/_ext/1386327864/btstack_cvsd_plc.o ${OBJECTDIR}/_ext/1386327864/btstack_sbc_decoder_bluedroid.o ${OBJECTDIR}/_ext/1386327864/btstack_sbc_encoder_bluedroid.o ${OBJECTDIR}/_ext/1386327864/btstack_sbc_plc.o ${OBJECTDIR}/_ext/1386327864/device_id_server.o ${OBJECTDIR}/_ext/1386327864/goep_client.o ${OBJECTDIR}/_ext/1386327864/hfp.o ${OBJECTDIR}/_ext/1386327864/hfp_ag.o ${OBJECTDIR}/_ext/1386327864/hfp_gsm_model.o ${OBJECTDIR}/_ext/1386327864/hfp_hf.o ${OBJECTDIR}/_ext/1386327864/hfp_msbc.o ${OBJECTDIR}/_ext/1386327864/hid_device.o ${OBJECTDIR}/_ext/1386327864/hsp_ag.o ${OBJECTDIR}/_ext/1386327864/hsp_hs.o ${OBJECTDIR}/_ext/1386327864/obex_iterator.o ${OBJECTDIR}/_ext/1386327864/pan.o ${OBJECTDIR}/_ext/1386327864/pbap_client.o ${OBJECTDIR}/_ext/1386528437/btstack_memory.o ${OBJECTDIR}/_ext/1386528437/hci.o ${OBJECTDIR}/_ext/1386528437/hci_cmd.o ${OBJECTDIR}/_ext/1386528437/hci_dump.o ${OBJECTDIR}/_ext/1386528437/l2cap.o ${OBJECTDIR}/_ext/1386528437/l2cap_signaling.o ${OBJECTDIR}/_ext/1386528437/btstack_linked_list.o ${OBJECTDIR}/_ext/1386528437/btstack_memory_pool.o ${OBJECTDIR}/_ext/1386327864/rfcomm.o ${OBJECTDIR}/_ext/1386528437/btstack_run_loop.o ${OBJECTDIR}/_ext/1386528437/btstack_util.o ${OBJECTDIR}/_ext/1386528437/hci_transport_h4.o ${OBJECTDIR}/_ext/1386528437/hci_transport_h5.o ${OBJECTDIR}/_ext/1386528437/btstack_slip.o ${OBJECTDIR}/_ext/1386528437/ad_parser.o ${OBJECTDIR}/_ext/1386528437/btstack_tlv.o ${OBJECTDIR}/_ext/1880736137/drv_tmr.o ${OBJECTDIR}/_ext/1112166103/sys_clk.o ${OBJECTDIR}/_ext/1112166103/sys_clk_pic32mx.o ${OBJECTDIR}/_ext/1510368962/sys_devcon.o ${OBJECTDIR}/_ext/1510368962/sys_devcon_pic32mx.o ${OBJECTDIR}/_ext/2087176412/sys_int_pic32.o ${OBJECTDIR}/_ext/2147153351/sys_ports.o ${OBJECTDIR}/_ext/1386528437/btstack_crypto.o
+OBJECTFILES=${OBJECTDIR}/_ext/101891878/system_init.o ${OBJECTDIR}/_ext/101891878/system_tasks.o ${OBJECTDIR}/_ext/1360937237/btstack_port.o ${OBJECTDIR}/_ext/1360937237/app_debug.o ${OBJECTDIR}/_ext/1360937237/app.o ${OBJECTDIR}/_ext/1360937237/main.o ${OBJECTDIR}/_ext/97075643/spp_and_le_counter.o ${OBJECTDIR}/_ext/770672057/alloc.o ${OBJECTDIR}/_ext/770672057/bitalloc-sbc.o ${OBJECTDIR}/_ext/770672057/bitalloc.o ${OBJECTDIR}/_ext/770672057/bitstream-decode.o ${OBJECTDIR}/_ext/770672057/decoder-oina.o ${OBJECTDIR}/_ext/770672057/decoder-private.o ${OBJECTDIR}/_ext/770672057/decoder-sbc.o ${OBJECTDIR}/_ext/770672057/dequant.o ${OBJECTDIR}/_ext/770672057/framing-sbc.o ${OBJECTDIR}/_ext/770672057/framing.o ${OBJECTDIR}/_ext/770672057/oi_codec_version.o ${OBJECTDIR}/_ext/770672057/synthesis-8-generated.o ${OBJECTDIR}/_ext/770672057/synthesis-dct8.o ${OBJECTDIR}/_ext/770672057/synthesis-sbc.o ${OBJECTDIR}/_ext/1907061729/sbc_analysis.o ${OBJECTDIR}/_ext/1907061729/sbc_dct.o ${OBJECTDIR}/_ext/1907061729/sbc_dct_coeffs.o ${OBJECTDIR}/_ext/1907061729/sbc_enc_bit_alloc_mono.o ${OBJECTDIR}/_ext/1907061729/sbc_enc_bit_alloc_ste.o ${OBJECTDIR}/_ext/1907061729/sbc_enc_coeffs.o ${OBJECTDIR}/_ext/1907061729/sbc_encoder.o ${OBJECTDIR}/_ext/1907061729/sbc_packing.o ${OBJECTDIR}/_ext/968912543/nao-deceased_by_disease.o ${OBJECTDIR}/_ext/835724193/hxcmod.o ${OBJECTDIR}/_ext/34712644/uECC.o ${OBJECTDIR}/_ext/1768064806/btstack_chipset_csr.o ${OBJECTDIR}/_ext/993942601/btstack_run_loop_embedded.o ${OBJECTDIR}/_ext/993942601/btstack_uart_block_embedded.o ${OBJECTDIR}/_ext/524132624/battery_service_server.o ${OBJECTDIR}/_ext/524132624/device_information_service_server.o ${OBJECTDIR}/_ext/524132624/hids_device.o ${OBJECTDIR}/_ext/534563071/att_db.o ${OBJECTDIR}/_ext/534563071/att_dispatch.o ${OBJECTDIR}/_ext/534563071/att_server.o ${OBJECTDIR}/_ext/534563071/le_device_db_memory.o ${OBJECTDIR}/_ext/534563071/sm.o ${OBJECTDIR}/_ext/534563071/ancs_client.o ${OBJECTDIR}/_ext/534563071/gatt_client.o ${OBJECTDIR}/_ext/1386327864/btstack_link_key_db_memory.o ${OBJECTDIR}/_ext/1386327864/sdp_client.o ${OBJECTDIR}/_ext/1386327864/sdp_client_rfcomm.o ${OBJECTDIR}/_ext/1386327864/sdp_server.o ${OBJECTDIR}/_ext/1386327864/sdp_util.o ${OBJECTDIR}/_ext/1386327864/spp_server.o ${OBJECTDIR}/_ext/1386327864/a2dp_sink.o ${OBJECTDIR}/_ext/1386327864/a2dp_source.o ${OBJECTDIR}/_ext/1386327864/avdtp.o ${OBJECTDIR}/_ext/1386327864/avdtp_acceptor.o ${OBJECTDIR}/_ext/1386327864/avdtp_initiator.o ${OBJECTDIR}/_ext/1386327864/avdtp_sink.o ${OBJECTDIR}/_ext/1386327864/avdtp_source.o ${OBJECTDIR}/_ext/1386327864/avdtp_util.o ${OBJECTDIR}/_ext/1386327864/avrcp.o ${OBJECTDIR}/_ext/1386327864/avrcp_browsing_controller.o ${OBJECTDIR}/_ext/1386327864/avrcp_controller.o ${OBJECTDIR}/_ext/1386327864/avrcp_media_item_iterator.o ${OBJECTDIR}/_ext/1386327864/avrcp_target.o ${OBJECTDIR}/_ext/1386327864/bnep.o ${OBJECTDIR}/_ext/1386327864/btstack_cvsd_plc.o ${OBJECTDIR}/_ext/1386327864/btstack_sbc_decoder_bluedroid.o ${OBJECTDIR}/_ext/1386327864/btstack_sbc_encoder_bluedroid.o ${OBJECTDIR}/_ext/1386327864/btstack_sbc_plc.o ${OBJECTDIR}/_ext/1386327864/device_id_server.o ${OBJECTDIR}/_ext/1386327864/goep_client.o ${OBJECTDIR}/_ext/1386327864/hfp.o ${OBJECTDIR}/_ext/1386327864/hfp_ag.o ${OBJECTDIR}/_ext/1386327864/hfp_gsm_model.o ${OBJECTDIR}/_ext/1386327864/hfp_hf.o ${OBJECTDIR}/_ext/1386327864/hfp_msbc.o ${OBJECTDIR}/_ext/1386327864/hid_device.o ${OBJECTDIR}/_ext/1386327864/hsp_ag.o ${OBJECTDIR}/_ext/1386327864/hsp_hs.o ${OBJECTDIR}/_ext/1386327864/obex_iterator.o ${OBJECTDIR}/_ext/1386327864/pan.o ${OBJECTDIR}/_ext/1386327864/pbap_client.o ${OBJECTDIR}/_ext/1386528437/btstack_memory.o ${OBJECTDIR}/_ext/1386528437/hci.o ${OBJECTDIR}/_ext/1386528437/hci_cmd.o ${OBJECTDIR}/_ext/1386528437/hci_dump.o ${OBJECTDIR}/_ext/1386528437/l2cap.o ${OBJECTDIR}/_ext/1386528437/l2cap_signaling.o ${OBJECTDIR}/_ext/1386528437/btstack_linked_list.o ${OBJECTDIR}/_ext/1386528437/btstack_memory_pool.o ${OBJECTDIR}/_ext/1386327864/rfcomm.o ${OBJECTDIR}/_ext/1386528437/btstack_run_loop.o ${OBJECTDIR}/_ext/1386528437/btstack_util.o ${OBJECTDIR}/_ext/1386528437/btstack_ring_buffer.o ${OBJECTDIR}/_ext/1386528437/hci_transport_h4.o ${OBJECTDIR}/_ext/1386528437/hci_transport_h5.o ${OBJECTDIR}/_ext/1386528437/btstack_slip.o ${OBJECTDIR}/_ext/1386528437/ad_parser.o ${OBJECTDIR}/_ext/1386528437/btstack_tlv.o ${OBJECTDIR}/_ext/1880736137/drv_tmr.o ${OBJECTDIR}/_ext/1112166103/sys_clk.o ${OBJECTDIR}/_ext/1112166103/sys_clk_pic32mx.o ${OBJECTDIR}/_ext/1510368962/sys_devcon.o ${OBJECTDIR}/_ext/1510368962/sys_devcon_pic32mx.o ${OBJECTDIR}/_ext/2087176412/sys_int_pic32.o ${OBJECTDIR}/_ext/2147153351/sys_ports.o ${OBJECTDIR}/_ext/1386528437/btstack_crypto.o
 
 # Source Files
-SOURCEFILES=../src/system_config/bt_audio_dk/system_init.c ../src/system_config/bt_audio_dk/system_tasks.c ../src/btstack_port.c ../src/app_debug.c ../src/app.c ../src/main.c ../../../example/spp_and_le_counter.c ../../../3rd-party/bluedroid/decoder/srce/alloc.c ../../../3rd-party/bluedroid/decoder/srce/bitalloc-sbc.c ../../../3rd-party/bluedroid/decoder/srce/bitalloc.c ../../../3rd-party/bluedroid/decoder/srce/bitstream-decode.c ../../../3rd-party/bluedroid/decoder/srce/decoder-oina.c ../../../3rd-party/bluedroid/decoder/srce/decoder-private.c ../../../3rd-party/bluedroid/decoder/srce/decoder-sbc.c ../../../3rd-party/bluedroid/decoder/srce/dequant.c ../../../3rd-party/bluedroid/decoder/srce/framing-sbc.c ../../../3rd-party/bluedroid/decoder/srce/framing.c ../../../3rd-party/bluedroid/decoder/srce/oi_codec_version.c ../../../3rd-party/bluedroid/decoder/srce/synthesis-8-generated.c ../../../3rd-party/bluedroid/decoder/srce/synthesis-dct8.c ../../../3rd-party/bluedroid/decoder/srce/synthesis-sbc.c ../../../3rd-party/bluedroid/encoder/srce/sbc_analysis.c ../../../3rd-party/bluedroid/encoder/srce/sbc_dct.c ../../../3rd-party/bluedroid/encoder/srce/sbc_dct_coeffs.c ../../../3rd-party/bluedroid/encoder/srce/sbc_enc_bit_alloc_mono.c ../../../3rd-party/bluedroid/encoder/srce/sbc_enc_bit_alloc_ste.c ../../../3rd-party/bluedroid/encoder/srce/sbc_enc_coeffs.c ../../../3rd-party/bluedroid/encoder/srce/sbc_encoder.c ../../../3rd-party/bluedroid/encoder/srce/sbc_packing.c ../../../3rd-party/hxcmod-player/mods/nao-deceased_by_disease.c ../../../3rd-party/hxcmod-player/hxcmod.c ../../../3rd-party/micro-ecc/uECC.c ../../../chipset/csr/btstack_chipset_csr.c ../../../platform/embedded/btstack_run_loop_embedded.c ../../../platform/embedded/btstack_uart_block_embedded.c ../../../src/ble/gatt-service/battery_service_server.c ../../../src/ble/gatt-service/device_information_service_server.c ../../../src/ble/gatt-service/hids_device.c ../../../src/ble/att_db.c ../../../src/ble/att_dispatch.c ../../../src/ble/att_server.c ../../../src/ble/le_device_db_memory.c ../../../src/ble/sm.c ../../../src/ble/ancs_client.c ../../../src/ble/gatt_client.c ../../../src/classic/btstack_link_key_db_memory.c ../../../src/classic/sdp_client.c ../../../src/classic/sdp_client_rfcomm.c ../../../src/classic/sdp_server.c ../../../src/classic/sdp_util.c ../../../src/classic/spp_server.c ../../../src/classic/a2dp_sink.c ../../../src/classic/a2dp_source.c ../../../src/classic/avdtp.c ../../../src/classic/avdtp_acceptor.c ../../../src/classic/avdtp_initiator.c ../../../src/classic/avdtp_sink.c ../../../src/classic/avdtp_source.c ../../../src/classic/avdtp_util.c ../../../src/classic/avrcp.c ../../../src/classic/avrcp_browsing_controller.c ../../../src/classic/avrcp_controller.c ../../../src/classic/avrcp_media_item_iterator.c ../../../src/classic/avrcp_target.c ../../../src/classic/bnep.c ../../../src/classic/btstack_cvsd_plc.c ../../../src/classic/btstack_sbc_decoder_bluedroid.c ../../../src/classic/btstack_sbc_encoder_bluedroid.c ../../../src/classic/btstack_sbc_plc.c ../../../src/classic/device_id_server.c ../../../src/classic/goep_client.c ../../../src/classic/hfp.c ../../../src/classic/hfp_ag.c ../../../src/classic/hfp_gsm_model.c ../../../src/classic/hfp_hf.c ../../../src/classic/hfp_msbc.c ../../../src/classic/hid_device.c ../../../src/classic/hsp_ag.c ../../../src/classic/hsp_hs.c ../../../src/classic/obex_iterator.c ../../../src/classic/pan.c ../../../src/classic/pbap_client.c ../../../src/btstack_memory.c ../../../src/hci.c ../../../src/hci_cmd.c ../../../src/hci_dump.c ../../../src/l2cap.c ../../../src/l2cap_signaling.c ../../../src/btstack_linked_list.c ../../../src/btstack_memory_pool.c ../../../src/classic/rfcomm.c ../../../src/btstack_run_loop.c ../../../src/btstack_util.c ../../../src/hci_transport_h4.c ../../../src/hci_transport_h5.c ../../../src/btstack_slip.c ../../../src/ad_parser.c ../../../src/btstack_tlv.c ../../../../driver/tmr/src/dynamic/drv_tmr.c ../../../../system/clk/src/sys_clk.c ../../../../system/clk/src/sys_clk_pic32mx.c ../../../../system/devcon/src/sys_devcon.c ../../../../system/devcon/src/sys_devcon_pic32mx.c ../../../../system/int/src/sys_int_pic32.c ../../../../system/ports/src/sys_ports.c ../../../src/btstack_crypto.c
+SOURCEFILES=../src/system_config/bt_audio_dk/system_init.c ../src/system_config/bt_audio_dk/system_tasks.c ../src/btstack_port.c ../src/app_debug.c ../src/app.c ../src/main.c ../../../example/spp_and_le_counter.c ../../../3rd-party/bluedroid/decoder/srce/alloc.c ../../../3rd-party/bluedroid/decoder/srce/bitalloc-sbc.c ../../../3rd-party/bluedroid/decoder/srce/bitalloc.c ../../../3rd-party/bluedroid/decoder/srce/bitstream-decode.c ../../../3rd-party/bluedroid/decoder/srce/decoder-oina.c ../../../3rd-party/bluedroid/decoder/srce/decoder-private.c ../../../3rd-party/bluedroid/decoder/srce/decoder-sbc.c ../../../3rd-party/bluedroid/decoder/srce/dequant.c ../../../3rd-party/bluedroid/decoder/srce/framing-sbc.c ../../../3rd-party/bluedroid/decoder/srce/framing.c ../../../3rd-party/bluedroid/decoder/srce/oi_codec_version.c ../../../3rd-party/bluedroid/decoder/srce/synthesis-8-generated.c ../../../3rd-party/bluedroid/decoder/srce/synthesis-dct8.c ../../../3rd-party/bluedroid/decoder/srce/synthesis-sbc.c ../../../3rd-party/bluedroid/encoder/srce/sbc_analysis.c ../../../3rd-party/bluedroid/encoder/srce/sbc_dct.c ../../../3rd-party/bluedroid/encoder/srce/sbc_dct_coeffs.c ../../../3rd-party/bluedroid/encoder/srce/sbc_enc_bit_alloc_mono.c ../../../3rd-party/bluedroid/encoder/srce/sbc_enc_bit_alloc_ste.c ../../../3rd-party/bluedroid/encoder/srce/sbc_enc_coeffs.c ../../../3rd-party/bluedroid/encoder/srce/sbc_encoder.c ../../../3rd-party/bluedroid/encoder/srce/sbc_packing.c ../../../3rd-party/hxcmod-player/mods/nao-deceased_by_disease.c ../../../3rd-party/hxcmod-player/hxcmod.c ../../../3rd-party/micro-ecc/uECC.c ../../../chipset/csr/btstack_chipset_csr.c ../../../platform/embedded/btstack_run_loop_embedded.c ../../../platform/embedded/btstack_uart_block_embedded.c ../../../src/ble/gatt-service/battery_service_server.c ../../../src/ble/gatt-service/device_information_service_server.c ../../../src/ble/gatt-service/hids_device.c ../../../src/ble/att_db.c ../../../src/ble/att_dispatch.c ../../../src/ble/att_server.c ../../../src/ble/le_device_db_memory.c ../../../src/ble/sm.c ../../../src/ble/ancs_client.c ../../../src/ble/gatt_client.c ../../../src/classic/btstack_link_key_db_memory.c ../../../src/classic/sdp_client.c ../../../src/classic/sdp_client_rfcomm.c ../../../src/classic/sdp_server.c ../../../src/classic/sdp_util.c ../../../src/classic/spp_server.c ../../../src/classic/a2dp_sink.c ../../../src/classic/a2dp_source.c ../../../src/classic/avdtp.c ../../../src/classic/avdtp_acceptor.c ../../../src/classic/avdtp_initiator.c ../../../src/classic/avdtp_sink.c ../../../src/classic/avdtp_source.c ../../../src/classic/avdtp_util.c ../../../src/classic/avrcp.c ../../../src/classic/avrcp_browsing_controller.c ../../../src/classic/avrcp_controller.c ../../../src/classic/avrcp_media_item_iterator.c ../../../src/classic/avrcp_target.c ../../../src/classic/bnep.c ../../../src/classic/btstack_cvsd_plc.c ../../../src/classic/btstack_sbc_decoder_bluedroid.c ../../../src/classic/btstack_sbc_encoder_bluedroid.c ../../../src/classic/btstack_sbc_plc.c ../../../src/classic/device_id_server.c ../../../src/classic/goep_client.c ../../../src/classic/hfp.c ../../../src/classic/hfp_ag.c ../../../src/classic/hfp_gsm_model.c ../../../src/classic/hfp_hf.c ../../../src/classic/hfp_msbc.c ../../../src/classic/hid_device.c ../../../src/classic/hsp_ag.c ../../../src/classic/hsp_hs.c ../../../src/classic/obex_iterator.c ../../../src/classic/pan.c ../../../src/classic/pbap_client.c ../../../src/btstack_memory.c ../../../src/hci.c ../../../src/hci_cmd.c ../../../src/hci_dump.c ../../../src/l2cap.c ../../../src/l2cap_signaling.c ../../../src/btstack_linked_list.c ../../../src/btstack_memory_pool.c ../../../src/classic/rfcomm.c ../../../src/btstack_run_loop.c ../../../src/btstack_util.c ../../../src/btstack_ring_buffer.c ../../../src/hci_transport_h4.c ../../../src/hci_transport_h5.c ../../../src/btstack_slip.c ../../../src/ad_parser.c ../../../src/btstack_tlv.c ../../../../driver/tmr/src/dynamic/drv_tmr.c ../../../../system/clk/src/sys_clk.c ../../../../system/clk/src/sys_clk_pic32mx.c ../../../../system/devcon/src/sys_devcon.c ../../../../system/devcon/src/sys_devcon_pic32mx.c ../../../../system/int/src/sys_int_pic32.c ../../../../system/ports/src/sys_ports.c ../../../src/btstack_crypto.c
 
 
 CFLAGS=
@@ -652,6 +652,12 @@ ${OBJECTDIR}/_ext/1386528437/btstack_util.o: ../../../src/btstack_util.c  nbproj
 	@${RM} ${OBJECTDIR}/_ext/1386528437/btstack_util.o 
 	@${FIXDEPS} "${OBJECTDIR}/_ext/1386528437/btstack_util.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -Os -I"." -I"../../../.." -I"../src" -I"../src/system_config/bt_audio_dk" -I"../../../src" -I"../../../chipset/csr" -I"../../../platform/embedded" -I"../../../3rd-party/micro-ecc" -I"../../../3rd-party/bluedroid/decoder/include" -I"../../../3rd-party/bluedroid/encoder/include" -I"../../../3rd-party/hxcmod-player" -I"../../../3rd-party/hxcmod-player/mods" -MMD -MF "${OBJECTDIR}/_ext/1386528437/btstack_util.o.d" -o ${OBJECTDIR}/_ext/1386528437/btstack_util.o ../../../src/btstack_util.c     
 	
+${OBJECTDIR}/_ext/1386528437/btstack_ring_buffer.o: ../../../src/btstack_ring_buffer.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/_ext/1386528437" 
+	@${RM} ${OBJECTDIR}/_ext/1386528437/btstack_ring_buffer.o.d 
+	@${RM} ${OBJECTDIR}/_ext/1386528437/btstack_ring_buffer.o 
+	@${FIXDEPS} "${OBJECTDIR}/_ext/1386528437/btstack_ring_buffer.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -Os -I"." -I"../../../.." -I"../src" -I"../src/system_config/bt_audio_dk" -I"../../../src" -I"../../../chipset/csr" -I"../../../platform/embedded" -I"../../../3rd-party/micro-ecc" -I"../../../3rd-party/bluedroid/decoder/include" -I"../../../3rd-party/bluedroid/encoder/include" -I"../../../3rd-party/hxcmod-player" -I"../../../3rd-party/hxcmod-player/mods" -MMD -MF "${OBJECTDIR}/_ext/1386528437/btstack_ring_buffer.o.d" -o ${OBJECTDIR}/_ext/1386528437/btstack_ring_buffer.o ../../../src/btstack_ring_buffer.c     
+	
 ${OBJECTDIR}/_ext/1386528437/hci_transport_h4.o: ../../../src/hci_transport_h4.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}/_ext/1386528437" 
 	@${RM} ${OBJECTDIR}/_ext/1386528437/hci_transport_h4.o.d 
@@ -1289,6 +1295,12 @@ ${OBJECTDIR}/_ext/1386528437/btstack_util.o: ../../../src/btstack_util.c  nbproj
 	@${RM} ${OBJECTDIR}/_ext/1386528437/btstack_util.o 
 	@${FIXDEPS} "${OBJECTDIR}/_ext/1386528437/btstack_util.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -Os -I"." -I"../../../.." -I"../src" -I"../src/system_config/bt_audio_dk" -I"../../../src" -I"../../../chipset/csr" -I"../../../platform/embedded" -I"../../../3rd-party/micro-ecc" -I"../../../3rd-party/bluedroid/decoder/include" -I"../../../3rd-party/bluedroid/encoder/include" -I"../../../3rd-party/hxcmod-player" -I"../../../3rd-party/hxcmod-player/mods" -MMD -MF "${OBJECTDIR}/_ext/1386528437/btstack_util.o.d" -o ${OBJECTDIR}/_ext/1386528437/btstack_util.o ../../../src/btstack_util.c     
 	
+${OBJECTDIR}/_ext/1386528437/btstack_ring_buffer.o: ../../../src/btstack_ring_buffer.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/_ext/1386528437" 
+	@${RM} ${OBJECTDIR}/_ext/1386528437/btstack_ring_buffer.o.d 
+	@${RM} ${OBJECTDIR}/_ext/1386528437/btstack_ring_buffer.o 
+	@${FIXDEPS} "${OBJECTDIR}/_ext/1386528437/btstack_ring_buffer.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -Os -I"." -I"../../../.." -I"../src" -I"../src/system_config/bt_audio_dk" -I"../../../src" -I"../../../chipset/csr" -I"../../../platform/embedded" -I"../../../3rd-party/micro-ecc" -I"../../../3rd-party/bluedroid/decoder/include" -I"../../../3rd-party/bluedroid/encoder/include" -I"../../../3rd-party/hxcmod-player" -I"../../../3rd-party/hxcmod-player/mods" -MMD -MF "${OBJECTDIR}/_ext/1386528437/btstack_ring_buffer.o.d" -o ${OBJECTDIR}/_ext/1386528437/btstack_ring_buffer.o ../../../src/btstack_ring_buffer.c     
+	
 ${OBJECTDIR}/_ext/1386528437/hci_transport_h4.o: ../../../src/hci_transport_h4.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}/_ext/1386528437" 
 	@${RM} ${OBJECTDIR}/_ext/1386528437/hci_transport_h4.o.d 
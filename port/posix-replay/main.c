@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define __BTSTACK_FILE__ "main.c"
+
+// *****************************************************************************
+//
+// hci_replay: replays Controller to Host packets of a PacketLogger or BlueZ hcidump packet log
+// through HCI, L2CAP, RFCOMM, SDP Server, SM, and ATT Server, and reports the processing rate
+//
+// usage: hci_replay [-t] [-o host_log.pklg] packet_log
+//   -t  deliver packets with the time differences of the packet log, default: as fast as possible
+//   -o  log packets and debug output of the replay
+//
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "btstack_config.h"
+
+#include "btstack_memory.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_tlv_posix.h"
+#include "hci.h"
+#include "hci_dump.h"
+#include "hci_dump_reader_posix.h"
+#include "hci_transport_replay_posix.h"
+#include "l2cap.h"
+#include "ble/att_server.h"
+#include "ble/le_device_db_tlv.h"
+#include "classic/rfcomm.h"
+#include "classic/sdp_server.h"
+#include "ble/sm.h"
+
+// GAP Service with Device Name
+static const uint8_t profile_data[] = {
+    // ATT DB Version
+    1,
+    // 0x0001 PRIMARY_SERVICE-GAP_SERVICE
+    0x0a, 0x00, 0x02, 0x00, 0x01, 0x00, 0x00, 0x28, 0x00, 0x18,
+    // 0x0002 CHARACTERISTIC-GAP_DEVICE_NAME-READ
+    0x0d, 0x00, 0x02, 0x00, 0x02, 0x00, 0x03, 0x28, 0x02, 0x03, 0x00, 0x00, 0x2a,
+    // 0x0003 VALUE-GAP_DEVICE_NAME-READ-'Replay'
+    0x0e, 0x00, 0x02, 0x00, 0x03, 0x00, 0x00, 0x2a, 0x52, 0x65, 0x70, 0x6c, 0x61, 0x79,
+    // END
+    0x00, 0x00,
+};
+
+// bonding information is not kept between runs
+#define TLV_DB_PATH "/tmp/hci_replay.tlv"
+
+static hci_dump_reader_posix_t reader;
+static btstack_tlv_posix_t     tlv_context;
+
+static void usage(const char * name){
+    printf("usage: %s [-t] [-o host_log.pklg] packet_log\n", name);
+    printf("  -t  deliver packets with the time differences of the packet log, default: as fast as possible\n");
+    printf("  -o  log packets and debug output of the replay\n");
+}
+
+static void replay_done(void){
+    hci_transport_replay_posix_stats_t stats;
+    hci_transport_replay_posix_get_stats(&stats);
+    uint32_t num_packets = stats.num_events + stats.num_acl_packets + stats.num_sco_packets;
+    double seconds = stats.duration_us / 1000000.0;
+    printf("Controller to Host: %u events, %u ACL packets, %u SCO packets, %u bytes\n",
+        stats.num_events, stats.num_acl_packets, stats.num_sco_packets, stats.num_bytes);
+    printf("Host to Controller: %u commands, %u ACL packets, %u SCO packets\n",
+        stats.num_host_commands, stats.num_host_acl_packets, stats.num_host_sco_packets);
+    if (stats.num_command_timeouts){
+        printf("Command Complete / Status without command from host: %u\n", stats.num_command_timeouts);
+    }
+    printf("Duration: %.3f ms", seconds * 1000.0);
+    if (seconds > 0){
+        printf(", %.0f packets/s, %.2f MB/s", num_packets / seconds, stats.num_bytes / seconds / 1000000.0);
+    }
+    printf("\n");
+    hci_dump_close();
+    hci_dump_reader_posix_close(&reader);
+    btstack_tlv_posix_deinit(&tlv_context);
+    unlink(TLV_DB_PATH);
+    exit(0);
+}
+
+int main(int argc, const char * argv[]){
+    int timing_accurate = 0;
+    const char * host_log_path = NULL;
+    const char * packet_log_path = NULL;
+    int i;
+    for (i = 1; i < argc; i++){
+        if (strcmp(argv[i], "-t") == 0){
+            timing_accurate = 1;
+        } else if (strcmp(argv[i], "-o") == 0 && (i + 1) < argc){
+            host_log_path = argv[++i];
+        } else if (argv[i][0] != '-' && packet_log_path == NULL){
+            packet_log_path = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (packet_log_path == NULL){
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (hci_dump_reader_posix_open(&reader, packet_log_path) != 0){
+        printf("Cannot read packet log %s\n", packet_log_path);
+        return 1;
+    }
+    printf("Replay %s (%s), %s\n", packet_log_path,
+        hci_dump_reader_posix_get_format(&reader) == HCI_DUMP_BLUEZ ? "BlueZ" : "PacketLogger",
+        timing_accurate ? "timing accurate" : "as fast as possible");
+
+    if (host_log_path){
+        hci_dump_open(host_log_path, HCI_DUMP_PACKETLOGGER);
+    } else {
+        hci_dump_enable_log_level(HCI_DUMP_LOG_LEVEL_DEBUG, 0);
+        hci_dump_enable_log_level(HCI_DUMP_LOG_LEVEL_INFO, 0);
+    }
+
+    btstack_memory_init();
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+
+    unlink(TLV_DB_PATH);
+    const btstack_tlv_t * tlv_impl = btstack_tlv_posix_init_instance(&tlv_context, TLV_DB_PATH);
+    btstack_tlv_set_instance(tlv_impl, &tlv_context);
+    le_device_db_tlv_configure(tlv_impl, &tlv_context);
+
+    hci_transport_replay_posix_set_timing_accurate(timing_accurate);
+    hci_transport_replay_posix_register_done_handler(&replay_done);
+    hci_init(hci_transport_replay_posix_instance(&reader), NULL);
+
+    l2cap_init();
+    rfcomm_init();
+    sdp_init();
+    sm_init();
+    att_server_init(profile_data, NULL, NULL);
+
+    hci_power_control(HCI_POWER_ON);
+    btstack_run_loop_execute();
+    return 0;
+}
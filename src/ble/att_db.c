@@ -95,6 +95,14 @@ static att_write_callback_t att_write_callback = NULL;
 static int      att_prepare_write_error_code   = 0;
 static uint16_t att_prepare_write_error_handle = 0x0000;
 
+// optional index: offset of attribute in att_db by handle, see att_set_db_index
+#define ATT_DB_INDEX_INVALID 0xffff
+static uint16_t * att_db_index;
+static uint16_t   att_db_index_size;
+static int        att_db_index_valid;
+static uint16_t   att_db_index_max_handle;
+static uint16_t   att_db_end_offset;
+
 // single cache for att_is_persistent_ccc - stores flags before write callback
 static uint16_t att_persistent_ccc_handle;
 static uint16_t att_persistent_ccc_uuid16;
@@ -158,8 +166,30 @@ static int att_iterator_match_uuid(att_iterator_t *it, uint8_t *uuid, uint16_t u
 }
 
 
+// position iterator at first attribute with handle >= start_handle, without index at start of att db
+static void att_iterator_init_at_handle(att_iterator_t *it, uint16_t start_handle){
+    att_iterator_init(it);
+    if (!att_db_index_valid) return;
+    uint32_t handle;
+    for (handle = start_handle; handle <= att_db_index_max_handle; handle++){
+        uint16_t offset = att_db_index[handle];
+        if (offset == ATT_DB_INDEX_INVALID) continue;
+        it->att_ptr = &att_db[offset];
+        return;
+    }
+    it->att_ptr = &att_db[att_db_end_offset];
+}
+
 static int att_find_handle(att_iterator_t *it, uint16_t handle){
     if (handle == 0) return 0;
+    if (att_db_index_valid){
+        if (handle > att_db_index_max_handle) return 0;
+        uint16_t offset = att_db_index[handle];
+        if (offset == ATT_DB_INDEX_INVALID) return 0;
+        it->att_ptr = &att_db[offset];
+        att_iterator_fetch_next(it);
+        return 1;
+    }
     att_iterator_init(it);
     while (att_iterator_has_next(it)){
         att_iterator_fetch_next(it);
@@ -202,6 +232,43 @@ static int att_copy_value(att_iterator_t *it, uint16_t offset, uint8_t * buffer,
     return bytes_to_copy;
 }
 
+// requires ascending handles, falls back to linear search otherwise
+static void att_db_index_build(void){
+    att_db_index_valid = 0;
+    if (att_db == NULL || att_db_index == NULL) return;
+    uint16_t i;
+    for (i = 0; i < att_db_index_size; i++){
+        att_db_index[i] = ATT_DB_INDEX_INVALID;
+    }
+    uint16_t prev_handle = 0;
+    att_iterator_t it;
+    att_iterator_init(&it);
+    while (att_iterator_has_next(&it)){
+        uint32_t offset = it.att_ptr - att_db;
+        if (offset >= ATT_DB_INDEX_INVALID){
+            log_error("ATT DB index: ATT DB too large");
+            return;
+        }
+        att_iterator_fetch_next(&it);
+        if (it.size == 0){
+            att_db_end_offset = offset;
+            break;
+        }
+        if (it.handle <= prev_handle){
+            log_error("ATT DB index: handle 0x%04x not ascending", it.handle);
+            return;
+        }
+        if (it.handle >= att_db_index_size){
+            log_error("ATT DB index: handle 0x%04x >= index size %u", it.handle, att_db_index_size);
+            return;
+        }
+        att_db_index[it.handle] = offset;
+        prev_handle = it.handle;
+    }
+    att_db_index_max_handle = prev_handle;
+    att_db_index_valid = 1;
+}
+
 void att_set_db(uint8_t const * db){
     // validate db version
     if (db == NULL) return;
@@ -210,6 +277,13 @@ void att_set_db(uint8_t const * db){
         return;
     }
     att_db = db;
+    att_db_index_build();
+}
+
+void att_set_db_index(uint16_t * index_storage, uint16_t num_entries){
+    att_db_index      = index_storage;
+    att_db_index_size = num_entries;
+    att_db_index_build();
 }
 
 void att_set_read_callback(att_read_callback_t callback){
@@ -378,7 +452,7 @@ static uint16_t handle_find_information_request2(att_connection_t * att_connecti
     uint16_t uuid_len = 0;
     
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_at_handle(&it, start_handle);
     while (att_iterator_has_next(&it)){
         att_iterator_fetch_next(&it);
         if (!it.handle) break;
@@ -460,7 +534,7 @@ static uint16_t handle_find_by_type_value_request2(att_connection_t * att_connec
     uint16_t prev_handle = 0;
     
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_at_handle(&it, start_handle);
     while (att_iterator_has_next(&it)){
         att_iterator_fetch_next(&it);
         
@@ -528,7 +602,7 @@ static uint16_t handle_read_by_type_request2(att_connection_t * att_connection,
     uint16_t pair_len = 0;
 
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_at_handle(&it, start_handle);
     uint8_t error_code = 0;
     uint16_t first_matching_but_unreadable_handle = 0;
 
@@ -858,7 +932,7 @@ static uint16_t handle_read_by_group_type_request2(att_connection_t * att_connec
     uint16_t prev_handle = 0;
 
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_at_handle(&it, start_handle);
     while (att_iterator_has_next(&it)){
         att_iterator_fetch_next(&it);
         
@@ -1224,7 +1298,7 @@ int gatt_server_get_get_handle_range_for_service_with_uuid16(uint16_t uuid16, ui
 // returns 0 if not found
 uint16_t gatt_server_get_value_handle_for_characteristic_with_uuid16(uint16_t start_handle, uint16_t end_handle, uint16_t uuid16){
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_at_handle(&it, start_handle);
     while (att_iterator_has_next(&it)){
         att_iterator_fetch_next(&it);
         if (it.handle && it.handle < start_handle) continue;
@@ -1237,7 +1311,7 @@ uint16_t gatt_server_get_value_handle_for_characteristic_with_uuid16(uint16_t st
 
 uint16_t gatt_server_get_descriptor_handle_for_characteristic_with_uuid16(uint16_t start_handle, uint16_t end_handle, uint16_t characteristic_uuid16, uint16_t descriptor_uuid16){
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_at_handle(&it, start_handle);
     int characteristic_found = 0;
     while (att_iterator_has_next(&it)){
         att_iterator_fetch_next(&it);
@@ -1310,7 +1384,7 @@ uint16_t gatt_server_get_value_handle_for_characteristic_with_uuid128(uint16_t s
     uint8_t attribute_value[16];
     reverse_128(uuid128, attribute_value);
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_at_handle(&it, start_handle);
     while (att_iterator_has_next(&it)){
         att_iterator_fetch_next(&it);
         if (it.handle && it.handle < start_handle) continue;
@@ -1326,7 +1400,7 @@ uint16_t gatt_server_get_client_configuration_handle_for_characteristic_with_uui
     uint8_t attribute_value[16];
     reverse_128(uuid128, attribute_value);
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_at_handle(&it, start_handle);
     int characteristic_found = 0;
     while (att_iterator_has_next(&it)){
         att_iterator_fetch_next(&it);
@@ -1351,6 +1425,32 @@ uint16_t gatt_server_get_client_configuration_handle_for_characteristic_with_uui
 }
 
 
+// returns 0 if not found
+uint16_t gatt_server_get_client_configuration_handle_for_value_handle(uint16_t value_handle){
+    att_iterator_t it;
+    att_iterator_init_at_handle(&it, value_handle);
+    int value_found = 0;
+    while (att_iterator_has_next(&it)){
+        att_iterator_fetch_next(&it);
+        if (it.handle && it.handle < value_handle) continue;
+        if (it.handle == 0) break;
+        if (it.handle == value_handle){
+            value_found = 1;
+            continue;
+        }
+        if (!value_found) break;
+        if (att_iterator_match_uuid16(&it, GATT_PRIMARY_SERVICE_UUID) 
+         || att_iterator_match_uuid16(&it, GATT_SECONDARY_SERVICE_UUID)
+         || att_iterator_match_uuid16(&it, GATT_CHARACTERISTICS_UUID)){
+            break;
+        }
+        if (att_iterator_match_uuid16(&it, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION)){
+            return it.handle;
+        }
+    }
+    return 0;
+}
+
 // 1-item cache to optimize query during write_callback
 static void att_persistent_ccc_cache(att_iterator_t * it){
     att_persistent_ccc_handle = it->handle;
@@ -118,6 +118,15 @@ typedef struct att_service_handler {
  */
 void att_set_db(uint8_t const * db);
 
+/*
+ * @brief provide memory for optional index from attribute handle to attribute, which is built in att_set_db
+ * @note lookups by handle become O(1), requests with handle range start at the first handle. 
+ *       Requires ascending handles. Call att_set_db again after modifying the ATT DB.
+ * @param index_storage with num_entries, at least highest attribute handle + 1, see ATT_DB_INDEX_SIZE in .h generated from .gatt
+ * @param num_entries
+ */
+void att_set_db_index(uint16_t * index_storage, uint16_t num_entries);
+
 /*
  * @brief set callback for read of dynamic attributes
  * @param callback
@@ -253,6 +262,9 @@ uint16_t gatt_server_get_value_handle_for_characteristic_with_uuid128(uint16_t s
 // returns 0 if not found
 uint16_t gatt_server_get_client_configuration_handle_for_characteristic_with_uuid128(uint16_t start_handle, uint16_t end_handle, const uint8_t * uuid128);
 
+// returns 0 if not found
+uint16_t gatt_server_get_client_configuration_handle_for_value_handle(uint16_t value_handle);
+
 // non-user functionality for att_server
 
 /*
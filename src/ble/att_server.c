@@ -71,11 +71,28 @@
 #define NVN_NUM_GATT_SERVER_CCC 20
 #endif
 
+#ifdef ENABLE_ATT_SERVER_NOTIFY_ALL
+#ifndef ATT_SERVER_NOTIFY_ALL_NUM_SLOTS
+#define ATT_SERVER_NOTIFY_ALL_NUM_SLOTS 4
+#endif
+#if (ATT_SERVER_NOTIFY_ALL_NUM_SLOTS < 1) || (ATT_SERVER_NOTIFY_ALL_NUM_SLOTS > 32)
+#error "ATT_SERVER_NOTIFY_ALL_NUM_SLOTS must be between 1 and 32"
+#endif
+#ifndef ATT_SERVER_NOTIFY_ALL_MAX_VALUE_LEN
+#define ATT_SERVER_NOTIFY_ALL_MAX_VALUE_LEN (ATT_DEFAULT_MTU - 3)
+#endif
+#endif
+
 static void att_run_for_context(att_server_t * att_server);
 static att_write_callback_t att_server_write_callback_for_handle(uint16_t handle);
 static btstack_packet_handler_t att_server_packet_handler_for_handle(uint16_t handle);
 static void att_server_persistent_ccc_restore(att_server_t * att_server);
 static void att_server_persistent_ccc_clear(att_server_t * att_server);
+#ifdef ENABLE_ATT_SERVER_NOTIFY_ALL
+static void att_server_notify_all_ccc_write(att_server_t * att_server, uint16_t ccc_handle, uint16_t value);
+static void att_server_notify_all_drop_pending(att_server_t * att_server, uint32_t slot_mask);
+static void att_server_notify_all_send_next(att_server_t * att_server);
+#endif
 
 typedef enum {
     ATT_SERVER_RUN_PHASE_1_REQUESTS,
@@ -225,6 +242,11 @@ static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uin
                             // workaround: identity resolving can already be complete, at least store result
                             att_server->ir_le_device_db_index = sm_le_device_index(con_handle);
                             att_server->pairing_active = 0;
+#ifdef ENABLE_ATT_SERVER_NOTIFY_ALL
+                            att_server->notify_all_subscribed = 0;
+                            att_server->notify_all_pending = 0;
+                            att_server->notify_all_next_slot = 0;
+#endif
                             // notify all
                             att_emit_event_to_all(packet, size);
                             break;
@@ -257,6 +279,10 @@ static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uin
                     att_server = att_server_for_handle(con_handle);
                     if (!att_server) break;
                     att_clear_transaction_queue(&att_server->connection);
+#ifdef ENABLE_ATT_SERVER_NOTIFY_ALL
+                    att_server_notify_all_drop_pending(att_server, 0xffffffffu);
+                    att_server->notify_all_subscribed = 0;
+#endif
                     att_server->connection.con_handle = 0;
                     att_server->pairing_active = 0;
                     att_server->state = ATT_SERVER_IDLE;
@@ -516,6 +542,9 @@ static int att_server_data_ready_for_phase(att_server_t * att_server,  att_serve
         case ATT_SERVER_RUN_PHASE_2_INDICATIONS:
              return (!btstack_linked_list_empty(&att_server->indication_requests) && att_server->value_indication_handle == 0);
         case ATT_SERVER_RUN_PHASE_3_NOTIFICATIONS:
+#ifdef ENABLE_ATT_SERVER_NOTIFY_ALL
+            if (att_server->notify_all_pending) return 1;
+#endif
             return (!btstack_linked_list_empty(&att_server->notification_requests));
     }
     // avoid warning
@@ -534,6 +563,13 @@ static void att_server_trigger_send_for_phase(att_server_t * att_server,  att_se
             client->callback(client->context);
             break;
        case ATT_SERVER_RUN_PHASE_3_NOTIFICATIONS:
+#ifdef ENABLE_ATT_SERVER_NOTIFY_ALL
+            // registered callbacks first, then queued notifications
+            if (btstack_linked_list_empty(&att_server->notification_requests)){
+                att_server_notify_all_send_next(att_server);
+                break;
+            }
+#endif
             client = (btstack_context_callback_registration_t*) att_server->notification_requests;
             btstack_linked_list_remove(&att_server->notification_requests, (btstack_linked_item_t *) client);
             client->callback(client->context);
@@ -817,6 +853,9 @@ static void att_server_persistent_ccc_restore(att_server_t * att_server){
         uint16_t attribute_handle = entry.att_handle;
         uint8_t  value[2];
         little_endian_store_16(value, 0, entry.value);
+#ifdef ENABLE_ATT_SERVER_NOTIFY_ALL
+        att_server_notify_all_ccc_write(att_server, attribute_handle, entry.value);
+#endif
         att_write_callback_t callback = att_server_write_callback_for_handle(attribute_handle);
         if (!callback) continue;
         log_info("CCC Index %u: Set Attribute handle 0x%04x to value 0x%04x", index, attribute_handle, entry.value );
@@ -827,6 +866,115 @@ static void att_server_persistent_ccc_restore(att_server_t * att_server){
 // persistent CCC writes
 // ---------------------
 
+#ifdef ENABLE_ATT_SERVER_NOTIFY_ALL
+// ---------------------
+// notify all subscribers
+// - CCC handles with notifications enabled by at least one connection get a value slot
+// - each connection has a bit per slot for enabled notifications and for queued notifications
+// - a queued notification sends the current value of the slot, i.e. updates are coalesced
+
+typedef struct {
+    uint16_t ccc_handle;
+    uint16_t attribute_handle;  // 0 if no value set yet
+    uint16_t value_len;
+    uint8_t  value[ATT_SERVER_NOTIFY_ALL_MAX_VALUE_LEN];
+} att_server_notify_all_slot_t;
+
+static att_server_notify_all_slot_t  att_server_notify_all_slots[ATT_SERVER_NOTIFY_ALL_NUM_SLOTS];
+static att_server_notify_all_stats_t att_server_notify_all_stats;
+
+static int att_server_notify_all_count_bits(uint32_t bits){
+    int count = 0;
+    while (bits){
+        bits &= bits - 1;
+        count++;
+    }
+    return count;
+}
+
+static void att_server_notify_all_drop_pending(att_server_t * att_server, uint32_t slot_mask){
+    uint32_t dropped = att_server->notify_all_pending & slot_mask;
+    if (!dropped) return;
+    int num_dropped = att_server_notify_all_count_bits(dropped);
+    att_server->notify_all_pending &= ~slot_mask;
+    att_server_notify_all_stats.notifications_dropped += num_dropped;
+    att_server_notify_all_stats.queue_depth -= num_dropped;
+}
+
+// returns slot index or -1 if not found
+static int att_server_notify_all_slot_for_ccc_handle(uint16_t ccc_handle){
+    int slot;
+    for (slot=0;slot<ATT_SERVER_NOTIFY_ALL_NUM_SLOTS;slot++){
+        if (att_server_notify_all_slots[slot].ccc_handle == ccc_handle) return slot;
+    }
+    return -1;
+}
+
+// returns slot index or -1 if all slots are in use by connected subscribers
+static int att_server_notify_all_slot_allocate(uint16_t ccc_handle){
+    uint32_t slots_in_use = 0;
+    btstack_linked_list_iterator_t it;
+    hci_connections_get_iterator(&it);
+    while(btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        slots_in_use |= connection->att_server.notify_all_subscribed | connection->att_server.notify_all_pending;
+    }
+    int slot;
+    for (slot=0;slot<ATT_SERVER_NOTIFY_ALL_NUM_SLOTS;slot++){
+        if (slots_in_use & (1u << slot)) continue;
+        att_server_notify_all_slots[slot].ccc_handle = ccc_handle;
+        att_server_notify_all_slots[slot].attribute_handle = 0;
+        att_server_notify_all_slots[slot].value_len = 0;
+        return slot;
+    }
+    return -1;
+}
+
+// called for CCC writes and for CCC values restored from persistent CCC tags
+static void att_server_notify_all_ccc_write(att_server_t * att_server, uint16_t ccc_handle, uint16_t value){
+    int slot = att_server_notify_all_slot_for_ccc_handle(ccc_handle);
+    if (value & GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION){
+        if (slot < 0){
+            slot = att_server_notify_all_slot_allocate(ccc_handle);
+        }
+        if (slot < 0){
+            log_error("Notify all: no slot for CCC handle 0x%04x, increase ATT_SERVER_NOTIFY_ALL_NUM_SLOTS", ccc_handle);
+            att_server_notify_all_stats.subscriptions_rejected++;
+            return;
+        }
+        att_server->notify_all_subscribed |= 1u << slot;
+    } else {
+        if (slot < 0) return;
+        att_server->notify_all_subscribed &= ~(1u << slot);
+        att_server_notify_all_drop_pending(att_server, 1u << slot);
+    }
+}
+
+static void att_server_notify_all_send_next(att_server_t * att_server){
+    // round robin over queued slots of this connection
+    int i;
+    for (i=0;i<ATT_SERVER_NOTIFY_ALL_NUM_SLOTS;i++){
+        int slot = (att_server->notify_all_next_slot + i) % ATT_SERVER_NOTIFY_ALL_NUM_SLOTS;
+        if ((att_server->notify_all_pending & (1u << slot)) == 0) continue;
+        att_server->notify_all_pending &= ~(1u << slot);
+        att_server->notify_all_next_slot = (slot + 1) % ATT_SERVER_NOTIFY_ALL_NUM_SLOTS;
+        att_server_notify_all_stats.queue_depth--;
+        att_server_notify_all_stats.notifications_sent++;
+
+        att_server_notify_all_slot_t * notify_all_slot = &att_server_notify_all_slots[slot];
+        l2cap_reserve_packet_buffer();
+        uint8_t * packet_buffer = l2cap_get_outgoing_buffer();
+        uint16_t size = att_prepare_handle_value_notification(&att_server->connection, notify_all_slot->attribute_handle,
+            notify_all_slot->value, notify_all_slot->value_len, packet_buffer);
+        l2cap_send_prepared_connectionless(att_server->connection.con_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, size);
+        return;
+    }
+}
+
+// notify all subscribers
+// ---------------------
+#endif
+
 // gatt service management
 static att_service_handler_t * att_service_handler_for_handle(uint16_t handle){
     btstack_linked_list_iterator_t it;
@@ -905,6 +1053,12 @@ static int att_server_write_callback(hci_con_handle_t con_handle, uint16_t attri
     // track CCC writes
     if (att_is_persistent_ccc(attribute_handle) && offset == 0 && buffer_size == 2){
         att_server_persistent_ccc_write(con_handle, attribute_handle, little_endian_read_16(buffer, 0));
+#ifdef ENABLE_ATT_SERVER_NOTIFY_ALL
+        att_server_t * att_server = att_server_for_handle(con_handle);
+        if (att_server){
+            att_server_notify_all_ccc_write(att_server, attribute_handle, little_endian_read_16(buffer, 0));
+        }
+#endif
     }
 
     att_write_callback_t callback = att_server_write_callback_for_handle(attribute_handle);
@@ -1016,6 +1170,73 @@ int att_server_indicate(hci_con_handle_t con_handle, uint16_t attribute_handle,
     return 0;
 }
 
+#ifdef ENABLE_ATT_SERVER_NOTIFY_ALL
+int att_server_notify_all_subscribers(uint16_t attribute_handle, const uint8_t *value, uint16_t value_len){
+    if (attribute_handle == 0) return ERROR_CODE_UNSUPPORTED_FEATURE_OR_PARAMETER_VALUE;
+    if (value_len > ATT_SERVER_NOTIFY_ALL_MAX_VALUE_LEN) return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+
+    // find slot by attribute handle, or by CCC handle for first value
+    int slot;
+    for (slot=0;slot<ATT_SERVER_NOTIFY_ALL_NUM_SLOTS;slot++){
+        if (att_server_notify_all_slots[slot].ccc_handle == 0) continue;
+        if (att_server_notify_all_slots[slot].attribute_handle == attribute_handle) break;
+    }
+    if (slot == ATT_SERVER_NOTIFY_ALL_NUM_SLOTS){
+        uint16_t ccc_handle = gatt_server_get_client_configuration_handle_for_value_handle(attribute_handle);
+        if (!ccc_handle) return ERROR_CODE_UNSUPPORTED_FEATURE_OR_PARAMETER_VALUE;
+        slot = att_server_notify_all_slot_for_ccc_handle(ccc_handle);
+        // no connection has enabled notifications
+        if (slot < 0) return ERROR_CODE_SUCCESS;
+    }
+
+    // latest value wins
+    att_server_notify_all_slot_t * notify_all_slot = &att_server_notify_all_slots[slot];
+    notify_all_slot->attribute_handle = attribute_handle;
+    notify_all_slot->value_len = value_len;
+    memcpy(notify_all_slot->value, value, value_len);
+
+    // queue for all subscribers
+    uint32_t slot_mask = 1u << slot;
+    hci_con_handle_t request_con_handle = HCI_CON_HANDLE_INVALID;
+    btstack_linked_list_iterator_t it;
+    hci_connections_get_iterator(&it);
+    while(btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        att_server_t * att_server = &connection->att_server;
+        if ((att_server->notify_all_subscribed & slot_mask) == 0) continue;
+        if (att_server->notify_all_pending & slot_mask){
+            att_server_notify_all_stats.notifications_coalesced++;
+            continue;
+        }
+        att_server->notify_all_pending |= slot_mask;
+        att_server_notify_all_stats.notifications_queued++;
+        att_server_notify_all_stats.queue_depth++;
+        if (att_server_notify_all_stats.queue_depth > att_server_notify_all_stats.max_queue_depth){
+            att_server_notify_all_stats.max_queue_depth = att_server_notify_all_stats.queue_depth;
+        }
+        if (request_con_handle == HCI_CON_HANDLE_INVALID){
+            request_con_handle = att_server->connection.con_handle;
+        }
+    }
+
+    // single request is enough as queues of all connections are served round robin
+    if (request_con_handle != HCI_CON_HANDLE_INVALID){
+        att_dispatch_server_request_can_send_now_event(request_con_handle);
+    }
+    return ERROR_CODE_SUCCESS;
+}
+
+uint16_t att_server_notify_all_get_queue_depth(hci_con_handle_t con_handle){
+    att_server_t * att_server = att_server_for_handle(con_handle);
+    if (!att_server) return 0;
+    return att_server_notify_all_count_bits(att_server->notify_all_pending);
+}
+
+void att_server_notify_all_get_stats(att_server_notify_all_stats_t * stats){
+    *stats = att_server_notify_all_stats;
+}
+#endif
+
 uint16_t att_server_get_mtu(hci_con_handle_t con_handle){
     att_server_t * att_server = att_server_for_handle(con_handle);
     if (!att_server) return 0;
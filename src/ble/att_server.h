@@ -124,6 +124,45 @@ int att_server_notify(hci_con_handle_t con_handle, uint16_t attribute_handle, co
  */
 int att_server_indicate(hci_con_handle_t con_handle, uint16_t attribute_handle, const uint8_t *value, uint16_t value_len);
 
+#ifdef ENABLE_ATT_SERVER_NOTIFY_ALL
+typedef struct {
+    uint32_t notifications_queued;
+    uint32_t notifications_sent;
+    uint32_t notifications_coalesced;   // value updated while notification was still queued
+    uint32_t notifications_dropped;     // queued notification discarded on disconnect or unsubscribe
+    uint32_t subscriptions_rejected;    // notifications enabled while all ATT_SERVER_NOTIFY_ALL_NUM_SLOTS were in use
+    uint16_t queue_depth;               // queued notifications for all connections
+    uint16_t max_queue_depth;
+} att_server_notify_all_stats_t;
+
+/*
+ * @brief notify all connected clients that have enabled notifications for the attribute. The value is
+ * queued for each subscriber and sent as soon as possible, round robin over all connections. If the
+ * attribute is updated before the previous value was sent to a client, only the latest value is sent.
+ * Subscribers are tracked from CCC writes and CCC values restored from persistent CCC tags.
+ * @note value_len is limited by ATT_SERVER_NOTIFY_ALL_MAX_VALUE_LEN
+ * @param attribute_handle of characteristic value with Client Characteristic Configuration descriptor
+ * @param value
+ * @param value_len
+ * @return 0 if ok, ERROR_CODE_UNSUPPORTED_FEATURE_OR_PARAMETER_VALUE if attribute has no CCC descriptor,
+ *         ERROR_CODE_MEMORY_CAPACITY_EXCEEDED if value_len is too large
+ */
+int att_server_notify_all_subscribers(uint16_t attribute_handle, const uint8_t *value, uint16_t value_len);
+
+/*
+ * @brief get number of queued notifications for connection
+ * @param con_handle
+ * @return number of queued notifications
+ */
+uint16_t att_server_notify_all_get_queue_depth(hci_con_handle_t con_handle);
+
+/*
+ * @brief get statistics for att_server_notify_all_subscribers
+ * @param stats
+ */
+void att_server_notify_all_get_stats(att_server_notify_all_stats_t * stats);
+#endif
+
 #ifdef ENABLE_ATT_DELAYED_RESPONSE
 /*
  * @brief response ready - called after returning ATT_READ__RESPONSE_PENDING in an att_read_callback or
@@ -43,6 +43,7 @@
 #include "btstack_config.h"
 
 #include "att_dispatch.h"
+#include "bluetooth_gatt.h"
 #include "ad_parser.h"
 #include "ble/att_db.h"
 #include "ble/core.h"
@@ -53,6 +54,7 @@
 #include "btstack_event.h"
 #include "btstack_memory.h"
 #include "btstack_run_loop.h"
+#include "btstack_tlv.h"
 #include "btstack_util.h"
 #include "classic/sdp_util.h"
 #include "hci.h"
@@ -60,8 +62,19 @@
 #include "hci_dump.h"
 #include "l2cap.h"
 
+#ifdef ENABLE_GATT_CLIENT_LISTENER_INDEX
+#define GATT_CLIENT_LISTENER_INDEX_MASK (GATT_CLIENT_LISTENER_INDEX_SIZE - 1)
+#endif
+
 static btstack_linked_list_t gatt_client_connections;
+#ifdef ENABLE_GATT_CLIENT_LISTENER_INDEX
+// listeners for a single value handle, hashed by con handle and value handle
+static btstack_linked_list_t gatt_client_value_listener_index[GATT_CLIENT_LISTENER_INDEX_SIZE];
+// listeners for all value handles of a connection, hashed by con handle
+static btstack_linked_list_t gatt_client_value_listener_any_index[GATT_CLIENT_LISTENER_INDEX_SIZE];
+#else
 static btstack_linked_list_t gatt_client_value_listeners;
+#endif
 static btstack_packet_callback_registration_t hci_event_callback_registration;
 
 #ifdef ENABLE_GATT_CLIENT_PAIRING
@@ -70,9 +83,19 @@ static btstack_packet_callback_registration_t sm_event_callback_registration;
 
 static uint8_t mtu_exchange_enabled;
 
+#ifdef ENABLE_GATT_CLIENT_REQUEST_QUEUE
+// context whose ongoing operation has been set aside by gatt_client_request_begin
+static gatt_client_t *       gatt_client_request_stash_context;
+static gatt_client_request_t gatt_client_request_stash;
+#endif
+
 static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle, uint8_t *packet, uint16_t size);
 static void gatt_client_event_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
 static void gatt_client_report_error_if_pending(gatt_client_t *peripheral, uint8_t error_code);
+static void gatt_client_run(void);
+#ifdef ENABLE_GATT_CLIENT_REQUEST_QUEUE
+static void gatt_client_request_queue_flush(gatt_client_t * peripheral, uint8_t error_code);
+#endif
 
 #ifdef ENABLE_LE_SIGNED_WRITE
 static void att_signed_write_handle_cmac_result(uint8_t hash[8]);
@@ -121,6 +144,10 @@ static void gatt_client_timeout_handler(btstack_timer_source_t * timer){
     if (!peripheral) return;
     log_info("GATT client timeout handle, handle 0x%02x", peripheral->con_handle);
     gatt_client_report_error_if_pending(peripheral, ATT_ERROR_TIMEOUT);           
+#ifdef ENABLE_GATT_CLIENT_REQUEST_QUEUE
+    // no further requests can be sent after ATT timeout, complete queued operations as on disconnect
+    gatt_client_request_queue_flush(peripheral, ATT_ERROR_TIMEOUT);
+#endif
 }
 
 static void gatt_client_timeout_start(gatt_client_t * peripheral){
@@ -174,15 +201,101 @@ static gatt_client_t * provide_context_for_conn_handle(hci_con_handle_t con_hand
     return context;
 }
 
+static int is_ready(gatt_client_t * context){
+    return context->gatt_client_state == P_READY;
+}
+
 static gatt_client_t * provide_context_for_conn_handle_and_start_timer(hci_con_handle_t con_handle){
     gatt_client_t * context = provide_context_for_conn_handle(con_handle);
     if (!context) return NULL;
+#ifdef ENABLE_GATT_CLIENT_REQUEST_QUEUE
+    // don't extend timeout of ongoing operation, queued operations start timer when dequeued
+    if (!is_ready(context) || context->request_queue_count) return context;
+#endif
     gatt_client_timeout_start(context);
     return context;
 }
 
-static int is_ready(gatt_client_t * context){
-    return context->gatt_client_state == P_READY;
+#ifdef ENABLE_GATT_CLIENT_REQUEST_QUEUE
+static void gatt_client_request_store(gatt_client_request_t * request, const gatt_client_t * context){
+    request->state = context->gatt_client_state;
+    request->callback = context->callback;
+    request->uuid16 = context->uuid16;
+    memcpy(request->uuid128, context->uuid128, 16);
+    request->start_group_handle = context->start_group_handle;
+    request->end_group_handle = context->end_group_handle;
+    request->query_start_handle = context->query_start_handle;
+    request->query_end_handle = context->query_end_handle;
+    request->characteristic_start_handle = context->characteristic_start_handle;
+    request->attribute_handle = context->attribute_handle;
+    request->attribute_offset = context->attribute_offset;
+    request->attribute_length = context->attribute_length;
+    request->attribute_value = context->attribute_value;
+    request->read_multiple_handle_count = context->read_multiple_handle_count;
+    request->read_multiple_handles = context->read_multiple_handles;
+    memcpy(request->client_characteristic_configuration_value, context->client_characteristic_configuration_value, 2);
+    request->filter_with_uuid = context->filter_with_uuid;
+    request->le_device_index = context->le_device_index;
+}
+
+static void gatt_client_request_load(gatt_client_t * context, const gatt_client_request_t * request){
+    context->gatt_client_state = request->state;
+    context->callback = request->callback;
+    context->uuid16 = request->uuid16;
+    memcpy(context->uuid128, request->uuid128, 16);
+    context->start_group_handle = request->start_group_handle;
+    context->end_group_handle = request->end_group_handle;
+    context->query_start_handle = request->query_start_handle;
+    context->query_end_handle = request->query_end_handle;
+    context->characteristic_start_handle = request->characteristic_start_handle;
+    context->attribute_handle = request->attribute_handle;
+    context->attribute_offset = request->attribute_offset;
+    context->attribute_length = request->attribute_length;
+    context->attribute_value = request->attribute_value;
+    context->read_multiple_handle_count = request->read_multiple_handle_count;
+    context->read_multiple_handles = request->read_multiple_handles;
+    memcpy(context->client_characteristic_configuration_value, request->client_characteristic_configuration_value, 2);
+    context->filter_with_uuid = request->filter_with_uuid;
+    context->le_device_index = request->le_device_index;
+}
+
+static void gatt_client_request_dequeue(gatt_client_t * context){
+    gatt_client_request_t * request = &context->request_queue[context->request_queue_head];
+    context->request_queue_head = (context->request_queue_head + 1) % GATT_CLIENT_REQUEST_QUEUE_SIZE;
+    context->request_queue_count--;
+    log_info("GATT client dequeue request, handle 0x%02x, %u pending", context->con_handle, context->request_queue_count);
+    gatt_client_request_load(context, request);
+    gatt_client_timeout_start(context);
+}
+#endif
+
+// API functions set up the operation in the context between gatt_client_request_begin and gatt_client_request_commit
+// with ENABLE_GATT_CLIENT_REQUEST_QUEUE, a busy context stashes its ongoing operation and the new one gets queued on commit
+static uint8_t gatt_client_request_begin(gatt_client_t * context){
+#ifdef ENABLE_GATT_CLIENT_REQUEST_QUEUE
+    if (is_ready(context) && context->request_queue_count == 0) return 0;
+    if (context->request_queue_count == GATT_CLIENT_REQUEST_QUEUE_SIZE) return GATT_CLIENT_BUSY;
+    gatt_client_request_store(&gatt_client_request_stash, context);
+    gatt_client_request_stash_context = context;
+    return 0;
+#else
+    if (!is_ready(context)) return GATT_CLIENT_IN_WRONG_STATE;
+    return 0;
+#endif
+}
+
+static void gatt_client_request_commit(gatt_client_t * context){
+#ifdef ENABLE_GATT_CLIENT_REQUEST_QUEUE
+    if (gatt_client_request_stash_context == context){
+        gatt_client_request_stash_context = NULL;
+        uint8_t index = (context->request_queue_head + context->request_queue_count) % GATT_CLIENT_REQUEST_QUEUE_SIZE;
+        gatt_client_request_store(&context->request_queue[index], context);
+        context->request_queue_count++;
+        log_info("GATT client queue request, handle 0x%02x, %u pending", context->con_handle, context->request_queue_count);
+        gatt_client_request_load(context, &gatt_client_request_stash);
+    }
+#endif
+    gatt_client_run();
 }
 
 int gatt_client_is_ready(hci_con_handle_t con_handle){
@@ -473,6 +586,9 @@ static uint16_t get_last_result_handle_from_included_services_list(uint8_t * pac
 static void gatt_client_handle_transaction_complete(gatt_client_t * peripheral){
     peripheral->gatt_client_state = P_READY;
     gatt_client_timeout_stop(peripheral);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    btstack_run_loop_remove_timer(&peripheral->cache_timer);
+#endif
 }
 
 static void emit_event_new(btstack_packet_handler_t callback, uint8_t * packet, uint16_t size){
@@ -481,29 +597,84 @@ static void emit_event_new(btstack_packet_handler_t callback, uint8_t * packet,
     (*callback)(HCI_EVENT_PACKET, 0, packet, size);
 }
 
+static btstack_linked_list_t * gatt_client_value_listener_list(hci_con_handle_t con_handle, uint16_t attribute_handle){
+#ifdef ENABLE_GATT_CLIENT_LISTENER_INDEX
+    uint32_t hash = (((uint32_t) con_handle << 16) | attribute_handle) * 2654435761u;
+    uint32_t bucket = (hash >> 16) & GATT_CLIENT_LISTENER_INDEX_MASK;
+    if (attribute_handle == GATT_CLIENT_ANY_VALUE_HANDLE){
+        return &gatt_client_value_listener_any_index[bucket];
+    }
+    return &gatt_client_value_listener_index[bucket];
+#else
+    UNUSED(con_handle);
+    UNUSED(attribute_handle);
+    return &gatt_client_value_listeners;
+#endif
+}
+
+static void gatt_client_add_value_listener(gatt_client_notification_t * notification, hci_con_handle_t con_handle, gatt_client_characteristic_t * characteristic){
+    notification->con_handle = con_handle;
+    notification->attribute_handle = characteristic ? characteristic->value_handle : GATT_CLIENT_ANY_VALUE_HANDLE;
+    btstack_linked_list_add(gatt_client_value_listener_list(con_handle, notification->attribute_handle), (btstack_linked_item_t*) notification);
+}
+
 void gatt_client_listen_for_characteristic_value_updates(gatt_client_notification_t * notification, btstack_packet_handler_t packet_handler, hci_con_handle_t con_handle, gatt_client_characteristic_t * characteristic){
     notification->callback = packet_handler;
-    notification->con_handle = con_handle;
-    notification->attribute_handle = characteristic->value_handle;
-    btstack_linked_list_add(&gatt_client_value_listeners, (btstack_linked_item_t*) notification);
+    notification->value_handler = NULL;
+    gatt_client_add_value_listener(notification, con_handle, characteristic);
+}
+
+void gatt_client_listen_for_characteristic_value_updates_direct(gatt_client_notification_t * notification, gatt_client_value_handler_t value_handler, hci_con_handle_t con_handle, gatt_client_characteristic_t * characteristic){
+    notification->callback = NULL;
+    notification->value_handler = value_handler;
+    gatt_client_add_value_listener(notification, con_handle, characteristic);
 }
 
 void gatt_client_stop_listening_for_characteristic_value_updates(gatt_client_notification_t * notification){
-    btstack_linked_list_remove(&gatt_client_value_listeners, (btstack_linked_item_t*) notification);
+    btstack_linked_list_remove(gatt_client_value_listener_list(notification->con_handle, notification->attribute_handle), (btstack_linked_item_t*) notification);
 }
 
-static void emit_event_to_registered_listeners(hci_con_handle_t con_handle, uint16_t attribute_handle, uint8_t * packet, uint16_t size){
+// @note assume that value is part of an l2cap buffer - overwrite HCI + L2CAP packet headers
+static const int characteristic_value_event_header_size = 8;
+static uint8_t * setup_characteristic_value_packet(uint8_t type, hci_con_handle_t con_handle, uint16_t attribute_handle, uint8_t * value, uint16_t length);
+
+// event is only set up in front of the value if a listener with packet handler is found
+static void emit_value_to_listeners_in_list(btstack_linked_list_t * listeners, uint8_t type, hci_con_handle_t con_handle, uint16_t attribute_handle, uint8_t * value, uint16_t length, uint8_t ** event){
     btstack_linked_list_iterator_t it;    
-    btstack_linked_list_iterator_init(&it, &gatt_client_value_listeners);
+    btstack_linked_list_iterator_init(&it, listeners);
     while (btstack_linked_list_iterator_has_next(&it)){
         gatt_client_notification_t * notification = (gatt_client_notification_t*) btstack_linked_list_iterator_next(&it);
         if (notification->con_handle != con_handle) continue;
-        if (notification->attribute_handle != attribute_handle) continue;
-        (*notification->callback)(HCI_EVENT_PACKET, 0, packet, size);
+        if ((notification->attribute_handle != attribute_handle) && (notification->attribute_handle != GATT_CLIENT_ANY_VALUE_HANDLE)) continue;
+        if (notification->value_handler){
+            (*notification->value_handler)(con_handle, attribute_handle, value, length);
+            continue;
+        }
+        if (*event == NULL){
+            *event = setup_characteristic_value_packet(type, con_handle, attribute_handle, value, length);
+        }
+        (*notification->callback)(HCI_EVENT_PACKET, 0, *event, characteristic_value_event_header_size + length);
     } 
 }
 
+// with ENABLE_GATT_CLIENT_LISTENER_INDEX, listeners for the value handle are called before listeners for all value handles
+static void emit_value_to_registered_listeners(uint8_t type, hci_con_handle_t con_handle, uint16_t attribute_handle, uint8_t * value, uint16_t length){
+    uint8_t * event = NULL;
+    emit_value_to_listeners_in_list(gatt_client_value_listener_list(con_handle, attribute_handle), type, con_handle, attribute_handle, value, length, &event);
+#ifdef ENABLE_GATT_CLIENT_LISTENER_INDEX
+    emit_value_to_listeners_in_list(gatt_client_value_listener_list(con_handle, GATT_CLIENT_ANY_VALUE_HANDLE), type, con_handle, attribute_handle, value, length, &event);
+#endif
+}
+
+#ifdef ENABLE_GATT_CLIENT_CACHE
+static void gatt_client_cache_query_complete(gatt_client_t * peripheral, uint8_t status);
+static void gatt_client_cache_record_result(gatt_client_t * peripheral, const uint8_t * packet, uint16_t size);
+#endif
+
 static void emit_gatt_complete_event(gatt_client_t * peripheral, uint8_t status){
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_query_complete(peripheral, status);
+#endif
     // @format H1
     uint8_t packet[5];
     packet[0] = GATT_EVENT_QUERY_COMPLETE;
@@ -523,6 +694,9 @@ static void emit_gatt_service_query_result_event(gatt_client_t * peripheral, uin
     little_endian_store_16(packet, 4, start_group_handle);
     little_endian_store_16(packet, 6, end_group_handle);
     reverse_128(uuid128, &packet[8]);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_record_result(peripheral, packet, sizeof(packet));
+#endif
     emit_event_new(peripheral->callback, packet, sizeof(packet));
 }
 
@@ -538,6 +712,9 @@ static void emit_gatt_included_service_query_result_event(gatt_client_t * periph
     little_endian_store_16(packet, 6, start_group_handle);
     little_endian_store_16(packet, 8, end_group_handle);
     reverse_128(uuid128, &packet[10]);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_record_result(peripheral, packet, sizeof(packet));
+#endif
     emit_event_new(peripheral->callback, packet, sizeof(packet));
 }
 
@@ -554,6 +731,9 @@ static void emit_gatt_characteristic_query_result_event(gatt_client_t * peripher
     little_endian_store_16(packet, 8,  end_handle);
     little_endian_store_16(packet, 10, properties);
     reverse_128(uuid128, &packet[12]);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_record_result(peripheral, packet, sizeof(packet));
+#endif
     emit_event_new(peripheral->callback, packet, sizeof(packet));
 }
 
@@ -567,6 +747,9 @@ static void emit_gatt_all_characteristic_descriptors_result_event(
     ///
     little_endian_store_16(packet, 4,  descriptor_handle);
     reverse_128(uuid128, &packet[6]);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_record_result(peripheral, packet, sizeof(packet));
+#endif
     emit_event_new(peripheral->callback, packet, sizeof(packet));
 }
 
@@ -580,6 +763,356 @@ static void emit_gatt_mtu_exchanged_result_event(gatt_client_t * peripheral, uin
     att_dispatch_client_mtu_exchanged(peripheral->con_handle, new_mtu);
     emit_event_new(peripheral->callback, packet, sizeof(packet));
 }
+
+#ifdef ENABLE_GATT_CLIENT_CACHE
+
+// Discovery results of bonded devices are stored in TLV, tag 'G' | le device index | id:
+// - id 0: gatt_client_cache_meta_t
+// - other ids: hash of query key. entry: generation (1), query key, results. Each result is stored as
+//   event type (1), len (1), event without header and con handle, with uuid128 shortened to uuid16 if possible
+// Entry ids are tracked in meta to delete them on invalidation, oldest entry is replaced if list is full
+#define GATT_CLIENT_CACHE_KEY_LEN     21
+#define GATT_CLIENT_CACHE_HEADER_LEN  (1 + GATT_CLIENT_CACHE_KEY_LEN)
+
+#ifndef GATT_CLIENT_CACHE_MAX_ENTRIES
+#define GATT_CLIENT_CACHE_MAX_ENTRIES 16
+#endif
+
+#define GATT_CLIENT_CACHE_DATABASE_HASH_UUID16 0x2B2A
+
+enum {
+    GATT_CLIENT_CACHE_IDLE = 0,     // next discovery state starts a new query
+    GATT_CLIENT_CACHE_BYPASS,       // query is not cached
+    GATT_CLIENT_CACHE_RECORDING,
+    GATT_CLIENT_CACHE_OVERFLOW,     // results exceed GATT_CLIENT_CACHE_ENTRY_SIZE
+};
+
+typedef struct {
+    uint8_t   generation;
+    uint8_t   addr_type;
+    bd_addr_t addr;
+    uint16_t  service_changed_handle;
+    uint8_t   database_hash_valid;
+    uint8_t   database_hash[16];
+    uint8_t   num_entries;
+    uint16_t  entry_ids[GATT_CLIENT_CACHE_MAX_ENTRIES];
+} gatt_client_cache_meta_t;
+
+static uint32_t gatt_client_cache_tag(int le_device_index, uint16_t id){
+    return ((uint32_t) 'G' << 24) | ((uint32_t) (le_device_index & 0xff) << 16) | id;
+}
+
+// FNV-1a folded to 16 bit, 0 is used for meta entry
+static uint16_t gatt_client_cache_query_id(const uint8_t * key){
+    uint32_t hash = 2166136261u;
+    int i;
+    for (i = 0; i < GATT_CLIENT_CACHE_KEY_LEN; i++){
+        hash ^= key[i];
+        hash *= 16777619u;
+    }
+    uint16_t id = (uint16_t) ((hash >> 16) ^ hash);
+    return id ? id : 1;
+}
+
+static uint8_t gatt_client_cache_event_size(uint8_t event_type){
+    switch (event_type){
+        case GATT_EVENT_SERVICE_QUERY_RESULT:
+            return 24;
+        case GATT_EVENT_INCLUDED_SERVICE_QUERY_RESULT:
+            return 26;
+        case GATT_EVENT_CHARACTERISTIC_QUERY_RESULT:
+            return 28;
+        case GATT_EVENT_ALL_CHARACTERISTIC_DESCRIPTORS_QUERY_RESULT:
+            return 22;
+        default:
+            return 0;
+    }
+}
+
+static void gatt_client_cache_meta_store(int le_device_index, const gatt_client_cache_meta_t * meta){
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return;
+    tlv_impl->store_tag(tlv_context, gatt_client_cache_tag(le_device_index, 0), (const uint8_t *) meta, sizeof(gatt_client_cache_meta_t));
+}
+
+static void gatt_client_cache_delete_entries(int le_device_index, gatt_client_cache_meta_t * meta){
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return;
+    int i;
+    for (i = 0; i < meta->num_entries; i++){
+        tlv_impl->delete_tag(tlv_context, gatt_client_cache_tag(le_device_index, meta->entry_ids[i]));
+    }
+    meta->num_entries = 0;
+}
+
+// returns 0 if no cache available for device
+static int gatt_client_cache_meta_get(int le_device_index, gatt_client_cache_meta_t * meta){
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return 0;
+
+    int addr_type = BD_ADDR_TYPE_UNKNOWN;
+    bd_addr_t addr;
+    le_device_db_info(le_device_index, &addr_type, addr, NULL);
+    if (addr_type == BD_ADDR_TYPE_UNKNOWN) return 0;
+
+    int size = tlv_impl->get_tag(tlv_context, gatt_client_cache_tag(le_device_index, 0), (uint8_t *) meta, sizeof(gatt_client_cache_meta_t));
+    if ((size == sizeof(gatt_client_cache_meta_t)) && (meta->addr_type == addr_type) && (bd_addr_cmp(meta->addr, addr) == 0)) return 1;
+
+    // new device or index re-used: delete entries of previous device
+    uint8_t generation = 0;
+    if (size == sizeof(gatt_client_cache_meta_t)){
+        gatt_client_cache_delete_entries(le_device_index, meta);
+        generation = meta->generation + 1;
+    }
+    memset(meta, 0, sizeof(gatt_client_cache_meta_t));
+    meta->generation = generation;
+    meta->addr_type  = (uint8_t) addr_type;
+    bd_addr_copy(meta->addr, addr);
+    gatt_client_cache_meta_store(le_device_index, meta);
+    return 1;
+}
+
+void gatt_client_cache_invalidate(int le_device_index){
+    gatt_client_cache_meta_t meta;
+    if (!gatt_client_cache_meta_get(le_device_index, &meta)) return;
+    log_info("gatt client cache: invalidate entries of device %u", le_device_index);
+    gatt_client_cache_delete_entries(le_device_index, &meta);
+    meta.generation++;
+    gatt_client_cache_meta_store(le_device_index, &meta);
+}
+
+// cache is only used on encrypted connections, identity of bonded device is not verified otherwise
+static int gatt_client_cache_le_device_index(gatt_client_t * peripheral){
+    if (gap_encryption_key_size(peripheral->con_handle) == 0) return -1;
+    return sm_le_device_index(peripheral->con_handle);
+}
+
+// adds entry id to meta, returns id of replaced entry or 0
+static uint16_t gatt_client_cache_meta_add_entry(gatt_client_cache_meta_t * meta, uint16_t id){
+    int i;
+    for (i = 0; i < meta->num_entries; i++){
+        if (meta->entry_ids[i] == id) return 0;
+    }
+    uint16_t replaced_id = 0;
+    if (meta->num_entries == GATT_CLIENT_CACHE_MAX_ENTRIES){
+        replaced_id = meta->entry_ids[0];
+        memmove(&meta->entry_ids[0], &meta->entry_ids[1], (GATT_CLIENT_CACHE_MAX_ENTRIES - 1) * sizeof(uint16_t));
+        meta->num_entries--;
+    }
+    meta->entry_ids[meta->num_entries++] = id;
+    return replaced_id;
+}
+
+// returns 0 if query is not cacheable
+static int gatt_client_cache_query_key(gatt_client_t * peripheral, uint8_t * key){
+    switch (peripheral->gatt_client_state){
+        case P_W2_SEND_SERVICE_QUERY:
+        case P_W2_SEND_ALL_CHARACTERISTICS_OF_SERVICE_QUERY:
+        case P_W2_SEND_ALL_CHARACTERISTIC_DESCRIPTORS_QUERY:
+        case P_W2_SEND_INCLUDED_SERVICE_QUERY:
+            memset(&key[5], 0, 16);
+            break;
+        case P_W2_SEND_SERVICE_WITH_UUID_QUERY:
+        case P_W2_SEND_CHARACTERISTIC_WITH_UUID_QUERY:
+            memcpy(&key[5], peripheral->uuid128, 16);
+            break;
+        default:
+            return 0;
+    }
+    if (peripheral->start_group_handle > peripheral->end_group_handle) return 0;
+    key[0] = (uint8_t) peripheral->gatt_client_state;
+    little_endian_store_16(key, 1, peripheral->start_group_handle);
+    little_endian_store_16(key, 3, peripheral->end_group_handle);
+    return 1;
+}
+
+static void gatt_client_cache_emit_results(gatt_client_t * peripheral){
+    const uint8_t * entry = peripheral->cache_entry;
+    uint16_t entry_len = peripheral->cache_entry_len;
+    uint16_t pos = GATT_CLIENT_CACHE_HEADER_LEN;
+
+    while ((pos + 2) <= entry_len){
+        uint8_t event_type = entry[pos];
+        uint8_t record_len = entry[pos+1];
+        uint8_t event_size = gatt_client_cache_event_size(event_type);
+        pos += 2;
+        if (event_size == 0) break;
+        if ((pos + record_len) > entry_len) break;
+        uint8_t fixed_len = event_size - 20;
+        if ((record_len != fixed_len + 2) && (record_len != fixed_len + 16)) break;
+
+        uint8_t packet[28];
+        packet[0] = event_type;
+        packet[1] = event_size - 2;
+        little_endian_store_16(packet, 2, peripheral->con_handle);
+        memcpy(&packet[4], &entry[pos], fixed_len);
+        if (record_len == fixed_len + 2){
+            uint8_t uuid128[16];
+            uuid_add_bluetooth_prefix(uuid128, little_endian_read_16(entry, pos + fixed_len));
+            reverse_128(uuid128, &packet[4 + fixed_len]);
+        } else {
+            memcpy(&packet[4 + fixed_len], &entry[pos + fixed_len], 16);
+        }
+        emit_event_new(peripheral->callback, packet, event_size);
+        pos += record_len;
+    }
+
+    gatt_client_handle_transaction_complete(peripheral);
+    emit_gatt_complete_event(peripheral, 0);
+}
+
+static void gatt_client_cache_emit_handler(btstack_timer_source_t * timer){
+    btstack_linked_item_t *it;
+    for (it = (btstack_linked_item_t *) gatt_client_connections; it ; it = it->next){
+        gatt_client_t * peripheral = (gatt_client_t *) it;
+        if (&peripheral->cache_timer != timer) continue;
+        if (peripheral->gatt_client_state != P_W4_CACHED_RESULTS_EMITTED) return;
+        gatt_client_cache_emit_results(peripheral);
+        // continue with queued operations
+        gatt_client_run();
+        return;
+    }
+}
+
+// returns 1 if query is answered from cache
+static int gatt_client_cache_query(gatt_client_t * peripheral){
+    if (peripheral->cache_state != GATT_CLIENT_CACHE_IDLE) return 0;
+
+    uint8_t key[GATT_CLIENT_CACHE_KEY_LEN];
+    if (!gatt_client_cache_query_key(peripheral, key)) return 0;
+    peripheral->cache_state = GATT_CLIENT_CACHE_BYPASS;
+
+    int le_device_index = gatt_client_cache_le_device_index(peripheral);
+    if (le_device_index < 0) return 0;
+
+    gatt_client_cache_meta_t meta;
+    if (!gatt_client_cache_meta_get(le_device_index, &meta)) return 0;
+
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    uint32_t tag = gatt_client_cache_tag(le_device_index, gatt_client_cache_query_id(key));
+    int entry_len = tlv_impl->get_tag(tlv_context, tag, peripheral->cache_entry, sizeof(peripheral->cache_entry));
+    if ((entry_len >= GATT_CLIENT_CACHE_HEADER_LEN) && (peripheral->cache_entry[0] == meta.generation)
+        && (memcmp(&peripheral->cache_entry[1], key, GATT_CLIENT_CACHE_KEY_LEN) == 0)){
+        log_info("gatt client cache: query type %u, range 0x%04x-0x%04x from cache", key[0], peripheral->start_group_handle, peripheral->end_group_handle);
+        // emit results from run loop, callbacks must not start another query until complete event
+        peripheral->gatt_client_state = P_W4_CACHED_RESULTS_EMITTED;
+        peripheral->cache_entry_len = (uint16_t) entry_len;
+        gatt_client_timeout_stop(peripheral);
+        btstack_run_loop_set_timer_handler(&peripheral->cache_timer, gatt_client_cache_emit_handler);
+        btstack_run_loop_set_timer(&peripheral->cache_timer, 0);
+        btstack_run_loop_add_timer(&peripheral->cache_timer);
+        return 1;
+    }
+
+    // miss or stale entry, record results
+    peripheral->cache_state = GATT_CLIENT_CACHE_RECORDING;
+    peripheral->cache_entry[0] = meta.generation;
+    memcpy(&peripheral->cache_entry[1], key, GATT_CLIENT_CACHE_KEY_LEN);
+    peripheral->cache_entry_len = GATT_CLIENT_CACHE_HEADER_LEN;
+    return 0;
+}
+
+static void gatt_client_cache_set_service_changed_handle(gatt_client_t * peripheral, uint16_t value_handle){
+    int le_device_index = gatt_client_cache_le_device_index(peripheral);
+    if (le_device_index < 0) return;
+    gatt_client_cache_meta_t meta;
+    if (!gatt_client_cache_meta_get(le_device_index, &meta)) return;
+    if (meta.service_changed_handle == value_handle) return;
+    meta.service_changed_handle = value_handle;
+    gatt_client_cache_meta_store(le_device_index, &meta);
+}
+
+static void gatt_client_cache_record_result(gatt_client_t * peripheral, const uint8_t * packet, uint16_t size){
+    if (peripheral->cache_state != GATT_CLIENT_CACHE_RECORDING) return;
+
+    uint16_t fixed_len = size - 20;
+    uint8_t uuid128[16];
+    reverse_128(&packet[size - 16], uuid128);
+    int has_uuid16 = uuid_has_bluetooth_prefix(uuid128);
+    uint16_t uuid16 = big_endian_read_16(uuid128, 2);
+
+    // Service Changed indication invalidates cache
+    if ((packet[0] == GATT_EVENT_CHARACTERISTIC_QUERY_RESULT) && has_uuid16 && (uuid16 == ORG_BLUETOOTH_CHARACTERISTIC_GATT_SERVICE_CHANGED)){
+        gatt_client_cache_set_service_changed_handle(peripheral, little_endian_read_16(packet, 6));
+    }
+
+    uint16_t record_len = fixed_len + (has_uuid16 ? 2 : 16);
+    if ((peripheral->cache_entry_len + 2u + record_len) > sizeof(peripheral->cache_entry)){
+        log_info("gatt client cache: results exceed GATT_CLIENT_CACHE_ENTRY_SIZE, not cached");
+        peripheral->cache_state = GATT_CLIENT_CACHE_OVERFLOW;
+        return;
+    }
+    uint8_t * record = &peripheral->cache_entry[peripheral->cache_entry_len];
+    record[0] = packet[0];
+    record[1] = (uint8_t) record_len;
+    memcpy(&record[2], &packet[4], fixed_len);
+    if (has_uuid16){
+        little_endian_store_16(record, 2 + fixed_len, uuid16);
+    } else {
+        memcpy(&record[2 + fixed_len], &packet[size - 16], 16);
+    }
+    peripheral->cache_entry_len += 2 + record_len;
+}
+
+static void gatt_client_cache_query_complete(gatt_client_t * peripheral, uint8_t status){
+    uint8_t cache_state = peripheral->cache_state;
+    peripheral->cache_state = GATT_CLIENT_CACHE_IDLE;
+    if (cache_state != GATT_CLIENT_CACHE_RECORDING) return;
+    if (status) return;
+
+    int le_device_index = gatt_client_cache_le_device_index(peripheral);
+    if (le_device_index < 0) return;
+    gatt_client_cache_meta_t meta;
+    if (!gatt_client_cache_meta_get(le_device_index, &meta)) return;
+    // cache invalidated during query
+    if (peripheral->cache_entry[0] != meta.generation) return;
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    uint16_t id = gatt_client_cache_query_id(&peripheral->cache_entry[1]);
+    uint16_t replaced_id = gatt_client_cache_meta_add_entry(&meta, id);
+    if (replaced_id){
+        tlv_impl->delete_tag(tlv_context, gatt_client_cache_tag(le_device_index, replaced_id));
+    }
+    gatt_client_cache_meta_store(le_device_index, &meta);
+    tlv_impl->store_tag(tlv_context, gatt_client_cache_tag(le_device_index, id), peripheral->cache_entry, peripheral->cache_entry_len);
+}
+
+static void gatt_client_cache_handle_indication(gatt_client_t * peripheral, uint16_t value_handle){
+    int le_device_index = gatt_client_cache_le_device_index(peripheral);
+    if (le_device_index < 0) return;
+    gatt_client_cache_meta_t meta;
+    if (!gatt_client_cache_meta_get(le_device_index, &meta)) return;
+    if ((meta.service_changed_handle == 0) || (meta.service_changed_handle != value_handle)) return;
+    log_info("gatt client cache: service changed");
+    gatt_client_cache_invalidate(le_device_index);
+}
+
+static void gatt_client_cache_handle_database_hash(gatt_client_t * peripheral, const uint8_t * database_hash){
+    int le_device_index = gatt_client_cache_le_device_index(peripheral);
+    if (le_device_index < 0) return;
+    gatt_client_cache_meta_t meta;
+    if (!gatt_client_cache_meta_get(le_device_index, &meta)) return;
+    if (meta.database_hash_valid && (memcmp(meta.database_hash, database_hash, 16) == 0)) return;
+    if (meta.database_hash_valid){
+        log_info("gatt client cache: database hash changed");
+        gatt_client_cache_delete_entries(le_device_index, &meta);
+        meta.generation++;
+    }
+    meta.database_hash_valid = 1;
+    memcpy(meta.database_hash, database_hash, 16);
+    gatt_client_cache_meta_store(le_device_index, &meta);
+}
+#endif
+
 ///
 static void report_gatt_services(gatt_client_t * peripheral, uint8_t * packet,  uint16_t size){
     uint8_t attr_length = packet[1];
@@ -663,8 +1196,6 @@ static void report_gatt_included_service_uuid128(gatt_client_t * peripheral, uin
 }
 
 // @returns packet pointer
-// @note assume that value is part of an l2cap buffer - overwrite HCI + L2CAP packet headers
-static const int characteristic_value_event_header_size = 8;
 static uint8_t * setup_characteristic_value_packet(uint8_t type, hci_con_handle_t con_handle, uint16_t attribute_handle, uint8_t * value, uint16_t length){
     // before the value inside the ATT PDU
     uint8_t * packet = value - characteristic_value_event_header_size;
@@ -699,14 +1230,12 @@ static uint8_t * setup_long_characteristic_value_packet(uint8_t type, hci_con_ha
 
 // @note assume that value is part of an l2cap buffer - overwrite parts of the HCI/L2CAP/ATT packet (4/4/3) bytes 
 static void report_gatt_notification(hci_con_handle_t con_handle, uint16_t value_handle, uint8_t * value, int length){
-    uint8_t * packet = setup_characteristic_value_packet(GATT_EVENT_NOTIFICATION, con_handle, value_handle, value, length);
-    emit_event_to_registered_listeners(con_handle, value_handle, packet, characteristic_value_event_header_size + length);
+    emit_value_to_registered_listeners(GATT_EVENT_NOTIFICATION, con_handle, value_handle, value, length);
 }
 
 // @note assume that value is part of an l2cap buffer - overwrite parts of the HCI/L2CAP/ATT packet (4/4/3) bytes 
 static void report_gatt_indication(hci_con_handle_t con_handle, uint16_t value_handle, uint8_t * value, int length){
-    uint8_t * packet = setup_characteristic_value_packet(GATT_EVENT_INDICATION, con_handle, value_handle, value, length);
-    emit_event_to_registered_listeners(con_handle, value_handle, packet, characteristic_value_event_header_size + length);
+    emit_value_to_registered_listeners(GATT_EVENT_INDICATION, con_handle, value_handle, value, length);
 }
 
 // @note assume that value is part of an l2cap buffer - overwrite parts of the HCI/L2CAP/ATT packet (4/4/3) bytes 
@@ -857,6 +1386,12 @@ static int gatt_client_run_for_peripheral( gatt_client_t * peripheral){
         return 1;
     }
 
+#ifdef ENABLE_GATT_CLIENT_REQUEST_QUEUE
+    if (is_ready(peripheral) && peripheral->request_queue_count){
+        gatt_client_request_dequeue(peripheral);
+    }
+#endif
+
     // check MTU for writes
     switch (peripheral->gatt_client_state){
         case P_W2_SEND_WRITE_CHARACTERISTIC_VALUE:
@@ -865,11 +1400,20 @@ static int gatt_client_run_for_peripheral( gatt_client_t * peripheral){
             log_error("gatt_client_run: value len %u > MTU %u - 3\n", peripheral->attribute_length, peripheral_mtu(peripheral));
             gatt_client_handle_transaction_complete(peripheral);
             emit_gatt_complete_event(peripheral, ATT_ERROR_INVALID_ATTRIBUTE_VALUE_LENGTH);
+#ifdef ENABLE_GATT_CLIENT_REQUEST_QUEUE
+            // trigger next queued operation
+            if (peripheral->request_queue_count) return 1;
+#endif
             return 0;
         default:
             break;
     }
 
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    // answer discovery of bonded device from cache
+    if (gatt_client_cache_query(peripheral)) return 0;
+#endif
+
     // log_info("gatt_client_state %u", peripheral->gatt_client_state);
     switch (peripheral->gatt_client_state){
         case P_W2_SEND_SERVICE_QUERY:
@@ -893,6 +1437,14 @@ static int gatt_client_run_for_peripheral( gatt_client_t * peripheral){
             return 1;
 
         case P_W2_SEND_ALL_CHARACTERISTIC_DESCRIPTORS_QUERY:
+#ifdef ENABLE_GATT_CLIENT_REQUEST_QUEUE
+            // characteristic without descriptors, complete in order with queued operations
+            if (peripheral->start_group_handle > peripheral->end_group_handle){
+                gatt_client_handle_transaction_complete(peripheral);
+                emit_gatt_complete_event(peripheral, 0);
+                return 1; // to trigger next queued operation
+            }
+#endif
             peripheral->gatt_client_state = P_W4_CHARACTERISTIC_WITH_UUID_QUERY_RESULT;
             send_gatt_characteristic_descriptor_request(peripheral);
             return 1;
@@ -1075,6 +1627,20 @@ static void gatt_client_report_error_if_pending(gatt_client_t *peripheral, uint8
     emit_gatt_complete_event(peripheral, error_code);
 }
 
+#ifdef ENABLE_GATT_CLIENT_REQUEST_QUEUE
+static void gatt_client_request_queue_flush(gatt_client_t * peripheral, uint8_t error_code){
+    // only report operations queued so far, callbacks might queue new ones
+    uint8_t num_requests = peripheral->request_queue_count;
+    while (num_requests--){
+        gatt_client_request_t * request = &peripheral->request_queue[peripheral->request_queue_head];
+        peripheral->request_queue_head = (peripheral->request_queue_head + 1) % GATT_CLIENT_REQUEST_QUEUE_SIZE;
+        peripheral->request_queue_count--;
+        peripheral->callback = request->callback;
+        emit_gatt_complete_event(peripheral, error_code);
+    }
+}
+#endif
+
 static void gatt_client_event_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
     UNUSED(channel);    // ok: handling own l2cap events
     UNUSED(size);       // ok: there is no channel
@@ -1091,7 +1657,13 @@ static void gatt_client_event_packet_handler(uint8_t packet_type, uint16_t chann
             if (!peripheral) break;
             
             gatt_client_report_error_if_pending(peripheral, ATT_ERROR_HCI_DISCONNECT_RECEIVED);
+#ifdef ENABLE_GATT_CLIENT_REQUEST_QUEUE
+            gatt_client_request_queue_flush(peripheral, ATT_ERROR_HCI_DISCONNECT_RECEIVED);
+#endif
             gatt_client_timeout_stop(peripheral);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+            btstack_run_loop_remove_timer(&peripheral->cache_timer);
+#endif
             btstack_linked_list_remove(&gatt_client_connections, (btstack_linked_item_t *) peripheral);
             btstack_memory_gatt_client_free(peripheral);
             break;
@@ -1183,6 +1755,9 @@ static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle,
             }
             break;
         case ATT_HANDLE_VALUE_INDICATION:
+#ifdef ENABLE_GATT_CLIENT_CACHE
+            gatt_client_cache_handle_indication(peripheral, little_endian_read_16(packet,1));
+#endif
             report_gatt_indication(handle, little_endian_read_16(packet,1), &packet[3], size-3);
             peripheral->send_confirmation = 1;
             break;
@@ -1238,6 +1813,11 @@ static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle,
                     uint16_t last_result_handle = 0;
                     for (offset = 2; offset < size ; offset += pair_size){
                         uint16_t value_handle = little_endian_read_16(packet, offset);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+                        if ((peripheral->uuid16 == GATT_CLIENT_CACHE_DATABASE_HASH_UUID16) && (pair_size == 18)){
+                            gatt_client_cache_handle_database_hash(peripheral, &packet[offset+2]);
+                        }
+#endif
                         report_gatt_characteristic_value(peripheral, value_handle, &packet[offset+2], pair_size-2);
                         last_result_handle = value_handle;
                     }
@@ -1603,17 +2183,19 @@ static void att_signed_write_handle_cmac_result(uint8_t hash[8]){
 
 uint8_t gatt_client_signed_write_without_response(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t handle, uint16_t message_len, uint8_t * message){
     gatt_client_t * peripheral = provide_context_for_conn_handle(con_handle);
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
-    peripheral->le_device_index = sm_le_device_index(con_handle);
-    if (peripheral->le_device_index < 0) return GATT_CLIENT_IN_WRONG_STATE; // device lookup not done / no stored bonding information
+    int le_device_index = sm_le_device_index(con_handle);
+    if (le_device_index < 0) return GATT_CLIENT_IN_WRONG_STATE; // device lookup not done / no stored bonding information
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
 
+    peripheral->le_device_index = le_device_index;
     peripheral->callback = callback;
     peripheral->attribute_handle = handle;
     peripheral->attribute_length = message_len;
     peripheral->attribute_value = message;
     peripheral->gatt_client_state = P_W4_CMAC_READY;
 
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0; 
 }
 #endif
@@ -1621,14 +2203,15 @@ uint8_t gatt_client_signed_write_without_response(btstack_packet_handler_t callb
 uint8_t gatt_client_discover_primary_services(btstack_packet_handler_t callback, hci_con_handle_t con_handle){
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
 
     peripheral->callback = callback;
     peripheral->start_group_handle = 0x0001;
     peripheral->end_group_handle   = 0xffff;
     peripheral->gatt_client_state = P_W2_SEND_SERVICE_QUERY;
     peripheral->uuid16 = 0;
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -1637,7 +2220,8 @@ uint8_t gatt_client_discover_primary_services_by_uuid16(btstack_packet_handler_t
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
 
     peripheral->callback = callback;
     peripheral->start_group_handle = 0x0001;
@@ -1645,7 +2229,7 @@ uint8_t gatt_client_discover_primary_services_by_uuid16(btstack_packet_handler_t
     peripheral->gatt_client_state = P_W2_SEND_SERVICE_WITH_UUID_QUERY;
     peripheral->uuid16 = uuid16;
     uuid_add_bluetooth_prefix((uint8_t*) &(peripheral->uuid128), peripheral->uuid16);
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -1653,7 +2237,8 @@ uint8_t gatt_client_discover_primary_services_by_uuid128(btstack_packet_handler_
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
 
     peripheral->callback = callback;
     peripheral->start_group_handle = 0x0001;
@@ -1661,7 +2246,7 @@ uint8_t gatt_client_discover_primary_services_by_uuid128(btstack_packet_handler_
     peripheral->uuid16 = 0;
     memcpy(peripheral->uuid128, uuid128, 16);
     peripheral->gatt_client_state = P_W2_SEND_SERVICE_WITH_UUID_QUERY;
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -1669,7 +2254,8 @@ uint8_t gatt_client_discover_characteristics_for_service(btstack_packet_handler_
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
 
     peripheral->callback = callback;
     peripheral->start_group_handle = service->start_group_handle;
@@ -1677,7 +2263,7 @@ uint8_t gatt_client_discover_characteristics_for_service(btstack_packet_handler_
     peripheral->filter_with_uuid = 0;
     peripheral->characteristic_start_handle = 0;
     peripheral->gatt_client_state = P_W2_SEND_ALL_CHARACTERISTICS_OF_SERVICE_QUERY;
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -1685,14 +2271,15 @@ uint8_t gatt_client_find_included_services_for_service(btstack_packet_handler_t
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
     
     peripheral->callback = callback;
     peripheral->start_group_handle = service->start_group_handle;
     peripheral->end_group_handle   = service->end_group_handle;
     peripheral->gatt_client_state = P_W2_SEND_INCLUDED_SERVICE_QUERY;
     
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -1700,7 +2287,8 @@ uint8_t gatt_client_discover_characteristics_for_handle_range_by_uuid16(btstack_
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
     
     peripheral->callback = callback;
     peripheral->start_group_handle = start_handle;
@@ -1711,7 +2299,7 @@ uint8_t gatt_client_discover_characteristics_for_handle_range_by_uuid16(btstack_
     peripheral->characteristic_start_handle = 0;
     peripheral->gatt_client_state = P_W2_SEND_CHARACTERISTIC_WITH_UUID_QUERY;
     
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -1719,7 +2307,8 @@ uint8_t gatt_client_discover_characteristics_for_handle_range_by_uuid128(btstack
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
     
     peripheral->callback = callback;
     peripheral->start_group_handle = start_handle;
@@ -1730,7 +2319,7 @@ uint8_t gatt_client_discover_characteristics_for_handle_range_by_uuid128(btstack
     peripheral->characteristic_start_handle = 0;
     peripheral->gatt_client_state = P_W2_SEND_CHARACTERISTIC_WITH_UUID_QUERY;
     
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -1747,18 +2336,21 @@ uint8_t gatt_client_discover_characteristic_descriptors(btstack_packet_handler_t
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
     
+#ifndef ENABLE_GATT_CLIENT_REQUEST_QUEUE
     if (characteristic->value_handle == characteristic->end_handle){
         emit_gatt_complete_event(peripheral, 0);
         return 0;
     }
+#endif
     peripheral->callback = callback;
     peripheral->start_group_handle = characteristic->value_handle + 1;
     peripheral->end_group_handle   = characteristic->end_handle;
     peripheral->gatt_client_state = P_W2_SEND_ALL_CHARACTERISTIC_DESCRIPTORS_QUERY;
     
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -1766,13 +2358,14 @@ uint8_t gatt_client_read_value_of_characteristic_using_value_handle(btstack_pack
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
     
     peripheral->callback = callback;
     peripheral->attribute_handle = value_handle;
     peripheral->attribute_offset = 0;
     peripheral->gatt_client_state = P_W2_SEND_READ_CHARACTERISTIC_VALUE_QUERY;
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -1780,7 +2373,8 @@ uint8_t gatt_client_read_value_of_characteristics_by_uuid16(btstack_packet_handl
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
     
     peripheral->callback = callback;
     peripheral->start_group_handle = start_handle;
@@ -1790,7 +2384,7 @@ uint8_t gatt_client_read_value_of_characteristics_by_uuid16(btstack_packet_handl
     peripheral->uuid16 = uuid16;
     uuid_add_bluetooth_prefix((uint8_t*) &(peripheral->uuid128), uuid16);
     peripheral->gatt_client_state = P_W2_SEND_READ_BY_TYPE_REQUEST;
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -1798,7 +2392,8 @@ uint8_t gatt_client_read_value_of_characteristics_by_uuid128(btstack_packet_hand
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
     
     peripheral->callback = callback;
     peripheral->start_group_handle = start_handle;
@@ -1808,7 +2403,7 @@ uint8_t gatt_client_read_value_of_characteristics_by_uuid128(btstack_packet_hand
     peripheral->uuid16 = 0;
     memcpy(peripheral->uuid128, uuid128, 16);
     peripheral->gatt_client_state = P_W2_SEND_READ_BY_TYPE_REQUEST;
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -1821,13 +2416,14 @@ uint8_t gatt_client_read_long_value_of_characteristic_using_value_handle_with_of
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
     
     peripheral->callback = callback;
     peripheral->attribute_handle = characteristic_value_handle;
     peripheral->attribute_offset = offset;
     peripheral->gatt_client_state = P_W2_SEND_READ_BLOB_QUERY;
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -1843,13 +2439,14 @@ uint8_t gatt_client_read_multiple_characteristic_values(btstack_packet_handler_t
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
     
     peripheral->callback = callback;
     peripheral->read_multiple_handle_count = num_value_handles;
     peripheral->read_multiple_handles = value_handles;
     peripheral->gatt_client_state = P_W2_SEND_READ_MULTIPLE_REQUEST;
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -1857,7 +2454,10 @@ uint8_t gatt_client_write_value_of_characteristic_without_response(hci_con_handl
     gatt_client_t * peripheral = provide_context_for_conn_handle(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
+    // write commands don't have a response, with ENABLE_GATT_CLIENT_REQUEST_QUEUE they're sent while a request is ongoing
+#ifndef ENABLE_GATT_CLIENT_REQUEST_QUEUE
     if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+#endif
     
     if (value_length > peripheral_mtu(peripheral) - 3) return GATT_CLIENT_VALUE_TOO_LONG;
     if (!att_dispatch_client_can_send_now(peripheral->con_handle)) return GATT_CLIENT_BUSY;
@@ -1870,14 +2470,15 @@ uint8_t gatt_client_write_value_of_characteristic(btstack_packet_handler_t callb
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
     
     peripheral->callback = callback;
     peripheral->attribute_handle = value_handle;
     peripheral->attribute_length = value_length;
     peripheral->attribute_value = data;
     peripheral->gatt_client_state = P_W2_SEND_WRITE_CHARACTERISTIC_VALUE;
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -1885,7 +2486,8 @@ uint8_t gatt_client_write_long_value_of_characteristic_with_offset(btstack_packe
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
     
     peripheral->callback = callback;
     peripheral->attribute_handle = value_handle;
@@ -1893,7 +2495,7 @@ uint8_t gatt_client_write_long_value_of_characteristic_with_offset(btstack_packe
     peripheral->attribute_offset = offset;
     peripheral->attribute_value = data;
     peripheral->gatt_client_state = P_W2_PREPARE_WRITE;
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -1905,7 +2507,8 @@ uint8_t gatt_client_reliable_write_long_value_of_characteristic(btstack_packet_h
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
     
     peripheral->callback = callback;
     peripheral->attribute_handle = value_handle;
@@ -1913,7 +2516,7 @@ uint8_t gatt_client_reliable_write_long_value_of_characteristic(btstack_packet_h
     peripheral->attribute_offset = 0;
     peripheral->attribute_value = value;
     peripheral->gatt_client_state = P_W2_PREPARE_RELIABLE_WRITE;
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -1921,7 +2524,6 @@ uint8_t gatt_client_write_client_characteristic_configuration(btstack_packet_han
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
     
     if ( (configuration & GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION) &&
         (characteristic->properties & ATT_PROPERTY_NOTIFY) == 0) {
@@ -1932,6 +2534,9 @@ uint8_t gatt_client_write_client_characteristic_configuration(btstack_packet_han
         log_info("gatt_client_write_client_characteristic_configuration: GATT_CLIENT_CHARACTERISTIC_INDICATION_NOT_SUPPORTED");
         return GATT_CLIENT_CHARACTERISTIC_INDICATION_NOT_SUPPORTED;
     }
+
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
     
     peripheral->callback = callback;
     peripheral->start_group_handle = characteristic->value_handle;
@@ -1943,7 +2548,7 @@ uint8_t gatt_client_write_client_characteristic_configuration(btstack_packet_han
 #else
     peripheral->gatt_client_state = P_W2_SEND_READ_CLIENT_CHARACTERISTIC_CONFIGURATION_QUERY;
 #endif
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -1951,13 +2556,14 @@ uint8_t gatt_client_read_characteristic_descriptor_using_descriptor_handle(btsta
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
     
     peripheral->callback = callback;
     peripheral->attribute_handle = descriptor_handle;
     
     peripheral->gatt_client_state = P_W2_SEND_READ_CHARACTERISTIC_DESCRIPTOR_QUERY;
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -1969,13 +2575,14 @@ uint8_t gatt_client_read_long_characteristic_descriptor_using_descriptor_handle_
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
     
     peripheral->callback = callback;
     peripheral->attribute_handle = descriptor_handle;
     peripheral->attribute_offset = offset;
     peripheral->gatt_client_state = P_W2_SEND_READ_BLOB_CHARACTERISTIC_DESCRIPTOR_QUERY;
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -1991,7 +2598,8 @@ uint8_t gatt_client_write_characteristic_descriptor_using_descriptor_handle(btst
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
     
     peripheral->callback = callback;
     peripheral->attribute_handle = descriptor_handle;
@@ -1999,7 +2607,7 @@ uint8_t gatt_client_write_characteristic_descriptor_using_descriptor_handle(btst
     peripheral->attribute_offset = 0;
     peripheral->attribute_value = data;
     peripheral->gatt_client_state = P_W2_SEND_WRITE_CHARACTERISTIC_DESCRIPTOR;
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -2011,7 +2619,8 @@ uint8_t gatt_client_write_long_characteristic_descriptor_using_descriptor_handle
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
     
     peripheral->callback = callback;
     peripheral->attribute_handle = descriptor_handle;
@@ -2019,7 +2628,7 @@ uint8_t gatt_client_write_long_characteristic_descriptor_using_descriptor_handle
     peripheral->attribute_offset = offset;
     peripheral->attribute_value = data;
     peripheral->gatt_client_state = P_W2_PREPARE_WRITE_CHARACTERISTIC_DESCRIPTOR;
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -2038,7 +2647,8 @@ uint8_t gatt_client_prepare_write(btstack_packet_handler_t callback, hci_con_han
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
     
     peripheral->callback = callback;
     peripheral->attribute_handle = attribute_handle;
@@ -2046,7 +2656,7 @@ uint8_t gatt_client_prepare_write(btstack_packet_handler_t callback, hci_con_han
     peripheral->attribute_offset = offset;
     peripheral->attribute_value = data;
     peripheral->gatt_client_state = P_W2_PREPARE_WRITE_SINGLE;
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -2057,11 +2667,12 @@ uint8_t gatt_client_execute_write(btstack_packet_handler_t callback, hci_con_han
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
 
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
     
     peripheral->callback = callback;
     peripheral->gatt_client_state = P_W2_EXECUTE_PREPARED_WRITE;
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;
 }
 
@@ -2072,11 +2683,12 @@ uint8_t gatt_client_cancel_write(btstack_packet_handler_t callback, hci_con_hand
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
     if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+    uint8_t status = gatt_client_request_begin(peripheral);
+    if (status) return status;
     
     peripheral->callback = callback;
     peripheral->gatt_client_state = P_W2_CANCEL_PREPARED_WRITE;
-    gatt_client_run();
+    gatt_client_request_commit(peripheral);
     return 0;    
 }
 
@@ -125,6 +125,11 @@ typedef enum {
     P_W4_CMAC_RESULT,
     P_W2_SEND_SIGNED_WRITE,
     P_W4_SEND_SINGED_WRITE_DONE,
+
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    // discovery results are emitted from cache
+    P_W4_CACHED_RESULTS_EMITTED,
+#endif
 } gatt_client_state_t;
     
     
@@ -135,6 +140,56 @@ typedef enum{
     MTU_AUTO_EXCHANGE_DISABLED
 } gatt_client_mtu_t;
 
+#ifdef ENABLE_GATT_CLIENT_REQUEST_QUEUE
+
+#ifndef GATT_CLIENT_REQUEST_QUEUE_SIZE
+#define GATT_CLIENT_REQUEST_QUEUE_SIZE 4
+#endif
+#if (GATT_CLIENT_REQUEST_QUEUE_SIZE < 1) || (GATT_CLIENT_REQUEST_QUEUE_SIZE > 255)
+#error "GATT_CLIENT_REQUEST_QUEUE_SIZE must be in range 1..255"
+#endif
+
+// parameters of a GATT client operation that waits for the current one to complete
+typedef struct {
+    gatt_client_state_t state;
+    btstack_packet_handler_t callback;
+
+    uint16_t uuid16;
+    uint8_t  uuid128[16];
+
+    uint16_t start_group_handle;
+    uint16_t end_group_handle;
+
+    uint16_t query_start_handle;
+    uint16_t query_end_handle;
+
+    uint16_t characteristic_start_handle;
+
+    uint16_t attribute_handle;
+    uint16_t attribute_offset;
+    uint16_t attribute_length;
+    uint8_t* attribute_value;
+
+    uint16_t    read_multiple_handle_count;
+    uint16_t  * read_multiple_handles;
+
+    uint8_t  client_characteristic_configuration_value[2];
+    uint8_t  filter_with_uuid;
+
+    int      le_device_index;
+} gatt_client_request_t;
+#endif
+
+#ifdef ENABLE_GATT_CLIENT_CACHE
+
+#ifndef GATT_CLIENT_CACHE_ENTRY_SIZE
+#define GATT_CLIENT_CACHE_ENTRY_SIZE 256
+#endif
+#if (GATT_CLIENT_CACHE_ENTRY_SIZE < 64) || (GATT_CLIENT_CACHE_ENTRY_SIZE > 65535)
+#error "GATT_CLIENT_CACHE_ENTRY_SIZE must be in range 64..65535"
+#endif
+#endif
+
 typedef struct gatt_client{
     btstack_linked_item_t    item;
     // TODO: rename gatt_client_state -> state
@@ -192,11 +247,45 @@ typedef struct gatt_client{
     uint8_t  pending_error_code;
 #endif
 
+#ifdef ENABLE_GATT_CLIENT_REQUEST_QUEUE
+    // FIFO of operations started while the client was busy
+    gatt_client_request_t request_queue[GATT_CLIENT_REQUEST_QUEUE_SIZE];
+    uint8_t  request_queue_head;
+    uint8_t  request_queue_count;
+#endif
+
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    // results of the ongoing discovery, stored for bonded peers on completion
+    uint8_t  cache_state;
+    uint16_t cache_entry_len;
+    uint8_t  cache_entry[GATT_CLIENT_CACHE_ENTRY_SIZE];
+    btstack_timer_source_t cache_timer;
+#endif
+
 } gatt_client_t;
 
+// used with gatt_client_notification_t to receive notifications and indications for all value handles
+#define GATT_CLIENT_ANY_VALUE_HANDLE 0x0000
+
+#ifdef ENABLE_GATT_CLIENT_LISTENER_INDEX
+#ifndef GATT_CLIENT_LISTENER_INDEX_SIZE
+#define GATT_CLIENT_LISTENER_INDEX_SIZE 32
+#endif
+#if (GATT_CLIENT_LISTENER_INDEX_SIZE < 2) || ((GATT_CLIENT_LISTENER_INDEX_SIZE & (GATT_CLIENT_LISTENER_INDEX_SIZE - 1)) != 0)
+#error GATT_CLIENT_LISTENER_INDEX_SIZE must be a power of two
+#endif
+#endif
+
+/**
+ * Handler for notifications and indications registered with gatt_client_listen_for_characteristic_value_updates_direct.
+ * value points into the incoming ACL buffer and is only valid during the call
+ */
+typedef void (*gatt_client_value_handler_t)(hci_con_handle_t con_handle, uint16_t value_handle, const uint8_t * value, uint16_t value_len);
+
 typedef struct gatt_client_notification {
     btstack_linked_item_t    item;
     btstack_packet_handler_t callback;
+    gatt_client_value_handler_t value_handler;
     hci_con_handle_t con_handle;
     uint16_t attribute_handle;
 } gatt_client_notification_t;
@@ -578,7 +667,8 @@ uint8_t gatt_client_write_client_characteristic_configuration(btstack_packet_han
  * @param notification struct used to store registration
  * @param callback
  * @param con_handle
- * @param characteristic
+ * @param characteristic or NULL for notifications and indications of all characteristics of con_handle
+ * @note with ENABLE_GATT_CLIENT_LISTENER_INDEX, listeners for a characteristic are called before listeners for all characteristics
  */
 void gatt_client_listen_for_characteristic_value_updates(gatt_client_notification_t * notification, btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_characteristic_t * characteristic);
 
@@ -588,6 +678,16 @@ void gatt_client_listen_for_characteristic_value_updates(gatt_client_notificatio
  */
 void gatt_client_stop_listening_for_characteristic_value_updates(gatt_client_notification_t * notification);
 
+/**
+ * @brief Register for notifications and indications of a characteristic without GATT_EVENT_NOTIFICATION / GATT_EVENT_INDICATION.
+ * @note value handler is called with the value in the incoming ACL buffer, which is neither copied nor prefixed with an event header
+ * @param notification struct used to store registration, use gatt_client_stop_listening_for_characteristic_value_updates to unregister
+ * @param value_handler
+ * @param con_handle
+ * @param characteristic or NULL for notifications and indications of all characteristics of con_handle
+ */
+void gatt_client_listen_for_characteristic_value_updates_direct(gatt_client_notification_t * notification, gatt_client_value_handler_t value_handler, hci_con_handle_t con_handle, gatt_client_characteristic_t * characteristic);
+
 /**
  * @brief Requests GATT_EVENT_CAN_WRITE_WITHOUT_RESPONSE that guarantees a single successful gatt_client_write_value_of_characteristic_without_response
  * @param callback
@@ -621,6 +721,14 @@ uint8_t gatt_client_execute_write(btstack_packet_handler_t callback, hci_con_han
  */
 uint8_t gatt_client_cancel_write(btstack_packet_handler_t callback, hci_con_handle_t con_handle);
 
+#ifdef ENABLE_GATT_CLIENT_CACHE
+/**
+ * @brief Drop cached discovery results for bonded device, e.g. after its attribute database was updated out-of-band
+ * @param le_device_index from LE Device DB
+ */
+void gatt_client_cache_invalidate(int le_device_index);
+#endif
+
 /* API_END */
 
 // used by generated btstack_event.c
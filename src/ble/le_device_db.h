@@ -194,6 +194,12 @@ void le_device_db_local_counter_set(int index, uint32_t counter);
  */
 void le_device_db_remove(int index);
 
+/**
+ * @brief set callback for added, replaced, or removed devices. Used by Security Manager
+ * @param callback
+ */
+void le_device_db_set_change_callback(void (*callback)(void));
+
 void le_device_db_dump(void);
 
 /* API_END */
@@ -76,7 +76,7 @@ typedef struct le_device_memory_db {
 
 } le_device_memory_db_t;
 
-#define INVALID_ENTRY_ADDR_TYPE 0xff
+#define INVALID_ENTRY_ADDR_TYPE BD_ADDR_TYPE_UNKNOWN
 
 #ifndef MAX_NR_LE_DEVICE_DB_ENTRIES
 #error "MAX_NR_LE_DEVICE_DB_ENTRIES not defined, please define in btstack_config.h"
@@ -84,6 +84,18 @@ typedef struct le_device_memory_db {
 
 static le_device_memory_db_t le_devices[MAX_NR_LE_DEVICE_DB_ENTRIES];
 
+static void (*le_device_db_change_callback)(void);
+
+void le_device_db_set_change_callback(void (*callback)(void)){
+    le_device_db_change_callback = callback;
+}
+
+static void le_device_db_notify_change(void){
+    if (le_device_db_change_callback){
+        (*le_device_db_change_callback)();
+    }
+}
+
 void le_device_db_init(void){
     int i;
     for (i=0;i<MAX_NR_LE_DEVICE_DB_ENTRIES;i++){
@@ -112,6 +124,7 @@ int le_device_db_max_count(void){
 // free device
 void le_device_db_remove(int index){
     le_devices[index].addr_type = INVALID_ENTRY_ADDR_TYPE;
+    le_device_db_notify_change();
 }
 
 int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
@@ -135,6 +148,7 @@ int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
 #ifdef ENABLE_LE_SIGNED_WRITE
     le_devices[index].remote_counter = 0; 
 #endif
+    le_device_db_notify_change();
     return index;
 }
 
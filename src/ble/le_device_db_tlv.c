@@ -44,6 +44,8 @@
 
 #include <string.h>
 #include "btstack_debug.h"
+#include "btstack_device_db_index.h"
+#include "btstack_util.h"
 
 // LE Device DB Implementation storing entries in btstack_tlv
 
@@ -95,6 +97,19 @@ typedef struct le_device_db_entry_t {
 static uint8_t  entry_map[NVM_NUM_DEVICE_DB_ENTRIES];
 static uint32_t num_valid_entries;
 
+#ifdef ENABLE_DEVICE_DB_INDEX
+// identity of stored entry, indexed by address
+typedef struct {
+    btstack_device_db_index_entry_t item;
+    uint32_t  seq_nr;
+    sm_key_t  irk;
+} le_device_db_tlv_index_entry_t;
+
+static le_device_db_tlv_index_entry_t   index_entries[NVM_NUM_DEVICE_DB_ENTRIES];
+static btstack_device_db_index_entry_t * index_buckets[NVM_NUM_DEVICE_DB_ENTRIES];
+static btstack_device_db_index_t         index_by_addr;
+#endif
+
 static const btstack_tlv_t * le_device_db_tlv_btstack_tlv_impl;
 static       void *          le_device_db_tlv_btstack_tlv_context;
 
@@ -144,10 +159,37 @@ static int le_device_db_tlv_delete(int index){
 	return 1;
 }
 
+#ifdef ENABLE_DEVICE_DB_INDEX
+
+// @returns index for addr type and address or -1
+static int le_device_db_tlv_index_find(int addr_type, const bd_addr_t addr){
+    le_device_db_tlv_index_entry_t * index_entry = (le_device_db_tlv_index_entry_t *) btstack_device_db_index_find(&index_by_addr, (uint8_t) addr_type, addr);
+    if (!index_entry) return -1;
+    return index_entry - index_entries;
+}
+
+static void le_device_db_tlv_index_add(int index, const le_device_db_entry_t * entry){
+    le_device_db_tlv_index_entry_t * index_entry = &index_entries[index];
+    index_entry->seq_nr = entry->seq_nr;
+    memcpy(index_entry->irk, entry->irk, 16);
+    btstack_device_db_index_add(&index_by_addr, &index_entry->item, (uint8_t) entry->addr_type, entry->addr);
+}
+
+// must be called before entry_map[index] is cleared
+static void le_device_db_tlv_index_remove(int index){
+    if (!entry_map[index]) return;
+    btstack_device_db_index_remove(&index_by_addr, &index_entries[index].item);
+}
+
+#endif
+
 static void le_device_db_tlv_scan(void){
     int i;
     num_valid_entries = 0;
     memset(entry_map, 0, sizeof(entry_map));
+#ifdef ENABLE_DEVICE_DB_INDEX
+    btstack_device_db_index_init(&index_by_addr, index_buckets, NVM_NUM_DEVICE_DB_ENTRIES);
+#endif
     for (i=0;i<NVM_NUM_DEVICE_DB_ENTRIES;i++){
         // lookup entry
         le_device_db_entry_t entry;
@@ -155,10 +197,25 @@ static void le_device_db_tlv_scan(void){
 
         entry_map[i] = 1;
         num_valid_entries++;
+#ifdef ENABLE_DEVICE_DB_INDEX
+        le_device_db_tlv_index_add(i, &entry);
+#endif
     }
     log_info("num valid le device entries %u", num_valid_entries);
 }
 
+static void (*le_device_db_change_callback)(void);
+
+void le_device_db_set_change_callback(void (*callback)(void)){
+    le_device_db_change_callback = callback;
+}
+
+static void le_device_db_notify_change(void){
+    if (le_device_db_change_callback){
+        (*le_device_db_change_callback)();
+    }
+}
+
 void le_device_db_init(void){
     if (!le_device_db_tlv_btstack_tlv_impl) {
         log_error("btstack_tlv not initialized");
@@ -186,11 +243,17 @@ void le_device_db_remove(int index){
 	// delete entry in TLV
 	le_device_db_tlv_delete(index);
 
+#ifdef ENABLE_DEVICE_DB_INDEX
+    le_device_db_tlv_index_remove(index);
+#endif
+
 	// mark as unused
     entry_map[index] = 0;
 
     // keep track
     num_valid_entries--;
+
+    le_device_db_notify_change();
 }
 
 int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
@@ -203,24 +266,32 @@ int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
 
 	// find unused entry in the used list
     int i;
+#ifdef ENABLE_DEVICE_DB_INDEX
+    index_for_addr = le_device_db_tlv_index_find(addr_type, addr);
+#endif
     for (i=0;i<NVM_NUM_DEVICE_DB_ENTRIES;i++){
          if (entry_map[i]) {
+#ifdef ENABLE_DEVICE_DB_INDEX
+            uint32_t entry_seq_nr = index_entries[i].seq_nr;
+#else
             le_device_db_entry_t entry;
             le_device_db_tlv_fetch(i, &entry);
+            uint32_t entry_seq_nr = entry.seq_nr;
             // found addr?
             if ((memcmp(addr, entry.addr, 6) == 0) && addr_type == entry.addr_type){
                 index_for_addr = i;
             }
+#endif
             // update highest seq nr
-            if (entry.seq_nr > highest_seq_nr){
-                highest_seq_nr = entry.seq_nr;
+            if (entry_seq_nr > highest_seq_nr){
+                highest_seq_nr = entry_seq_nr;
             }
             // find entry with lowest seq nr
-            if ((index_for_lowest_seq_nr == -1) || (entry.seq_nr < lowest_seq_nr)){
+            if ((index_for_lowest_seq_nr == -1) || (entry_seq_nr < lowest_seq_nr)){
                 index_for_lowest_seq_nr = i;
-                lowest_seq_nr = entry.seq_nr;
+                lowest_seq_nr = entry_seq_nr;
             }
-        } else {
+        } else if (index_for_empty < 0) {
             index_for_empty = i;
         }
     }
@@ -258,7 +329,12 @@ int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
 
     // store
     le_device_db_tlv_store(index_to_use, &entry);
-    
+
+#ifdef ENABLE_DEVICE_DB_INDEX
+    le_device_db_tlv_index_remove(index_to_use);
+    le_device_db_tlv_index_add(index_to_use, &entry);
+#endif
+
     // set in entry_mape
     entry_map[index_to_use] = 1;
 
@@ -267,6 +343,7 @@ int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
         num_valid_entries++;
     }
 
+    le_device_db_notify_change();
     return index_to_use;
 }
 
@@ -274,6 +351,14 @@ int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
 // get device information: addr type and address
 void le_device_db_info(int index, int * addr_type, bd_addr_t addr, sm_key_t irk){
 
+#ifdef ENABLE_DEVICE_DB_INDEX
+    // identity is kept in RAM
+    if (index < 0 || index >= NVM_NUM_DEVICE_DB_ENTRIES) return;
+    if (!entry_map[index]) return;
+    if (addr_type) *addr_type = index_entries[index].item.addr_type;
+    if (addr) memcpy(addr, index_entries[index].item.addr, 6);
+    if (irk) memcpy(irk, index_entries[index].irk, 16);
+#else
 	// fetch entry
 	le_device_db_entry_t entry;
 	int ok = le_device_db_tlv_fetch(index, &entry);
@@ -282,6 +367,7 @@ void le_device_db_info(int index, int * addr_type, bd_addr_t addr, sm_key_t irk)
     if (addr_type) *addr_type = entry.addr_type;
     if (addr) memcpy(addr, entry.addr, 6);
     if (irk) memcpy(irk, entry.irk, 16);
+#endif
 }
 
 void le_device_db_encryption_set(int index, uint16_t ediv, uint8_t rand[8], sm_key_t ltk, int key_size, int authenticated, int authorized){
@@ -82,6 +82,14 @@
 #define USE_CMAC_ENGINE
 #endif
 
+// resolve addresses against all bonded devices at once if AES128 can be calculated without HCI Controller
+#if defined(ENABLE_SOFTWARE_AES128) || defined(HAVE_AES128)
+#define USE_ADDRESS_RESOLUTION_BATCH
+#ifndef SM_ADDRESS_RESOLUTION_CACHE_SIZE
+#define SM_ADDRESS_RESOLUTION_CACHE_SIZE 8
+#endif
+#endif
+
 #define BTSTACK_TAG32(A,B,C,D) ((A << 24) | (B << 16) | (C << 8) | D)
 
 //
@@ -147,6 +155,14 @@ typedef enum {
     ADDRESS_RESOLUTION_FAILED,
 } address_resolution_event_t;
 
+#ifdef USE_ADDRESS_RESOLUTION_BATCH
+typedef struct {
+    bd_addr_t address;
+    // -1 if not resolvable with IRKs in LE Device DB
+    int       le_db_index;
+} address_resolution_cache_entry_t;
+#endif
+
 typedef enum {
     EC_KEY_GENERATION_IDLE,
     EC_KEY_GENERATION_ACTIVE,
@@ -248,6 +264,12 @@ static void *    sm_address_resolution_context;
 static address_resolution_mode_t sm_address_resolution_mode;
 static btstack_linked_list_t sm_address_resolution_general_queue;
 
+#ifdef USE_ADDRESS_RESOLUTION_BATCH
+// resolved addresses, most recently used first. Flushed on every LE Device DB change
+static address_resolution_cache_entry_t sm_address_resolution_cache[SM_ADDRESS_RESOLUTION_CACHE_SIZE];
+static int sm_address_resolution_cache_num_entries;
+#endif
+
 // aes128 crypto engine.
 static sm_aes128_state_t  sm_aes128_state;
 
@@ -261,7 +283,9 @@ static btstack_crypto_random_t   sm_crypto_random_oob_request;
 
 // temp storage for random data
 static uint8_t sm_random_data[8];
+#ifndef USE_ADDRESS_RESOLUTION_BATCH
 static uint8_t sm_aes128_key[16];
+#endif
 static uint8_t sm_aes128_plaintext[16];
 static uint8_t sm_aes128_ciphertext[16];
 
@@ -400,7 +424,9 @@ static void sm_done_for_handle(hci_con_handle_t con_handle);
 static sm_connection_t * sm_get_connection_for_handle(hci_con_handle_t con_handle);
 static inline int sm_calc_actual_encryption_key_size(int other);
 static int sm_validate_stk_generation_method(void);
+#ifndef USE_ADDRESS_RESOLUTION_BATCH
 static void sm_handle_encryption_result_address_resolution(void *arg);
+#endif
 static void sm_handle_encryption_result_dkg_dhk(void *arg);
 static void sm_handle_encryption_result_dkg_irk(void *arg);
 static void sm_handle_encryption_result_enc_a(void *arg);
@@ -877,6 +903,81 @@ int sm_address_resolution_lookup(uint8_t address_type, bd_addr_t address){
     return 0;
 }
 
+#ifdef USE_ADDRESS_RESOLUTION_BATCH
+
+static void sm_address_resolution_cache_flush(void){
+    sm_address_resolution_cache_num_entries = 0;
+}
+
+static void sm_address_resolution_cache_add(const bd_addr_t address, int le_db_index){
+    int num_entries = btstack_min(sm_address_resolution_cache_num_entries, SM_ADDRESS_RESOLUTION_CACHE_SIZE - 1);
+    memmove(&sm_address_resolution_cache[1], &sm_address_resolution_cache[0], num_entries * sizeof(address_resolution_cache_entry_t));
+    memcpy(sm_address_resolution_cache[0].address, address, 6);
+    sm_address_resolution_cache[0].le_db_index = le_db_index;
+    sm_address_resolution_cache_num_entries = num_entries + 1;
+}
+
+static void sm_address_resolution_cache_remove(int pos){
+    sm_address_resolution_cache_num_entries--;
+    memmove(&sm_address_resolution_cache[pos], &sm_address_resolution_cache[pos+1], (sm_address_resolution_cache_num_entries - pos) * sizeof(address_resolution_cache_entry_t));
+}
+
+// ah(irk, prand) == hash
+static int sm_address_resolution_irk_matches(const sm_key_t irk, const bd_addr_t address){
+    sm_key_t r_prime;
+    sm_key_t ah;
+    sm_ah_r_prime((uint8_t *) address, r_prime);
+    btstack_crypto_aes128_calc(irk, r_prime, ah);
+    return memcmp(&address[3], &ah[13], 3) == 0;
+}
+
+// match address against identity addresses and IRKs of all devices, @returns le_device_db index or -1
+static int sm_address_resolution_resolve_all(uint8_t address_type, const bd_addr_t address){
+    int resolvable = address_type != BD_ADDR_TYPE_LE_PUBLIC && (address[0] & 0xc0) == 0x40;
+    int i;
+    int max_count = le_device_db_max_count();
+    for (i=0; i < max_count; i++){
+        int addr_type = BD_ADDR_TYPE_UNKNOWN;
+        bd_addr_t addr;
+        sm_key_t irk;
+        le_device_db_info(i, &addr_type, addr, irk);
+        if (addr_type == BD_ADDR_TYPE_UNKNOWN) continue;
+        if (address_type == addr_type && memcmp(addr, address, 6) == 0) return i;
+        if (resolvable && sm_address_resolution_irk_matches(irk, address)) return i;
+    }
+    return -1;
+}
+
+int sm_address_resolution_resolve(uint8_t address_type, bd_addr_t address){
+    // only resolvable private addresses are cached
+    int resolvable = address_type != BD_ADDR_TYPE_LE_PUBLIC && (address[0] & 0xc0) == 0x40;
+    if (!resolvable){
+        return sm_address_resolution_resolve_all(address_type, address);
+    }
+
+    int le_db_index;
+    int pos;
+    for (pos = 0; pos < sm_address_resolution_cache_num_entries; pos++){
+        if (memcmp(sm_address_resolution_cache[pos].address, address, 6) != 0) continue;
+        le_db_index = sm_address_resolution_cache[pos].le_db_index;
+        sm_address_resolution_cache_remove(pos);
+        if (le_db_index >= 0){
+            // verify that device is still stored with same IRK
+            int addr_type = BD_ADDR_TYPE_UNKNOWN;
+            sm_key_t irk;
+            le_device_db_info(le_db_index, &addr_type, NULL, irk);
+            if (addr_type == BD_ADDR_TYPE_UNKNOWN || !sm_address_resolution_irk_matches(irk, address)) break;
+        }
+        sm_address_resolution_cache_add(address, le_db_index);
+        return le_db_index;
+    }
+
+    le_db_index = sm_address_resolution_resolve_all(address_type, address);
+    sm_address_resolution_cache_add(address, le_db_index);
+    return le_db_index;
+}
+#endif
+
 // CMAC calculation using AES Engineq
 #ifdef USE_CMAC_ENGINE
 
@@ -1806,6 +1907,35 @@ static void sm_start_calculating_ltk_from_ediv_and_rand(sm_connection_t * sm_con
 }
 #endif
 
+// start lookup for connection or from general queue, @returns 1 if started
+static int sm_address_resolution_start_next_lookup(void){
+    if (!sm_address_resolution_idle()) return 0;
+
+    // -- find connection that require csrk lookup
+    btstack_linked_list_iterator_t it;
+    hci_connections_get_iterator(&it);
+    while(btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * hci_connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        sm_connection_t  * sm_connection  = &hci_connection->sm_connection;
+        if (sm_connection->sm_irk_lookup_state == IRK_LOOKUP_W4_READY){
+            // and start lookup
+            sm_address_resolution_start_lookup(sm_connection->sm_peer_addr_type, sm_connection->sm_handle, sm_connection->sm_peer_address, ADDRESS_RESOLUTION_FOR_CONNECTION, sm_connection);
+            sm_connection->sm_irk_lookup_state = IRK_LOOKUP_STARTED;
+            return 1;
+        }
+    }
+
+    // -- resolve addresses for received addresses
+    if (!btstack_linked_list_empty(&sm_address_resolution_general_queue)){
+        sm_lookup_entry_t * entry = (sm_lookup_entry_t *) sm_address_resolution_general_queue;
+        btstack_linked_list_remove(&sm_address_resolution_general_queue, (btstack_linked_item_t *) entry);
+        sm_address_resolution_start_lookup(entry->address_type, 0, entry->address, ADDRESS_RESOLUTION_GENERAL, NULL);
+        btstack_memory_sm_lookup_entry_free(entry);
+        return 1;
+    }
+    return 0;
+}
+
 static void sm_run(void){
 
     btstack_linked_list_iterator_t it;
@@ -1876,30 +2006,20 @@ static void sm_run(void){
     }
 
     // CSRK Lookup
-    // -- if csrk lookup ready, find connection that require csrk lookup
-    if (sm_address_resolution_idle()){
-        hci_connections_get_iterator(&it);
-        while(btstack_linked_list_iterator_has_next(&it)){
-            hci_connection_t * hci_connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
-            sm_connection_t  * sm_connection  = &hci_connection->sm_connection;
-            if (sm_connection->sm_irk_lookup_state == IRK_LOOKUP_W4_READY){
-                // and start lookup
-                sm_address_resolution_start_lookup(sm_connection->sm_peer_addr_type, sm_connection->sm_handle, sm_connection->sm_peer_address, ADDRESS_RESOLUTION_FOR_CONNECTION, sm_connection);
-                sm_connection->sm_irk_lookup_state = IRK_LOOKUP_STARTED;
-                break;
-            }
-        }
-    }
-
-    // -- if csrk lookup ready, resolved addresses for received addresses
-    if (sm_address_resolution_idle()) {
-        if (!btstack_linked_list_empty(&sm_address_resolution_general_queue)){
-            sm_lookup_entry_t * entry = (sm_lookup_entry_t *) sm_address_resolution_general_queue;
-            btstack_linked_list_remove(&sm_address_resolution_general_queue, (btstack_linked_item_t *) entry);
-            sm_address_resolution_start_lookup(entry->address_type, 0, entry->address, ADDRESS_RESOLUTION_GENERAL, NULL);
-            btstack_memory_sm_lookup_entry_free(entry);
+#ifdef USE_ADDRESS_RESOLUTION_BATCH
+    // -- resolve all pending lookups without HCI Controller
+    while (sm_address_resolution_start_next_lookup()){
+        int le_db_index = sm_address_resolution_resolve(sm_address_resolution_addr_type, sm_address_resolution_address);
+        log_info("LE Device Lookup: %s, index %d", bd_addr_to_str(sm_address_resolution_address), le_db_index);
+        if (le_db_index >= 0){
+            sm_address_resolution_test = le_db_index;
+            sm_address_resolution_handle_event(ADDRESS_RESOLUTION_SUCEEDED);
+        } else {
+            sm_address_resolution_handle_event(ADDRESS_RESOLUTION_FAILED);
         }
     }
+#else
+    sm_address_resolution_start_next_lookup();
 
     // -- Continue with CSRK device lookup by public or resolvable private address
     if (!sm_address_resolution_idle()){
@@ -1940,6 +2060,7 @@ static void sm_run(void){
             sm_address_resolution_handle_event(ADDRESS_RESOLUTION_FAILED);
         }
     }
+#endif
 
 #ifdef ENABLE_LE_SECURE_CONNECTIONS
     switch (sm_sc_oob_state){
@@ -2772,6 +2893,7 @@ static void sm_handle_encryption_result_enc_ph4_ltk(void *arg){
 }
 #endif
 
+#ifndef USE_ADDRESS_RESOLUTION_BATCH
 static void sm_handle_encryption_result_address_resolution(void *arg){
     UNUSED(arg);
     sm_aes128_state = SM_AES128_IDLE;
@@ -2788,6 +2910,7 @@ static void sm_handle_encryption_result_address_resolution(void *arg){
     sm_address_resolution_test++;
     sm_run();
 }
+#endif
 
 static void sm_handle_encryption_result_dkg_irk(void *arg){
     UNUSED(arg);
@@ -3878,6 +4001,11 @@ void sm_init(void){
     sm_address_resolution_ah_calculation_active = 0;
     sm_address_resolution_mode = ADDRESS_RESOLUTION_IDLE;
     sm_address_resolution_general_queue = NULL;
+#ifdef USE_ADDRESS_RESOLUTION_BATCH
+    // added, replaced, or removed IRKs invalidate cached results
+    sm_address_resolution_cache_flush();
+    le_device_db_set_change_callback(&sm_address_resolution_cache_flush);
+#endif
 
     gap_random_adress_update_period = 15 * 60 * 1000L;
     sm_active_connection_handle = HCI_CON_HANDLE_INVALID;
@@ -3950,8 +4078,7 @@ void sm_request_pairing(hci_con_handle_t con_handle){
                 case IRK_LOOKUP_SUCCEEDED:
 #ifndef ENABLE_LE_CENTRAL_AUTO_ENCRYPTION
                     le_device_db_encryption_get(sm_conn->sm_le_db_index, NULL, NULL, ltk, NULL, NULL, NULL);
-                    int have_ltk = !sm_is_null_key(ltk);
-                    log_info("have ltk %u", have_ltk);
+                    log_info("have ltk %u", !sm_is_null_key(ltk));
                     // trigger 'pairing complete' event on encryption change
                     sm_conn->sm_pairing_requested = 1;
                     sm_conn->sm_engine_state = SM_INITIATOR_PH0_HAS_LTK;
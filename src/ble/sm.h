@@ -199,6 +199,18 @@ void sm_cmac_signed_write_start(const sm_key_t key, uint8_t opcode, uint16_t att
  */
 int sm_address_resolution_lookup(uint8_t addr_type, bd_addr_t addr);
 
+/*
+ * @brief Match address against bonded devices without HCI Controller, e.g. for address in GAP_EVENT_ADVERTISING_REPORT
+ * @param addr_type
+ * @param addr
+ * @return index from le_device_db or -1 if not found
+ * @note Results for resolvable private addresses are cached. Does not trigger SM_IDENTITY_RESOLVING_* events
+ * @note Only available with software AES128 engine (ENABLE_SOFTWARE_AES128) or platform AES128 engine (HAVE_AES128)
+ */
+#if defined(ENABLE_SOFTWARE_AES128) || defined(HAVE_AES128)
+int sm_address_resolution_resolve(uint8_t addr_type, bd_addr_t addr);
+#endif
+
 /**
  * @brief Identify device in LE Device DB.
  * @param handle
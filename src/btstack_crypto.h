@@ -45,6 +45,7 @@
 #ifndef __BTSTACK_CTRYPTO_H
 #define __BTSTACK_CTRYPTO_H
 
+#include "btstack_config.h"
 #include "btstack_defines.h"
 
 #if defined __cplusplus
@@ -152,6 +153,17 @@ void btstack_crypto_random_generate(btstack_crypto_random_t * request, uint8_t *
  */
 void btstack_crypto_aes128_encrypt(btstack_crypto_aes128_t * request, const uint8_t * key, const uint8_t * plaintext, uint8_t * ciphertext, void (* callback)(void * arg), void * callback_arg);
 
+/** 
+ * Encrypt plaintext using AES128 without completion callback
+ * @param key (16 bytes)
+ * @param plaintext (16 bytes)
+ * @param ciphertext (16 bytes)
+ * @note only available with software AES128 engine (ENABLE_SOFTWARE_AES128) or platform AES128 engine (HAVE_AES128)
+ */
+#if defined(ENABLE_SOFTWARE_AES128) || defined(HAVE_AES128)
+void btstack_crypto_aes128_calc(const uint8_t * key, const uint8_t * plaintext, uint8_t * ciphertext);
+#endif
+
 /**
  * Calculate Cipher-based Message Authentication Code (CMAC) using AES128 and a generator function to provide data
  * @param request
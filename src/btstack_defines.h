@@ -70,6 +70,14 @@ typedef struct {
   void * context;
 } btstack_context_callback_registration_t;
 
+/**
+ * @brief Buffer segment for scatter-gather send, e.g. header in packet buffer and payload in application memory
+ */
+typedef struct {
+    const uint8_t * data;
+    uint16_t        len;
+} btstack_iovec_t;
+
 /**
  * @brief 128 bit key used with AES128 in Security Manager
  */
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define __BTSTACK_FILE__ "btstack_device_db_index.c"
+
+/*
+ *  btstack_device_db_index.c
+ */
+
+#include <string.h>
+
+#include "btstack_device_db_index.h"
+#include "btstack_util.h"
+
+static btstack_device_db_index_entry_t ** btstack_device_db_index_bucket(const btstack_device_db_index_t * index, const bd_addr_t addr){
+    // lower part of address is random enough
+    return &index->buckets[(big_endian_read_32(addr, 2) * 2654435761u) % index->num_buckets];
+}
+
+void btstack_device_db_index_init(btstack_device_db_index_t * index, btstack_device_db_index_entry_t ** buckets, uint16_t num_buckets){
+    index->buckets = buckets;
+    index->num_buckets = num_buckets;
+    memset(buckets, 0, num_buckets * sizeof(btstack_device_db_index_entry_t *));
+}
+
+void btstack_device_db_index_add(btstack_device_db_index_t * index, btstack_device_db_index_entry_t * entry, uint8_t addr_type, const bd_addr_t addr){
+    btstack_device_db_index_entry_t ** bucket = btstack_device_db_index_bucket(index, addr);
+    memcpy(entry->addr, addr, 6);
+    entry->addr_type = addr_type;
+    entry->next = *bucket;
+    *bucket = entry;
+}
+
+void btstack_device_db_index_remove(btstack_device_db_index_t * index, btstack_device_db_index_entry_t * entry){
+    btstack_device_db_index_entry_t ** link = btstack_device_db_index_bucket(index, entry->addr);
+    while (*link){
+        if (*link == entry){
+            *link = entry->next;
+            return;
+        }
+        link = &(*link)->next;
+    }
+}
+
+btstack_device_db_index_entry_t * btstack_device_db_index_find(const btstack_device_db_index_t * index, uint8_t addr_type, const bd_addr_t addr){
+    btstack_device_db_index_entry_t * entry;
+    for (entry = *btstack_device_db_index_bucket(index, addr); entry ; entry = entry->next){
+        if ((entry->addr_type == addr_type) && (memcmp(entry->addr, addr, 6) == 0)) return entry;
+    }
+    return NULL;
+}
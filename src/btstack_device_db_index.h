@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ *  btstack_device_db_index.h
+ *
+ *  Hash index of device DB entries by address, used with ENABLE_DEVICE_DB_INDEX
+ */
+
+#ifndef __BTSTACK_DEVICE_DB_INDEX_H
+#define __BTSTACK_DEVICE_DB_INDEX_H
+
+#include <stdint.h>
+#include "bluetooth.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+// to be embedded in DB entry
+typedef struct btstack_device_db_index_entry {
+    struct btstack_device_db_index_entry * next;   // next entry with same hash of address
+    bd_addr_t addr;
+    uint8_t   addr_type;
+} btstack_device_db_index_entry_t;
+
+typedef struct {
+    btstack_device_db_index_entry_t ** buckets;
+    uint16_t num_buckets;
+} btstack_device_db_index_t;
+
+/**
+ * @brief Init index with provided buckets
+ * @param index
+ * @param buckets
+ * @param num_buckets
+ */
+void btstack_device_db_index_init(btstack_device_db_index_t * index, btstack_device_db_index_entry_t ** buckets, uint16_t num_buckets);
+
+/**
+ * @brief Add entry for address, entry must not be in index
+ * @param index
+ * @param entry
+ * @param addr_type
+ * @param addr
+ */
+void btstack_device_db_index_add(btstack_device_db_index_t * index, btstack_device_db_index_entry_t * entry, uint8_t addr_type, const bd_addr_t addr);
+
+/**
+ * @brief Remove entry, ignored if entry is not in index
+ * @param index
+ * @param entry
+ */
+void btstack_device_db_index_remove(btstack_device_db_index_t * index, btstack_device_db_index_entry_t * entry);
+
+/**
+ * @brief Find entry for address
+ * @param index
+ * @param addr_type
+ * @param addr
+ * @return entry or NULL
+ */
+btstack_device_db_index_entry_t * btstack_device_db_index_find(const btstack_device_db_index_t * index, uint8_t addr_type, const bd_addr_t addr);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // __BTSTACK_DEVICE_DB_INDEX_H
@@ -113,8 +113,8 @@ int btstack_ring_buffer_write(btstack_ring_buffer_t * ring_buffer, uint8_t * dat
     return 0;
 } 
 
-// fetch data_length bytes from ring buffer
-void btstack_ring_buffer_read(btstack_ring_buffer_t * ring_buffer, uint8_t * data, uint32_t data_length, uint32_t * number_of_bytes_read){
+// copy data_length bytes from ring buffer without removing them
+void btstack_ring_buffer_peek(btstack_ring_buffer_t * ring_buffer, uint8_t * data, uint32_t data_length, uint32_t * number_of_bytes_read){
     // limit data to get and report
     data_length = btstack_min(data_length, btstack_ring_buffer_bytes_available(ring_buffer));
     *number_of_bytes_read = data_length;
@@ -129,19 +129,37 @@ void btstack_ring_buffer_read(btstack_ring_buffer_t * ring_buffer, uint8_t * dat
     data_length -= bytes_to_copy;
     data += bytes_to_copy;
 
-    // update last read index
-    ring_buffer->last_read_index += bytes_to_copy;
-    if (ring_buffer->last_read_index == ring_buffer->size){
-        ring_buffer->last_read_index = 0;
-    }
-
     // copy second chunk
     if (data_length) {
         memcpy(data, &ring_buffer->storage[0], data_length);
-        ring_buffer->last_read_index += data_length;
+    }
+}
+
+// get data up to end of storage
+uint8_t * btstack_ring_buffer_peek_contiguous(btstack_ring_buffer_t * ring_buffer, uint32_t * length){
+    *length = btstack_min(btstack_ring_buffer_bytes_available(ring_buffer), ring_buffer->size - ring_buffer->last_read_index);
+    return &ring_buffer->storage[ring_buffer->last_read_index];
+}
+
+// drop data_length bytes from ring buffer
+void btstack_ring_buffer_skip(btstack_ring_buffer_t * ring_buffer, uint32_t data_length){
+    data_length = btstack_min(data_length, btstack_ring_buffer_bytes_available(ring_buffer));
+
+    // simplify logic below by asserting data_length > 0
+    if (data_length == 0) return;
+
+    // update last read index
+    ring_buffer->last_read_index += data_length;
+    if (ring_buffer->last_read_index >= ring_buffer->size){
+        ring_buffer->last_read_index -= ring_buffer->size;
     }
 
     // clear full flag
     ring_buffer->full = 0;
-} 
+}
 
+// fetch data_length bytes from ring buffer
+void btstack_ring_buffer_read(btstack_ring_buffer_t * ring_buffer, uint8_t * data, uint32_t data_length, uint32_t * number_of_bytes_read){
+    btstack_ring_buffer_peek(ring_buffer, data, data_length, number_of_bytes_read);
+    btstack_ring_buffer_skip(ring_buffer, *number_of_bytes_read);
+}
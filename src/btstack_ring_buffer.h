@@ -103,6 +103,30 @@ int btstack_ring_buffer_write(btstack_ring_buffer_t * ring_buffer, uint8_t * dat
  */
 void btstack_ring_buffer_read(btstack_ring_buffer_t * ring_buffer, uint8_t * buffer, uint32_t length, uint32_t * number_of_bytes_read); 
 
+/**
+ * Copy from ring buffer without removing data
+ * @param ring_buffer object
+ * @param buffer to store data
+ * @param length to copy
+ * @param number_of_bytes_read
+ */
+void btstack_ring_buffer_peek(btstack_ring_buffer_t * ring_buffer, uint8_t * buffer, uint32_t length, uint32_t * number_of_bytes_read);
+
+/**
+ * Get data available for read that is stored contiguously, i.e. up to end of storage
+ * @param ring_buffer object
+ * @param length of contiguous data
+ * @return pointer to data, only valid until next write
+ */
+uint8_t * btstack_ring_buffer_peek_contiguous(btstack_ring_buffer_t * ring_buffer, uint32_t * length);
+
+/**
+ * Remove data from ring buffer without copying it
+ * @param ring_buffer object
+ * @param length to remove, limited to number of bytes available
+ */
+void btstack_ring_buffer_skip(btstack_ring_buffer_t * ring_buffer, uint32_t length);
+
 #if defined __cplusplus
 }
 #endif
@@ -137,6 +137,16 @@ void btstack_run_loop_set_timer(btstack_timer_source_t *a, uint32_t timeout_in_m
     the_run_loop->set_timer(a, timeout_in_ms);
 }
 
+void btstack_run_loop_set_timer_us(btstack_timer_source_t *a, uint32_t timeout_in_us){
+    btstack_run_loop_assert();
+    if (the_run_loop->set_timer_us){
+        the_run_loop->set_timer_us(a, timeout_in_us);
+    } else {
+        // round up to next ms
+        the_run_loop->set_timer(a, (timeout_in_us + 999) / 1000);
+    }
+}
+
 /**
  * @brief Set context for this timer
  */
@@ -175,12 +185,155 @@ uint32_t btstack_run_loop_get_time_ms(void){
     return the_run_loop->get_time_ms();
 }
 
+/**
+ * @brief Get current time in us
+ */
+uint64_t btstack_run_loop_get_time_us(void){
+    btstack_run_loop_assert();
+    if (the_run_loop->get_time_us){
+        return the_run_loop->get_time_us();
+    }
+    return ((uint64_t) the_run_loop->get_time_ms()) * 1000;
+}
+
 
 void btstack_run_loop_timer_dump(void){
     btstack_run_loop_assert();
     the_run_loop->dump_timer();
 }
 
+// Timer queue implemented as pairing heap: each timer has a list of children ordered by insertion,
+// linked via item.next. prev points to the previous sibling, or the parent for the first child.
+
+// timeouts are compared relative to each other to handle wrap-around of 32-bit time
+static int btstack_timer_queue_is_before(btstack_timer_source_t * a, btstack_timer_source_t * b){
+    int32_t delta = (int32_t)(a->timeout - b->timeout);
+#ifdef HAVE_POSIX_TIME
+    // run loops with microsecond timers keep timeout in ms and use timeout_us for sub-ms ordering
+    if (delta == 0){
+        return a->timeout_us < b->timeout_us;
+    }
+#endif
+    return delta < 0;
+}
+
+static btstack_timer_source_t * btstack_timer_queue_next_sibling(btstack_timer_source_t * timer){
+    return (btstack_timer_source_t *) timer->item.next;
+}
+
+// meld two heaps, the root with the later timeout becomes first child of the other one
+static btstack_timer_source_t * btstack_timer_queue_meld(btstack_timer_source_t * a, btstack_timer_source_t * b){
+    if (btstack_timer_queue_is_before(b, a)){
+        btstack_timer_source_t * tmp = a;
+        a = b;
+        b = tmp;
+    }
+    b->prev = a;
+    b->item.next = (btstack_linked_item_t *) a->child;
+    if (a->child){
+        a->child->prev = b;
+    }
+    a->child = b;
+    a->item.next = NULL;
+    a->prev = NULL;
+    return a;
+}
+
+// two-pass pairing of a list of siblings into a single heap
+static btstack_timer_source_t * btstack_timer_queue_merge_pairs(btstack_timer_source_t * first){
+    // first pass: meld pairs from left to right, collect results in reverse order
+    btstack_timer_source_t * pairs = NULL;
+    while (first){
+        btstack_timer_source_t * a = first;
+        btstack_timer_source_t * b = btstack_timer_queue_next_sibling(a);
+        if (b){
+            first = btstack_timer_queue_next_sibling(b);
+            a = btstack_timer_queue_meld(a, b);
+        } else {
+            first = NULL;
+        }
+        a->item.next = (btstack_linked_item_t *) pairs;
+        pairs = a;
+    }
+    // second pass: meld from right to left
+    btstack_timer_source_t * root = NULL;
+    while (pairs){
+        btstack_timer_source_t * next = btstack_timer_queue_next_sibling(pairs);
+        pairs->item.next = NULL;
+        pairs->prev = NULL;
+        root = root ? btstack_timer_queue_meld(root, pairs) : pairs;
+        pairs = next;
+    }
+    return root;
+}
+
+static int btstack_timer_queue_contains(btstack_timer_queue_t * queue, btstack_timer_source_t * timer){
+    return (queue->root == timer) || (timer->prev != NULL);
+}
+
+void btstack_timer_queue_init(btstack_timer_queue_t * queue){
+    queue->root = NULL;
+}
+
+int btstack_timer_queue_add(btstack_timer_queue_t * queue, btstack_timer_source_t * timer){
+    int added = 1;
+    if (btstack_timer_queue_contains(queue, timer)){
+        // timeout might have changed since it was added, re-insert at new position
+        btstack_timer_queue_remove(queue, timer);
+        added = 0;
+    }
+    timer->item.next = NULL;
+    timer->child = NULL;
+    timer->prev  = NULL;
+    if (queue->root){
+        queue->root = btstack_timer_queue_meld(queue->root, timer);
+    } else {
+        queue->root = timer;
+    }
+    return added;
+}
+
+int btstack_timer_queue_remove(btstack_timer_queue_t * queue, btstack_timer_source_t * timer){
+    if (!btstack_timer_queue_contains(queue, timer)) return 0;
+    btstack_timer_source_t * children = btstack_timer_queue_merge_pairs(timer->child);
+    if (queue->root == timer){
+        queue->root = children;
+    } else {
+        // unlink from parent or previous sibling
+        btstack_timer_source_t * next = btstack_timer_queue_next_sibling(timer);
+        if (timer->prev->child == timer){
+            timer->prev->child = next;
+        } else {
+            timer->prev->item.next = (btstack_linked_item_t *) next;
+        }
+        if (next){
+            next->prev = timer->prev;
+        }
+        if (children){
+            queue->root = btstack_timer_queue_meld(queue->root, children);
+        }
+    }
+    timer->item.next = NULL;
+    timer->child = NULL;
+    timer->prev  = NULL;
+    return 1;
+}
+
+btstack_timer_source_t * btstack_timer_queue_first(const btstack_timer_queue_t * queue){
+    return queue->root;
+}
+
+static void btstack_timer_queue_dump_siblings(btstack_timer_source_t * timer, int level){
+    for ( ; timer ; timer = btstack_timer_queue_next_sibling(timer)){
+        log_info("timer %p, level %u, timeout %u", (void *) timer, level, (unsigned int) timer->timeout);
+        btstack_timer_queue_dump_siblings(timer->child, level + 1);
+    }
+}
+
+void btstack_timer_queue_dump(const btstack_timer_queue_t * queue){
+    btstack_timer_queue_dump_siblings(queue->root, 0);
+}
+
 /**
  * Execute run_loop
  */
@@ -91,8 +91,20 @@ typedef struct btstack_timer_source {
     // will be called when timer fired
     void  (*process)(struct btstack_timer_source *ts); 
     void * context;
+    // timer queue: first child and parent or previous sibling, next sibling is stored in item.next
+    struct btstack_timer_source * child;
+    struct btstack_timer_source * prev;
+#ifdef HAVE_POSIX_TIME
+    // timeout in microseconds for run loops that provide get_time_us
+    uint64_t timeout_us;
+#endif
 } btstack_timer_source_t;
 
+// timer queue ordered by timeout, stored as pairing heap, e.g. used by run loop implementations
+typedef struct {
+    btstack_timer_source_t * root;
+} btstack_timer_queue_t;
+
 typedef struct btstack_run_loop {
 	void (*init)(void);
 	void (*add_data_source)(btstack_data_source_t * data_source);
@@ -105,10 +117,49 @@ typedef struct btstack_run_loop {
 	void (*execute)(void);
 	void (*dump_timer)(void);
 	uint32_t (*get_time_ms)(void);
+	// optional: microsecond resolution
+	void (*set_timer_us)(btstack_timer_source_t * timer, uint32_t timeout_in_us);
+	uint64_t (*get_time_us)(void);
 } btstack_run_loop_t;
 
 void btstack_run_loop_timer_dump(void);
 
+/**
+ * @brief Init timer queue
+ * @param queue
+ */
+void btstack_timer_queue_init(btstack_timer_queue_t * queue);
+
+/**
+ * @brief Add timer to queue in O(1)
+ * @note Timer needs to be zero initialized before it is added for the first time. Its queue links are only modified by add and remove
+ * @param queue
+ * @param timer
+ * @returns 1 if added, 0 if timer was already in queue and has been moved to its current timeout
+ */
+int btstack_timer_queue_add(btstack_timer_queue_t * queue, btstack_timer_source_t * timer);
+
+/**
+ * @brief Remove timer from queue in amortized O(log n)
+ * @param queue
+ * @param timer
+ * @returns 1 if removed, 0 if timer was not in queue
+ */
+int btstack_timer_queue_remove(btstack_timer_queue_t * queue, btstack_timer_source_t * timer);
+
+/**
+ * @brief Get timer with earliest timeout in O(1)
+ * @param queue
+ * @returns timer or NULL if queue is empty
+ */
+btstack_timer_source_t * btstack_timer_queue_first(const btstack_timer_queue_t * queue);
+
+/**
+ * @brief Log all timers in queue
+ * @param queue
+ */
+void btstack_timer_queue_dump(const btstack_timer_queue_t * queue);
+
 /* API_START */
 
 /**
@@ -120,9 +171,17 @@ void btstack_run_loop_init(const btstack_run_loop_t * run_loop);
 
 /**
  * @brief Set timer based on current time in milliseconds.
+ * @note If timer is in the run loop, remove it or add it again to re-arm it
  */
 void btstack_run_loop_set_timer(btstack_timer_source_t * ts, uint32_t timeout_in_ms);
 
+/**
+ * @brief Set timer based on current time in microseconds.
+ * @note If timer is in the run loop, remove it or add it again to re-arm it
+ * @note Falls back to millisecond resolution if run loop does not provide microsecond timers
+ */
+void btstack_run_loop_set_timer_us(btstack_timer_source_t * ts, uint32_t timeout_in_us);
+
 /**
  * @brief Set callback that will be executed when timer expires.
  */
@@ -154,6 +213,12 @@ int  btstack_run_loop_remove_timer(btstack_timer_source_t * timer);
  */
 uint32_t btstack_run_loop_get_time_ms(void);
 
+/**
+ * @brief Get current time in us
+ * @note Falls back to millisecond resolution if run loop does not provide microsecond time
+ */
+uint64_t btstack_run_loop_get_time_us(void);
+
 /**
  * @brief Set data source callback.
  */
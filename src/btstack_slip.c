@@ -45,6 +45,8 @@
 #include "btstack_slip.h"
 #include "btstack_debug.h"
 
+#include <string.h>
+
 typedef enum {
 	SLIP_ENCODER_DEFAULT,
 	SLIP_ENCODER_SEND_DC,
@@ -218,6 +220,55 @@ void btstack_slip_decoder_process(uint8_t input){
     }
 }
 
+/**
+ * @brief Process block of received bytes until a frame is complete or all bytes have been processed
+ * @param input
+ * @param len
+ * @return number of bytes processed
+ */
+uint16_t btstack_slip_decoder_process_buffer(const uint8_t * input, uint16_t len){
+    uint16_t pos = 0;
+    // offset of next frame delimiter in input, len if none
+    uint16_t sof_pos = 0;
+    while (pos < len && decoder_state != SLIP_DECODER_COMPLETE){
+        if (sof_pos < pos){
+            sof_pos = pos;
+        }
+        if (sof_pos == pos){
+            const uint8_t * sof = (const uint8_t *) memchr(&input[pos], BTSTACK_SLIP_SOF, len - pos);
+            sof_pos = sof ? (uint16_t) (sof - input) : len;
+        }
+        switch (decoder_state){
+            case SLIP_DECODER_UNKNOWN:
+                // skip bytes before next frame delimiter
+                if (sof_pos == len) return len;
+                pos = sof_pos;
+                btstack_slip_decoder_process(input[pos++]);
+                break;
+            case SLIP_DECODER_ACTIVE: {
+                // copy bytes up to next frame delimiter or escape
+                uint16_t run = sof_pos - pos;
+                const uint8_t * esc = (const uint8_t *) memchr(&input[pos], 0xdb, run);
+                if (esc){
+                    run = (uint16_t) (esc - &input[pos]);
+                }
+                if (run == 0 || (decoder_pos + run) > decoder_max_size){
+                    btstack_slip_decoder_process(input[pos++]);
+                    break;
+                }
+                memcpy(&decoder_buffer[decoder_pos], &input[pos], run);
+                decoder_pos += run;
+                pos += run;
+                break;
+            }
+            default:
+                btstack_slip_decoder_process(input[pos++]);
+                break;
+        }
+    }
+    return pos;
+}
+
 /**
  * @brief Get size of decoded frame
  * @return size of frame. Size = 0 => frame not complete
@@ -88,6 +88,15 @@ void btstack_slip_decoder_init(uint8_t * buffer, uint16_t max_size);
 
 void btstack_slip_decoder_process(uint8_t input);
 
+/**
+ * @brief Process block of received bytes until a frame is complete or all bytes have been processed
+ * @note if a frame is complete, call btstack_slip_decoder_init before processing the remaining bytes
+ * @param input
+ * @param len
+ * @return number of bytes processed
+ */
+uint16_t btstack_slip_decoder_process_buffer(const uint8_t * input, uint16_t len);
+
 /**
  * @brief Get size of decoded frame
  * @return size of frame. Size = 0 => frame not complete
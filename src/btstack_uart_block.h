@@ -46,6 +46,7 @@
 #define __BTSTACK_UART_BLOCK_H
 
 #include <stdint.h>
+#include "btstack_defines.h"
 
 typedef struct {
     uint32_t   baudrate;
@@ -143,6 +144,28 @@ typedef struct {
      */
     void (*set_wakeup_handler)(void (*wakeup_handler)(void));
 
+    // support for streaming receive
+
+    /**
+     * receive available data: read up to max_len bytes into buffer, data received handler is
+     * called with number of bytes as soon as at least one byte has been received.
+     * optional, NULL if not supported
+     */
+    void (*receive_available)(uint8_t *buffer, uint16_t max_len);
+
+    /**
+     * set callback for data received via receive_available. NULL disables callback
+     */
+    void (*set_data_received)(void (*data_handler)(uint16_t len));
+
+    // support for scatter-gather send
+
+    /**
+     * send block gathered from iovcnt segments, block sent handler is called after all segments have been sent
+     * segments have to stay valid until then. optional, NULL if not supported
+     */
+    void (*send_block_iov)(const btstack_iovec_t * iov, int iovcnt);
+
 } btstack_uart_block_t;
 
 // common implementations
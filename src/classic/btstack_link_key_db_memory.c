@@ -37,6 +37,7 @@
 
 #define __BTSTACK_FILE__ "btstack_link_key_db_memory.c"
 
+#include <stddef.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -51,6 +52,55 @@
 // This list should be directly accessed only by tests
 btstack_linked_list_t db_mem_link_keys = NULL;
 
+#ifdef ENABLE_DEVICE_DB_INDEX
+
+// number of hash buckets for lookup by bd_addr
+#ifndef BTSTACK_LINK_KEY_DB_MEMORY_INDEX_SIZE
+#define BTSTACK_LINK_KEY_DB_MEMORY_INDEX_SIZE 32
+#endif
+
+static btstack_device_db_index_entry_t * db_mem_index_buckets[BTSTACK_LINK_KEY_DB_MEMORY_INDEX_SIZE];
+static btstack_device_db_index_t db_mem_index = { db_mem_index_buckets, BTSTACK_LINK_KEY_DB_MEMORY_INDEX_SIZE };
+
+static void db_mem_index_remove(btstack_link_key_db_memory_entry_t * item){
+    btstack_device_db_index_remove(&db_mem_index, &item->index_item);
+}
+
+// list with prev pointers to move items to front in O(1)
+static void db_mem_list_remove(btstack_link_key_db_memory_entry_t * item){
+    btstack_link_key_db_memory_entry_t * next = (btstack_link_key_db_memory_entry_t *) item->item.next;
+    if (item->prev){
+        item->prev->item.next = (btstack_linked_item_t *) next;
+    } else {
+        db_mem_link_keys = (btstack_linked_item_t *) next;
+    }
+    if (next){
+        next->prev = item->prev;
+    }
+}
+
+static void db_mem_list_add(btstack_link_key_db_memory_entry_t * item){
+    btstack_link_key_db_memory_entry_t * head = (btstack_link_key_db_memory_entry_t *) db_mem_link_keys;
+    item->item.next = (btstack_linked_item_t *) head;
+    item->prev = NULL;
+    if (head){
+        head->prev = item;
+    }
+    db_mem_link_keys = (btstack_linked_item_t *) item;
+}
+
+#else
+
+static void db_mem_list_remove(btstack_link_key_db_memory_entry_t * item){
+    btstack_linked_list_remove(&db_mem_link_keys, (btstack_linked_item_t *) item);
+}
+
+static void db_mem_list_add(btstack_link_key_db_memory_entry_t * item){
+    btstack_linked_list_add(&db_mem_link_keys, (btstack_linked_item_t *) item);
+}
+
+#endif
+
 // Device info
 static void db_open(void){
 }
@@ -63,6 +113,12 @@ static void db_close(void){
 }
 
 static btstack_link_key_db_memory_entry_t * get_item(btstack_linked_list_t list, bd_addr_t bd_addr) {
+#ifdef ENABLE_DEVICE_DB_INDEX
+    UNUSED(list);
+    btstack_device_db_index_entry_t * index_item = btstack_device_db_index_find(&db_mem_index, BD_ADDR_TYPE_CLASSIC, bd_addr);
+    if (!index_item) return NULL;
+    return (btstack_link_key_db_memory_entry_t *) (((uint8_t *) index_item) - offsetof(btstack_link_key_db_memory_entry_t, index_item));
+#else
     btstack_linked_item_t *it;
     for (it = (btstack_linked_item_t *) list; it ; it = it->next){
         btstack_link_key_db_memory_entry_t * item = (btstack_link_key_db_memory_entry_t *) it;
@@ -71,6 +127,7 @@ static btstack_link_key_db_memory_entry_t * get_item(btstack_linked_list_t list,
         }
     }
     return NULL;
+#endif
 }
 
 static int get_link_key(bd_addr_t bd_addr, link_key_t link_key, link_key_type_t * link_key_type) {
@@ -82,8 +139,8 @@ static int get_link_key(bd_addr_t bd_addr, link_key_t link_key, link_key_type_t
     if (link_key_type) {
         *link_key_type = item->link_key_type;
     }
-	btstack_linked_list_remove(&db_mem_link_keys, (btstack_linked_item_t *) item);
-    btstack_linked_list_add(&db_mem_link_keys, (btstack_linked_item_t *) item);
+    db_mem_list_remove(item);
+    db_mem_list_add(item);
 
 	return 1;
 }
@@ -93,7 +150,10 @@ static void delete_link_key(bd_addr_t bd_addr){
     
     if (!item) return;
     
-    btstack_linked_list_remove(&db_mem_link_keys, (btstack_linked_item_t *) item);
+    db_mem_list_remove(item);
+#ifdef ENABLE_DEVICE_DB_INDEX
+    db_mem_index_remove(item);
+#endif
     btstack_memory_btstack_link_key_db_memory_entry_free((btstack_link_key_db_memory_entry_t*)item);
 }
 
@@ -103,7 +163,10 @@ static void put_link_key(bd_addr_t bd_addr, link_key_t link_key, link_key_type_t
     // check for existing record and remove if found
     btstack_link_key_db_memory_entry_t * record = get_item(db_mem_link_keys, bd_addr);
     if (record){
-        btstack_linked_list_remove(&db_mem_link_keys, (btstack_linked_item_t*) record);
+        db_mem_list_remove(record);
+#ifdef ENABLE_DEVICE_DB_INDEX
+        db_mem_index_remove(record);
+#endif
     }
 
     // record not found, get new one from memory pool
@@ -115,7 +178,10 @@ static void put_link_key(bd_addr_t bd_addr, link_key_t link_key, link_key_type_t
     if (!record){
         record = (btstack_link_key_db_memory_entry_t*) btstack_linked_list_get_last_item(&db_mem_link_keys);
         if (record) {
-            btstack_linked_list_remove(&db_mem_link_keys, (btstack_linked_item_t*) record);
+            db_mem_list_remove(record);
+#ifdef ENABLE_DEVICE_DB_INDEX
+            db_mem_index_remove(record);
+#endif
         }
     }
         
@@ -124,7 +190,10 @@ static void put_link_key(bd_addr_t bd_addr, link_key_t link_key, link_key_type_t
     memcpy(record->bd_addr, bd_addr, sizeof(bd_addr_t));
     memcpy(record->link_key, link_key, LINK_KEY_LEN);
     record->link_key_type = link_key_type;
-    btstack_linked_list_add(&db_mem_link_keys, (btstack_linked_item_t *) record);
+    db_mem_list_add(record);
+#ifdef ENABLE_DEVICE_DB_INDEX
+    btstack_device_db_index_add(&db_mem_index, &record->index_item, BD_ADDR_TYPE_CLASSIC, bd_addr);
+#endif
 }
 
 static int iterator_init(btstack_link_key_iterator_t * it){
@@ -42,6 +42,8 @@
 #ifndef __BTSTACK_LINK_KEY_DB_MEMORY_H
 #define __BTSTACK_LINK_KEY_DB_MEMORY_H
 
+#include "btstack_config.h"
+#include "btstack_device_db_index.h"
 #include "btstack_link_key_db.h"
 #include "btstack_linked_list.h"
 
@@ -54,11 +56,16 @@ extern "C" {
  */
 const btstack_link_key_db_t * btstack_link_key_db_memory_instance(void);
 
-typedef struct {
+typedef struct btstack_link_key_db_memory_entry {
     btstack_linked_item_t item;
     bd_addr_t bd_addr;
     link_key_t link_key;
     link_key_type_t link_key_type;
+#ifdef ENABLE_DEVICE_DB_INDEX
+    // previous item in list and index by bd_addr
+    struct btstack_link_key_db_memory_entry * prev;
+    btstack_device_db_index_entry_t index_item;
+#endif
 } btstack_link_key_db_memory_entry_t;
 
 /* API_END */
@@ -43,6 +43,7 @@
 #include "classic/btstack_link_key_db_tlv.h"
 
 #include "btstack_debug.h"
+#include "btstack_device_db_index.h"
 #include "btstack_util.h"
 #include "classic/core.h"
 
@@ -51,9 +52,23 @@
 #define NVM_NUM_LINK_KEYS 1
 #endif
 
+#ifdef ENABLE_DEVICE_DB_INDEX
+// BD_ADDR and seq nr of stored entry, indexed by BD_ADDR
+typedef struct {
+    btstack_device_db_index_entry_t item;
+    uint32_t  seq_nr;
+    uint8_t   valid;
+} btstack_link_key_db_tlv_index_entry_t;
+#endif
+
 typedef struct {
     const btstack_tlv_t * btstack_tlv_impl;
     void * btstack_tlv_context;
+#ifdef ENABLE_DEVICE_DB_INDEX
+    btstack_link_key_db_tlv_index_entry_t index[NVM_NUM_LINK_KEYS];
+    btstack_device_db_index_entry_t * buckets[NVM_NUM_LINK_KEYS];
+    btstack_device_db_index_t index_by_addr;
+#endif
 } btstack_link_key_db_tlv_h;
 
 typedef struct link_key_nvm {
@@ -74,6 +89,65 @@ static uint32_t btstack_link_key_db_tag_for_index(uint8_t index){
     return (tag_0 << 24) | (tag_1 << 16) | (tag_2 << 8) | index;
 }
 
+#ifdef ENABLE_DEVICE_DB_INDEX
+
+// @returns index of entry for bd_addr or -1
+static int btstack_link_key_db_tlv_index_find(const bd_addr_t bd_addr){
+    btstack_link_key_db_tlv_index_entry_t * entry = (btstack_link_key_db_tlv_index_entry_t *) btstack_device_db_index_find(&self->index_by_addr, BD_ADDR_TYPE_CLASSIC, bd_addr);
+    if (!entry) return -1;
+    return entry - self->index;
+}
+
+static void btstack_link_key_db_tlv_index_add(int index, const bd_addr_t bd_addr, uint32_t seq_nr){
+    btstack_link_key_db_tlv_index_entry_t * entry = &self->index[index];
+    entry->seq_nr = seq_nr;
+    entry->valid  = 1;
+    btstack_device_db_index_add(&self->index_by_addr, &entry->item, BD_ADDR_TYPE_CLASSIC, bd_addr);
+}
+
+static void btstack_link_key_db_tlv_index_remove(int index){
+    btstack_link_key_db_tlv_index_entry_t * entry = &self->index[index];
+    if (!entry->valid) return;
+    btstack_device_db_index_remove(&self->index_by_addr, &entry->item);
+    entry->valid = 0;
+}
+
+// read all entries once
+static void btstack_link_key_db_tlv_index_build(void){
+    int i;
+    btstack_device_db_index_init(&self->index_by_addr, self->buckets, NVM_NUM_LINK_KEYS);
+    for (i=0;i<NVM_NUM_LINK_KEYS;i++){
+        self->index[i].valid = 0;
+    }
+    for (i=0;i<NVM_NUM_LINK_KEYS;i++){
+        link_key_nvm_t entry;
+        uint32_t tag = btstack_link_key_db_tag_for_index(i);
+        int size = self->btstack_tlv_impl->get_tag(self->btstack_tlv_context, tag, (uint8_t*) &entry, sizeof(entry));
+        if (size == 0) continue;
+        btstack_link_key_db_tlv_index_add(i, entry.bd_addr, entry.seq_nr);
+    }
+}
+
+#endif
+
+// fetch BD_ADDR and seq nr of stored entry
+// @returns 1 if entry exists
+static int btstack_link_key_db_tlv_fetch_info(int index, bd_addr_t bd_addr, uint32_t * seq_nr){
+#ifdef ENABLE_DEVICE_DB_INDEX
+    if (!self->index[index].valid) return 0;
+    memcpy(bd_addr, self->index[index].item.addr, 6);
+    *seq_nr = self->index[index].seq_nr;
+#else
+    link_key_nvm_t entry;
+    uint32_t tag = btstack_link_key_db_tag_for_index(index);
+    int size = self->btstack_tlv_impl->get_tag(self->btstack_tlv_context, tag, (uint8_t*) &entry, sizeof(entry));
+    if (size == 0) return 0;
+    memcpy(bd_addr, entry.bd_addr, 6);
+    *seq_nr = entry.seq_nr;
+#endif
+    return 1;
+}
+
 // Device info
 static void btstack_link_key_db_tlv_open(void){
 }
@@ -86,6 +160,17 @@ static void btstack_link_key_db_tlv_close(void){
 }
 
 static int btstack_link_key_db_tlv_get_link_key(bd_addr_t bd_addr, link_key_t link_key, link_key_type_t * link_key_type) {
+#ifdef ENABLE_DEVICE_DB_INDEX
+    int index = btstack_link_key_db_tlv_index_find(bd_addr);
+    if (index < 0) return 0;
+    link_key_nvm_t entry;
+    uint32_t tag = btstack_link_key_db_tag_for_index(index);
+    int size = self->btstack_tlv_impl->get_tag(self->btstack_tlv_context, tag, (uint8_t*) &entry, sizeof(entry));
+    if (size == 0) return 0;
+    memcpy(link_key, entry.link_key, 16);
+    *link_key_type = entry.link_key_type;
+    return 1;
+#else
     int i;
     for (i=0;i<NVM_NUM_LINK_KEYS;i++){
         link_key_nvm_t entry;
@@ -100,9 +185,16 @@ static int btstack_link_key_db_tlv_get_link_key(bd_addr_t bd_addr, link_key_t li
         return 1;
     }
 	return 0;
+#endif
 }
 
 static void btstack_link_key_db_tlv_delete_link_key(bd_addr_t bd_addr){
+#ifdef ENABLE_DEVICE_DB_INDEX
+    int index = btstack_link_key_db_tlv_index_find(bd_addr);
+    if (index < 0) return;
+    self->btstack_tlv_impl->delete_tag(self->btstack_tlv_context, btstack_link_key_db_tag_for_index(index));
+    btstack_link_key_db_tlv_index_remove(index);
+#else
     int i;
     for (i=0;i<NVM_NUM_LINK_KEYS;i++){
         link_key_nvm_t entry;
@@ -114,6 +206,7 @@ static void btstack_link_key_db_tlv_delete_link_key(bd_addr_t bd_addr){
         self->btstack_tlv_impl->delete_tag(self->btstack_tlv_context, tag);
         break;
     }
+#endif
 }
 
 static void btstack_link_key_db_tlv_put_link_key(bd_addr_t bd_addr, link_key_t link_key, link_key_type_t link_key_type){
@@ -125,26 +218,26 @@ static void btstack_link_key_db_tlv_put_link_key(bd_addr_t bd_addr, link_key_t l
     uint32_t tag_for_empty = 0;
 
     for (i=0;i<NVM_NUM_LINK_KEYS;i++){
-        link_key_nvm_t entry;
+        bd_addr_t entry_bd_addr;
+        uint32_t  entry_seq_nr;
         uint32_t tag = btstack_link_key_db_tag_for_index(i);
-        int size = self->btstack_tlv_impl->get_tag(self->btstack_tlv_context, tag, (uint8_t*) &entry, sizeof(entry));
         // empty/deleted tag
-        if (size == 0) {
+        if (!btstack_link_key_db_tlv_fetch_info(i, entry_bd_addr, &entry_seq_nr)) {
             tag_for_empty = tag;
             continue;
         }
         // found addr?
-        if (memcmp(bd_addr, entry.bd_addr, 6) == 0){
+        if (memcmp(bd_addr, entry_bd_addr, 6) == 0){
             tag_for_addr = tag;
         }
         // update highest seq nr
-        if (entry.seq_nr > highest_seq_nr){
-            highest_seq_nr = entry.seq_nr;
+        if (entry_seq_nr > highest_seq_nr){
+            highest_seq_nr = entry_seq_nr;
         }
         // find entry with lowest seq nr
-        if ((tag_for_lowest_seq_nr == 0) || (entry.seq_nr < lowest_seq_nr)){
+        if ((tag_for_lowest_seq_nr == 0) || (entry_seq_nr < lowest_seq_nr)){
             tag_for_lowest_seq_nr = tag;
-            lowest_seq_nr = entry.seq_nr;
+            lowest_seq_nr = entry_seq_nr;
         }
     }
 
@@ -172,6 +265,12 @@ static void btstack_link_key_db_tlv_put_link_key(bd_addr_t bd_addr, link_key_t l
     entry.seq_nr = highest_seq_nr + 1;
 
     self->btstack_tlv_impl->store_tag(self->btstack_tlv_context, tag_to_use, (uint8_t*) &entry, sizeof(entry));
+
+#ifdef ENABLE_DEVICE_DB_INDEX
+    int index = tag_to_use & 0xff;
+    btstack_link_key_db_tlv_index_remove(index);
+    btstack_link_key_db_tlv_index_add(index, bd_addr, entry.seq_nr);
+#endif
 }
 
 static int btstack_link_key_db_tlv_iterator_init(btstack_link_key_iterator_t * it){
@@ -183,6 +282,12 @@ static int  btstack_link_key_db_tlv_iterator_get_next(btstack_link_key_iterator_
     uintptr_t i = (uintptr_t) it->context;
     int found = 0;
     while (i<NVM_NUM_LINK_KEYS){
+#ifdef ENABLE_DEVICE_DB_INDEX
+        if (!self->index[i].valid) {
+            i++;
+            continue;
+        }
+#endif
         link_key_nvm_t entry;
         uint32_t tag = btstack_link_key_db_tag_for_index(i++);
         int size = self->btstack_tlv_impl->get_tag(self->btstack_tlv_context, tag, (uint8_t*) &entry, sizeof(entry));
@@ -216,6 +321,9 @@ static const btstack_link_key_db_t btstack_link_key_db_tlv = {
 const btstack_link_key_db_t * btstack_link_key_db_tlv_get_instance(const btstack_tlv_t * btstack_tlv_impl, void * btstack_tlv_context){
     self->btstack_tlv_impl = btstack_tlv_impl;
     self->btstack_tlv_context = btstack_tlv_context;
+#ifdef ENABLE_DEVICE_DB_INDEX
+    btstack_link_key_db_tlv_index_build();
+#endif
     return &btstack_link_key_db_tlv;
 }
 
@@ -45,6 +45,7 @@
 
 #include <stdint.h>
 #include "btstack_sbc_plc.h"
+#include "btstack_ring_buffer.h"
 
 #if defined __cplusplus
 extern "C" {
@@ -55,6 +56,10 @@ typedef enum{
     SBC_MODE_mSBC
 } btstack_sbc_mode_t;
 
+// size of codec state stored in btstack_sbc_decoder_state_t and btstack_sbc_encoder_state_t, checked by codec implementation
+#define BTSTACK_SBC_DECODER_STORAGE_SIZE 3232
+#define BTSTACK_SBC_ENCODER_STORAGE_SIZE 2688
+
 typedef struct {
     void * context;
     void (*handle_pcm_data)(int16_t * data, int num_samples, int num_channels, int sample_rate, void * context);
@@ -67,12 +72,24 @@ typedef struct {
     int good_frames_nr;
     int bad_frames_nr;
     int zero_frames_nr;
+
+    // codec state, decoder_state points here
+    union {
+        void *   align;
+        uint32_t words[BTSTACK_SBC_DECODER_STORAGE_SIZE / 4];
+    } decoder_storage;
 } btstack_sbc_decoder_state_t;
 
 typedef struct {
     // private
     void * encoder_state;
     btstack_sbc_mode_t mode;
+
+    // codec state, encoder_state points here
+    union {
+        void *   align;
+        uint32_t words[BTSTACK_SBC_ENCODER_STORAGE_SIZE / 4];
+    } encoder_storage;
 } btstack_sbc_encoder_state_t;
 
 /* API_START */
@@ -80,6 +97,7 @@ typedef struct {
 /* BTstack SBC decoder */
 /**
  * @brief Init SBC decoder
+ * @note All decoder state is kept in the state struct, multiple decoders can be used at the same time
  * @param state
  * @param mode
  * @param callback for decoded PCM data in host endianess
@@ -90,6 +108,7 @@ void btstack_sbc_decoder_init(btstack_sbc_decoder_state_t * state, btstack_sbc_m
 
 /**
  * @brief Process received SBC data
+ * @note Complete frames are decoded directly from buffer, only a partial frame at the end is copied into the decoder state
  * @param state
  * @param packet_status_flag from SCO packet: 0 = OK, 1 = possibly invalid data, 2 = no data received, 3 = data partially lost
  * @param buffer
@@ -97,6 +116,18 @@ void btstack_sbc_decoder_init(btstack_sbc_decoder_state_t * state, btstack_sbc_m
  */
 void btstack_sbc_decoder_process_data(btstack_sbc_decoder_state_t * state, int packet_status_flag, uint8_t * buffer, int size);
 
+/**
+ * @brief Process SBC data stored in ring buffer, e.g. A2DP Sink jitter buffer
+ * @note Frames are decoded directly from ring buffer storage and removed from the ring buffer, 
+ *       a partial frame at the end is left in the ring buffer. Only supported for SBC_MODE_STANDARD
+ *       and not to be mixed with btstack_sbc_decoder_process_data for the same stream
+ * @param state
+ * @param ring_buffer
+ * @param max_frames to decode, 0 = all complete frames
+ * @return number of decoded frames
+ */
+int btstack_sbc_decoder_process_ring_buffer(btstack_sbc_decoder_state_t * state, btstack_ring_buffer_t * ring_buffer, int max_frames);
+
 /**
  * @brief Get number of samples per SBC frame
  */
@@ -116,6 +147,7 @@ int btstack_sbc_decoder_sample_rate(btstack_sbc_decoder_state_t * state);
 /* BTstack SBC Encoder */
 /**
  * @brief Init SBC encoder
+ * @note All encoder state is kept in the state struct, multiple encoders can be used at the same time
  * @param state
  * @param mode 
  * @param blocks
@@ -130,25 +162,29 @@ void btstack_sbc_encoder_init(btstack_sbc_encoder_state_t * state, btstack_sbc_m
 
 /**
  * @brief Encode PCM data
+ * @param state
  * @param buffer with samples in host endianess
  */
-void btstack_sbc_encoder_process_data(int16_t * input_buffer);
+void btstack_sbc_encoder_process_data(btstack_sbc_encoder_state_t * state, int16_t * input_buffer);
 
 /**
  * @brief Return SBC frame
+ * @param state
  */
-uint8_t * btstack_sbc_encoder_sbc_buffer(void);
+uint8_t * btstack_sbc_encoder_sbc_buffer(btstack_sbc_encoder_state_t * state);
 
 /**
  * @brief Return SBC frame length
+ * @param state
  */
-uint16_t  btstack_sbc_encoder_sbc_buffer_length(void);
+uint16_t  btstack_sbc_encoder_sbc_buffer_length(btstack_sbc_encoder_state_t * state);
 
 /**
  * @brief Return number of audio frames required for one SBC packet
  * @note  each audio frame contains 2 sample values in stereo modes
+ * @param state
  */
-int  btstack_sbc_encoder_num_audio_frames(void);
+int  btstack_sbc_encoder_num_audio_frames(btstack_sbc_encoder_state_t * state);
 
 /* API_END */
 
@@ -52,6 +52,7 @@
 
 #include "btstack_sbc.h"
 #include "btstack_sbc_plc.h"
+#include "btstack_ring_buffer.h"
 
 #include "oi_codec_sbc.h"
 #include "oi_assert.h"
@@ -77,10 +78,11 @@ typedef struct {
     int search_new_sync_word;
     int sync_word_found;
     int first_good_frame_found; 
+    int frame_count;
 } bludroid_decoder_state_t;
 
-static btstack_sbc_decoder_state_t * sbc_decoder_state_singleton = NULL;
-static bludroid_decoder_state_t bd_decoder_state;
+// fails to compile if decoder state does not fit into btstack_sbc_decoder_state_t
+typedef uint8_t bludroid_decoder_storage_check_t[(sizeof(bludroid_decoder_state_t) <= BTSTACK_SBC_DECODER_STORAGE_SIZE) ? 1 : -1];
 
 // Testing only - START
 static int plc_enabled = 1;
@@ -157,17 +159,17 @@ void OI_AssertFail(const char* file, int line, const char* reason){
 #endif
 
 void btstack_sbc_decoder_init(btstack_sbc_decoder_state_t * state, btstack_sbc_mode_t mode, void (*callback)(int16_t * data, int num_samples, int num_channels, int sample_rate, void * context), void * context){
-    if (sbc_decoder_state_singleton && sbc_decoder_state_singleton != state ){
-        log_error("SBC decoder: different sbc decoder state is allready registered");
-    } 
+    memset(state, 0, sizeof(btstack_sbc_decoder_state_t));
+    bludroid_decoder_state_t * bd_decoder_state = (bludroid_decoder_state_t *) &state->decoder_storage;
+
     OI_STATUS status = OI_STATUS_SUCCESS;
     switch (mode){
         case SBC_MODE_STANDARD:
             // note: we always request stereo output, even for mono input
-            status = OI_CODEC_SBC_DecoderReset(&(bd_decoder_state.decoder_context), bd_decoder_state.decoder_data, sizeof(bd_decoder_state.decoder_data), 2, 2, FALSE);
+            status = OI_CODEC_SBC_DecoderReset(&(bd_decoder_state->decoder_context), bd_decoder_state->decoder_data, sizeof(bd_decoder_state->decoder_data), 2, 2, FALSE);
             break;
         case SBC_MODE_mSBC:
-            status = OI_CODEC_mSBC_DecoderReset(&(bd_decoder_state.decoder_context), bd_decoder_state.decoder_data, sizeof(bd_decoder_state.decoder_data));
+            status = OI_CODEC_mSBC_DecoderReset(&(bd_decoder_state->decoder_context), bd_decoder_state->decoder_data, sizeof(bd_decoder_state->decoder_data));
             break;
         default:
             break;
@@ -177,23 +179,20 @@ void btstack_sbc_decoder_init(btstack_sbc_decoder_state_t * state, btstack_sbc_m
         log_error("SBC decoder: error during reset %d\n", status);
     }
     
-    sbc_decoder_state_singleton = state;
-    
-    bd_decoder_state.bytes_in_frame_buffer = 0;
-    bd_decoder_state.pcm_bytes = sizeof(bd_decoder_state.pcm_data);
-    bd_decoder_state.h2_sequence_nr = -1;
-    bd_decoder_state.sync_word_found = 0;
-    bd_decoder_state.search_new_sync_word = 0;
+    bd_decoder_state->bytes_in_frame_buffer = 0;
+    bd_decoder_state->pcm_bytes = sizeof(bd_decoder_state->pcm_data);
+    bd_decoder_state->h2_sequence_nr = -1;
+    bd_decoder_state->sync_word_found = 0;
+    bd_decoder_state->search_new_sync_word = 0;
     if (mode == SBC_MODE_mSBC){
-        bd_decoder_state.search_new_sync_word = 1;
+        bd_decoder_state->search_new_sync_word = 1;
     }
-    bd_decoder_state.first_good_frame_found = 0;
+    bd_decoder_state->first_good_frame_found = 0;
 
-    memset(state, 0, sizeof(btstack_sbc_decoder_state_t));
     state->handle_pcm_data = callback;
     state->mode = mode;
     state->context = context;
-    state->decoder_state = &bd_decoder_state;
+    state->decoder_state = bd_decoder_state;
     btstack_sbc_plc_init(&state->plc_state);
 }
 
@@ -209,114 +208,188 @@ static void append_received_sbc_data(bludroid_decoder_state_t * state, uint8_t *
 }
 
 
-static void btstack_sbc_decoder_process_sbc_data(btstack_sbc_decoder_state_t * state, uint8_t * buffer, int size){
+// decode next SBC frame from data, returns number of bytes processed
+// if frame is incomplete, only garbage before the syncword is processed and *frame_incomplete is set
+static uint32_t btstack_sbc_decoder_decode_sbc_frame(btstack_sbc_decoder_state_t * state, const uint8_t * data, uint32_t size, int * frame_incomplete){
     bludroid_decoder_state_t * decoder_state = (bludroid_decoder_state_t*)state->decoder_state;
-    int input_bytes_to_process = size;
-    int keep_decoding = 1; 
-
-    while (keep_decoding) {
-        // Fill decoder_state->frame_buffer as much as possible.
-        int bytes_free_in_frame_buffer = SBC_MAX_FRAME_LEN - decoder_state->bytes_in_frame_buffer;
-        int bytes_to_append = btstack_min(input_bytes_to_process, bytes_free_in_frame_buffer);
-        if (bytes_to_append){
-            append_received_sbc_data(decoder_state, buffer, bytes_to_append);
-            buffer += bytes_to_append;
-            input_bytes_to_process -= bytes_to_append;
-        }
 
-        // Decode the next frame in decoder_state->frame_buffer.
-        int bytes_in_frame_buffer_before_decoding = decoder_state->bytes_in_frame_buffer;
-        const OI_BYTE *frame_data = decoder_state->frame_buffer;
-        OI_UINT32 frame_data_len = decoder_state->bytes_in_frame_buffer;
-        OI_STATUS status = OI_CODEC_SBC_DecodeFrame(&(decoder_state->decoder_context), 
-                                                    &frame_data, 
-                                                    &frame_data_len,
-                                                    decoder_state->pcm_plc_data, 
-                                                    &(decoder_state->pcm_bytes));
-        uint16_t bytes_processed = bytes_in_frame_buffer_before_decoding - frame_data_len;
-    
-        static int frame_count = 0;
-        if (corrupt_frame_period > 0){
-            frame_count++;
+    if (corrupt_frame_period > 0){
+        decoder_state->frame_count++;
 
-            if (frame_count % corrupt_frame_period == 0){
-                *(uint8_t*)&frame_data[5] = 0;
-                frame_count = 0;
+        if (decoder_state->frame_count % corrupt_frame_period == 0){
+            if (data != decoder_state->frame_buffer){
+                // corrupt copy, input data is not modified
+                size = btstack_min(size, sizeof(decoder_state->frame_buffer));
+                memcpy(decoder_state->frame_buffer, data, size);
+                data = decoder_state->frame_buffer;
             }
+            if (size > 5){
+                decoder_state->frame_buffer[5] = 0;
+            }
+            decoder_state->frame_count = 0;
         }
+    }
 
-        // Handle decoding result.
-        switch(status){
-            case OI_STATUS_SUCCESS:
-            case OI_CODEC_SBC_PARTIAL_DECODE:
-                state->handle_pcm_data(decoder_state->pcm_plc_data, 
-                                       btstack_sbc_decoder_num_samples_per_frame(state), 
-                                       btstack_sbc_decoder_num_channels(state), 
-                                       btstack_sbc_decoder_sample_rate(state), state->context);
-                state->good_frames_nr++;
-                break;
-                
-            case OI_CODEC_SBC_NOT_ENOUGH_HEADER_DATA:
-            case OI_CODEC_SBC_NOT_ENOUGH_BODY_DATA:
-            case OI_CODEC_SBC_NOT_ENOUGH_AUDIO_DATA:
-                if (input_bytes_to_process > 0){
-                    // Should never occur: The SBC code claims there is not enough bytes in the frame_buffer,
-                    // but the frame_buffer was full. (The frame_buffer is always full before decoding when input_bytes_to_process > 0.)
-                    // Clear frame_buffer.
-                    log_info("SBC decode: frame_buffer too small for frame");
-                    bytes_processed = bytes_in_frame_buffer_before_decoding;
-                } else {
-                    // Exit decode loop, because there is not enough data in frame_buffer to decode the next frame.
-                    keep_decoding = 0;
-                }
-                break;
-                
-            case OI_CODEC_SBC_NO_SYNCWORD:
-                // This means the entire frame_buffer did not contain the syncword.
-                // Discard the frame_buffer contents.
-                log_info("SBC decode: no syncword found");
-                bytes_processed = bytes_in_frame_buffer_before_decoding;
-                break;
-                
-            case OI_CODEC_SBC_CHECKSUM_MISMATCH:
-                // The next frame is somehow corrupt.
-                log_info("SBC decode: checksum error");
-                // Did the codec consume any bytes?
-                if (bytes_processed > 0){
-                    // Good. Nothing to do.
-                } else {
-                    // Skip the bogus frame by skipping the header.
-                    bytes_processed = 1;
-                }
-                break;
-                
-            case OI_STATUS_INVALID_PARAMETERS:
-                // This caused by corrupt frames.
-                // The codec apparently does not recover from this.
-                // Re-initialize the codec.
-                log_info("SBC decode: invalid parameters: resetting codec");
-                if (OI_CODEC_SBC_DecoderReset(&(bd_decoder_state.decoder_context), bd_decoder_state.decoder_data, sizeof(bd_decoder_state.decoder_data), 2, 2, FALSE) != OI_STATUS_SUCCESS){
-                    log_info("SBC decode: resetting codec failed");
-                    
-                }
-                break;
-            default:
-                // Anything else went wrong. 
-                // Skip a few bytes and try again.
+    const OI_BYTE *frame_data = data;
+    OI_UINT32 frame_data_len = size;
+    OI_STATUS status = OI_CODEC_SBC_DecodeFrame(&(decoder_state->decoder_context), 
+                                                &frame_data, 
+                                                &frame_data_len,
+                                                decoder_state->pcm_plc_data, 
+                                                &(decoder_state->pcm_bytes));
+    uint32_t bytes_processed = size - frame_data_len;
+    *frame_incomplete = 0;
+
+    // Handle decoding result.
+    switch(status){
+        case OI_STATUS_SUCCESS:
+        case OI_CODEC_SBC_PARTIAL_DECODE:
+            state->handle_pcm_data(decoder_state->pcm_plc_data, 
+                                   btstack_sbc_decoder_num_samples_per_frame(state), 
+                                   btstack_sbc_decoder_num_channels(state), 
+                                   btstack_sbc_decoder_sample_rate(state), state->context);
+            state->good_frames_nr++;
+            break;
+            
+        case OI_CODEC_SBC_NOT_ENOUGH_HEADER_DATA:
+        case OI_CODEC_SBC_NOT_ENOUGH_BODY_DATA:
+        case OI_CODEC_SBC_NOT_ENOUGH_AUDIO_DATA:
+            if (frame_data_len >= SBC_MAX_FRAME_LEN){
+                // Should never occur: The SBC code claims there are not enough bytes for a frame,
+                // but there is more than the maximal frame size. Skip the bogus header.
+                log_info("SBC decode: frame too large");
+                bytes_processed++;
+            } else {
+                // Wait for more data, syncword is at start of remaining data
+                *frame_incomplete = 1;
+            }
+            break;
+            
+        case OI_CODEC_SBC_NO_SYNCWORD:
+            // This means the entire data did not contain the syncword.
+            // Discard it.
+            log_info("SBC decode: no syncword found");
+            bytes_processed = size;
+            break;
+            
+        case OI_CODEC_SBC_CHECKSUM_MISMATCH:
+            // The next frame is somehow corrupt.
+            log_info("SBC decode: checksum error");
+            // Did the codec consume any bytes?
+            if (bytes_processed > 0){
+                // Good. Nothing to do.
+            } else {
+                // Skip the bogus frame by skipping the header.
                 bytes_processed = 1;
-                log_info("SBC decode: unknown status %d", status);
-                break;
-        }   
-        
-        // Remove decoded frame from decoder_state->frame_buffer.
-        if (bytes_processed > bytes_in_frame_buffer_before_decoding) {
-            bytes_processed = bytes_in_frame_buffer_before_decoding;
+            }
+            break;
+            
+        case OI_STATUS_INVALID_PARAMETERS:
+            // This caused by corrupt frames.
+            // The codec apparently does not recover from this.
+            // Re-initialize the codec and skip the header.
+            log_info("SBC decode: invalid parameters: resetting codec");
+            if (OI_CODEC_SBC_DecoderReset(&(decoder_state->decoder_context), decoder_state->decoder_data, sizeof(decoder_state->decoder_data), 2, 2, FALSE) != OI_STATUS_SUCCESS){
+                log_info("SBC decode: resetting codec failed");
+                
+            }
+            bytes_processed++;
+            break;
+        default:
+            // Anything else went wrong. 
+            // Skip a few bytes and try again.
+            bytes_processed = 1;
+            log_info("SBC decode: unknown status %d", status);
+            break;
+    }   
+
+    return btstack_min(bytes_processed, size);
+}
+
+static void btstack_sbc_decoder_process_sbc_data(btstack_sbc_decoder_state_t * state, uint8_t * buffer, int size){
+    bludroid_decoder_state_t * decoder_state = (bludroid_decoder_state_t*)state->decoder_state;
+    uint32_t bytes_processed;
+    int frame_incomplete;
+
+    // complete partial frame from last call in frame_buffer
+    while (decoder_state->bytes_in_frame_buffer){
+        uint32_t bytes_buffered = decoder_state->bytes_in_frame_buffer;
+        uint32_t bytes_to_append = btstack_min(size, sizeof(decoder_state->frame_buffer) - bytes_buffered);
+        memcpy(decoder_state->frame_buffer + bytes_buffered, buffer, bytes_to_append);
+        bytes_processed = btstack_sbc_decoder_decode_sbc_frame(state, decoder_state->frame_buffer, bytes_buffered + bytes_to_append, &frame_incomplete);
+        if (frame_incomplete){
+            // keep partial frame, continue if garbage was skipped and more input is available
+            uint32_t bytes_left = bytes_buffered + bytes_to_append - bytes_processed;
+            memmove(decoder_state->frame_buffer, decoder_state->frame_buffer + bytes_processed, bytes_left);
+            decoder_state->bytes_in_frame_buffer = bytes_left;
+            buffer += bytes_to_append;
+            size   -= bytes_to_append;
+            if (size == 0) return;
+            continue;
+        }
+        if (bytes_processed >= bytes_buffered){
+            // continue with input after frame
+            buffer += bytes_processed - bytes_buffered;
+            size   -= bytes_processed - bytes_buffered;
+            decoder_state->bytes_in_frame_buffer = 0;
+        } else {
+            // only skipped bytes in frame_buffer
+            memmove(decoder_state->frame_buffer, decoder_state->frame_buffer + bytes_processed, bytes_buffered - bytes_processed);
+            decoder_state->bytes_in_frame_buffer -= bytes_processed;
+        }
+    }
+
+    // decode complete frames in place
+    while (size > 0){
+        bytes_processed = btstack_sbc_decoder_decode_sbc_frame(state, buffer, size, &frame_incomplete);
+        buffer += bytes_processed;
+        size   -= bytes_processed;
+        if (frame_incomplete){
+            // store partial frame for next call
+            memcpy(decoder_state->frame_buffer, buffer, size);
+            decoder_state->bytes_in_frame_buffer = size;
+            return;
         }
-        memmove(decoder_state->frame_buffer, decoder_state->frame_buffer + bytes_processed, bytes_in_frame_buffer_before_decoding - bytes_processed);
-        decoder_state->bytes_in_frame_buffer -= bytes_processed;
     }
 }
 
+int btstack_sbc_decoder_process_ring_buffer(btstack_sbc_decoder_state_t * state, btstack_ring_buffer_t * ring_buffer, int max_frames){
+    bludroid_decoder_state_t * decoder_state = (bludroid_decoder_state_t*)state->decoder_state;
+    int good_frames_nr = state->good_frames_nr;
+
+    if (state->mode != SBC_MODE_STANDARD){
+        log_error("SBC decode: ring buffer input only supported for SBC");
+        return 0;
+    }
+
+    // partial frames are kept in the ring buffer
+    if (decoder_state->bytes_in_frame_buffer){
+        log_error("SBC decode: drop %u bytes from btstack_sbc_decoder_process_data", (unsigned int) decoder_state->bytes_in_frame_buffer);
+        decoder_state->bytes_in_frame_buffer = 0;
+    }
+
+    while ((max_frames == 0) || ((state->good_frames_nr - good_frames_nr) < max_frames)){
+        uint32_t bytes_available = btstack_ring_buffer_bytes_available(ring_buffer);
+        if (bytes_available == 0) break;
+
+        // decode in place from storage
+        uint32_t bytes_contiguous;
+        uint8_t * data = btstack_ring_buffer_peek_contiguous(ring_buffer, &bytes_contiguous);
+        int frame_incomplete;
+        uint32_t bytes_processed = btstack_sbc_decoder_decode_sbc_frame(state, data, bytes_contiguous, &frame_incomplete);
+        btstack_ring_buffer_skip(ring_buffer, bytes_processed);
+
+        if (frame_incomplete && (bytes_contiguous < bytes_available)){
+            // frame wraps around end of storage, copy it into frame_buffer
+            uint32_t size;
+            btstack_ring_buffer_peek(ring_buffer, decoder_state->frame_buffer, sizeof(decoder_state->frame_buffer), &size);
+            bytes_processed = btstack_sbc_decoder_decode_sbc_frame(state, decoder_state->frame_buffer, size, &frame_incomplete);
+            btstack_ring_buffer_skip(ring_buffer, bytes_processed);
+        }
+        if (frame_incomplete) break;
+    }
+    return state->good_frames_nr - good_frames_nr;
+}
 
 static void btstack_sbc_decoder_process_msbc_data(btstack_sbc_decoder_state_t * state, int packet_status_flag, uint8_t * buffer, int size){
     bludroid_decoder_state_t * decoder_state = (bludroid_decoder_state_t*)state->decoder_state;
@@ -328,34 +401,49 @@ static void btstack_sbc_decoder_process_msbc_data(btstack_sbc_decoder_state_t *
 
     while (input_bytes_to_process > 0){
 
-        // fill buffer with new data
-        int bytes_missing_for_complete_msbc_frame = msbc_frame_size - decoder_state->bytes_in_frame_buffer;
-        int bytes_to_append = btstack_min(input_bytes_to_process, bytes_missing_for_complete_msbc_frame);
-        if (bytes_to_append) {
-            append_received_sbc_data(decoder_state, buffer, bytes_to_append);
-            buffer += bytes_to_append;
-            input_bytes_to_process -= bytes_to_append;
-        }
+        const OI_BYTE *frame_data;
+        OI_UINT32 frame_bytes;
+        int decode_in_place = (decoder_state->bytes_in_frame_buffer == 0) && (input_bytes_to_process >= (int) msbc_frame_size);
 
-        if (decoder_state->bytes_in_frame_buffer < msbc_frame_size){
-            // printf("not enough data %d > %d\n", msbc_frame_size, decoder_state->bytes_in_frame_buffer);
-            if (input_bytes_to_process){
-                log_error("SHOULD NOT HAPPEN... not enough bytes, but bytes left to process");
+        if (decode_in_place){
+            // complete mSBC frame in input, decode without copy
+            frame_data  = buffer;
+            frame_bytes = msbc_frame_size;
+        } else {
+            // fill buffer with new data
+            int bytes_missing_for_complete_msbc_frame = msbc_frame_size - decoder_state->bytes_in_frame_buffer;
+            int bytes_to_append = btstack_min(input_bytes_to_process, bytes_missing_for_complete_msbc_frame);
+            if (bytes_to_append) {
+                append_received_sbc_data(decoder_state, buffer, bytes_to_append);
+                buffer += bytes_to_append;
+                input_bytes_to_process -= bytes_to_append;
             }
-            break;
+
+            if (decoder_state->bytes_in_frame_buffer < msbc_frame_size){
+                // printf("not enough data %d > %d\n", msbc_frame_size, decoder_state->bytes_in_frame_buffer);
+                if (input_bytes_to_process){
+                    log_error("SHOULD NOT HAPPEN... not enough bytes, but bytes left to process");
+                }
+                break;
+            }
+            frame_data  = decoder_state->frame_buffer;
+            frame_bytes = decoder_state->bytes_in_frame_buffer;
         }
-        
-        uint16_t bytes_in_frame_buffer_before_decoding = decoder_state->bytes_in_frame_buffer;
+
+        uint16_t bytes_in_frame_buffer_before_decoding = frame_bytes;
         uint16_t bytes_processed = 0;
-        const OI_BYTE *frame_data = decoder_state->frame_buffer;
 
-        static int frame_count = 0;
         if (corrupt_frame_period > 0){
-           frame_count++;
+            decoder_state->frame_count++;
 
-            if (frame_count % corrupt_frame_period == 0){
-                *(uint8_t*)&frame_data[5] = 0;
-                frame_count = 0;
+            if (decoder_state->frame_count % corrupt_frame_period == 0){
+                if (decode_in_place){
+                    // corrupt copy, input data is not modified
+                    memcpy(decoder_state->frame_buffer, frame_data, frame_bytes);
+                    frame_data = decoder_state->frame_buffer;
+                }
+                decoder_state->frame_buffer[5] = 0;
+                decoder_state->frame_count = 0;
             }
         }
 
@@ -364,16 +452,16 @@ static void btstack_sbc_decoder_process_msbc_data(btstack_sbc_decoder_state_t *
         int zero_seq_found = 0;
 
         if (decoder_state->first_good_frame_found){
-            zero_seq_found = find_sequence_of_zeros(frame_data, decoder_state->bytes_in_frame_buffer, 20);
+            zero_seq_found = find_sequence_of_zeros(frame_data, frame_bytes, 20);
             bad_frame = zero_seq_found || packet_status_flag;
         } 
 
         if (bad_frame){
             status = OI_CODEC_SBC_CHECKSUM_MISMATCH;
-            decoder_state->bytes_in_frame_buffer = 0;
+            frame_bytes = 0;
         } else {
             if (decoder_state->search_new_sync_word && !decoder_state->sync_word_found){
-                int h2_syncword = find_h2_syncword(frame_data, decoder_state->bytes_in_frame_buffer);
+                int h2_syncword = find_h2_syncword(frame_data, frame_bytes);
             
                 if (h2_syncword != -1){
                     decoder_state->sync_word_found = 1;
@@ -382,12 +470,12 @@ static void btstack_sbc_decoder_process_msbc_data(btstack_sbc_decoder_state_t *
             }
             status = OI_CODEC_SBC_DecodeFrame(&(decoder_state->decoder_context), 
                                                 &frame_data, 
-                                                &(decoder_state->bytes_in_frame_buffer), 
+                                                &frame_bytes, 
                                                 decoder_state->pcm_plc_data, 
                                                 &(decoder_state->pcm_bytes));
         }        
     
-        bytes_processed = bytes_in_frame_buffer_before_decoding - decoder_state->bytes_in_frame_buffer;
+        bytes_processed = bytes_in_frame_buffer_before_decoding - frame_bytes;
         OI_UINT32 bytes_in_frame_buffer = msbc_frame_size;
 
         switch(status){
@@ -402,7 +490,7 @@ static void btstack_sbc_decoder_process_msbc_data(btstack_sbc_decoder_state_t *
                                     btstack_sbc_decoder_num_channels(state), 
                                     btstack_sbc_decoder_sample_rate(state), state->context);
                 state->good_frames_nr++;
-                continue;
+                break;
             case OI_CODEC_SBC_NOT_ENOUGH_HEADER_DATA:
             case OI_CODEC_SBC_NOT_ENOUGH_BODY_DATA:
             case OI_CODEC_SBC_NOT_ENOUGH_AUDIO_DATA:
@@ -414,7 +502,7 @@ static void btstack_sbc_decoder_process_msbc_data(btstack_sbc_decoder_state_t *
             case OI_CODEC_SBC_NO_SYNCWORD:
             case OI_CODEC_SBC_CHECKSUM_MISMATCH:
                 // printf("NO_SYNCWORD or CHECKSUM_MISMATCH\n");
-                decoder_state->bytes_in_frame_buffer = 0;
+                frame_bytes = 0;
                 if (!decoder_state->first_good_frame_found) break;
 
                 if (!decoder_state->sync_word_found){
@@ -462,7 +550,7 @@ static void btstack_sbc_decoder_process_msbc_data(btstack_sbc_decoder_state_t *
                 // The codec apparently does not recover from this.
                 // Re-initialize the codec.
                 log_info("SBC decode: invalid parameters: resetting codec");
-                if (OI_CODEC_mSBC_DecoderReset(&(bd_decoder_state.decoder_context), bd_decoder_state.decoder_data, sizeof(bd_decoder_state.decoder_data)) != OI_STATUS_SUCCESS){
+                if (OI_CODEC_mSBC_DecoderReset(&(decoder_state->decoder_context), decoder_state->decoder_data, sizeof(decoder_state->decoder_data)) != OI_STATUS_SUCCESS){
                     log_info("SBC decode: resetting codec failed");
                     
                 }
@@ -472,7 +560,14 @@ static void btstack_sbc_decoder_process_msbc_data(btstack_sbc_decoder_state_t *
                 break;
         }
 
-        memmove(decoder_state->frame_buffer, decoder_state->frame_buffer + bytes_processed, decoder_state->bytes_in_frame_buffer);
+        if (decode_in_place){
+            // remaining bytes are still in input
+            buffer += msbc_frame_size - frame_bytes;
+            input_bytes_to_process -= msbc_frame_size - frame_bytes;
+        } else {
+            memmove(decoder_state->frame_buffer, decoder_state->frame_buffer + bytes_processed, frame_bytes);
+            decoder_state->bytes_in_frame_buffer = frame_bytes;
+        }
     }
 }
 
@@ -68,69 +68,70 @@ typedef struct {
     uint8_t sbc_packet[1000];
 } bludroid_encoder_state_t;
 
-static btstack_sbc_encoder_state_t * sbc_encoder_state_singleton = NULL;
-static bludroid_encoder_state_t bd_encoder_state;
+// fails to compile if encoder state does not fit into btstack_sbc_encoder_state_t
+typedef uint8_t bludroid_encoder_storage_check_t[(sizeof(bludroid_encoder_state_t) <= BTSTACK_SBC_ENCODER_STORAGE_SIZE) ? 1 : -1];
 
+static SBC_ENC_PARAMS * btstack_sbc_encoder_get_context(btstack_sbc_encoder_state_t * state){
+    return &((bludroid_encoder_state_t *) state->encoder_state)->context;
+}
 
 void btstack_sbc_encoder_init(btstack_sbc_encoder_state_t * state, btstack_sbc_mode_t mode, 
                         int blocks, int subbands, int allmethod, int sample_rate, int bitpool, int channel_mode){
 
-    if (sbc_encoder_state_singleton && sbc_encoder_state_singleton != state ){
-        log_error("SBC encoder: different sbc decoder state is allready registered");
-    } 
-    
-    sbc_encoder_state_singleton = state;
-
-    if (!sbc_encoder_state_singleton){
+    if (!state){
         log_error("SBC encoder init: sbc state is NULL");
+        return;
     }
 
-    sbc_encoder_state_singleton->mode = mode;
+    bludroid_encoder_state_t * bd_encoder_state = (bludroid_encoder_state_t *) &state->encoder_storage;
+    memset(bd_encoder_state, 0, sizeof(bludroid_encoder_state_t));
+
+    state->mode = mode;
 
-    switch (sbc_encoder_state_singleton->mode){
+    switch (state->mode){
         case SBC_MODE_STANDARD:
-            bd_encoder_state.context.s16NumOfBlocks = blocks;                          
-            bd_encoder_state.context.s16NumOfSubBands = subbands;                       
-            bd_encoder_state.context.s16AllocationMethod = allmethod;                     
-            bd_encoder_state.context.s16BitPool = bitpool;  
-            bd_encoder_state.context.mSBCEnabled = 0;
-            bd_encoder_state.context.s16ChannelMode = channel_mode;
-            bd_encoder_state.context.s16NumOfChannels = 2;
-            if (bd_encoder_state.context.s16ChannelMode == SBC_MONO){
-                bd_encoder_state.context.s16NumOfChannels = 1;
+            bd_encoder_state->context.s16NumOfBlocks = blocks;                          
+            bd_encoder_state->context.s16NumOfSubBands = subbands;                       
+            bd_encoder_state->context.s16AllocationMethod = allmethod;                     
+            bd_encoder_state->context.s16BitPool = bitpool;  
+            bd_encoder_state->context.mSBCEnabled = 0;
+            bd_encoder_state->context.s16ChannelMode = channel_mode;
+            bd_encoder_state->context.s16NumOfChannels = 2;
+            if (bd_encoder_state->context.s16ChannelMode == SBC_MONO){
+                bd_encoder_state->context.s16NumOfChannels = 1;
             }
             switch(sample_rate){
-                case 16000: bd_encoder_state.context.s16SamplingFreq = SBC_sf16000; break;
-                case 32000: bd_encoder_state.context.s16SamplingFreq = SBC_sf32000; break;
-                case 44100: bd_encoder_state.context.s16SamplingFreq = SBC_sf44100; break;
-                case 48000: bd_encoder_state.context.s16SamplingFreq = SBC_sf48000; break;
-                default: bd_encoder_state.context.s16SamplingFreq = 0; break;
+                case 16000: bd_encoder_state->context.s16SamplingFreq = SBC_sf16000; break;
+                case 32000: bd_encoder_state->context.s16SamplingFreq = SBC_sf32000; break;
+                case 44100: bd_encoder_state->context.s16SamplingFreq = SBC_sf44100; break;
+                case 48000: bd_encoder_state->context.s16SamplingFreq = SBC_sf48000; break;
+                default: bd_encoder_state->context.s16SamplingFreq = 0; break;
             }
             break;
         case SBC_MODE_mSBC:
-            bd_encoder_state.context.s16NumOfBlocks    = 15;
-            bd_encoder_state.context.s16NumOfSubBands  = 8;
-            bd_encoder_state.context.s16AllocationMethod = SBC_LOUDNESS;
-            bd_encoder_state.context.s16BitPool   = 26;
-            bd_encoder_state.context.s16ChannelMode = SBC_MONO;
-            bd_encoder_state.context.s16NumOfChannels = 1;
-            bd_encoder_state.context.mSBCEnabled = 1;
-            bd_encoder_state.context.s16SamplingFreq = SBC_sf16000;
+            bd_encoder_state->context.s16NumOfBlocks    = 15;
+            bd_encoder_state->context.s16NumOfSubBands  = 8;
+            bd_encoder_state->context.s16AllocationMethod = SBC_LOUDNESS;
+            bd_encoder_state->context.s16BitPool   = 26;
+            bd_encoder_state->context.s16ChannelMode = SBC_MONO;
+            bd_encoder_state->context.s16NumOfChannels = 1;
+            bd_encoder_state->context.mSBCEnabled = 1;
+            bd_encoder_state->context.s16SamplingFreq = SBC_sf16000;
             break;
     }
-    bd_encoder_state.context.pu8Packet = bd_encoder_state.sbc_packet;
+    bd_encoder_state->context.pu8Packet = bd_encoder_state->sbc_packet;
     
-    sbc_encoder_state_singleton->encoder_state = &bd_encoder_state;
-    SBC_ENC_PARAMS * context = &((bludroid_encoder_state_t *)sbc_encoder_state_singleton->encoder_state)->context;
-    SBC_Encoder_Init(context);
+    state->encoder_state = bd_encoder_state;
+    SBC_Encoder_Init(btstack_sbc_encoder_get_context(state));
 }
 
 
-void btstack_sbc_encoder_process_data(int16_t * input_buffer){
-    if (!sbc_encoder_state_singleton){
+void btstack_sbc_encoder_process_data(btstack_sbc_encoder_state_t * state, int16_t * input_buffer){
+    if (!state || !state->encoder_state){
         log_error("SBC encoder: sbc state is NULL, call btstack_sbc_encoder_init to initialize it");
+        return;
     }
-    SBC_ENC_PARAMS * context = &((bludroid_encoder_state_t *)sbc_encoder_state_singleton->encoder_state)->context;
+    SBC_ENC_PARAMS * context = btstack_sbc_encoder_get_context(state);
     context->ps16PcmBuffer = input_buffer;
     if (context->mSBCEnabled){
         context->pu8Packet[0] = 0xad;
@@ -138,17 +139,17 @@ void btstack_sbc_encoder_process_data(int16_t * input_buffer){
     SBC_Encoder(context);
 }
 
-int btstack_sbc_encoder_num_audio_frames(void){
-    SBC_ENC_PARAMS * context = &((bludroid_encoder_state_t *)sbc_encoder_state_singleton->encoder_state)->context;
+int btstack_sbc_encoder_num_audio_frames(btstack_sbc_encoder_state_t * state){
+    SBC_ENC_PARAMS * context = btstack_sbc_encoder_get_context(state);
     return context->s16NumOfSubBands * context->s16NumOfBlocks;
 }
 
-uint8_t * btstack_sbc_encoder_sbc_buffer(void){
-    SBC_ENC_PARAMS * context = &((bludroid_encoder_state_t *)sbc_encoder_state_singleton->encoder_state)->context;
+uint8_t * btstack_sbc_encoder_sbc_buffer(btstack_sbc_encoder_state_t * state){
+    SBC_ENC_PARAMS * context = btstack_sbc_encoder_get_context(state);
     return context->pu8Packet;
 }
 
-uint16_t  btstack_sbc_encoder_sbc_buffer_length(void){
-    SBC_ENC_PARAMS * context = &((bludroid_encoder_state_t *)sbc_encoder_state_singleton->encoder_state)->context;
+uint16_t  btstack_sbc_encoder_sbc_buffer_length(btstack_sbc_encoder_state_t * state){
+    SBC_ENC_PARAMS * context = btstack_sbc_encoder_get_context(state);
     return context->u16PacketLength;
 }
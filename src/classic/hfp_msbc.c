@@ -84,8 +84,8 @@ void hfp_msbc_encode_audio_frame(int16_t * pcm_samples){
     msbc_sequence_number = (msbc_sequence_number + 1) & 3;
 
     // SBC Frame
-    btstack_sbc_encoder_process_data(pcm_samples);
-    memcpy(msbc_buffer + msbc_buffer_offset, btstack_sbc_encoder_sbc_buffer(), MSBC_FRAME_SIZE);
+    btstack_sbc_encoder_process_data(&state, pcm_samples);
+    memcpy(msbc_buffer + msbc_buffer_offset, btstack_sbc_encoder_sbc_buffer(&state), MSBC_FRAME_SIZE);
     msbc_buffer_offset += MSBC_FRAME_SIZE;
 
     // Final padding to use 60 bytes for 120 audio samples
@@ -110,7 +110,7 @@ int hfp_msbc_num_bytes_in_stream(void){
 }
 
 int hfp_msbc_num_audio_samples_per_frame(void){
-    return btstack_sbc_encoder_num_audio_frames();
+    return btstack_sbc_encoder_num_audio_frames(&state);
 }
 
 
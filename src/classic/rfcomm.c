@@ -536,6 +536,33 @@ static int rfcomm_send_uih_prepared(rfcomm_multiplexer_t *multiplexer, uint8_t d
     return err;
 }
 
+// variant of rfcomm_send_uih_prepared with payload provided by application (UIH, 2 byte len, no credits)
+static int rfcomm_send_uih_iov(rfcomm_multiplexer_t *multiplexer, uint8_t dlci, const uint8_t * data, uint16_t len){
+
+    uint8_t address = (1 << 0) | (multiplexer->outgoing << 1) | (dlci << 2); 
+    uint8_t control = BT_RFCOMM_UIH;
+
+    uint8_t * rfcomm_out_buffer = l2cap_get_outgoing_buffer();
+    
+    // header and fcs are stored in outgoing buffer
+    rfcomm_out_buffer[0] = address;
+    rfcomm_out_buffer[1] = control;
+    rfcomm_out_buffer[2] = (len & 0x7f) << 1; // bits 0-6
+    rfcomm_out_buffer[3] = len >> 7;          // bits 7-14
+
+    // UIH frames only calc FCS over address + control (5.1.1)
+    rfcomm_out_buffer[4] =  btstack_crc8_calc(rfcomm_out_buffer, 2); // calc fcs
+
+    btstack_iovec_t iov[3];
+    iov[0].data = &rfcomm_out_buffer[0];
+    iov[0].len  = 4;
+    iov[1].data = data;
+    iov[1].len  = len;
+    iov[2].data = &rfcomm_out_buffer[4];
+    iov[2].len  = 1;
+    return l2cap_send_prepared_iov(multiplexer->l2cap_cid, iov, 3);
+}
+
 // C/R Flag in Address
 // - terms: initiator = station that creates multiplexer with SABM
 // - terms: responder = station that responds to multiplexer setup with UA
@@ -2180,6 +2207,38 @@ int rfcomm_send(uint16_t rfcomm_cid, uint8_t *data, uint16_t len){
     return err;
 }
 
+int rfcomm_send_zero_copy(uint16_t rfcomm_cid, const uint8_t *data, uint16_t len){
+    rfcomm_channel_t * channel = rfcomm_channel_for_rfcomm_cid(rfcomm_cid);
+    if (!channel){
+        log_error("cid 0x%02x doesn't exist!", rfcomm_cid);
+        return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    }
+
+    int err = rfcomm_assert_send_valid(channel, len);
+    if (err) return err;
+    if (!l2cap_can_send_packet_now(channel->multiplexer->l2cap_cid)){
+        log_error("rfcomm_send_zero_copy: l2cap cannot send now");
+        return BTSTACK_ACL_BUFFERS_FULL;
+    }
+
+    rfcomm_reserve_packet_buffer();
+
+    // send might cause l2cap to emit new credits, update counters first
+    if (len){
+        channel->credits_outgoing--;
+    }
+
+    err = rfcomm_send_uih_iov(channel->multiplexer, channel->dlci, data, len);
+    if (err){
+        if (len) {
+            channel->credits_outgoing++;
+        }
+        log_error("rfcomm_send_zero_copy: error %d", err);
+        rfcomm_release_packet_buffer();
+    }
+    return err;
+}
+
 // Sends Local Lnie Status, see LINE_STATUS_..
 int rfcomm_send_local_line_status(uint16_t rfcomm_cid, uint8_t line_status){
     rfcomm_channel_t * channel = rfcomm_channel_for_rfcomm_cid(rfcomm_cid);
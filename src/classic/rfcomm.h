@@ -343,6 +343,13 @@ void rfcomm_request_can_send_now_event(uint16_t rfcomm_cid);
  */
 int  rfcomm_send(uint16_t rfcomm_cid, uint8_t *data, uint16_t len);
 
+/** 
+ * @brief Sends RFCOMM data packet without copying data into the outgoing buffer
+ * @note If supported by the HCI Transport, data is sent from the provided buffer and has to stay valid
+ *       until the next can send now event. Otherwise, it's copied as in rfcomm_send.
+ */
+int  rfcomm_send_zero_copy(uint16_t rfcomm_cid, const uint8_t *data, uint16_t len);
+
 /** 
  * @brief Sends Local Line Status, see LINE_STATUS_..
  * @param rfcomm_cid
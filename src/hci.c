@@ -177,6 +177,208 @@ static const char * default_classic_name = "BTstack 00:00:00:00:00:00";
 static uint8_t disable_l2cap_timeouts = 0;
 #endif
 
+#ifdef ENABLE_HCI_CONNECTION_INDEX
+
+#define HCI_CONNECTION_INDEX_MASK (HCI_CONNECTION_INDEX_SIZE - 1)
+
+static uint16_t hci_connection_index_hash_handle(hci_con_handle_t con_handle){
+    return (con_handle ^ (con_handle >> 8)) & HCI_CONNECTION_INDEX_MASK;
+}
+
+static uint16_t hci_connection_index_hash_address(const uint8_t * addr, bd_addr_type_t addr_type){
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    int i;
+    for (i = 0; i < 6; i++){
+        hash = (hash ^ addr[i]) * 16777619u;
+    }
+    hash = (hash ^ (uint8_t) addr_type) * 16777619u;
+    return (hash ^ (hash >> 16)) & HCI_CONNECTION_INDEX_MASK;
+}
+
+static uint16_t hci_connection_index_home(const hci_connection_t * conn, int by_address){
+    if (by_address){
+        return hci_connection_index_hash_address(conn->address, conn->address_type);
+    }
+    return hci_connection_index_hash_handle(conn->con_handle);
+}
+
+static int hci_connection_index_same_key(const hci_connection_t * a, const hci_connection_t * b, int by_address){
+    if (by_address){
+        return a->address_type == b->address_type && memcmp(a->address, b->address, 6) == 0;
+    }
+    return a->con_handle == b->con_handle;
+}
+
+// connections without valid con handle are not indexed by handle
+static int hci_connection_index_has_key(const hci_connection_t * conn, int by_address){
+    return by_address || conn->con_handle != HCI_CON_HANDLE_INVALID;
+}
+
+// @returns 1 if stored, 0 if key already present or table full
+static int hci_connection_index_insert(hci_connection_index_t * index, hci_connection_t * conn, int by_address){
+    uint16_t pos = hci_connection_index_home(conn, by_address);
+    while (index->slots[pos]){
+        if (hci_connection_index_same_key(index->slots[pos], conn, by_address)){
+            index->unindexed++;
+            return 0;
+        }
+        pos = (pos + 1) & HCI_CONNECTION_INDEX_MASK;
+    }
+    // keep one slot free to terminate probing
+    if (index->used >= HCI_CONNECTION_INDEX_SIZE - 1){
+        index->unindexed++;
+        return 0;
+    }
+    index->slots[pos] = conn;
+    index->used++;
+    return 1;
+}
+
+// re-create index from connections list, on duplicate keys the first connection in the list wins - as with list scan
+static void hci_connection_index_rebuild(hci_connection_index_t * index, int by_address){
+    memset(index, 0, sizeof(hci_connection_index_t));
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->connections);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * conn = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        if (!hci_connection_index_has_key(conn, by_address)) continue;
+        hci_connection_index_insert(index, conn, by_address);
+    }
+}
+
+// remove slot with backward shift deletion, key of conn must not have changed since insert
+static void hci_connection_index_remove_slot(hci_connection_index_t * index, hci_connection_t * conn, int by_address){
+    uint16_t pos = hci_connection_index_home(conn, by_address);
+    while (index->slots[pos] != conn){
+        if (index->slots[pos] == NULL) return;
+        pos = (pos + 1) & HCI_CONNECTION_INDEX_MASK;
+    }
+    uint16_t hole = pos;
+    while (1){
+        pos = (pos + 1) & HCI_CONNECTION_INDEX_MASK;
+        hci_connection_t * item = index->slots[pos];
+        if (item == NULL) break;
+        // move item into hole unless its home lies cyclically in (hole, pos]
+        uint16_t home = hci_connection_index_home(item, by_address);
+        if (((pos - home) & HCI_CONNECTION_INDEX_MASK) >= ((pos - hole) & HCI_CONNECTION_INDEX_MASK)){
+            index->slots[hole] = item;
+            hole = pos;
+        }
+    }
+    index->slots[hole] = NULL;
+    index->used--;
+}
+
+// call after adding conn to connections list
+static void hci_connection_index_add(hci_connection_index_t * index, hci_connection_t * conn, int by_address){
+    if (!hci_connection_index_has_key(conn, by_address)) return;
+    if (hci_connection_index_insert(index, conn, by_address)) return;
+    // duplicate key or full: let list order decide
+    hci_connection_index_rebuild(index, by_address);
+}
+
+// call after removing conn from connections list
+static void hci_connection_index_remove(hci_connection_index_t * index, hci_connection_t * conn, int by_address){
+    if (!hci_connection_index_has_key(conn, by_address)) return;
+    hci_connection_index_remove_slot(index, conn, by_address);
+    // a previously unindexed connection might fit now
+    if (index->unindexed){
+        hci_connection_index_rebuild(index, by_address);
+    }
+}
+
+static hci_connection_t * hci_connection_index_lookup_handle(hci_con_handle_t con_handle){
+    hci_connection_index_t * index = &hci_stack->connection_index_by_handle;
+    uint16_t pos = hci_connection_index_hash_handle(con_handle);
+    while (index->slots[pos]){
+        if (index->slots[pos]->con_handle == con_handle) return index->slots[pos];
+        pos = (pos + 1) & HCI_CONNECTION_INDEX_MASK;
+    }
+    return NULL;
+}
+
+static hci_connection_t * hci_connection_index_lookup_address(const uint8_t * addr, bd_addr_type_t addr_type){
+    hci_connection_index_t * index = &hci_stack->connection_index_by_address;
+    uint16_t pos = hci_connection_index_hash_address(addr, addr_type);
+    while (index->slots[pos]){
+        hci_connection_t * conn = index->slots[pos];
+        if (conn->address_type == addr_type && memcmp(addr, conn->address, 6) == 0) return conn;
+        pos = (pos + 1) & HCI_CONNECTION_INDEX_MASK;
+    }
+    return NULL;
+}
+#endif
+
+/**
+ * set con handle for connection and update index
+ */
+static void hci_connection_set_handle(hci_connection_t * conn, hci_con_handle_t con_handle){
+#ifdef ENABLE_HCI_CONNECTION_INDEX
+    hci_connection_index_t * index = &hci_stack->connection_index_by_handle;
+    if (hci_connection_index_has_key(conn, 0)){
+        hci_connection_index_remove_slot(index, conn, 0);
+    }
+    conn->con_handle = con_handle;
+    if (index->unindexed){
+        hci_connection_index_rebuild(index, 0);
+    } else {
+        hci_connection_index_add(index, conn, 0);
+    }
+#else
+    conn->con_handle = con_handle;
+#endif
+}
+
+#ifdef HCI_ACL_RECOMBINATION_BUFFERS
+static uint8_t * hci_acl_recombination_buffer_get(void){
+    uint8_t * buffer = (uint8_t *) btstack_memory_pool_get(&hci_stack->acl_recombination_buffers_pool);
+    if (!buffer) return NULL;
+    hci_acl_recombination_stats_t * stats = &hci_stack->acl_recombination_stats;
+    stats->buffers_used++;
+    if (stats->buffers_used > stats->buffers_high_water_mark){
+        stats->buffers_high_water_mark = stats->buffers_used;
+    }
+    return buffer;
+}
+
+static void hci_acl_recombination_buffer_free(uint8_t * buffer){
+    btstack_memory_pool_free(&hci_stack->acl_recombination_buffers_pool, buffer);
+    hci_stack->acl_recombination_stats.buffers_used--;
+}
+
+void hci_get_acl_recombination_stats(hci_acl_recombination_stats_t * stats){
+    *stats = hci_stack->acl_recombination_stats;
+}
+#endif
+
+// drop partial L2CAP packet, if any
+static void hci_acl_recombination_reset(hci_connection_t * conn){
+    conn->acl_recombination_length = 0;
+    conn->acl_recombination_pos = 0;
+#ifdef HCI_ACL_RECOMBINATION_BUFFERS
+    if (conn->acl_recombination_buffer){
+        hci_acl_recombination_buffer_free(conn->acl_recombination_buffer);
+        conn->acl_recombination_buffer = NULL;
+    }
+#endif
+}
+
+/**
+ * remove connection from list and index, then free it
+ */
+static void hci_connection_free(hci_connection_t * conn){
+    btstack_linked_list_remove(&hci_stack->connections, (btstack_linked_item_t *) conn);
+#ifdef ENABLE_HCI_CONNECTION_INDEX
+    hci_connection_index_remove(&hci_stack->connection_index_by_handle,  conn, 0);
+    hci_connection_index_remove(&hci_stack->connection_index_by_address, conn, 1);
+#endif
+#ifdef HCI_ACL_RECOMBINATION_BUFFERS
+    hci_acl_recombination_reset(conn);
+#endif
+    btstack_memory_hci_connection_free( conn );
+}
+
 /**
  * create connection for given address
  *
@@ -199,10 +401,16 @@ static hci_connection_t * create_connection_for_bd_addr_and_type(bd_addr_t addr,
 #endif
     conn->acl_recombination_length = 0;
     conn->acl_recombination_pos = 0;
+#ifdef HCI_ACL_RECOMBINATION_BUFFERS
+    conn->acl_recombination_buffer = NULL;
+#endif
     conn->num_acl_packets_sent = 0;
     conn->num_sco_packets_sent = 0;
     conn->le_con_parameter_update_state = CON_PARAMETER_UPDATE_NONE;
     btstack_linked_list_add(&hci_stack->connections, (btstack_linked_item_t *) conn);
+#ifdef ENABLE_HCI_CONNECTION_INDEX
+    hci_connection_index_add(&hci_stack->connection_index_by_address, conn, 1);
+#endif
     return conn;
 }
 
@@ -273,6 +481,12 @@ void hci_connections_get_iterator(btstack_linked_list_iterator_t *it){
  * @return connection OR NULL, if not found
  */
 hci_connection_t * hci_connection_for_handle(hci_con_handle_t con_handle){
+#ifdef ENABLE_HCI_CONNECTION_INDEX
+    if (con_handle != HCI_CON_HANDLE_INVALID){
+        hci_connection_t * conn = hci_connection_index_lookup_handle(con_handle);
+        if (conn || hci_stack->connection_index_by_handle.unindexed == 0) return conn;
+    }
+#endif
     btstack_linked_list_iterator_t it;
     btstack_linked_list_iterator_init(&it, &hci_stack->connections);
     while (btstack_linked_list_iterator_has_next(&it)){
@@ -290,6 +504,10 @@ hci_connection_t * hci_connection_for_handle(hci_con_handle_t con_handle){
  * @return connection OR NULL, if not found
  */
 hci_connection_t * hci_connection_for_bd_addr_and_type(bd_addr_t  addr, bd_addr_type_t addr_type){
+#ifdef ENABLE_HCI_CONNECTION_INDEX
+    hci_connection_t * conn = hci_connection_index_lookup_address(addr, addr_type);
+    if (conn || hci_stack->connection_index_by_address.unindexed == 0) return conn;
+#endif
     btstack_linked_list_iterator_t it;
     btstack_linked_list_iterator_init(&it, &hci_stack->connections);
     while (btstack_linked_list_iterator_has_next(&it)){
@@ -538,8 +756,17 @@ static int hci_transport_can_send_prepared_packet_now(uint8_t packet_type){
     return hci_stack->hci_transport->can_send_packet_now(packet_type);
 }
 
+// transport can send ACL packet now, or ACL packet can be queued while transport sends queued packets
+static int hci_transport_can_accept_acl_packet(void){
+    if (hci_transport_can_send_prepared_packet_now(HCI_ACL_DATA_PACKET)) return 1;
+#if HCI_OUTGOING_BUFFERS > 1
+    if (hci_stack->outgoing_buffer_in_flight && hci_stack->outgoing_buffers_free > 0) return 1;
+#endif
+    return 0;
+}
+
 static int hci_can_send_prepared_acl_packet_for_address_type(bd_addr_type_t address_type){
-    if (!hci_transport_can_send_prepared_packet_now(HCI_ACL_DATA_PACKET)) return 0;
+    if (!hci_transport_can_accept_acl_packet()) return 0;
     return hci_number_free_acl_slots_for_connection_type(address_type) > 0;
 }
 
@@ -549,6 +776,12 @@ int hci_can_send_acl_le_packet_now(void){
 }
 
 int hci_can_send_prepared_acl_packet_now(hci_con_handle_t con_handle) {
+    if (!hci_transport_can_accept_acl_packet()) return 0;
+    return hci_number_free_acl_slots_for_handle(con_handle) > 0;
+}
+
+// used for fragments and packets that cannot be queued
+static int hci_can_send_acl_fragment_now(hci_con_handle_t con_handle) {
     if (!hci_transport_can_send_prepared_packet_now(HCI_ACL_DATA_PACKET)) return 0;
     return hci_number_free_acl_slots_for_handle(con_handle) > 0;
 }
@@ -605,15 +838,105 @@ static int hci_transport_synchronous(void){
     return hci_stack->hci_transport->can_send_packet_now == NULL;
 }
 
+// max ACL data packet length depends on connection type (LE vs. Classic) and available buffers
+static uint16_t hci_max_acl_data_packet_length_for_connection(hci_connection_t * connection){
+    if (hci_is_le_connection(connection) && hci_stack->le_data_packets_length > 0){
+        return hci_stack->le_data_packets_length;
+    }
+    return hci_stack->acl_data_packet_length;
+}
+
+#if HCI_OUTGOING_BUFFERS > 1
+static void hci_outgoing_buffers_reset(void){
+    btstack_memory_pool_create(&hci_stack->outgoing_buffers_pool, hci_stack->outgoing_buffers_storage, HCI_OUTGOING_BUFFERS, sizeof(hci_outgoing_buffer_t));
+    hci_stack->outgoing_buffer_current = (hci_outgoing_buffer_t *) btstack_memory_pool_get(&hci_stack->outgoing_buffers_pool);
+    hci_stack->outgoing_buffers_free = HCI_OUTGOING_BUFFERS - 1;
+    hci_stack->outgoing_buffer_in_flight = NULL;
+    hci_stack->outgoing_acl_queue = NULL;
+    hci_stack->hci_packet_buffer = &hci_stack->outgoing_buffer_current->data[HCI_OUTGOING_PRE_BUFFER_SIZE];
+}
+
+static void hci_outgoing_buffer_send(hci_outgoing_buffer_t * buffer){
+    // transport might report packet sent during send_packet already
+    hci_stack->outgoing_buffer_in_flight = buffer;
+    uint8_t * packet = &buffer->data[HCI_OUTGOING_PRE_BUFFER_SIZE];
+    hci_dump_packet(HCI_ACL_DATA_PACKET, 0, packet, buffer->size);
+    hci_stack->hci_transport->send_packet(HCI_ACL_DATA_PACKET, packet, buffer->size);
+}
+
+// pre: packet fits into single ACL fragment and a free buffer is available
+static int hci_outgoing_buffer_send_acl_packet(hci_connection_t * connection, uint16_t size){
+
+    connection->num_acl_packets_sent++;
+
+    // hand over current buffer with prepared packet and provide next one for upper layers
+    hci_outgoing_buffer_t * buffer = hci_stack->outgoing_buffer_current;
+    buffer->size = size;
+    hci_stack->outgoing_buffer_current = (hci_outgoing_buffer_t *) btstack_memory_pool_get(&hci_stack->outgoing_buffers_pool);
+    hci_stack->outgoing_buffers_free--;
+    hci_stack->hci_packet_buffer = &hci_stack->outgoing_buffer_current->data[HCI_OUTGOING_PRE_BUFFER_SIZE];
+    hci_release_packet_buffer();
+
+    if (hci_stack->outgoing_buffer_in_flight){
+        btstack_linked_list_add_tail(&hci_stack->outgoing_acl_queue, (btstack_linked_item_t *) buffer);
+    } else {
+        hci_outgoing_buffer_send(buffer);
+    }
+    return 0;
+}
+
+// return buffer of sent packet to pool and send next queued packet
+static void hci_outgoing_buffer_packet_sent(void){
+    btstack_memory_pool_free(&hci_stack->outgoing_buffers_pool, hci_stack->outgoing_buffer_in_flight);
+    hci_stack->outgoing_buffers_free++;
+    hci_stack->outgoing_buffer_in_flight = NULL;
+    hci_outgoing_buffer_t * buffer = (hci_outgoing_buffer_t *) btstack_linked_list_pop(&hci_stack->outgoing_acl_queue);
+    if (buffer){
+        hci_outgoing_buffer_send(buffer);
+    }
+}
+
+// drop queued packets for closed connection
+static void hci_outgoing_buffer_drop_packets_for_handle(hci_con_handle_t con_handle){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->outgoing_acl_queue);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_outgoing_buffer_t * buffer = (hci_outgoing_buffer_t *) btstack_linked_list_iterator_next(&it);
+        if (READ_ACL_CONNECTION_HANDLE(&buffer->data[HCI_OUTGOING_PRE_BUFFER_SIZE]) != con_handle) continue;
+        btstack_linked_list_iterator_remove(&it);
+        btstack_memory_pool_free(&hci_stack->outgoing_buffers_pool, buffer);
+        hci_stack->outgoing_buffers_free++;
+    }
+}
+#endif
+
+// collect ACL header and the parts of the gathered ACL payload that form the fragment at payload_pos
+static int hci_acl_fragment_iov(btstack_iovec_t * fragment_iov, const uint8_t * acl_header, uint16_t payload_pos, uint16_t payload_len){
+    fragment_iov[0].data = acl_header;
+    fragment_iov[0].len  = 4;
+    int fragment_iovcnt = 1;
+    int i;
+    for (i = 0; i < hci_stack->acl_fragmentation_iov_count && payload_len > 0; i++){
+        const btstack_iovec_t * iov = &hci_stack->acl_fragmentation_iov[i];
+        if (payload_pos >= iov->len){
+            payload_pos -= iov->len;
+            continue;
+        }
+        uint16_t len = btstack_min(iov->len - payload_pos, payload_len);
+        fragment_iov[fragment_iovcnt].data = &iov->data[payload_pos];
+        fragment_iov[fragment_iovcnt].len  = len;
+        fragment_iovcnt++;
+        payload_pos  = 0;
+        payload_len -= len;
+    }
+    return fragment_iovcnt;
+}
+
 static int hci_send_acl_packet_fragments(hci_connection_t *connection){
 
     // log_info("hci_send_acl_packet_fragments  %u/%u (con 0x%04x)", hci_stack->acl_fragmentation_pos, hci_stack->acl_fragmentation_total_size, connection->con_handle);
 
-    // max ACL data packet length depends on connection type (LE vs. Classic) and available buffers
-    uint16_t max_acl_data_packet_length = hci_stack->acl_data_packet_length;
-    if (hci_is_le_connection(connection) && hci_stack->le_data_packets_length > 0){
-        max_acl_data_packet_length = hci_stack->le_data_packets_length;
-    }
+    uint16_t max_acl_data_packet_length = hci_max_acl_data_packet_length_for_connection(connection);
 
     // testing: reduce buffer to minimum
     // max_acl_data_packet_length = 52;
@@ -637,20 +960,36 @@ static int hci_send_acl_packet_fragments(hci_connection_t *connection){
             current_acl_data_packet_length = max_acl_data_packet_length;
         }
 
+        // gathered payload: ACL header for each fragment is built separately
+        uint8_t * acl_header;
+        if (hci_stack->acl_fragmentation_iov_count){
+            acl_header = hci_stack->acl_fragmentation_header;
+            memcpy(acl_header, hci_stack->hci_packet_buffer, 2);
+        } else {
+            acl_header = &hci_stack->hci_packet_buffer[acl_header_pos];
+        }
+
         // copy handle_and_flags if not first fragment and update packet boundary flags to be 01 (continuing fragmnent)
         if (acl_header_pos > 0){
             uint16_t handle_and_flags = little_endian_read_16(hci_stack->hci_packet_buffer, 0);
             handle_and_flags = (handle_and_flags & 0xcfff) | (1 << 12);
-            little_endian_store_16(hci_stack->hci_packet_buffer, acl_header_pos, handle_and_flags);
+            little_endian_store_16(acl_header, 0, handle_and_flags);
         }
 
         // update header len
-        little_endian_store_16(hci_stack->hci_packet_buffer, acl_header_pos + 2, current_acl_data_packet_length);
+        little_endian_store_16(acl_header, 2, current_acl_data_packet_length);
 
         // count packet
         connection->num_acl_packets_sent++;
         log_debug("hci_send_acl_packet_fragments loop before send (more fragments %d)", more_fragments);
 
+        // collect segments for fragment before state gets updated
+        btstack_iovec_t fragment_iov[1 + HCI_ACL_IOV_MAX];
+        int fragment_iovcnt = 0;
+        if (hci_stack->acl_fragmentation_iov_count){
+            fragment_iovcnt = hci_acl_fragment_iov(fragment_iov, acl_header, acl_header_pos, current_acl_data_packet_length);
+        }
+
         // update state for next fragment (if any) as "transport done" might be sent during send_packet already
         if (more_fragments){
             // update start of next fragment to send
@@ -659,13 +998,19 @@ static int hci_send_acl_packet_fragments(hci_connection_t *connection){
             // done
             hci_stack->acl_fragmentation_pos = 0;
             hci_stack->acl_fragmentation_total_size = 0;
+            hci_stack->acl_fragmentation_iov_count = 0;
         }
 
         // send packet
-        uint8_t * packet = &hci_stack->hci_packet_buffer[acl_header_pos];
-        const int size = current_acl_data_packet_length + 4;
-        hci_dump_packet(HCI_ACL_DATA_PACKET, 0, packet, size);
-        err = hci_stack->hci_transport->send_packet(HCI_ACL_DATA_PACKET, packet, size);
+        if (fragment_iovcnt){
+            hci_dump_packet_iov(HCI_ACL_DATA_PACKET, 0, fragment_iov, fragment_iovcnt);
+            err = hci_stack->hci_transport->send_packet_iov(HCI_ACL_DATA_PACKET, fragment_iov, fragment_iovcnt);
+        } else {
+            uint8_t * packet = &hci_stack->hci_packet_buffer[acl_header_pos];
+            const int size = current_acl_data_packet_length + 4;
+            hci_dump_packet(HCI_ACL_DATA_PACKET, 0, packet, size);
+            err = hci_stack->hci_transport->send_packet(HCI_ACL_DATA_PACKET, packet, size);
+        }
 
         log_debug("hci_send_acl_packet_fragments loop after send (more fragments %d)", more_fragments);
 
@@ -673,7 +1018,7 @@ static int hci_send_acl_packet_fragments(hci_connection_t *connection){
         if (!more_fragments) break;
 
         // can send more?
-        if (!hci_can_send_prepared_acl_packet_now(connection->con_handle)) return err;
+        if (!hci_can_send_acl_fragment_now(connection->con_handle)) return err;
     }
 
     log_debug("hci_send_acl_packet_fragments loop over");
@@ -722,13 +1067,68 @@ int hci_send_acl_packet_buffer(int size){
 
     // hci_dump_packet( HCI_ACL_DATA_PACKET, 0, packet, size);
 
+#if HCI_OUTGOING_BUFFERS > 1
+    // queue packet if it fits into single ACL fragment and isn't gathered from segments
+    if (!hci_transport_synchronous() && hci_stack->acl_fragmentation_iov_count == 0 && (size - 4) <= hci_max_acl_data_packet_length_for_connection(connection)){
+        return hci_outgoing_buffer_send_acl_packet(connection, size);
+    }
+#endif
+
     // setup data
     hci_stack->acl_fragmentation_total_size = size;
     hci_stack->acl_fragmentation_pos = 4;   // start of L2CAP packet
 
+#if HCI_OUTGOING_BUFFERS > 1
+    // transport busy with queued packets, first fragment gets sent by hci_run
+    if (!hci_can_send_acl_fragment_now(con_handle)) return 0;
+#endif
+
     return hci_send_acl_packet_fragments(connection);
 }
 
+// pre: caller has reserved the packet buffer and stored ACL header in it
+int hci_send_acl_packet_buffer_iov(const btstack_iovec_t * iov, int iovcnt){
+
+    if (iovcnt > HCI_ACL_IOV_MAX){
+        log_error("hci_send_acl_packet_buffer_iov: %u segments > HCI_ACL_IOV_MAX", iovcnt);
+        hci_release_packet_buffer();
+        hci_emit_transport_packet_sent();
+        return 0;
+    }
+
+    uint16_t size = 4;
+    int i;
+    for (i = 0; i < iovcnt; i++){
+        size += iov[i].len;
+    }
+
+    // transport cannot gather: copy segments into packet buffer
+    if (hci_stack->hci_transport->send_packet_iov == NULL){
+        if (size > HCI_ACL_BUFFER_SIZE){
+            log_error("hci_send_acl_packet_buffer_iov: size %u > HCI_ACL_BUFFER_SIZE", size);
+            hci_release_packet_buffer();
+            hci_emit_transport_packet_sent();
+            return 0;
+        }
+        // copy last segment first, as segments in packet buffer, e.g. a trailer, are stored before their final position
+        uint16_t pos = size;
+        for (i = iovcnt - 1; i >= 0; i--){
+            pos -= iov[i].len;
+            memmove(&hci_stack->hci_packet_buffer[pos], iov[i].data, iov[i].len);
+        }
+        return hci_send_acl_packet_buffer(size);
+    }
+
+    memcpy(hci_stack->acl_fragmentation_iov, iov, iovcnt * sizeof(btstack_iovec_t));
+    hci_stack->acl_fragmentation_iov_count = iovcnt;
+    int err = hci_send_acl_packet_buffer(size);
+    // no fragment sent
+    if (hci_stack->acl_fragmentation_total_size == 0){
+        hci_stack->acl_fragmentation_iov_count = 0;
+    }
+    return err;
+}
+
 #ifdef ENABLE_CLASSIC
 // pre: caller has reserved the packet buffer
 int hci_send_sco_packet_buffer(int size){
@@ -822,7 +1222,7 @@ static void acl_handler(uint8_t *packet, int size){
             if (conn->acl_recombination_pos + acl_length > 4 + HCI_ACL_BUFFER_SIZE){
                 log_error( "ACL Cont Fragment to large: combined packet %u > buffer size %u for handle 0x%02x",
                     conn->acl_recombination_pos + acl_length, 4 + HCI_ACL_BUFFER_SIZE, con_handle);
-                conn->acl_recombination_pos = 0;
+                hci_acl_recombination_reset(conn);
                 return;
             }
 
@@ -835,10 +1235,20 @@ static void acl_handler(uint8_t *packet, int size){
             
             // forward complete L2CAP packet if complete. 
             if (conn->acl_recombination_pos >= conn->acl_recombination_length + 4 + 4){ // pos already incl. ACL header
+#ifdef HCI_ACL_RECOMBINATION_BUFFERS
+                // detach buffer from connection first, as connection might get freed by packet handler
+                uint8_t * buffer = conn->acl_recombination_buffer;
+                uint16_t  size   = conn->acl_recombination_pos;
+                conn->acl_recombination_buffer = NULL;
+                hci_acl_recombination_reset(conn);
+                hci_emit_acl_packet(&buffer[HCI_INCOMING_PRE_BUFFER_SIZE], size);
+                hci_acl_recombination_buffer_free(buffer);
+#else
                 hci_emit_acl_packet(&conn->acl_recombination_buffer[HCI_INCOMING_PRE_BUFFER_SIZE], conn->acl_recombination_pos);
                 // reset recombination buffer
                 conn->acl_recombination_length = 0;
                 conn->acl_recombination_pos = 0;
+#endif
             }
             break;
             
@@ -847,7 +1257,7 @@ static void acl_handler(uint8_t *packet, int size){
             // sanity check
             if (conn->acl_recombination_pos) {
                 log_error( "ACL First Fragment but data in buffer for handle 0x%02x, dropping stale fragments", con_handle);
-                conn->acl_recombination_pos = 0;
+                hci_acl_recombination_reset(conn);
             }
 
             // peek into L2CAP packet!
@@ -867,6 +1277,15 @@ static void acl_handler(uint8_t *packet, int size){
                     return;
                 }
 
+#ifdef HCI_ACL_RECOMBINATION_BUFFERS
+                conn->acl_recombination_buffer = hci_acl_recombination_buffer_get();
+                if (!conn->acl_recombination_buffer){
+                    log_error( "ACL First Fragment but no free recombination buffer for handle 0x%02x, dropping packet", con_handle);
+                    hci_stack->acl_recombination_stats.packets_dropped++;
+                    return;
+                }
+#endif
+
                 // store first fragment and tweak acl length for complete package
                 memcpy(&conn->acl_recombination_buffer[HCI_INCOMING_PRE_BUFFER_SIZE], packet, acl_length + 4);
                 conn->acl_recombination_pos    = acl_length + 4;
@@ -896,8 +1315,7 @@ static void hci_shutdown_connection(hci_connection_t *conn){
 
     btstack_run_loop_remove_timer(&conn->timeout);
     
-    btstack_linked_list_remove(&hci_stack->connections, (btstack_linked_item_t *) conn);
-    btstack_memory_hci_connection_free( conn );
+    hci_connection_free( conn );
     
     // now it's gone
     hci_emit_nr_connections_changed();
@@ -1797,8 +2215,7 @@ static void hci_handle_connection_failed(hci_connection_t * conn, uint8_t status
 #endif
     
     // connection failed, remove entry
-    btstack_linked_list_remove(&hci_stack->connections, (btstack_linked_item_t *) conn);
-    btstack_memory_hci_connection_free( conn );
+    hci_connection_free( conn );
 
 #ifdef ENABLE_CLASSIC
     // notify client if dedicated bonding
@@ -2070,7 +2487,7 @@ static void event_handler(uint8_t *packet, int size){
             if (conn) {
                 if (!packet[2]){
                     conn->state = OPEN;
-                    conn->con_handle = little_endian_read_16(packet, 3);
+                    hci_connection_set_handle(conn, little_endian_read_16(packet, 3));
                     conn->bonding_flags |= BONDING_REQUEST_REMOTE_FEATURES;
 
                     // restart timer
@@ -2102,7 +2519,7 @@ static void event_handler(uint8_t *packet, int size){
                 break;
             }
             conn->state = OPEN;
-            conn->con_handle = little_endian_read_16(packet, 3);            
+            hci_connection_set_handle(conn, little_endian_read_16(packet, 3));
 
 #ifdef ENABLE_SCO_OVER_HCI
             // update SCO
@@ -2248,8 +2665,12 @@ static void event_handler(uint8_t *packet, int size){
                     log_info("hci: drop fragmented ACL data for closed connection");
                      hci_stack->acl_fragmentation_total_size = 0;
                      hci_stack->acl_fragmentation_pos = 0;
+                     hci_stack->acl_fragmentation_iov_count = 0;
                 }
             }
+#if HCI_OUTGOING_BUFFERS > 1
+            hci_outgoing_buffer_drop_packets_for_handle(handle);
+#endif
 
             // re-enable advertisements for le connections if active
             conn = hci_connection_for_handle(handle);
@@ -2292,8 +2713,16 @@ static void event_handler(uint8_t *packet, int size){
                 log_error("Synchronous HCI Transport shouldn't send HCI_EVENT_TRANSPORT_PACKET_SENT");
                 return; // instead of break: to avoid re-entering hci_run()
             }
-            if (hci_stack->acl_fragmentation_total_size) break;
-            hci_release_packet_buffer();
+#if HCI_OUTGOING_BUFFERS > 1
+            // packet from outgoing buffer sent, packet buffer wasn't reserved for it
+            if (hci_stack->outgoing_buffer_in_flight){
+                hci_outgoing_buffer_packet_sent();
+            } else
+#endif
+            {
+                if (hci_stack->acl_fragmentation_total_size) break;
+                hci_release_packet_buffer();
+            }
             
             // L2CAP receives this event via the hci_emit_event below
 
@@ -2354,8 +2783,7 @@ static void event_handler(uint8_t *packet, int size){
                         hci_stack->le_connecting_state = LE_CONNECTING_IDLE;
                         // remove entry
                         if (conn){
-                            btstack_linked_list_remove(&hci_stack->connections, (btstack_linked_item_t *) conn);
-                            btstack_memory_hci_connection_free( conn );
+                            hci_connection_free( conn );
                         }
                         break;
                     }
@@ -2383,7 +2811,7 @@ static void event_handler(uint8_t *packet, int size){
                     
                     conn->state = OPEN;
                     conn->role  = packet[6];
-                    conn->con_handle             = hci_subevent_le_connection_complete_get_connection_handle(packet);
+                    hci_connection_set_handle(conn, hci_subevent_le_connection_complete_get_connection_handle(packet));
                     conn->le_connection_interval = hci_subevent_le_connection_complete_get_conn_interval(packet);
 
 #ifdef ENABLE_LE_PERIPHERAL
@@ -2555,6 +2983,10 @@ void hci_register_sco_packet_handler(btstack_packet_handler_t handler){
 static void hci_state_reset(void){
     // no connections yet
     hci_stack->connections = NULL;
+#ifdef ENABLE_HCI_CONNECTION_INDEX
+    memset(&hci_stack->connection_index_by_handle,  0, sizeof(hci_connection_index_t));
+    memset(&hci_stack->connection_index_by_address, 0, sizeof(hci_connection_index_t));
+#endif
 
     // keep discoverable/connectable as this has been requested by the client(s)
     // hci_stack->discoverable = 0;
@@ -2564,6 +2996,9 @@ static void hci_state_reset(void){
 
     // buffer is free
     hci_stack->hci_packet_buffer_reserved = 0;
+#if HCI_OUTGOING_BUFFERS > 1
+    hci_outgoing_buffers_reset();
+#endif
 
     // no pending cmds
     hci_stack->decline_reason = 0;
@@ -2613,8 +3048,16 @@ void hci_init(const hci_transport_t *transport, const void *config){
     // reference to used config
     hci_stack->config = config;
     
-    // setup pointer for outgoing packet buffer
+#ifdef HCI_ACL_RECOMBINATION_BUFFERS
+    btstack_memory_pool_create(&hci_stack->acl_recombination_buffers_pool, hci_stack->acl_recombination_buffers_storage,
+        HCI_ACL_RECOMBINATION_BUFFERS, sizeof(hci_acl_recombination_buffer_t));
+    hci_stack->acl_recombination_stats.buffers_total = HCI_ACL_RECOMBINATION_BUFFERS;
+#endif
+
+    // setup pointer for outgoing packet buffer, with multiple outgoing buffers done in hci_state_reset
+#if HCI_OUTGOING_BUFFERS == 1
     hci_stack->hci_packet_buffer = &hci_stack->hci_packet_buffer_data[HCI_OUTGOING_PRE_BUFFER_SIZE];
+#endif
 
     // max acl payload size defined in config.h
     hci_stack->acl_data_packet_length = HCI_ACL_PAYLOAD_SIZE;
@@ -3083,7 +3526,7 @@ static void hci_run(void){
         hci_con_handle_t con_handle = READ_ACL_CONNECTION_HANDLE(hci_stack->hci_packet_buffer);
         hci_connection_t *connection = hci_connection_for_handle(con_handle);
         if (connection) {
-            if (hci_can_send_prepared_acl_packet_now(con_handle)){
+            if (hci_can_send_acl_fragment_now(con_handle)){
                 hci_send_acl_packet_fragments(connection);
                 return;
             }
@@ -3092,6 +3535,7 @@ static void hci_run(void){
             log_info("hci_run: fragmented ACL packet no connection -> discard fragment");
             hci_stack->acl_fragmentation_total_size = 0;
             hci_stack->acl_fragmentation_pos = 0;
+            hci_stack->acl_fragmentation_iov_count = 0;
         }
     }
 
@@ -4312,8 +4756,7 @@ uint8_t gap_connect_cancel(void){
         case SEND_CREATE_CONNECTION:
             // skip sending create connection and emit event instead
             hci_emit_le_connection_complete(conn->address_type, conn->address, 0, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
-            btstack_linked_list_remove(&hci_stack->connections, (btstack_linked_item_t *) conn);
-            btstack_memory_hci_connection_free( conn );
+            hci_connection_free( conn );
             break;            
         case SENT_CREATE_CONNECTION:
             // request to send cancel connection
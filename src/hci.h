@@ -50,6 +50,7 @@
 #include "btstack_chipset.h"
 #include "btstack_control.h"
 #include "btstack_linked_list.h"
+#include "btstack_memory_pool.h"
 #include "btstack_util.h"
 #include "classic/btstack_link_key_db.h"
 #include "hci_cmd.h"
@@ -132,6 +133,36 @@ extern "C" {
 #endif
 #endif
 
+// number of outgoing packet buffers: with more than one, ACL packets are queued while the HCI Transport is busy
+#ifndef HCI_OUTGOING_BUFFERS
+#define HCI_OUTGOING_BUFFERS 1
+#endif
+#if HCI_OUTGOING_BUFFERS < 1
+#error HCI_OUTGOING_BUFFERS must be at least 1
+#endif
+
+// number of shared ACL recombination buffers, if defined, buffers are only taken for L2CAP packets split into fragments
+#ifdef HCI_ACL_RECOMBINATION_BUFFERS
+#if HCI_ACL_RECOMBINATION_BUFFERS < 1
+#error HCI_ACL_RECOMBINATION_BUFFERS must be at least 1
+#endif
+#endif
+
+// max number of segments for ACL payload in hci_send_acl_packet_buffer_iov, e.g. L2CAP + RFCOMM header, payload, FCS
+#ifndef HCI_ACL_IOV_MAX
+#define HCI_ACL_IOV_MAX 4
+#endif
+
+// number of slots of the optional connection index (by con handle and by address), must be a power of two
+#ifdef ENABLE_HCI_CONNECTION_INDEX
+#ifndef HCI_CONNECTION_INDEX_SIZE
+#define HCI_CONNECTION_INDEX_SIZE 32
+#endif
+#if (HCI_CONNECTION_INDEX_SIZE < 2) || ((HCI_CONNECTION_INDEX_SIZE & (HCI_CONNECTION_INDEX_SIZE - 1)) != 0)
+#error HCI_CONNECTION_INDEX_SIZE must be a power of two
+#endif
+#endif
+
 // BNEP may uncompress the IP Header by 16 bytes
 #ifndef HCI_INCOMING_PRE_BUFFER_SIZE
 #ifdef ENABLE_CLASSIC
@@ -431,6 +462,13 @@ typedef struct {
     btstack_linked_list_t   notification_requests;
     btstack_linked_list_t   indication_requests;
 
+#ifdef ENABLE_ATT_SERVER_NOTIFY_ALL
+    // bit per att_server_notify_all_subscribers value slot
+    uint32_t                notify_all_subscribed;
+    uint32_t                notify_all_pending;
+    uint8_t                 notify_all_next_slot;
+#endif
+
     uint16_t                request_size;
     uint8_t                 request_buffer[ATT_REQUEST_BUFFER_SIZE];
 
@@ -505,7 +543,12 @@ typedef struct {
     uint32_t timestamp;
 
     // ACL packet recombination - PRE_BUFFER + ACL Header + ACL payload
+#ifdef HCI_ACL_RECOMBINATION_BUFFERS
+    // taken from shared pool for first fragment, returned when packet complete
+    uint8_t * acl_recombination_buffer;
+#else
     uint8_t  acl_recombination_buffer[HCI_INCOMING_PRE_BUFFER_SIZE + 4 + HCI_ACL_BUFFER_SIZE];
+#endif
     uint16_t acl_recombination_pos;
     uint16_t acl_recombination_length;
     
@@ -540,6 +583,19 @@ typedef struct {
 
 } hci_connection_t;
 
+#ifdef ENABLE_HCI_CONNECTION_INDEX
+/**
+ * Open addressing hash table with linear probing over hci_connection_t
+ */
+typedef struct {
+    hci_connection_t * slots[HCI_CONNECTION_INDEX_SIZE];
+    // number of used slots
+    uint16_t used;
+    // number of connections not stored due to full table or duplicate key, lookups fall back to list if > 0
+    uint16_t unindexed;
+} hci_connection_index_t;
+#endif
+
 
 /** 
  * HCI Inititizlization State Machine
@@ -673,6 +729,31 @@ typedef struct {
     uint8_t        state;   
 } whitelist_entry_t;
 
+// usage of shared ACL recombination buffers
+typedef struct {
+    uint16_t buffers_total;
+    uint16_t buffers_used;
+    uint16_t buffers_high_water_mark;
+    uint32_t packets_dropped;
+} hci_acl_recombination_stats_t;
+
+#ifdef HCI_ACL_RECOMBINATION_BUFFERS
+// shared ACL recombination buffer, aligned for use with btstack_memory_pool
+typedef union {
+    btstack_linked_item_t item;
+    uint8_t data[HCI_INCOMING_PRE_BUFFER_SIZE + 4 + HCI_ACL_BUFFER_SIZE];
+} hci_acl_recombination_buffer_t;
+#endif
+
+#if HCI_OUTGOING_BUFFERS > 1
+// outgoing packet buffer, queued ACL packets are stored with size
+typedef struct {
+    btstack_linked_item_t item;
+    uint16_t size;
+    uint8_t  data[HCI_OUTGOING_PRE_BUFFER_SIZE + HCI_OUTGOING_PACKET_BUFFER_SIZE];
+} hci_outgoing_buffer_t;
+#endif
+
 /**
  * main data structure
  */
@@ -693,6 +774,19 @@ typedef struct {
     // list of existing baseband connections
     btstack_linked_list_t     connections;
 
+#ifdef HCI_ACL_RECOMBINATION_BUFFERS
+    // shared ACL recombination buffers
+    hci_acl_recombination_buffer_t acl_recombination_buffers_storage[HCI_ACL_RECOMBINATION_BUFFERS];
+    btstack_memory_pool_t          acl_recombination_buffers_pool;
+    hci_acl_recombination_stats_t  acl_recombination_stats;
+#endif
+
+#ifdef ENABLE_HCI_CONNECTION_INDEX
+    // index into connections, keyed on con handle and on (address, address type)
+    hci_connection_index_t connection_index_by_handle;
+    hci_connection_index_t connection_index_by_address;
+#endif
+
     /* callback to L2CAP layer */
     btstack_packet_handler_t acl_packet_handler;
 
@@ -719,10 +813,25 @@ typedef struct {
 
     // single buffer for HCI packet assembly + additional prebuffer for H4 drivers
     uint8_t   * hci_packet_buffer;
+#if HCI_OUTGOING_BUFFERS > 1
+    // hci_packet_buffer points into current buffer from pool, ACL packets are queued while another one is sent
+    hci_outgoing_buffer_t   outgoing_buffers_storage[HCI_OUTGOING_BUFFERS];
+    btstack_memory_pool_t   outgoing_buffers_pool;
+    uint8_t                 outgoing_buffers_free;
+    hci_outgoing_buffer_t * outgoing_buffer_current;
+    hci_outgoing_buffer_t * outgoing_buffer_in_flight;
+    btstack_linked_list_t   outgoing_acl_queue;
+#else
     uint8_t   hci_packet_buffer_data[HCI_OUTGOING_PRE_BUFFER_SIZE + HCI_OUTGOING_PACKET_BUFFER_SIZE];
+#endif
     uint8_t   hci_packet_buffer_reserved;
     uint16_t  acl_fragmentation_pos;
     uint16_t  acl_fragmentation_total_size;
+
+    // ACL payload gathered from segments, see hci_send_acl_packet_buffer_iov
+    btstack_iovec_t acl_fragmentation_iov[HCI_ACL_IOV_MAX];
+    uint8_t   acl_fragmentation_iov_count;
+    uint8_t   acl_fragmentation_header[4];
      
     /* host to controller flow control */
     uint8_t  num_cmd_packets;
@@ -1031,6 +1140,14 @@ void hci_release_packet_buffer(void);
 */
 void hci_set_master_slave_policy(uint8_t policy);
 
+#ifdef HCI_ACL_RECOMBINATION_BUFFERS
+/**
+ * @brief Get usage of shared ACL recombination buffers
+ * @param stats
+ */
+void hci_get_acl_recombination_stats(hci_acl_recombination_stats_t * stats);
+#endif
+
 /* API_END */
 
 
@@ -1084,6 +1201,14 @@ int hci_can_send_prepared_acl_packet_now(hci_con_handle_t con_handle);
  */
 int hci_send_acl_packet_buffer(int size);
 
+/**
+ * Send acl packet with ACL header prepared in hci packet buffer and ACL payload gathered from iovcnt segments
+ * Segments can be located in hci packet buffer, at or before their final position, or in application memory.
+ * Without support for send_packet_iov in the HCI Transport, the segments are copied into the hci packet buffer.
+ * Otherwise, segments have to stay valid until the packet buffer gets released.
+ */
+int hci_send_acl_packet_buffer_iov(const btstack_iovec_t * iov, int iovcnt);
+
 /**
  * Check if authentication is active. It delays automatic disconnect while no L2CAP connection
  * Called by l2cap.
@@ -64,9 +64,26 @@
 #ifdef HAVE_POSIX_FILE_IO
 #include <fcntl.h>        // open
 #include <unistd.h>       // write 
+#include <string.h>
 #include <time.h>
 #include <sys/time.h>     // for timestamps
 #include <sys/stat.h>     // for mode flags
+#ifndef _WIN32
+#include <sys/uio.h>      // writev
+#endif
+#endif
+
+#ifdef ENABLE_HCI_DUMP_ASYNC
+#ifndef HAVE_POSIX_FILE_IO
+#error "ENABLE_HCI_DUMP_ASYNC requires HAVE_POSIX_FILE_IO"
+#endif
+#include <pthread.h>
+#ifndef HCI_DUMP_ASYNC_BUFFER_SIZE
+#define HCI_DUMP_ASYNC_BUFFER_SIZE 65536
+#endif
+#if (HCI_DUMP_ASYNC_BUFFER_SIZE & (HCI_DUMP_ASYNC_BUFFER_SIZE - 1)) != 0
+#error "HCI_DUMP_ASYNC_BUFFER_SIZE must be a power of two"
+#endif
 #endif
 
 // BLUEZ hcidump - struct not used directly, but left here as documentation
@@ -91,7 +108,8 @@ typedef struct {
 pktlog_hdr;
 #define PKTLOG_HDR_SIZE 13
 
-static int dump_file = -1;
+// only accessed by BTstack thread
+static int dump_enabled;
 #ifdef HAVE_POSIX_FILE_IO
 static int dump_format;
 static uint8_t header_bluez[HCIDUMP_HDR_SIZE];
@@ -100,12 +118,52 @@ static char time_string[40];
 static int  max_nr_packets = -1;
 static int  nr_packets = 0;
 static char log_message_buffer[256];
+
+// file, rotation, file size and nr packets are only accessed by writer thread if async
+static int      dump_file = -1;
+static char     dump_filename[256];
+static uint32_t max_file_size;
+static int      max_nr_files;
+static uint32_t file_size;
+static uint32_t dropped_packets;
+
+// header + ACL fragment
+#define HCI_DUMP_IOV_MAX (2 + HCI_ACL_IOV_MAX)
+
+#ifndef _WIN32
+typedef struct iovec hci_dump_iovec_t;
+#else
+typedef struct {
+    void * iov_base;
+    size_t iov_len;
+} hci_dump_iovec_t;
+#endif
+#endif
+
+#ifdef ENABLE_HCI_DUMP_ASYNC
+// single producer (BTstack thread), single consumer (writer thread) ring of complete records
+static uint8_t   async_buffer[HCI_DUMP_ASYNC_BUFFER_SIZE];
+static uint32_t  async_write_pos;
+static uint32_t  async_read_pos;
+static int       async_writer_waiting;
+static int       async_writer_stop;
+static int       async_writer_active;
+static pthread_t async_writer_thread;
+static pthread_mutex_t async_writer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  async_writer_cond  = PTHREAD_COND_INITIALIZER;
+static uint32_t  async_dropped_unreported;
+static void hci_dump_async_start(void);
+static void hci_dump_async_stop(void);
 #endif
 
 // levels: debug, info, error
 static int log_level_enabled[3] = { 1, 1, 1};
 
 void hci_dump_open(const char *filename, hci_dump_format_t format){
+    // stop writer thread and close previous file
+    if (dump_enabled){
+        hci_dump_close();
+    }
 #ifdef HAVE_POSIX_FILE_IO
     dump_format = format;
     if (dump_format == HCI_DUMP_STDOUT) {
@@ -120,23 +178,290 @@ void hci_dump_open(const char *filename, hci_dump_format_t format){
         dump_file = open(filename, oflags, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH );
         if (dump_file < 0){
             printf("hci_dump_open: failed to open file %s\n", filename);
+            return;
+        }
+
+        // remember filename for rotation
+        if (strlen(filename) < sizeof(dump_filename)){
+            strcpy(dump_filename, filename);
+        } else {
+            dump_filename[0] = 0;
         }
     }
+    nr_packets = 0;
+    file_size = 0;
+    dropped_packets = 0;
+#ifdef ENABLE_HCI_DUMP_ASYNC
+    // writer thread owns dump_file from now on
+    if (dump_format != HCI_DUMP_STDOUT){
+        hci_dump_async_start();
+    }
+#endif
 #else
     UNUSED(filename);
     UNUSED(format);
-    
-    dump_file = 1;
 #endif
+    dump_enabled = 1;
 }
 
 #ifdef HAVE_POSIX_FILE_IO
 void hci_dump_set_max_packets(int packets){
     max_nr_packets = packets;
 }
+
+void hci_dump_set_rotation(uint32_t max_size, int num_files){
+    max_file_size = max_size;
+    max_nr_files  = num_files;
+}
+
+uint32_t hci_dump_get_dropped_packets(void){
+    return dropped_packets;
+}
+#endif
+
+#ifdef HAVE_POSIX_FILE_IO
+
+static void hci_dump_file_write(hci_dump_iovec_t * iov, int iovcnt){
+    // avoid -Wunused-result
+    int res;
+#ifndef _WIN32
+    res = writev(dump_file, iov, iovcnt);
+#else
+    int i;
+    for (i = 0; i < iovcnt; i++){
+        res = write(dump_file, iov[i].iov_base, iov[i].iov_len);
+    }
+#endif
+    UNUSED(res);
+}
+
+// rename filename.n-1 -> filename.n, ..., filename -> filename.1 and start new file
+static void hci_dump_file_rotate(void){
+    if (max_nr_files > 0 && dump_filename[0]){
+        char old_name[sizeof(dump_filename) + 12];
+        char new_name[sizeof(dump_filename) + 12];
+        close(dump_file);
+        int i;
+        for (i = max_nr_files; i > 0; i--){
+            if (i > 1){
+                snprintf(old_name, sizeof(old_name), "%s.%u", dump_filename, i - 1);
+            } else {
+                snprintf(old_name, sizeof(old_name), "%s", dump_filename);
+            }
+            snprintf(new_name, sizeof(new_name), "%s.%u", dump_filename, i);
+            rename(old_name, new_name);
+        }
+        int oflags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef _WIN32
+        oflags |= O_BINARY;
+#endif
+        dump_file = open(dump_filename, oflags, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH );
+    } else {
+        lseek(dump_file, 0, SEEK_SET);
+        // avoid -Wunused-result
+        int res = ftruncate(dump_file, 0);
+        UNUSED(res);
+    }
+    nr_packets = 0;
+    file_size = 0;
+}
+
+// new file needed if record would exceed max nr packets or max file size
+static int hci_dump_file_rotation_needed(uint32_t record_size){
+    if (max_nr_packets > 0 && nr_packets >= max_nr_packets) return 1;
+    if (max_file_size > 0 && file_size > 0 && (file_size + record_size) > max_file_size) return 1;
+    return 0;
+}
+
+// write header and packet with a single writev
+static void hci_dump_file_write_record(const uint8_t * header, uint16_t header_len, const btstack_iovec_t * iov, int iovcnt, uint16_t len){
+    if (hci_dump_file_rotation_needed(header_len + len)){
+        hci_dump_file_rotate();
+    }
+    nr_packets++;
+    file_size += header_len + len;
+
+    hci_dump_iovec_t file_iov[HCI_DUMP_IOV_MAX];
+    file_iov[0].iov_base = (void *) header;
+    file_iov[0].iov_len  = header_len;
+    int file_iovcnt = 1;
+    int i;
+    for (i = 0; i < iovcnt; i++){
+        if (file_iovcnt == HCI_DUMP_IOV_MAX){
+            hci_dump_file_write(file_iov, file_iovcnt);
+            file_iovcnt = 0;
+        }
+        file_iov[file_iovcnt].iov_base = (void *) iov[i].data;
+        file_iov[file_iovcnt].iov_len  = iov[i].len;
+        file_iovcnt++;
+    }
+    hci_dump_file_write(file_iov, file_iovcnt);
+}
+
 #endif
 
-static void printf_packet(uint8_t packet_type, uint8_t in, uint8_t * packet, uint16_t len){
+#ifdef ENABLE_HCI_DUMP_ASYNC
+
+// size of record from header
+static uint32_t hci_dump_record_size(const uint8_t * header){
+    if (dump_format == HCI_DUMP_BLUEZ){
+        return HCIDUMP_HDR_SIZE - 1 + little_endian_read_16(header, 0);
+    } else {
+        return 4 + big_endian_read_32(header, 0);
+    }
+}
+
+static void hci_dump_async_copy_in(uint32_t pos, const uint8_t * data, uint32_t len){
+    uint32_t offset = pos & (HCI_DUMP_ASYNC_BUFFER_SIZE - 1);
+    uint32_t bytes_to_end = HCI_DUMP_ASYNC_BUFFER_SIZE - offset;
+    if (len <= bytes_to_end){
+        memcpy(&async_buffer[offset], data, len);
+    } else {
+        memcpy(&async_buffer[offset], data, bytes_to_end);
+        memcpy(async_buffer, &data[bytes_to_end], len - bytes_to_end);
+    }
+}
+
+static void hci_dump_async_copy_out(uint32_t pos, uint8_t * data, uint32_t len){
+    uint32_t offset = pos & (HCI_DUMP_ASYNC_BUFFER_SIZE - 1);
+    uint32_t bytes_to_end = HCI_DUMP_ASYNC_BUFFER_SIZE - offset;
+    if (len <= bytes_to_end){
+        memcpy(data, &async_buffer[offset], len);
+    } else {
+        memcpy(data, &async_buffer[offset], bytes_to_end);
+        memcpy(&data[bytes_to_end], async_buffer, len - bytes_to_end);
+    }
+}
+
+// write records [read_pos, read_pos + len) with a single writev
+static void hci_dump_async_write(uint32_t read_pos, uint32_t len){
+    hci_dump_iovec_t iov[2];
+    int iovcnt = 1;
+    uint32_t offset = read_pos & (HCI_DUMP_ASYNC_BUFFER_SIZE - 1);
+    uint32_t bytes_to_end = HCI_DUMP_ASYNC_BUFFER_SIZE - offset;
+    iov[0].iov_base = &async_buffer[offset];
+    iov[0].iov_len  = len;
+    if (len > bytes_to_end){
+        iov[0].iov_len  = bytes_to_end;
+        iov[1].iov_base = async_buffer;
+        iov[1].iov_len  = len - bytes_to_end;
+        iovcnt = 2;
+    }
+    hci_dump_file_write(iov, iovcnt);
+}
+
+// writer thread: write all available records, batched until file has to be rotated
+static void hci_dump_async_drain(void){
+    uint32_t read_pos  = async_read_pos;
+    uint32_t write_pos = __atomic_load_n(&async_write_pos, __ATOMIC_ACQUIRE);
+    while (read_pos != write_pos){
+        uint32_t batch_len = 0;
+        while ((read_pos + batch_len) != write_pos){
+            uint8_t header[4];
+            hci_dump_async_copy_out(read_pos + batch_len, header, sizeof(header));
+            uint32_t record_size = hci_dump_record_size(header);
+            if (hci_dump_file_rotation_needed(record_size)){
+                // write records for current file first
+                if (batch_len > 0) break;
+                hci_dump_file_rotate();
+            }
+            nr_packets++;
+            file_size += record_size;
+            batch_len += record_size;
+        }
+        hci_dump_async_write(read_pos, batch_len);
+        read_pos += batch_len;
+        __atomic_store_n(&async_read_pos, read_pos, __ATOMIC_RELEASE);
+    }
+}
+
+static void * hci_dump_async_writer(void * context){
+    UNUSED(context);
+    pthread_mutex_lock(&async_writer_mutex);
+    while (1){
+        if (async_read_pos == __atomic_load_n(&async_write_pos, __ATOMIC_SEQ_CST)){
+            if (async_writer_stop) break;
+            // producer only signals if writer is waiting, re-check after announcing it
+            __atomic_store_n(&async_writer_waiting, 1, __ATOMIC_SEQ_CST);
+            if (async_read_pos == __atomic_load_n(&async_write_pos, __ATOMIC_SEQ_CST)){
+                struct timespec timeout;
+                clock_gettime(CLOCK_REALTIME, &timeout);
+                timeout.tv_nsec += 100000000;
+                if (timeout.tv_nsec >= 1000000000){
+                    timeout.tv_sec++;
+                    timeout.tv_nsec -= 1000000000;
+                }
+                pthread_cond_timedwait(&async_writer_cond, &async_writer_mutex, &timeout);
+            }
+            __atomic_store_n(&async_writer_waiting, 0, __ATOMIC_SEQ_CST);
+            continue;
+        }
+        pthread_mutex_unlock(&async_writer_mutex);
+        hci_dump_async_drain();
+        pthread_mutex_lock(&async_writer_mutex);
+    }
+    pthread_mutex_unlock(&async_writer_mutex);
+    return NULL;
+}
+
+static void hci_dump_async_start(void){
+    async_read_pos  = 0;
+    async_write_pos = 0;
+    async_writer_waiting = 0;
+    async_writer_stop = 0;
+    async_dropped_unreported = 0;
+    async_writer_active = pthread_create(&async_writer_thread, NULL, &hci_dump_async_writer, NULL) == 0;
+    if (!async_writer_active){
+        printf("hci_dump_open: failed to start writer thread, writing synchronously\n");
+    }
+}
+
+static void hci_dump_async_stop(void){
+    if (!async_writer_active) return;
+    pthread_mutex_lock(&async_writer_mutex);
+    async_writer_stop = 1;
+    pthread_cond_signal(&async_writer_cond);
+    pthread_mutex_unlock(&async_writer_mutex);
+    pthread_join(async_writer_thread, NULL);
+    async_writer_active = 0;
+}
+
+// copy record into ring, called from BTstack thread only
+static int hci_dump_async_enqueue(const uint8_t * header, uint16_t header_len, const btstack_iovec_t * iov, int iovcnt, uint16_t len){
+    uint32_t write_pos = async_write_pos;
+    uint32_t read_pos  = __atomic_load_n(&async_read_pos, __ATOMIC_ACQUIRE);
+    uint32_t bytes_free = HCI_DUMP_ASYNC_BUFFER_SIZE - (write_pos - read_pos);
+    if ((uint32_t) (header_len + len) > bytes_free) return 0;
+    hci_dump_async_copy_in(write_pos, header, header_len);
+    write_pos += header_len;
+    int i;
+    for (i = 0; i < iovcnt; i++){
+        hci_dump_async_copy_in(write_pos, iov[i].data, iov[i].len);
+        write_pos += iov[i].len;
+    }
+    __atomic_store_n(&async_write_pos, write_pos, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&async_writer_waiting, __ATOMIC_SEQ_CST)){
+        pthread_mutex_lock(&async_writer_mutex);
+        pthread_cond_signal(&async_writer_cond);
+        pthread_mutex_unlock(&async_writer_mutex);
+    }
+    return 1;
+}
+#endif
+
+// same format as printf_hexdump, without line break between segments
+static void printf_hexdump_iov(const btstack_iovec_t * iov, int iovcnt){
+    int i;
+    for (i = 0; i < iovcnt; i++){
+        int j;
+        for (j = 0; j < iov[i].len; j++){
+            printf("%02X ", iov[i].data[j]);
+        }
+    }
+    printf("\n");
+}
+
+static void printf_packet(uint8_t packet_type, uint8_t in, const btstack_iovec_t * iov, int iovcnt){
     switch (packet_type){
         case HCI_COMMAND_DATA_PACKET:
             printf("CMD => ");
@@ -159,12 +484,12 @@ static void printf_packet(uint8_t packet_type, uint8_t in, uint8_t * packet, uin
             }
             break;
         case LOG_MESSAGE_PACKET:
-            printf("LOG -- %s\n", (char*) packet);
+            printf("LOG -- %s\n", (const char*) iov[0].data);
             return;
         default:
             return;
     }
-    printf_hexdump(packet, len);  
+    printf_hexdump_iov(iov, iovcnt);
 }
 
 static void printf_timestamp(void){
@@ -197,36 +522,20 @@ static void printf_timestamp(void){
 }
 
 void hci_dump_packet(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t len) {    
-
-    if (dump_file < 0) return; // not activated yet
+    btstack_iovec_t iov;
+    iov.data = packet;
+    iov.len  = len;
+    hci_dump_packet_iov(packet_type, in, &iov, 1);
+}
 
 #ifdef HAVE_POSIX_FILE_IO
-
-    // don't grow bigger than max_nr_packets
-    if (dump_format != HCI_DUMP_STDOUT && max_nr_packets > 0){
-        if (nr_packets >= max_nr_packets){
-            lseek(dump_file, 0, SEEK_SET);
-            // avoid -Wunused-result
-            int res = ftruncate(dump_file, 0);
-            UNUSED(res);
-            nr_packets = 0;
-        }
-        nr_packets++;
-    }
-    
+// setup header for BlueZ or PacketLogger format, returns header size or 0 if packet type not supported
+static uint16_t hci_dump_setup_header(uint8_t packet_type, uint8_t in, uint16_t len, const uint8_t ** header){
     // get time
     struct timeval curr_time;
     gettimeofday(&curr_time, NULL);
 
-    // avoid -Wunused-result
-    int res = 0;
     switch (dump_format){
-        case HCI_DUMP_STDOUT: {
-            printf_timestamp();
-            printf_packet(packet_type, in, packet, len);
-            break;
-        }
-            
         case HCI_DUMP_BLUEZ:
             little_endian_store_16( header_bluez, 0, 1 + len);
             header_bluez[2] = in;
@@ -234,9 +543,8 @@ void hci_dump_packet(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t
             little_endian_store_32( header_bluez, 4, (uint32_t) curr_time.tv_sec);
             little_endian_store_32( header_bluez, 8,            curr_time.tv_usec);
             header_bluez[12] = packet_type;
-            res = write (dump_file, header_bluez, HCIDUMP_HDR_SIZE);
-            res = write (dump_file, packet, len );
-            break;
+            *header = header_bluez;
+            return HCIDUMP_HDR_SIZE;
             
         case HCI_DUMP_PACKETLOGGER:
             big_endian_store_32( header_packetlogger, 0, PKTLOG_HDR_SIZE - 4 + len);
@@ -267,20 +575,79 @@ void hci_dump_packet(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t
                     header_packetlogger[12] = 0xfc;
                     break;
                 default:
-                    return;
+                    return 0;
             }
-            res = write (dump_file, &header_packetlogger, PKTLOG_HDR_SIZE);
-            res = write (dump_file, packet, len );
-            break;
+            *header = header_packetlogger;
+            return PKTLOG_HDR_SIZE;
             
         default:
-            break;
+            return 0;
     }
-    UNUSED(res);
+}
+
+#ifdef ENABLE_HCI_DUMP_ASYNC
+// report dropped packets as soon as there's space again
+static void hci_dump_async_report_dropped(void){
+    if (async_dropped_unreported == 0) return;
+    char message[40];
+    btstack_iovec_t message_iov;
+    message_iov.data = (const uint8_t *) message;
+    message_iov.len  = snprintf(message, sizeof(message), "hci_dump: %u packets dropped", (unsigned int) async_dropped_unreported);
+    const uint8_t * header;
+    uint16_t header_len = hci_dump_setup_header(LOG_MESSAGE_PACKET, 0, message_iov.len, &header);
+    if (hci_dump_async_enqueue(header, header_len, &message_iov, 1, message_iov.len)){
+        async_dropped_unreported = 0;
+    }
+}
+#endif
+#endif
+
+void hci_dump_packet_iov(uint8_t packet_type, uint8_t in, const btstack_iovec_t * iov, int iovcnt){
+
+    if (!dump_enabled) return; // not activated yet
+
+    uint16_t len = 0;
+    int i;
+    for (i = 0; i < iovcnt; i++){
+        len += iov[i].len;
+    }
+
+#ifdef HAVE_POSIX_FILE_IO
+
+    if (dump_format == HCI_DUMP_STDOUT){
+        printf_timestamp();
+        printf_packet(packet_type, in, iov, iovcnt);
+        return;
+    }
+
+#ifdef ENABLE_HCI_DUMP_ASYNC
+    if (async_writer_active){
+        hci_dump_async_report_dropped();
+    }
+#endif
+
+    const uint8_t * header;
+    uint16_t header_len = hci_dump_setup_header(packet_type, in, len, &header);
+    if (header_len == 0) return;
+
+#ifdef ENABLE_HCI_DUMP_ASYNC
+    if (async_writer_active){
+        // drop packet if ring is full or earlier drops have not been reported yet
+        if (async_dropped_unreported || !hci_dump_async_enqueue(header, header_len, iov, iovcnt, len)){
+            async_dropped_unreported++;
+            dropped_packets++;
+        }
+        return;
+    }
+#endif
+
+    hci_dump_file_write_record(header, header_len, iov, iovcnt, len);
 #else
 
+    UNUSED(len);
+
     printf_timestamp();
-    printf_packet(packet_type, in, packet, len);
+    printf_packet(packet_type, in, iov, iovcnt);
 
 #endif
 }
@@ -295,7 +662,7 @@ void hci_dump_log_va_arg(int log_level, const char * format, va_list argptr){
     if (!hci_dump_log_level_active(log_level)) return;
 
 #ifdef HAVE_POSIX_FILE_IO
-    if (dump_file >= 0){
+    if (dump_enabled){
         int len = vsnprintf(log_message_buffer, sizeof(log_message_buffer), format, argptr);
         hci_dump_packet(LOG_MESSAGE_PACKET, 0, (uint8_t*) log_message_buffer, len);
         return;
@@ -328,10 +695,24 @@ void hci_dump_log_P(int log_level, PGM_P format, ...){
 #endif
 
 void hci_dump_close(void){
-#ifdef HAVE_POSIX_FILE_IO
-    close(dump_file);
+#ifdef ENABLE_HCI_DUMP_ASYNC
+    if (async_writer_active){
+        hci_dump_async_stop();
+        // ring is empty now, report remaining drops directly
+        if (async_dropped_unreported){
+            int len = snprintf(log_message_buffer, sizeof(log_message_buffer), "hci_dump: %u packets dropped", (unsigned int) async_dropped_unreported);
+            hci_dump_packet(LOG_MESSAGE_PACKET, 0, (uint8_t*) log_message_buffer, len);
+            async_dropped_unreported = 0;
+        }
+    }
 #endif
+#ifdef HAVE_POSIX_FILE_IO
+    if (dump_enabled && dump_format != HCI_DUMP_STDOUT){
+        close(dump_file);
+    }
     dump_file = -1;
+#endif
+    dump_enabled = 0;
 }
 
 void hci_dump_enable_log_level(int log_level, int enable){
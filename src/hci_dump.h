@@ -48,6 +48,7 @@
 
 #include <stdint.h>
 #include <stdarg.h>       // for va_list
+#include "btstack_defines.h"
 
 #ifdef __AVR__
 #include <avr/pgmspace.h>
@@ -79,11 +80,30 @@ void hci_dump_open(const char *filename, hci_dump_format_t format);
  */
 void hci_dump_set_max_packets(int packets); // -1 for unlimited
 
+/*
+ * @brief Rotate log files instead of truncating the current one when max file size or max packets is reached.
+ * The current file is renamed to filename.1, older files to filename.2 .. filename.num_files. Call before hci_dump_open.
+ * @param max_file_size in bytes, 0 for unlimited
+ * @param num_files number of old files to keep, 0 to truncate the current file
+ */
+void hci_dump_set_rotation(uint32_t max_file_size, int num_files);
+
+/*
+ * @brief Get number of packets dropped by the asynchronous writer (ENABLE_HCI_DUMP_ASYNC) since hci_dump_open
+ * @return number of dropped packets
+ */
+uint32_t hci_dump_get_dropped_packets(void);
+
 /*
  * @brief 
  */
 void hci_dump_packet(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t len);
 
+/*
+ * @brief Dump packet gathered from iovcnt segments
+ */
+void hci_dump_packet_iov(uint8_t packet_type, uint8_t in, const btstack_iovec_t * iov, int iovcnt);
+
 /*
  * @brief 
  */
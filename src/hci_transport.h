@@ -110,6 +110,12 @@ typedef struct {
      */
     void   (*set_sco_config)(uint16_t voice_setting, int num_connections);
 
+    /**
+     * send packet gathered from iovcnt segments, segments have to stay valid until packet has been sent
+     * optional, NULL if not supported
+     */
+    int    (*send_packet_iov)(uint8_t packet_type, const btstack_iovec_t * iov, int iovcnt);
+
 } hci_transport_t;
 
 typedef enum {
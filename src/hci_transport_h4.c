@@ -46,6 +46,7 @@
  */
 
 #include <inttypes.h>
+#include <string.h>
 
 #include "btstack_config.h"
 
@@ -147,6 +148,16 @@ static int read_pos;
 static uint8_t hci_packet_with_pre_buffer[HCI_INCOMING_PRE_BUFFER_SIZE + HCI_INCOMING_PACKET_BUFFER_SIZE + 1]; // packet type + max(acl header + acl payload, event header + event data)
 static uint8_t * hci_packet = &hci_packet_with_pre_buffer[HCI_INCOMING_PRE_BUFFER_SIZE];
 
+#ifdef ENABLE_H4_READ_AHEAD
+// read ahead buffer, used if UART driver supports receive_available
+#ifndef H4_READ_AHEAD_BUFFER_SIZE
+#define H4_READ_AHEAD_BUFFER_SIZE 1024
+#endif
+static uint8_t  read_ahead_buffer[H4_READ_AHEAD_BUFFER_SIZE];
+// bytes of current block already copied from read ahead buffer
+static int      read_ahead_block_pos;
+#endif
+
 #ifdef ENABLE_CC256X_BAUDRATE_CHANGE_FLOWCONTROL_BUG_WORKAROUND
 static const uint8_t local_version_event_prefix[] = { 0x04, 0x0e, 0x0c, 0x01, 0x01, 0x10};
 static const uint8_t baud_rate_command_prefix[]   = { 0x01, 0x36, 0xff, 0x04};
@@ -170,11 +181,18 @@ static void hci_transport_h4_reset_statemachine(void){
 }
 
 static void hci_transport_h4_trigger_next_read(void){
+#ifdef ENABLE_H4_READ_AHEAD
+    if (btstack_uart->receive_available){
+        btstack_uart->receive_available(read_ahead_buffer, sizeof(read_ahead_buffer));
+        return;
+    }
+#endif
     // log_info("hci_transport_h4_trigger_next_read: %u bytes", bytes_to_read);
     btstack_uart->receive_block(&hci_packet[read_pos], bytes_to_read);  
 }
 
-static void hci_transport_h4_block_read(void){
+// process bytes_to_read bytes received at hci_packet[read_pos] and set up next block
+static void hci_transport_h4_process_block(void){
 
     read_pos += bytes_to_read;
 
@@ -272,9 +290,29 @@ static void hci_transport_h4_block_read(void){
         bytes_to_read = 7;
     }
 #endif
+}
+
+static void hci_transport_h4_block_read(void){
+    hci_transport_h4_process_block();
+    hci_transport_h4_trigger_next_read();
+}
 
+#ifdef ENABLE_H4_READ_AHEAD
+// parse as many blocks as possible from read ahead buffer, also handles empty payloads at end of data
+static void hci_transport_h4_data_received(uint16_t len){
+    uint16_t pos = 0;
+    while (1){
+        int bytes_to_copy = btstack_min(bytes_to_read - read_ahead_block_pos, len - pos);
+        memcpy(&hci_packet[read_pos + read_ahead_block_pos], &read_ahead_buffer[pos], bytes_to_copy);
+        pos                  += bytes_to_copy;
+        read_ahead_block_pos += bytes_to_copy;
+        if (read_ahead_block_pos < bytes_to_read) break;
+        read_ahead_block_pos = 0;
+        hci_transport_h4_process_block();
+    }
     hci_transport_h4_trigger_next_read();
 }
+#endif
 
 static void hci_transport_h4_block_sent(void){
     switch (tx_state){
@@ -346,6 +384,33 @@ static int hci_transport_h4_send_packet(uint8_t packet_type, uint8_t * packet, i
     return 0;
 }
 
+#ifndef ENABLE_EHCILL
+// max number of segments for send_packet_iov, packet type is sent as separate segment
+#define HCI_TRANSPORT_H4_IOV_MAX 8
+
+static btstack_iovec_t send_packet_iov[HCI_TRANSPORT_H4_IOV_MAX];
+static uint8_t         send_packet_iov_type;
+
+static int hci_transport_h4_send_packet_iov(uint8_t packet_type, const btstack_iovec_t * iov, int iovcnt){
+
+    if (iovcnt >= HCI_TRANSPORT_H4_IOV_MAX){
+        log_error("hci_transport_h4_send_packet_iov: too many segments %u", iovcnt);
+        return -1;
+    }
+
+    // packet type doesn't need to be stored before actual data
+    send_packet_iov_type = packet_type;
+    send_packet_iov[0].data = &send_packet_iov_type;
+    send_packet_iov[0].len  = 1;
+    memcpy(&send_packet_iov[1], iov, iovcnt * sizeof(btstack_iovec_t));
+
+    // start sending
+    tx_state = TX_W4_PACKET_SENT;
+    btstack_uart->send_block_iov(send_packet_iov, iovcnt + 1);
+    return 0;
+}
+#endif
+
 static void hci_transport_h4_init(const void * transport_config){
     // check for hci_transport_config_uart_t
     if (!transport_config) {
@@ -367,6 +432,11 @@ static void hci_transport_h4_init(const void * transport_config){
     btstack_uart->init(&uart_config);
     btstack_uart->set_block_received(&hci_transport_h4_block_read);
     btstack_uart->set_block_sent(&hci_transport_h4_block_sent);
+#ifdef ENABLE_H4_READ_AHEAD
+    if (btstack_uart->set_data_received){
+        btstack_uart->set_data_received(&hci_transport_h4_data_received);
+    }
+#endif
 }
 
 static int hci_transport_h4_open(void){
@@ -375,6 +445,9 @@ static int hci_transport_h4_open(void){
         return res;
     }
     hci_transport_h4_reset_statemachine();
+#ifdef ENABLE_H4_READ_AHEAD
+    read_ahead_block_pos = 0;
+#endif
     hci_transport_h4_trigger_next_read();
 
     tx_state = TX_IDLE;
@@ -674,10 +747,34 @@ static const hci_transport_t hci_transport_h4 = {
     /* int    (*set_baudrate)(uint32_t baudrate); */                &hci_transport_h4_set_baudrate,
     /* void   (*reset_link)(void); */                               NULL,
     /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL, 
+    /* int    (*send_packet_iov)(...); */                           NULL,
+};
+
+#ifndef ENABLE_EHCILL
+// variant with scatter-gather send for UART drivers that support send_block_iov
+static const hci_transport_t hci_transport_h4_iov = {
+    /* const char * name; */                                        "H4",
+    /* void   (*init) (const void *transport_config); */            &hci_transport_h4_init,
+    /* int    (*open)(void); */                                     &hci_transport_h4_open,
+    /* int    (*close)(void); */                                    &hci_transport_h4_close,
+    /* void   (*register_packet_handler)(void (*handler)(...); */   &hci_transport_h4_register_packet_handler,
+    /* int    (*can_send_packet_now)(uint8_t packet_type); */       &hci_transport_h4_can_send_now,
+    /* int    (*send_packet)(...); */                               &hci_transport_h4_send_packet,
+    /* int    (*set_baudrate)(uint32_t baudrate); */                &hci_transport_h4_set_baudrate,
+    /* void   (*reset_link)(void); */                               NULL,
+    /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL, 
+    /* int    (*send_packet_iov)(...); */                           &hci_transport_h4_send_packet_iov,
 };
+#endif
 
 // configure and return h4 singleton
 const hci_transport_t * hci_transport_h4_instance(const btstack_uart_block_t * uart_driver) {
     btstack_uart = uart_driver;
+#ifndef ENABLE_EHCILL
+    // eHCILL might need to defer sending, which is only supported for single block
+    if (uart_driver->send_block_iov){
+        return &hci_transport_h4_iov;
+    }
+#endif
     return &hci_transport_h4;
 }
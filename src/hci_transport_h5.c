@@ -94,6 +94,11 @@ typedef enum {
 // max size of write requests
 #define LINK_SLIP_TX_CHUNK_LEN 64
 
+// max size of read requests, if UART driver supports receive_available
+#ifndef LINK_SLIP_RX_CHUNK_LEN
+#define LINK_SLIP_RX_CHUNK_LEN 256
+#endif
+
 // ---
 static const uint8_t link_control_sync[] =   { 0x01, 0x7e};
 static const uint8_t link_control_sync_response[] = { 0x02, 0x7d};
@@ -729,12 +734,32 @@ static void hci_transport_link_update_resend_timeout(uint32_t baudrate){
 
 static uint8_t hci_transport_link_read_byte;
 
+// used if UART driver supports receive_available
+static uint8_t hci_transport_link_read_buffer[LINK_SLIP_RX_CHUNK_LEN];
+
 static void hci_transport_h5_read_next_byte(void){
+    if (btstack_uart->receive_available){
+        btstack_uart->receive_available(hci_transport_link_read_buffer, sizeof(hci_transport_link_read_buffer));
+        return;
+    }
     btstack_uart->receive_block(&hci_transport_link_read_byte, 1);    
 }
 
 // track time receiving SLIP frame
 static uint32_t hci_transport_h5_receive_start;
+
+static void hci_transport_h5_frame_received(uint16_t frame_size){
+    // track time
+    uint32_t packet_receive_time = btstack_run_loop_get_time_ms() - hci_transport_h5_receive_start;
+    uint32_t nominmal_time = (frame_size + 6) * 10 * 1000 / uart_config.baudrate;
+    log_info("slip frame time %u ms for %u decoded bytes. nomimal time %u ms", (int) packet_receive_time, frame_size, (int) nominmal_time);
+    // reset state
+    hci_transport_h5_receive_start = 0;
+    // 
+    hci_transport_h5_process_frame(frame_size);
+    hci_transport_slip_init();
+}
+
 static void hci_transport_h5_block_received(){
     // track start time when receiving first byte // a bit hackish
     if (hci_transport_h5_receive_start == 0 && hci_transport_link_read_byte != BTSTACK_SLIP_SOF){
@@ -743,15 +768,22 @@ static void hci_transport_h5_block_received(){
     btstack_slip_decoder_process(hci_transport_link_read_byte);
     uint16_t frame_size = btstack_slip_decoder_frame_size();
     if (frame_size) {
-        // track time
-        uint32_t packet_receive_time = btstack_run_loop_get_time_ms() - hci_transport_h5_receive_start;
-        uint32_t nominmal_time = (frame_size + 6) * 10 * 1000 / uart_config.baudrate;
-        log_info("slip frame time %u ms for %u decoded bytes. nomimal time %u ms", (int) packet_receive_time, frame_size, (int) nominmal_time);
-        // reset state
-        hci_transport_h5_receive_start = 0;
-        // 
-        hci_transport_h5_process_frame(frame_size);
-        hci_transport_slip_init();
+        hci_transport_h5_frame_received(frame_size);
+    }
+    hci_transport_h5_read_next_byte();
+}
+
+static void hci_transport_h5_data_received(uint16_t len){
+    uint16_t pos = 0;
+    while (pos < len){
+        if (hci_transport_h5_receive_start == 0){
+            hci_transport_h5_receive_start = btstack_run_loop_get_time_ms();
+        }
+        pos += btstack_slip_decoder_process_buffer(&hci_transport_link_read_buffer[pos], len - pos);
+        uint16_t frame_size = btstack_slip_decoder_frame_size();
+        if (frame_size) {
+            hci_transport_h5_frame_received(frame_size);
+        }
     }
     hci_transport_h5_read_next_byte();
 }
@@ -802,6 +834,9 @@ static void hci_transport_h5_init(const void * transport_config){
     // setup UART driver
     btstack_uart->init(&uart_config);
     btstack_uart->set_block_received(&hci_transport_h5_block_received);
+    if (btstack_uart->set_data_received){
+        btstack_uart->set_data_received(&hci_transport_h5_data_received);
+    }
     btstack_uart->set_block_sent(&hci_transport_h5_block_sent);
 }
 
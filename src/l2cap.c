@@ -1132,7 +1132,7 @@ int l2cap_send_prepared(uint16_t local_cid, uint16_t len){
     l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
     if (!channel) {
         log_error("l2cap_send_prepared no channel for cid 0x%02x", local_cid);
-        return -1;   // TODO: define error
+        return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
     }
 
     if (!hci_can_send_prepared_acl_packet_now(channel->con_handle)){
@@ -1173,7 +1173,7 @@ int l2cap_send(uint16_t local_cid, uint8_t *data, uint16_t len){
     l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
     if (!channel) {
         log_error("l2cap_send no channel for cid 0x%02x", local_cid);
-        return -1;   // TODO: define error
+        return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
     }
 
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
@@ -1199,6 +1199,93 @@ int l2cap_send(uint16_t local_cid, uint8_t *data, uint16_t len){
     return l2cap_send_prepared(local_cid, len);
 }
 
+// assumption - only on Classic connections
+// cannot be used for L2CAP ERTM
+int l2cap_send_prepared_iov(uint16_t local_cid, const btstack_iovec_t * iov, int iovcnt){
+
+    if (!hci_is_packet_buffer_reserved()){
+        log_error("l2cap_send_prepared_iov called without reserving packet first");
+        return BTSTACK_ACL_BUFFERS_FULL;
+    }
+
+    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
+    if (!channel) {
+        log_error("l2cap_send_prepared_iov no channel for cid 0x%02x", local_cid);
+        return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+    }
+
+#ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
+    if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+        log_error("l2cap_send_prepared_iov cid 0x%02x, not supported for ERTM", local_cid);
+        return ERROR_CODE_COMMAND_DISALLOWED;
+    }
+#endif
+
+    // L2CAP header is sent as first segment
+    if (iovcnt >= HCI_ACL_IOV_MAX){
+        log_error("l2cap_send_prepared_iov cid 0x%02x, too many segments", local_cid);
+        return ERROR_CODE_UNSUPPORTED_FEATURE_OR_PARAMETER_VALUE;
+    }
+
+    if (!hci_can_send_prepared_acl_packet_now(channel->con_handle)){
+        log_info("l2cap_send_prepared_iov cid 0x%02x, cannot send", local_cid);
+        return BTSTACK_ACL_BUFFERS_FULL;
+    }
+
+    log_debug("l2cap_send_prepared_iov cid 0x%02x, handle %u, 1 credit used", local_cid, channel->con_handle);
+
+    uint16_t len = 0;
+    int i;
+    for (i = 0; i < iovcnt; i++){
+        len += iov[i].len;
+    }
+
+    // set non-flushable packet boundary flag if supported on Controller
+    uint8_t *acl_buffer = hci_get_outgoing_packet_buffer();
+    uint8_t packet_boundary_flag = hci_non_flushable_packet_boundary_flag_supported() ? 0x00 : 0x02;
+    l2cap_setup_header(acl_buffer, channel->con_handle, packet_boundary_flag, channel->remote_cid, len);
+
+    btstack_iovec_t acl_iov[HCI_ACL_IOV_MAX];
+    acl_iov[0].data = &acl_buffer[4];
+    acl_iov[0].len  = 4;
+    memcpy(&acl_iov[1], iov, iovcnt * sizeof(btstack_iovec_t));
+
+    // send
+    return hci_send_acl_packet_buffer_iov(acl_iov, iovcnt + 1);
+}
+
+// assumption - only on Classic connections
+int l2cap_send_zero_copy(uint16_t local_cid, const uint8_t *data, uint16_t len){
+    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
+    if (!channel) {
+        log_error("l2cap_send_zero_copy no channel for cid 0x%02x", local_cid);
+        return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+    }
+
+#ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
+    // ERTM keeps a copy for retransmission anyway
+    if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+        return l2cap_ertm_send(channel, (uint8_t *) data, len);
+    }
+#endif
+
+    if (len > channel->remote_mtu){
+        log_error("l2cap_send_zero_copy cid 0x%02x, data length exceeds remote MTU.", local_cid);
+        return L2CAP_DATA_LEN_EXCEEDS_REMOTE_MTU;
+    }
+
+    if (!hci_can_send_acl_packet_now(channel->con_handle)){
+        log_info("l2cap_send_zero_copy cid 0x%02x, cannot send", local_cid);
+        return BTSTACK_ACL_BUFFERS_FULL;
+    }
+
+    hci_reserve_packet_buffer();
+    btstack_iovec_t iov;
+    iov.data = data;
+    iov.len  = len;
+    return l2cap_send_prepared_iov(local_cid, &iov, 1);
+}
+
 int l2cap_send_echo_request(hci_con_handle_t con_handle, uint8_t *data, uint16_t len){
     return l2cap_send_signaling_packet(con_handle, ECHO_REQUEST, 0x77, len, data);
 }
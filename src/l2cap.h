@@ -481,6 +481,13 @@ uint16_t l2cap_get_remote_mtu_for_local_cid(uint16_t local_cid);
  */
 int l2cap_send(uint16_t local_cid, uint8_t *data, uint16_t len);
 
+/** 
+ * @brief Sends L2CAP data packet to the channel with given identifier without copying data into the outgoing buffer
+ * @note If supported by the HCI Transport, data is sent from the provided buffer and has to stay valid
+ *       until the next can send now event. Otherwise, it's copied as in l2cap_send.
+ */
+int l2cap_send_zero_copy(uint16_t local_cid, const uint8_t *data, uint16_t len);
+
 /** 
  * @brief Registers L2CAP service with given PSM and MTU, and assigns a packet handler.
  */
@@ -542,6 +549,12 @@ uint8_t *l2cap_get_outgoing_buffer(void);
  */
 int l2cap_send_prepared(uint16_t local_cid, uint16_t len);
 
+/** 
+ * @brief Send L2CAP packet to channel with L2CAP payload gathered from iovcnt segments, see hci_send_acl_packet_buffer_iov
+ * @note Only for L2CAP Basic Mode Channels
+ */
+int l2cap_send_prepared_iov(uint16_t local_cid, const btstack_iovec_t * iov, int iovcnt);
+
 /** 
  * @brief Release outgoing buffer (only needed if l2cap_send_prepared is not called)
  * @note Only for L2CAP Basic Mode Channels
@@ -0,0 +1,122 @@
+/*
+ * Benchmark: ATT requests on a profile with ~500 attributes, with linear search and with ATT DB index
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "ble/att_db.h"
+#include "ble/att_db_util.h"
+#include "bluetooth.h"
+#include "bluetooth_gatt.h"
+#include "btstack_util.h"
+#include "hci_dump.h"
+
+#define NUM_SERVICES 62
+#define ROUNDS       200
+
+static uint16_t att_db_index_storage[1000];
+static uint16_t max_handle;
+static att_connection_t att_connection;
+
+static uint16_t read_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size){
+    (void) con_handle;
+    uint8_t value[2];
+    little_endian_store_16(value, 0, attribute_handle);
+    return att_read_callback_handle_blob(value, sizeof(value), offset, buffer, buffer_size);
+}
+
+static int write_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size){
+    (void) con_handle;
+    (void) attribute_handle;
+    (void) transaction_mode;
+    (void) offset;
+    (void) buffer;
+    (void) buffer_size;
+    return 0;
+}
+
+// 8 attributes per service: service, 2 x characteristic + value, characteristic + value + CCC
+static void setup_db(void){
+    uint8_t characteristic_uuid128[] = { 0x00, 0x00, 0xFF, 0x11, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5F, 0x9B, 0x34, 0xFB};
+    uint8_t value[] = "value";
+    att_db_util_init();
+    int i;
+    for (i = 0; i < NUM_SERVICES; i++){
+        att_db_util_add_service_uuid16(0x1800 + i);
+        att_db_util_add_characteristic_uuid16(0x2a00 + i, ATT_PROPERTY_READ, ATT_SECURITY_NONE, ATT_SECURITY_NONE, value, 4);
+        characteristic_uuid128[3] = (uint8_t) i;
+        att_db_util_add_characteristic_uuid128(characteristic_uuid128, ATT_PROPERTY_READ | ATT_PROPERTY_WRITE | ATT_PROPERTY_DYNAMIC, ATT_SECURITY_NONE, ATT_SECURITY_NONE, NULL, 0);
+        max_handle = att_db_util_add_characteristic_uuid16(0x2b00 + i, ATT_PROPERTY_READ | ATT_PROPERTY_NOTIFY, ATT_SECURITY_NONE, ATT_SECURITY_NONE, value, 2) + 1;
+    }
+    att_set_db(att_db_util_get_address());
+    att_set_read_callback(&read_callback);
+    att_set_write_callback(&write_callback);
+}
+
+static double now_us(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+// read, write, and read by type for every handle
+static void run_requests(const char * name){
+    uint8_t request[7];
+    uint8_t response[ATT_DEFAULT_MTU];
+    double read_us = 0;
+    double write_us = 0;
+    double read_by_type_us = 0;
+    int round;
+    for (round = 0; round < ROUNDS; round++){
+        uint16_t handle;
+        double start = now_us();
+        for (handle = 1; handle <= max_handle; handle++){
+            request[0] = ATT_READ_REQUEST;
+            little_endian_store_16(request, 1, handle);
+            att_handle_request(&att_connection, request, 3, response);
+        }
+        double after_read = now_us();
+        for (handle = 1; handle <= max_handle; handle++){
+            request[0] = ATT_WRITE_REQUEST;
+            little_endian_store_16(request, 1, handle);
+            little_endian_store_16(request, 3, 0x0001);
+            att_handle_request(&att_connection, request, 5, response);
+        }
+        double after_write = now_us();
+        for (handle = 1; handle <= max_handle; handle++){
+            request[0] = ATT_READ_BY_TYPE_REQUEST;
+            little_endian_store_16(request, 1, handle);
+            little_endian_store_16(request, 3, 0xffff);
+            little_endian_store_16(request, 5, GATT_CHARACTERISTICS_UUID);
+            att_handle_request(&att_connection, request, 7, response);
+        }
+        double after_read_by_type = now_us();
+        read_us         += after_read - start;
+        write_us        += after_write - after_read;
+        read_by_type_us += after_read_by_type - after_write;
+    }
+    uint32_t num_requests = ROUNDS * max_handle;
+    printf("%-14s read %7.3f us, write %7.3f us, read by type %7.3f us per request\n", name,
+        read_us / num_requests, write_us / num_requests, read_by_type_us / num_requests);
+}
+
+int main(int argc, const char * argv[]){
+    (void) argc;
+    (void) argv;
+
+    hci_dump_enable_log_level(HCI_DUMP_LOG_LEVEL_INFO, 0);
+    memset(&att_connection, 0, sizeof(att_connection));
+    att_connection.mtu = ATT_DEFAULT_MTU;
+    att_connection.max_mtu = ATT_DEFAULT_MTU;
+
+    setup_db();
+    printf("ATT DB with %u attributes, %u bytes\n", max_handle, att_db_util_get_size());
+
+    run_requests("linear search:");
+    att_set_db_index(att_db_index_storage, max_handle + 1);
+    run_requests("index:");
+    return 0;
+}
@@ -0,0 +1,168 @@
+
+// *****************************************************************************
+//
+// test ATT DB index: responses have to match the ones without index
+//
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "ble/att_db.h"
+#include "ble/att_db_util.h"
+#include "bluetooth.h"
+#include "bluetooth_gatt.h"
+#include "btstack_util.h"
+#include "hci_dump.h"
+
+#define NUM_SERVICES 62
+
+static uint16_t att_db_index_storage[1000];
+static uint16_t max_handle;
+static att_connection_t att_connection;
+
+// 0000FF10-0000-1000-8000-00805F9B34FB
+static uint8_t service_uuid128[] = { 0x00, 0x00, 0xFF, 0x10, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5F, 0x9B, 0x34, 0xFB};
+static uint8_t characteristic_uuid128[] = { 0x00, 0x00, 0xFF, 0x11, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5F, 0x9B, 0x34, 0xFB};
+
+static uint16_t read_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size){
+    (void) con_handle;
+    uint8_t value[2];
+    little_endian_store_16(value, 0, attribute_handle);
+    return att_read_callback_handle_blob(value, sizeof(value), offset, buffer, buffer_size);
+}
+
+static int write_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size){
+    (void) con_handle;
+    (void) attribute_handle;
+    (void) transaction_mode;
+    (void) offset;
+    (void) buffer;
+    (void) buffer_size;
+    return 0;
+}
+
+// 8 attributes per service: service, 2 x characteristic + value, characteristic + value + CCC
+static void setup_db(void){
+    att_db_util_init();
+    uint8_t value[] = "value";
+    int i;
+    for (i = 0; i < NUM_SERVICES; i++){
+        if (i % 5 == 4){
+            service_uuid128[3] = (uint8_t) i;
+            att_db_util_add_service_uuid128(service_uuid128);
+        } else {
+            att_db_util_add_service_uuid16(0x1800 + i);
+        }
+        att_db_util_add_characteristic_uuid16(0x2a00 + i, ATT_PROPERTY_READ, ATT_SECURITY_NONE, ATT_SECURITY_NONE, value, i % 4 + 1);
+        characteristic_uuid128[3] = (uint8_t) i;
+        att_db_util_add_characteristic_uuid128(characteristic_uuid128, ATT_PROPERTY_READ | ATT_PROPERTY_WRITE | ATT_PROPERTY_DYNAMIC, ATT_SECURITY_NONE, ATT_SECURITY_NONE, NULL, 0);
+        max_handle = att_db_util_add_characteristic_uuid16(0x2b00 + (i % 3), ATT_PROPERTY_READ | ATT_PROPERTY_NOTIFY, ATT_SECURITY_NONE, ATT_SECURITY_NONE, value, 2) + 1;
+    }
+    att_set_db(att_db_util_get_address());
+    att_set_read_callback(&read_callback);
+    att_set_write_callback(&write_callback);
+}
+
+static uint16_t handle_request(const uint8_t * request, uint16_t request_len, uint8_t * response){
+    uint8_t request_buffer[30];
+    memcpy(request_buffer, request, request_len);
+    return att_handle_request(&att_connection, request_buffer, request_len, response);
+}
+
+// same response with and without index
+static void check_request(const uint8_t * request, uint16_t request_len){
+    uint8_t expected[ATT_DEFAULT_MTU];
+    uint8_t response[ATT_DEFAULT_MTU];
+    att_set_db_index(NULL, 0);
+    uint16_t expected_len = handle_request(request, request_len, expected);
+    att_set_db_index(att_db_index_storage, max_handle + 1);
+    uint16_t response_len = handle_request(request, request_len, response);
+    CHECK_EQUAL(expected_len, response_len);
+    MEMCMP_EQUAL(expected, response, expected_len);
+}
+
+static void check_range_request(uint8_t opcode, uint16_t start_handle, uint16_t end_handle, uint16_t uuid16){
+    uint8_t request[7];
+    request[0] = opcode;
+    little_endian_store_16(request, 1, start_handle);
+    little_endian_store_16(request, 3, end_handle);
+    little_endian_store_16(request, 5, uuid16);
+    check_request(request, opcode == ATT_FIND_INFORMATION_REQUEST ? 5 : 7);
+}
+
+TEST_GROUP(AttDbIndex){
+    void setup(void){
+        hci_dump_enable_log_level(HCI_DUMP_LOG_LEVEL_INFO, 0);
+        memset(&att_connection, 0, sizeof(att_connection));
+        att_connection.mtu = ATT_DEFAULT_MTU;
+        att_connection.max_mtu = ATT_DEFAULT_MTU;
+        setup_db();
+    }
+};
+
+TEST(AttDbIndex, IndexSize){
+    // index too small: falls back to linear search
+    uint8_t request[3];
+    request[0] = ATT_READ_REQUEST;
+    little_endian_store_16(request, 1, max_handle);
+    att_set_db_index(att_db_index_storage, max_handle);
+    uint8_t response[ATT_DEFAULT_MTU];
+    uint16_t response_len = handle_request(request, sizeof(request), response);
+    CHECK_EQUAL(ATT_READ_RESPONSE, response[0]);
+    CHECK_EQUAL(3, response_len);
+    CHECK(NUM_SERVICES * 8 <= max_handle);
+}
+
+TEST(AttDbIndex, ReadWrite){
+    uint16_t handle;
+    for (handle = 0; handle <= max_handle + 2; handle++){
+        uint8_t request[5];
+        request[0] = ATT_READ_REQUEST;
+        little_endian_store_16(request, 1, handle);
+        check_request(request, 3);
+        request[0] = ATT_READ_BLOB_REQUEST;
+        little_endian_store_16(request, 3, 1);
+        check_request(request, 5);
+        request[0] = ATT_WRITE_REQUEST;
+        little_endian_store_16(request, 3, 0x0001);
+        check_request(request, 5);
+    }
+}
+
+TEST(AttDbIndex, RangeRequests){
+    uint16_t start_handle;
+    for (start_handle = 0; start_handle <= max_handle + 2; start_handle += 3){
+        uint16_t end_handle = start_handle + 7;
+        check_range_request(ATT_FIND_INFORMATION_REQUEST, start_handle, end_handle, 0);
+        check_range_request(ATT_FIND_INFORMATION_REQUEST, start_handle, 0xffff, 0);
+        check_range_request(ATT_READ_BY_TYPE_REQUEST, start_handle, 0xffff, GATT_CHARACTERISTICS_UUID);
+        check_range_request(ATT_READ_BY_TYPE_REQUEST, start_handle, end_handle, 0x2b01);
+        check_range_request(ATT_READ_BY_GROUP_TYPE_REQUEST, start_handle, 0xffff, GATT_PRIMARY_SERVICE_UUID);
+        check_range_request(ATT_FIND_BY_TYPE_VALUE_REQUEST, start_handle, 0xffff, GATT_PRIMARY_SERVICE_UUID);
+    }
+}
+
+TEST(AttDbIndex, GattServerQueries){
+    uint16_t start_handle;
+    for (start_handle = 0; start_handle <= max_handle; start_handle += 5){
+        uint16_t uuid16 = 0x2b00 + (start_handle % 3);
+        att_set_db_index(NULL, 0);
+        uint16_t value_handle = gatt_server_get_value_handle_for_characteristic_with_uuid16(start_handle, 0xffff, uuid16);
+        uint16_t ccc_handle   = gatt_server_get_client_configuration_handle_for_characteristic_with_uuid16(start_handle, 0xffff, uuid16);
+        uint16_t handle128    = gatt_server_get_value_handle_for_characteristic_with_uuid128(start_handle, 0xffff, characteristic_uuid128);
+        att_set_db_index(att_db_index_storage, max_handle + 1);
+        CHECK_EQUAL(value_handle, gatt_server_get_value_handle_for_characteristic_with_uuid16(start_handle, 0xffff, uuid16));
+        CHECK_EQUAL(ccc_handle,   gatt_server_get_client_configuration_handle_for_characteristic_with_uuid16(start_handle, 0xffff, uuid16));
+        CHECK_EQUAL(handle128,    gatt_server_get_value_handle_for_characteristic_with_uuid128(start_handle, 0xffff, characteristic_uuid128));
+    }
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
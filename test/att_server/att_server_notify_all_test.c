@@ -0,0 +1,534 @@
+
+// *****************************************************************************
+//
+// ATT Server notify all test: notifications queued for all subscribed connections,
+// coalescing of updates, round robin over connections, dropped notifications on
+// disconnect and unsubscribe, and subscribers restored from persistent CCC tags
+//
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_config.h"
+#include "bluetooth.h"
+#include "btstack_defines.h"
+#include "btstack_linked_list.h"
+#include "btstack_run_loop.h"
+#include "btstack_tlv.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "ble/att_db.h"
+#include "ble/att_dispatch.h"
+#include "ble/att_server.h"
+#include "ble/le_device_db.h"
+#include "ble/sm.h"
+#include "l2cap.h"
+
+static const uint8_t profile_data[] = {
+    // ATT DB Version
+    1,
+    // 0x0001 PRIMARY_SERVICE-1234
+    0x0a, 0x00, 0x02, 0x00, 0x01, 0x00, 0x00, 0x28, 0x34, 0x12,
+    // 0x0002 CHARACTERISTIC-AA01-NOTIFY
+    0x0d, 0x00, 0x02, 0x00, 0x02, 0x00, 0x03, 0x28, 0x10, 0x03, 0x00, 0x01, 0xaa,
+    // 0x0003 VALUE-AA01-NOTIFY-DYNAMIC
+    0x08, 0x00, 0x00, 0x01, 0x03, 0x00, 0x01, 0xaa,
+    // 0x0004 CLIENT_CHARACTERISTIC_CONFIGURATION
+    0x0a, 0x00, 0x0e, 0x01, 0x04, 0x00, 0x02, 0x29, 0x00, 0x00,
+    // 0x0005 CHARACTERISTIC-AA02-NOTIFY
+    0x0d, 0x00, 0x02, 0x00, 0x05, 0x00, 0x03, 0x28, 0x10, 0x06, 0x00, 0x02, 0xaa,
+    // 0x0006 VALUE-AA02-NOTIFY-DYNAMIC
+    0x08, 0x00, 0x00, 0x01, 0x06, 0x00, 0x02, 0xaa,
+    // 0x0007 CHARACTERISTIC_USER_DESCRIPTION 'ab'
+    0x0a, 0x00, 0x02, 0x00, 0x07, 0x00, 0x01, 0x29, 0x61, 0x62,
+    // 0x0008 CLIENT_CHARACTERISTIC_CONFIGURATION
+    0x0a, 0x00, 0x0e, 0x01, 0x08, 0x00, 0x02, 0x29, 0x00, 0x00,
+    // 0x0009 CHARACTERISTIC-AA03-READ
+    0x0d, 0x00, 0x02, 0x00, 0x09, 0x00, 0x03, 0x28, 0x02, 0x0a, 0x00, 0x03, 0xaa,
+    // 0x000a VALUE-AA03-READ
+    0x08, 0x00, 0x02, 0x00, 0x0a, 0x00, 0x03, 0xaa,
+    // END
+    0x00, 0x00,
+};
+
+#define VALUE_HANDLE_1  0x0003
+#define CCC_HANDLE_1    0x0004
+#define VALUE_HANDLE_2  0x0006
+#define CCC_HANDLE_2    0x0008
+#define VALUE_HANDLE_3  0x000a
+
+#define MAX_CONNECTIONS 4
+#define MAX_SENT        32
+
+// same layout as in att_server.c
+typedef struct {
+    uint32_t seq_nr;
+    uint16_t att_handle;
+    uint8_t  value;
+    uint8_t  device_index;
+} persistent_ccc_entry_t;
+
+typedef struct {
+    hci_con_handle_t con_handle;
+    uint16_t         attribute_handle;
+    uint8_t          value[20];
+    uint16_t         value_len;
+} sent_notification_t;
+
+static btstack_packet_handler_t att_server_packet_handler;
+static btstack_packet_handler_t hci_event_handler;
+
+static btstack_linked_list_t connections;
+static hci_connection_t      hci_connections[MAX_CONNECTIONS];
+static int                   le_device_index[MAX_CONNECTIONS];
+
+static int                   can_send_now_requested;
+static int                   acl_slots;
+static uint8_t               outgoing_buffer[100];
+static sent_notification_t   sent[MAX_SENT];
+static int                   num_sent;
+
+// TLV with single persistent CCC tag
+static uint32_t              tlv_tag;
+static persistent_ccc_entry_t tlv_entry;
+
+// mocks
+
+void hci_add_event_handler(btstack_packet_callback_registration_t * callback_handler){
+    hci_event_handler = callback_handler->callback;
+}
+void sm_add_event_handler(btstack_packet_callback_registration_t * callback_handler){
+    UNUSED(callback_handler);
+}
+void hci_connections_get_iterator(btstack_linked_list_iterator_t *it){
+    btstack_linked_list_iterator_init(it, &connections);
+}
+hci_connection_t * hci_connection_for_handle(hci_con_handle_t con_handle){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &connections);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        if (connection->con_handle == con_handle) return connection;
+    }
+    return NULL;
+}
+int gap_authenticated(hci_con_handle_t con_handle){
+    UNUSED(con_handle);
+    return 0;
+}
+authorization_state_t gap_authorization_state(hci_con_handle_t con_handle){
+    UNUSED(con_handle);
+    return AUTHORIZATION_UNKNOWN;
+}
+int gap_encryption_key_size(hci_con_handle_t con_handle){
+    UNUSED(con_handle);
+    return 16;
+}
+int gap_reconnect_security_setup_active(hci_con_handle_t con_handle){
+    UNUSED(con_handle);
+    return 0;
+}
+int sm_le_device_index(hci_con_handle_t con_handle){
+    return le_device_index[con_handle - 0x40];
+}
+void sm_request_pairing(hci_con_handle_t con_handle){
+    UNUSED(con_handle);
+}
+int sm_cmac_ready(void){
+    return 1;
+}
+void sm_cmac_signed_write_start(const sm_key_t key, uint8_t opcode, uint16_t attribute_handle, uint16_t message_len, const uint8_t * message, uint32_t sign_counter, void (*done_handler)(uint8_t * hash)){
+    (void) key;
+    UNUSED(opcode);
+    UNUSED(attribute_handle);
+    UNUSED(message_len);
+    UNUSED(message);
+    UNUSED(sign_counter);
+    UNUSED(done_handler);
+}
+uint32_t le_device_db_remote_counter_get(int index){
+    UNUSED(index);
+    return 0;
+}
+void le_device_db_remote_counter_set(int index, uint32_t counter){
+    UNUSED(index);
+    UNUSED(counter);
+}
+void le_device_db_remote_csrk_get(int index, sm_key_t csrk){
+    UNUSED(index);
+    (void) csrk;
+}
+uint16_t l2cap_max_le_mtu(void){
+    return 100;
+}
+int l2cap_reserve_packet_buffer(void){
+    return 1;
+}
+void l2cap_release_packet_buffer(void){
+}
+uint8_t * l2cap_get_outgoing_buffer(void){
+    return outgoing_buffer;
+}
+int l2cap_send_prepared_connectionless(hci_con_handle_t con_handle, uint16_t cid, uint16_t len){
+    UNUSED(cid);
+    acl_slots--;
+    if (outgoing_buffer[0] != ATT_HANDLE_VALUE_NOTIFICATION) return 0;
+    sent_notification_t * notification = &sent[num_sent++];
+    notification->con_handle = con_handle;
+    notification->attribute_handle = little_endian_read_16(outgoing_buffer, 1);
+    notification->value_len = len - 3;
+    memcpy(notification->value, &outgoing_buffer[3], len - 3);
+    return 0;
+}
+void att_dispatch_register_server(btstack_packet_handler_t packet_handler){
+    att_server_packet_handler = packet_handler;
+}
+int att_dispatch_server_can_send_now(hci_con_handle_t con_handle){
+    UNUSED(con_handle);
+    return acl_slots > 0;
+}
+void att_dispatch_server_request_can_send_now_event(hci_con_handle_t con_handle){
+    UNUSED(con_handle);
+    can_send_now_requested = 1;
+}
+void att_dispatch_server_mtu_exchanged(hci_con_handle_t con_handle, uint16_t new_mtu){
+    UNUSED(con_handle);
+    UNUSED(new_mtu);
+}
+void btstack_run_loop_set_timer_handler(btstack_timer_source_t *ts, void (*process)(btstack_timer_source_t *_ts)){
+    UNUSED(ts);
+    UNUSED(process);
+}
+void btstack_run_loop_set_timer(btstack_timer_source_t *ts, uint32_t timeout_in_ms){
+    UNUSED(ts);
+    UNUSED(timeout_in_ms);
+}
+void btstack_run_loop_add_timer(btstack_timer_source_t *ts){
+    UNUSED(ts);
+}
+int btstack_run_loop_remove_timer(btstack_timer_source_t *ts){
+    UNUSED(ts);
+    return 0;
+}
+void * btstack_run_loop_get_timer_context(btstack_timer_source_t *ts){
+    UNUSED(ts);
+    return NULL;
+}
+
+static int tlv_get_tag(void * context, uint32_t tag, uint8_t * buffer, uint32_t buffer_size){
+    UNUSED(context);
+    if (tag != tlv_tag || buffer_size < sizeof(tlv_entry)) return 0;
+    memcpy(buffer, &tlv_entry, sizeof(tlv_entry));
+    return sizeof(tlv_entry);
+}
+static int tlv_store_tag(void * context, uint32_t tag, const uint8_t * data, uint32_t data_size){
+    UNUSED(context);
+    if (data_size != sizeof(tlv_entry)) return 1;
+    tlv_tag = tag;
+    memcpy(&tlv_entry, data, sizeof(tlv_entry));
+    return 0;
+}
+static void tlv_delete_tag(void * context, uint32_t tag){
+    UNUSED(context);
+    if (tag == tlv_tag){
+        tlv_tag = 0;
+    }
+}
+static const btstack_tlv_t tlv_impl = {
+    &tlv_get_tag,
+    &tlv_store_tag,
+    &tlv_delete_tag,
+};
+
+// helper
+
+static hci_con_handle_t connect(int index){
+    hci_con_handle_t con_handle = 0x40 + index;
+    hci_connection_t * connection = &hci_connections[index];
+    memset(connection, 0, sizeof(hci_connection_t));
+    connection->con_handle = con_handle;
+    btstack_linked_list_add_tail(&connections, (btstack_linked_item_t *) connection);
+    uint8_t event[] = { HCI_EVENT_LE_META, 0x13, HCI_SUBEVENT_LE_CONNECTION_COMPLETE, 0x00, 0, 0, 0x01, 0x00,
+        0x01, 0x02, 0x03, 0x04, 0x05, (uint8_t) index, 0x28, 0x00, 0x00, 0x00, 0xd0, 0x07, 0x05 };
+    little_endian_store_16(event, 4, con_handle);
+    (*hci_event_handler)(HCI_EVENT_PACKET, 0, event, sizeof(event));
+    return con_handle;
+}
+
+static void disconnect(hci_con_handle_t con_handle){
+    uint8_t event[] = { HCI_EVENT_DISCONNECTION_COMPLETE, 4, 0x00, 0, 0, 0x13 };
+    little_endian_store_16(event, 3, con_handle);
+    (*hci_event_handler)(HCI_EVENT_PACKET, 0, event, sizeof(event));
+    btstack_linked_list_remove(&connections, (btstack_linked_item_t *) hci_connection_for_handle(con_handle));
+}
+
+static void write_ccc(hci_con_handle_t con_handle, uint16_t ccc_handle, uint16_t value){
+    uint8_t pdu[] = { ATT_WRITE_COMMAND, 0, 0, 0, 0 };
+    little_endian_store_16(pdu, 1, ccc_handle);
+    little_endian_store_16(pdu, 3, value);
+    (*att_server_packet_handler)(ATT_DATA_PACKET, con_handle, pdu, sizeof(pdu));
+}
+
+// default number of slots
+#ifndef ATT_SERVER_NOTIFY_ALL_NUM_SLOTS
+static void encryption_enabled(hci_con_handle_t con_handle){
+    uint8_t event[] = { HCI_EVENT_ENCRYPTION_CHANGE, 4, 0x00, 0, 0, 0x01 };
+    little_endian_store_16(event, 3, con_handle);
+    (*hci_event_handler)(HCI_EVENT_PACKET, 0, event, sizeof(event));
+}
+
+// provide ACL slots and emit can send now while requested
+static void send_with_acl_slots(int num_slots){
+    acl_slots = num_slots;
+    while (can_send_now_requested && acl_slots > 0){
+        can_send_now_requested = 0;
+        uint8_t event[] = { L2CAP_EVENT_CAN_SEND_NOW, 0 };
+        (*att_server_packet_handler)(HCI_EVENT_PACKET, 0, event, sizeof(event));
+    }
+}
+
+static int count_sent(hci_con_handle_t con_handle, uint16_t attribute_handle){
+    int count = 0;
+    int i;
+    for (i=0;i<num_sent;i++){
+        if (sent[i].con_handle != con_handle) continue;
+        if (sent[i].attribute_handle != attribute_handle) continue;
+        count++;
+    }
+    return count;
+}
+
+TEST_GROUP(ATT_SERVER_NOTIFY_ALL){
+    att_server_notify_all_stats_t stats_start;
+    void setup(void){
+        memset(le_device_index, 0xff, sizeof(le_device_index));
+        tlv_tag = 0;
+        num_sent = 0;
+        acl_slots = 0;
+        can_send_now_requested = 0;
+        att_server_notify_all_get_stats(&stats_start);
+    }
+    void teardown(void){
+        while (connections){
+            disconnect(((hci_connection_t *) connections)->con_handle);
+        }
+    }
+    void check_stats(uint32_t queued, uint32_t sent, uint32_t coalesced, uint32_t dropped){
+        att_server_notify_all_stats_t stats;
+        att_server_notify_all_get_stats(&stats);
+        CHECK_EQUAL(queued,    stats.notifications_queued    - stats_start.notifications_queued);
+        CHECK_EQUAL(sent,      stats.notifications_sent      - stats_start.notifications_sent);
+        CHECK_EQUAL(coalesced, stats.notifications_coalesced - stats_start.notifications_coalesced);
+        CHECK_EQUAL(dropped,   stats.notifications_dropped   - stats_start.notifications_dropped);
+    }
+};
+
+TEST(ATT_SERVER_NOTIFY_ALL, NoSubscribers){
+    const uint8_t value[] = { 1, 2, 3 };
+    uint8_t long_value[ATT_DEFAULT_MTU];
+    memset(long_value, 0, sizeof(long_value));
+    connect(0);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, att_server_notify_all_subscribers(VALUE_HANDLE_1, value, sizeof(value)));
+    CHECK_EQUAL(ERROR_CODE_UNSUPPORTED_FEATURE_OR_PARAMETER_VALUE, att_server_notify_all_subscribers(VALUE_HANDLE_3, value, sizeof(value)));
+    CHECK_EQUAL(ERROR_CODE_UNSUPPORTED_FEATURE_OR_PARAMETER_VALUE, att_server_notify_all_subscribers(0x0100, value, sizeof(value)));
+    CHECK_EQUAL(ERROR_CODE_MEMORY_CAPACITY_EXCEEDED, att_server_notify_all_subscribers(VALUE_HANDLE_1, long_value, sizeof(long_value)));
+    send_with_acl_slots(10);
+    CHECK_EQUAL(0, num_sent);
+    check_stats(0, 0, 0, 0);
+}
+
+TEST(ATT_SERVER_NOTIFY_ALL, FanOut){
+    const uint8_t value_1[] = { 1, 2, 3 };
+    const uint8_t value_2[] = { 4, 5 };
+    hci_con_handle_t con_handle_a = connect(0);
+    hci_con_handle_t con_handle_b = connect(1);
+    hci_con_handle_t con_handle_c = connect(2);
+    write_ccc(con_handle_a, CCC_HANDLE_1, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION);
+    write_ccc(con_handle_c, CCC_HANDLE_1, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION);
+    write_ccc(con_handle_b, CCC_HANDLE_2, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION);
+
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, att_server_notify_all_subscribers(VALUE_HANDLE_1, value_1, sizeof(value_1)));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, att_server_notify_all_subscribers(VALUE_HANDLE_2, value_2, sizeof(value_2)));
+    CHECK_EQUAL(1, att_server_notify_all_get_queue_depth(con_handle_a));
+    CHECK_EQUAL(1, att_server_notify_all_get_queue_depth(con_handle_b));
+    CHECK_EQUAL(1, att_server_notify_all_get_queue_depth(con_handle_c));
+    CHECK(can_send_now_requested);
+
+    send_with_acl_slots(10);
+    CHECK_EQUAL(3, num_sent);
+    CHECK_EQUAL(1, count_sent(con_handle_a, VALUE_HANDLE_1));
+    CHECK_EQUAL(1, count_sent(con_handle_b, VALUE_HANDLE_2));
+    CHECK_EQUAL(1, count_sent(con_handle_c, VALUE_HANDLE_1));
+    int i;
+    for (i=0;i<num_sent;i++){
+        if (sent[i].attribute_handle == VALUE_HANDLE_1){
+            CHECK_EQUAL(sizeof(value_1), sent[i].value_len);
+            MEMCMP_EQUAL(value_1, sent[i].value, sizeof(value_1));
+        } else {
+            CHECK_EQUAL(sizeof(value_2), sent[i].value_len);
+            MEMCMP_EQUAL(value_2, sent[i].value, sizeof(value_2));
+        }
+    }
+    CHECK_EQUAL(0, att_server_notify_all_get_queue_depth(con_handle_a));
+    check_stats(3, 3, 0, 0);
+}
+
+TEST(ATT_SERVER_NOTIFY_ALL, LatestValueWins){
+    hci_con_handle_t con_handle = connect(0);
+    write_ccc(con_handle, CCC_HANDLE_1, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION);
+    uint8_t value;
+    for (value=0;value<5;value++){
+        CHECK_EQUAL(ERROR_CODE_SUCCESS, att_server_notify_all_subscribers(VALUE_HANDLE_1, &value, 1));
+    }
+    CHECK_EQUAL(1, att_server_notify_all_get_queue_depth(con_handle));
+    send_with_acl_slots(10);
+    CHECK_EQUAL(1, num_sent);
+    CHECK_EQUAL(4, sent[0].value[0]);
+    check_stats(1, 1, 4, 0);
+}
+
+TEST(ATT_SERVER_NOTIFY_ALL, RoundRobin){
+    hci_con_handle_t con_handles[MAX_CONNECTIONS];
+    int i;
+    for (i=0;i<MAX_CONNECTIONS;i++){
+        con_handles[i] = connect(i);
+        write_ccc(con_handles[i], CCC_HANDLE_1, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION);
+        write_ccc(con_handles[i], CCC_HANDLE_2, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION);
+    }
+    const uint8_t value[] = { 0x55 };
+    att_server_notify_all_subscribers(VALUE_HANDLE_1, value, sizeof(value));
+    att_server_notify_all_subscribers(VALUE_HANDLE_2, value, sizeof(value));
+
+    att_server_notify_all_stats_t stats;
+    att_server_notify_all_get_stats(&stats);
+    CHECK_EQUAL(2 * MAX_CONNECTIONS, stats.queue_depth);
+    CHECK(stats.max_queue_depth >= 2 * MAX_CONNECTIONS);
+
+    // single ACL slot per can send now: every connection gets its first notification before any gets the second
+    int round;
+    for (round=0;round<2*MAX_CONNECTIONS;round++){
+        send_with_acl_slots(1);
+    }
+    CHECK_EQUAL(2 * MAX_CONNECTIONS, num_sent);
+    for (i=0;i<MAX_CONNECTIONS;i++){
+        int j;
+        for (j=i+1;j<MAX_CONNECTIONS;j++){
+            CHECK(sent[i].con_handle != sent[j].con_handle);
+        }
+    }
+    for (i=0;i<MAX_CONNECTIONS;i++){
+        CHECK_EQUAL(1, count_sent(con_handles[i], VALUE_HANDLE_1));
+        CHECK_EQUAL(1, count_sent(con_handles[i], VALUE_HANDLE_2));
+    }
+    att_server_notify_all_get_stats(&stats);
+    CHECK_EQUAL(0, stats.queue_depth);
+    CHECK_FALSE(can_send_now_requested);
+}
+
+TEST(ATT_SERVER_NOTIFY_ALL, DroppedOnDisconnectAndUnsubscribe){
+    const uint8_t value[] = { 0x55 };
+    hci_con_handle_t con_handle_a = connect(0);
+    hci_con_handle_t con_handle_b = connect(1);
+    write_ccc(con_handle_a, CCC_HANDLE_1, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION);
+    write_ccc(con_handle_a, CCC_HANDLE_2, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION);
+    write_ccc(con_handle_b, CCC_HANDLE_1, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION);
+    att_server_notify_all_subscribers(VALUE_HANDLE_1, value, sizeof(value));
+    att_server_notify_all_subscribers(VALUE_HANDLE_2, value, sizeof(value));
+    CHECK_EQUAL(2, att_server_notify_all_get_queue_depth(con_handle_a));
+
+    disconnect(con_handle_a);
+    write_ccc(con_handle_b, CCC_HANDLE_1, 0);
+    CHECK_EQUAL(0, att_server_notify_all_get_queue_depth(con_handle_b));
+
+    att_server_notify_all_subscribers(VALUE_HANDLE_1, value, sizeof(value));
+    send_with_acl_slots(10);
+    CHECK_EQUAL(0, num_sent);
+    check_stats(3, 0, 0, 3);
+
+    att_server_notify_all_stats_t stats;
+    att_server_notify_all_get_stats(&stats);
+    CHECK_EQUAL(0, stats.queue_depth);
+}
+
+TEST(ATT_SERVER_NOTIFY_ALL, IndicationsOnlyNotSubscribed){
+    const uint8_t value[] = { 0x55 };
+    hci_con_handle_t con_handle = connect(0);
+    write_ccc(con_handle, CCC_HANDLE_1, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_INDICATION);
+    att_server_notify_all_subscribers(VALUE_HANDLE_1, value, sizeof(value));
+    send_with_acl_slots(10);
+    CHECK_EQUAL(0, num_sent);
+}
+
+TEST(ATT_SERVER_NOTIFY_ALL, RestoredFromPersistentCCC){
+    const uint8_t value[] = { 0x55 };
+    // bonded device with notifications enabled in previous connection
+    le_device_index[0] = 2;
+    tlv_tag = ('B' << 24) | ('T' << 16) | ('C' << 8) | 3;
+    tlv_entry.seq_nr = 1;
+    tlv_entry.att_handle = CCC_HANDLE_2;
+    tlv_entry.value = GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION;
+    tlv_entry.device_index = 2;
+
+    hci_con_handle_t con_handle = connect(0);
+    att_server_notify_all_subscribers(VALUE_HANDLE_2, value, sizeof(value));
+    CHECK_EQUAL(0, att_server_notify_all_get_queue_depth(con_handle));
+
+    encryption_enabled(con_handle);
+    att_server_notify_all_subscribers(VALUE_HANDLE_2, value, sizeof(value));
+    CHECK_EQUAL(1, att_server_notify_all_get_queue_depth(con_handle));
+    send_with_acl_slots(10);
+    CHECK_EQUAL(1, count_sent(con_handle, VALUE_HANDLE_2));
+}
+
+#elif ATT_SERVER_NOTIFY_ALL_NUM_SLOTS == 1
+TEST_GROUP(ATT_SERVER_NOTIFY_ALL_SINGLE_SLOT){
+    void setup(void){
+        memset(le_device_index, 0xff, sizeof(le_device_index));
+        tlv_tag = 0;
+        num_sent = 0;
+        acl_slots = 0;
+    }
+    void teardown(void){
+        while (connections){
+            disconnect(((hci_connection_t *) connections)->con_handle);
+        }
+    }
+};
+
+TEST(ATT_SERVER_NOTIFY_ALL_SINGLE_SLOT, SubscriptionRejected){
+    const uint8_t value[] = { 1, 2, 3 };
+    att_server_notify_all_stats_t stats_start;
+    att_server_notify_all_stats_t stats;
+    att_server_notify_all_get_stats(&stats_start);
+    hci_con_handle_t con_handle_a = connect(0);
+    hci_con_handle_t con_handle_b = connect(1);
+    write_ccc(con_handle_a, CCC_HANDLE_1, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION);
+    // only slot in use for CCC_HANDLE_1
+    write_ccc(con_handle_b, CCC_HANDLE_2, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION);
+    att_server_notify_all_get_stats(&stats);
+    CHECK_EQUAL(1, stats.subscriptions_rejected - stats_start.subscriptions_rejected);
+
+    att_server_notify_all_subscribers(VALUE_HANDLE_2, value, sizeof(value));
+    CHECK_EQUAL(0, att_server_notify_all_get_queue_depth(con_handle_b));
+
+    // slot gets free after unsubscribe
+    write_ccc(con_handle_a, CCC_HANDLE_1, 0);
+    write_ccc(con_handle_b, CCC_HANDLE_2, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION);
+    att_server_notify_all_subscribers(VALUE_HANDLE_2, value, sizeof(value));
+    CHECK_EQUAL(1, att_server_notify_all_get_queue_depth(con_handle_b));
+    att_server_notify_all_get_stats(&stats);
+    CHECK_EQUAL(1, stats.subscriptions_rejected - stats_start.subscriptions_rejected);
+}
+#endif
+
+int main (int argc, const char * argv[]){
+    btstack_tlv_set_instance(&tlv_impl, NULL);
+    att_server_init(profile_data, NULL, NULL);
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -35,109 +35,150 @@
  *
  */
 
-#include <stdio.h>
+/*
+ * Throughput of SBC encoder and decoder: frames per second for 4 and 8 subbands, 4 to 16 blocks,
+ * mono and joint stereo. Build with -DDISABLE_SBC_SSE2 to measure the C implementation of the filterbanks
+ */
+
 #include <math.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <portaudio.h>
+#include <time.h>
 
 #include "btstack_sbc.h"
-#include "avdtp.h"
-#include "avdtp_source.h"
-#include "btstack_stdin.h"
+#include "btstack_util.h"
+#include "hci_dump.h"
 
-#define NUM_CHANNELS        2
 #define SAMPLE_RATE         44100
-#define BYTES_PER_AUDIO_SAMPLE   (2*NUM_CHANNELS)
-#define LATENCY             300 // ms
+#define NUM_FRAMES          4000
+#define NUM_ROUNDS          5
 
 #ifndef M_PI
 #define M_PI  3.14159265
 #endif
 #define TABLE_SIZE_441HZ   100
 
+// channel mode: 0 = mono, 3 = joint stereo
 typedef struct {
-    int16_t source[TABLE_SIZE_441HZ];
-    int left_phase;
-    int right_phase;
-} paTestData;
+    int subbands;
+    int blocks;
+    int channel_mode;
+    int bitpool;
+} sbc_configuration_t;
 
-static uint8_t pcm_frame[2*8*16*2];
+static const sbc_configuration_t configurations[] = {
+    { 4,  4, 0, 18 }, { 4,  8, 0, 18 }, { 4, 12, 0, 18 }, { 4, 16, 0, 18 },
+    { 4,  4, 3, 35 }, { 4,  8, 3, 35 }, { 4, 12, 3, 35 }, { 4, 16, 3, 35 },
+    { 8,  4, 0, 31 }, { 8,  8, 0, 31 }, { 8, 12, 0, 31 }, { 8, 16, 0, 31 },
+    { 8,  4, 3, 53 }, { 8,  8, 3, 53 }, { 8, 12, 3, 53 }, { 8, 16, 3, 53 },
+};
 
-static paTestData sin_data;
+static int16_t sine_table[TABLE_SIZE_441HZ];
+static int16_t pcm_frames[NUM_FRAMES][16 * 8 * 2];
+static uint8_t sbc_frames[NUM_FRAMES][512];
+static uint16_t sbc_frame_len[NUM_FRAMES];
 
-static btstack_sbc_mode_t mode = SBC_MODE_STANDARD;
 static btstack_sbc_encoder_state_t sbc_encoder_state;
 static btstack_sbc_decoder_state_t sbc_decoder_state;
 
+static int num_samples_decoded;
+
 static void handle_pcm_data(int16_t * data, int num_samples, int num_channels, int sample_rate, void * context){
-    UNUSED(sample_rate);
-    UNUSED(context);
     UNUSED(data);
-    UNUSED(num_samples);
     UNUSED(num_channels);
+    UNUSED(sample_rate);
+    UNUSED(context);
+    num_samples_decoded += num_samples;
+}
+
+static double now_us(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
 }
 
-static void fill_sine_frame(void *userData, int num_samples_to_write){
-    paTestData *data = (paTestData*)userData;
-    int count = 0;
-    int offset = 0;
-    while (count < num_samples_to_write){
-        uint8_t write_data[BYTES_PER_AUDIO_SAMPLE];
-        *(int16_t*)&write_data[0] = data->source[data->left_phase];
-        *(int16_t*)&write_data[2] = data->source[data->right_phase];
-        
-        memcpy(pcm_frame+offset, write_data, BYTES_PER_AUDIO_SAMPLE);
-        offset += BYTES_PER_AUDIO_SAMPLE;
-        count++;
-
-        data->left_phase += 1;
-        if (data->left_phase >= TABLE_SIZE_441HZ){
-            data->left_phase -= TABLE_SIZE_441HZ;
+// 441 Hz on left channel, 882 Hz on right channel
+static void fill_sine_frames(int num_samples, int num_channels){
+    int frame;
+    int phase = 0;
+    for (frame = 0; frame < NUM_FRAMES; frame++){
+        int i;
+        for (i = 0; i < num_samples; i++){
+            pcm_frames[frame][i * num_channels] = sine_table[phase % TABLE_SIZE_441HZ];
+            if (num_channels == 2){
+                pcm_frames[frame][i * num_channels + 1] = sine_table[(2 * phase) % TABLE_SIZE_441HZ];
+            }
+            phase++;
         }
-        data->right_phase += 1; 
-        if (data->right_phase >= TABLE_SIZE_441HZ){
-            data->right_phase -= TABLE_SIZE_441HZ;
-        } 
     }
 }
 
-int btstack_main(int argc, const char * argv[]);
-int btstack_main(int argc, const char * argv[]){
+static void benchmark(const sbc_configuration_t * configuration){
+    int num_channels = configuration->channel_mode == 0 ? 1 : 2;
+    int frame;
+
+    fill_sine_frames(configuration->blocks * configuration->subbands, num_channels);
+
+    // best of several rounds
+    double encoding_time = 0;
+    double decoding_time = 0;
+    int round;
+    for (round = 0; round < NUM_ROUNDS; round++){
+        btstack_sbc_encoder_init(&sbc_encoder_state, SBC_MODE_STANDARD, configuration->blocks, configuration->subbands,
+            0, SAMPLE_RATE, configuration->bitpool, configuration->channel_mode);
+        double start = now_us();
+        for (frame = 0; frame < NUM_FRAMES; frame++){
+            btstack_sbc_encoder_process_data(&sbc_encoder_state, pcm_frames[frame]);
+            sbc_frame_len[frame] = btstack_sbc_encoder_sbc_buffer_length(&sbc_encoder_state);
+            memcpy(sbc_frames[frame], btstack_sbc_encoder_sbc_buffer(&sbc_encoder_state), sbc_frame_len[frame]);
+        }
+        double duration = now_us() - start;
+        if (round == 0 || duration < encoding_time){
+            encoding_time = duration;
+        }
+
+        num_samples_decoded = 0;
+        btstack_sbc_decoder_init(&sbc_decoder_state, SBC_MODE_STANDARD, &handle_pcm_data, NULL);
+        start = now_us();
+        for (frame = 0; frame < NUM_FRAMES; frame++){
+            btstack_sbc_decoder_process_data(&sbc_decoder_state, 0, sbc_frames[frame], sbc_frame_len[frame]);
+        }
+        duration = now_us() - start;
+        if (round == 0 || duration < decoding_time){
+            decoding_time = duration;
+        }
+    }
+
+    printf("%u subbands, %2u blocks, %-12s encode %8.0f frames/s, decode %8.0f frames/s\n",
+        configuration->subbands, configuration->blocks, configuration->channel_mode == 0 ? "mono:" : "joint stereo:",
+        NUM_FRAMES * 1000000.0 / encoding_time, NUM_FRAMES * 1000000.0 / decoding_time);
+
+    if (num_samples_decoded != NUM_FRAMES * configuration->blocks * configuration->subbands){
+        printf("error: %u of %u samples decoded\n", num_samples_decoded, NUM_FRAMES * configuration->blocks * configuration->subbands);
+        exit(1);
+    }
+}
+
+int main(int argc, const char * argv[]){
     (void) argc;
     (void) argv;
-    btstack_sbc_encoder_init(&sbc_encoder_state, SBC_MODE_STANDARD, 16, 8, 2, 44100, 53);
-                    
+    hci_dump_enable_log_level(HCI_DUMP_LOG_LEVEL_INFO, 0);
+
     /* initialise sinusoidal wavetable */
     int i;
-    for (i=0; i<TABLE_SIZE_441HZ; i++){ 
-        sin_data.source[i] = sin(((double)i/(double)TABLE_SIZE_441HZ) * M_PI * 2.)*32767;
+    for (i=0; i<TABLE_SIZE_441HZ; i++){
+        sine_table[i] = sin(((double)i/(double)TABLE_SIZE_441HZ) * M_PI * 2.)*32767;
     }
-    sin_data.left_phase = sin_data.right_phase = 0;
-    
-    btstack_sbc_decoder_init(&sbc_decoder_state, mode, handle_pcm_data, NULL);
-    int num_frames = 10000;
-    uint32_t timestamp_start;
-    uint32_t encoding_time = 0;
-    uint32_t decoding_time = 0;
-    
-    timestamp_start = btstack_run_loop_get_time_ms();
-    for (i=0; i<num_frames; i++){
-        fill_sine_frame(&sin_data, 128);
-        btstack_sbc_encoder_process_data((int16_t *) pcm_frame);
-    }
-    encoding_time = btstack_run_loop_get_time_ms() - timestamp_start;
 
-    timestamp_start = btstack_run_loop_get_time_ms();
-    for (i=0; i<num_frames; i++){
-        fill_sine_frame(&sin_data, 128);
-        btstack_sbc_encoder_process_data((int16_t *) pcm_frame);
-        btstack_sbc_decoder_process_data(&sbc_decoder_state, 0, btstack_sbc_encoder_sbc_buffer(), btstack_sbc_encoder_sbc_buffer_length());
+#if defined(__SSE2__) && !defined(DISABLE_SBC_SSE2)
+    printf("SBC filterbanks with SSE2, best of %u rounds with %u frames per configuration\n", NUM_ROUNDS, NUM_FRAMES);
+#else
+    printf("SBC filterbanks in C, best of %u rounds with %u frames per configuration\n", NUM_ROUNDS, NUM_FRAMES);
+#endif
+    for (i = 0; i < (int) (sizeof(configurations) / sizeof(sbc_configuration_t)); i++){
+        benchmark(&configurations[i]);
     }
-    decoding_time =  btstack_run_loop_get_time_ms() - timestamp_start - encoding_time;
-
-    printf("%d frames encoded in %dms\n", num_frames, encoding_time);
-    printf("%d frames decoded in %dms\n", num_frames, decoding_time);
-    
-    exit(0);
+    return 0;
 }
@@ -49,7 +49,11 @@ TEST_GROUP(RemoteDeviceDB){
         sprintf((char*)link_key, "%d", 100);
     }
     
-    void teardown(void){}
+    void teardown(void){
+        btstack_link_key_db_memory_instance()->delete_link_key(addr1);
+        btstack_link_key_db_memory_instance()->delete_link_key(addr2);
+        btstack_link_key_db_memory_instance()->delete_link_key(addr3);
+    }
 };
 
 TEST(RemoteDeviceDB, MemoryPool){
@@ -114,6 +118,28 @@ TEST(RemoteDeviceDB, SortByLastUsedKey){
     STRCMP_EQUAL((char*)item->link_key, "20"); 
 }
 
+TEST(RemoteDeviceDB, DeleteAfterReplacement){
+    sprintf((char*)link_key, "%d", 10);
+	btstack_link_key_db_memory_instance()->put_link_key(addr1, link_key, link_key_type);
+    sprintf((char*)link_key, "%d", 20);
+	btstack_link_key_db_memory_instance()->put_link_key(addr2, link_key, link_key_type);
+    sprintf((char*)link_key, "%d", 30);
+	btstack_link_key_db_memory_instance()->put_link_key(addr3, link_key, link_key_type);
+	btstack_link_key_db_memory_instance()->delete_link_key(addr2);
+
+    CHECK(!btstack_link_key_db_memory_instance()->get_link_key(addr1, link_key, &link_key_type));
+    CHECK(!btstack_link_key_db_memory_instance()->get_link_key(addr2, link_key, &link_key_type));
+    CHECK(btstack_link_key_db_memory_instance()->get_link_key(addr3, link_key, &link_key_type));
+    STRCMP_EQUAL((char*)link_key, "30");
+
+    sprintf((char*)link_key, "%d", 40);
+	btstack_link_key_db_memory_instance()->put_link_key(addr1, link_key, link_key_type);
+    CHECK(btstack_link_key_db_memory_instance()->get_link_key(addr3, link_key, &link_key_type));
+    STRCMP_EQUAL((char*)link_key, "30");
+    CHECK(btstack_link_key_db_memory_instance()->get_link_key(addr1, link_key, &link_key_type));
+    STRCMP_EQUAL((char*)link_key, "40");
+}
+
 int main (int argc, const char * argv[]){
     return CommandLineTestRunner::RunAllTests(argc, argv);
 }
\ No newline at end of file
@@ -0,0 +1,112 @@
+/*
+ * Benchmark: btstack_crypto AES128, CMAC, and CCM operations via HCI LE Encrypt with mock controller
+ * or with software AES128 engine, depending on configuration
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "btstack_crypto.h"
+#include "btstack_util.h"
+#include "hci_dump.h"
+
+#define ROUNDS 20000
+
+int mock_get_hci_le_encrypt_count(void);
+
+#if defined(ENABLE_SOFTWARE_AES128) && defined(DISABLE_AES_NI)
+static const char * engine_name = "software AES128 (portable)";
+#elif defined(ENABLE_SOFTWARE_AES128)
+static const char * engine_name = "software AES128";
+#else
+static const char * engine_name = "HCI LE Encrypt (mock controller)";
+#endif
+
+static int callbacks;
+
+static uint8_t key[16];
+static uint8_t nonce[13];
+static uint8_t message[65];
+static uint8_t output[65];
+static uint8_t hash[16];
+
+static void crypto_done(void * arg){
+    (void) arg;
+    callbacks++;
+}
+
+static double now_us(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+static void report(const char * name, double start, int hci_le_encrypt_start){
+    double duration = now_us() - start;
+    int round_trips = mock_get_hci_le_encrypt_count() - hci_le_encrypt_start;
+    printf("  %-28s %8.3f us, %5.1f HCI round trips per operation\n", name, duration / ROUNDS, (double) round_trips / ROUNDS);
+}
+
+static void benchmark_aes128(void){
+    btstack_crypto_aes128_t request;
+    int hci_le_encrypt_start = mock_get_hci_le_encrypt_count();
+    double start = now_us();
+    int i;
+    for (i = 0; i < ROUNDS; i++){
+        message[0] = (uint8_t) i;
+        btstack_crypto_aes128_encrypt(&request, key, message, output, &crypto_done, NULL);
+    }
+    report("AES128:", start, hci_le_encrypt_start);
+}
+
+// 65 bytes, same as LE Secure Connections f4 and f6
+static void benchmark_cmac(void){
+    btstack_crypto_aes128_cmac_t request;
+    int hci_le_encrypt_start = mock_get_hci_le_encrypt_count();
+    double start = now_us();
+    int i;
+    for (i = 0; i < ROUNDS; i++){
+        message[0] = (uint8_t) i;
+        btstack_crypto_aes128_cmac_message(&request, key, 65, message, hash, &crypto_done, NULL);
+    }
+    report("CMAC (65 bytes):", start, hci_le_encrypt_start);
+}
+
+// 18 bytes with 4 byte MIC, same as Mesh Network PDU
+static void benchmark_ccm(void){
+    btstack_crypto_ccm_t request;
+    int hci_le_encrypt_start = mock_get_hci_le_encrypt_count();
+    double start = now_us();
+    int i;
+    for (i = 0; i < ROUNDS; i++){
+        message[0] = (uint8_t) i;
+        btstack_crypo_ccm_init(&request, key, nonce, 18, 4);
+        btstack_crypto_ccm_encrypt_block(&request, 18, message, output, &crypto_done, NULL);
+    }
+    report("CCM (18 bytes, 4 byte MIC):", start, hci_le_encrypt_start);
+}
+
+int main(int argc, const char * argv[]){
+    (void) argc;
+    (void) argv;
+    int i;
+    for (i = 0; i < 16; i++){
+        key[i] = (uint8_t) (i * 7);
+    }
+    memset(nonce, 0x55, sizeof(nonce));
+    memset(message, 0xaa, sizeof(message));
+
+    hci_dump_enable_log_level(HCI_DUMP_LOG_LEVEL_INFO, 0);
+    btstack_crypto_init();
+    printf("%s:\n", engine_name);
+    benchmark_aes128();
+    benchmark_cmac();
+    benchmark_ccm();
+    if (callbacks != 3 * ROUNDS){
+        printf("error: %u of %u operations completed\n", callbacks, 3 * ROUNDS);
+        return 1;
+    }
+    return 0;
+}
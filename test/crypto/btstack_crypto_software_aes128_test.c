@@ -0,0 +1,201 @@
+
+// *****************************************************************************
+//
+// test software AES128 engine in btstack_crypto: AES128, CMAC, and CCM complete without HCI LE Encrypt
+//
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_crypto.h"
+#include "btstack_util.h"
+#include "hci_dump.h"
+#include "aes_cmac.h"
+
+int mock_get_hci_le_encrypt_count(void);
+
+static int callbacks;
+
+static void crypto_done(void * arg){
+    (void) arg;
+    callbacks++;
+}
+
+static void parse_hex(uint8_t * buffer, const char * hex_string){
+    while (*hex_string){
+        if (*hex_string == ' '){
+            hex_string++;
+            continue;
+        }
+        int high_nibble = nibble_for_char(*hex_string++);
+        int low_nibble  = nibble_for_char(*hex_string++);
+        *buffer++ = (high_nibble << 4) | low_nibble;
+    }
+}
+
+static void check_aes128(const char * key_string, const char * plaintext_string, const char * ciphertext_string){
+    uint8_t key[16];
+    uint8_t plaintext[16];
+    uint8_t expected[16];
+    uint8_t ciphertext[16];
+    parse_hex(key, key_string);
+    parse_hex(plaintext, plaintext_string);
+    parse_hex(expected, ciphertext_string);
+    btstack_crypto_aes128_t request;
+    btstack_crypto_aes128_encrypt(&request, key, plaintext, ciphertext, &crypto_done, NULL);
+    MEMCMP_EQUAL(expected, ciphertext, 16);
+}
+
+// RFC 4493 Test Vectors
+static const char * cmac_key     = "2b7e151628aed2a6abf7158809cf4f3c";
+static const char * cmac_message = "6bc1bee22e409f96e93d7e117393172a ae2d8a571e03ac9c9eb76fac45af8e51 30c81c46a35ce411e5fbc1191a0a52ef f69f2445df4f9b17ad2b417be66c3710";
+static uint8_t cmac_message_bytes[64];
+
+static uint8_t cmac_get_byte(uint16_t pos){
+    return cmac_message_bytes[pos];
+}
+
+static void check_cmac(uint16_t len, const char * hash_string){
+    uint8_t key[16];
+    uint8_t expected[16];
+    uint8_t hash[16];
+    parse_hex(key, cmac_key);
+    parse_hex(cmac_message_bytes, cmac_message);
+    parse_hex(expected, hash_string);
+    btstack_crypto_aes128_cmac_t request;
+    btstack_crypto_aes128_cmac_message(&request, key, len, cmac_message_bytes, hash, &crypto_done, NULL);
+    MEMCMP_EQUAL(expected, hash, 16);
+    memset(hash, 0, sizeof(hash));
+    btstack_crypto_aes128_cmac_generator(&request, key, len, &cmac_get_byte, hash, &crypto_done, NULL);
+    MEMCMP_EQUAL(expected, hash, 16);
+}
+
+// Mesh Profile Sample Data, Message #24: Network PDU encryption
+static uint8_t ccm_key[16];
+static uint8_t ccm_nonce[13];
+static uint8_t ccm_plaintext[18];
+static uint8_t ccm_ciphertext[18];
+static uint8_t ccm_net_mic[4];
+
+static void ccm_setup(void){
+    parse_hex(ccm_key, "0953fa93e7caac9638f58820220a398e");
+    parse_hex(ccm_nonce, "000307080d1234000012345677");
+    parse_hex(ccm_plaintext, "9736e6a03401de1547118463123e5f6a17b9");
+    parse_hex(ccm_ciphertext, "94e998b4081f5a7308ce3edbb3b06cdecd02");
+    parse_hex(ccm_net_mic, "8e307f1c");
+}
+
+// queue CMAC from AES128 callback
+static btstack_crypto_aes128_cmac_t chained_cmac_request;
+static uint8_t chained_hash[16];
+static uint8_t chained_key[16];
+
+static void chained_aes128_done(void * arg){
+    (void) arg;
+    callbacks++;
+    btstack_crypto_aes128_cmac_message(&chained_cmac_request, chained_key, 0, NULL, chained_hash, &crypto_done, NULL);
+}
+
+TEST_GROUP(SoftwareAES128){
+    void setup(void){
+        callbacks = 0;
+        hci_dump_enable_log_level(HCI_DUMP_LOG_LEVEL_INFO, 0);
+        btstack_crypto_init();
+    }
+    void teardown(void){
+        CHECK_EQUAL(0, mock_get_hci_le_encrypt_count());
+    }
+};
+
+TEST(SoftwareAES128, AES128){
+    // FIPS-197, Appendix B and C.1
+    check_aes128("2b7e151628aed2a6abf7158809cf4f3c", "3243f6a8885a308d313198a2e0370734", "3925841d02dc09fbdc118597196a0b32");
+    check_aes128("000102030405060708090a0b0c0d0e0f", "00112233445566778899aabbccddeeff", "69c4e0d86a7b0430d8cdb78070b4c55a");
+    CHECK_EQUAL(2, callbacks);
+}
+
+TEST(SoftwareAES128, AES128Random){
+    // compare with reference implementation, alternate keys to invalidate cached key schedule
+    int i;
+    srand(1);
+    uint8_t keys[2][16];
+    for (i = 0; i < 1000; i++){
+        uint8_t plaintext[16];
+        uint8_t expected[16];
+        uint8_t ciphertext[16];
+        uint8_t * key = keys[i & 1];
+        int j;
+        for (j = 0; j < 16; j++){
+            if ((i % 10) < 2){
+                key[j] = (uint8_t) rand();
+            }
+            plaintext[j] = (uint8_t) rand();
+        }
+        aes128_calc_cyphertext(key, plaintext, expected);
+        btstack_crypto_aes128_t request;
+        btstack_crypto_aes128_encrypt(&request, key, plaintext, ciphertext, &crypto_done, NULL);
+        MEMCMP_EQUAL(expected, ciphertext, 16);
+    }
+    CHECK_EQUAL(1000, callbacks);
+}
+
+TEST(SoftwareAES128, CMAC){
+    check_cmac( 0, "bb1d6929e95937287fa37d129b756746");
+    check_cmac(16, "070a16b46b4d4144f79bdd9dd04a287c");
+    check_cmac(40, "dfa66747de9ae63030ca32611497c827");
+    check_cmac(64, "51f0bebf7e3b9d92fc49741779363cfe");
+    CHECK_EQUAL(8, callbacks);
+}
+
+TEST(SoftwareAES128, CCMEncrypt){
+    ccm_setup();
+    uint8_t ciphertext[18];
+    uint8_t net_mic[4];
+    btstack_crypto_ccm_t request;
+    btstack_crypo_ccm_init(&request, ccm_key, ccm_nonce, sizeof(ccm_plaintext), 4);
+    btstack_crypto_ccm_encrypt_block(&request, sizeof(ccm_plaintext), ccm_plaintext, ciphertext, &crypto_done, NULL);
+    CHECK_EQUAL(1, callbacks);
+    btstack_crypo_ccm_get_authentication_value(&request, net_mic);
+    MEMCMP_EQUAL(ccm_ciphertext, ciphertext, sizeof(ccm_ciphertext));
+    MEMCMP_EQUAL(ccm_net_mic, net_mic, sizeof(ccm_net_mic));
+}
+
+TEST(SoftwareAES128, CCMDecryptInBlocks){
+    ccm_setup();
+    uint8_t plaintext[18];
+    uint8_t net_mic[4];
+    btstack_crypto_ccm_t request;
+    btstack_crypo_ccm_init(&request, ccm_key, ccm_nonce, sizeof(ccm_ciphertext), 4);
+    btstack_crypto_ccm_decrypt_block(&request, 16, ccm_ciphertext, plaintext, &crypto_done, NULL);
+    btstack_crypto_ccm_decrypt_block(&request, 2, &ccm_ciphertext[16], &plaintext[16], &crypto_done, NULL);
+    CHECK_EQUAL(2, callbacks);
+    btstack_crypo_ccm_get_authentication_value(&request, net_mic);
+    MEMCMP_EQUAL(ccm_plaintext, plaintext, sizeof(ccm_plaintext));
+    MEMCMP_EQUAL(ccm_net_mic, net_mic, sizeof(ccm_net_mic));
+}
+
+TEST(SoftwareAES128, OperationFromCallback){
+    uint8_t key[16];
+    uint8_t plaintext[16];
+    uint8_t ciphertext[16];
+    uint8_t expected[16];
+    memset(key, 0, sizeof(key));
+    memset(plaintext, 0, sizeof(plaintext));
+    memset(chained_key, 0, sizeof(chained_key));
+    btstack_crypto_aes128_t request;
+    btstack_crypto_aes128_encrypt(&request, key, plaintext, ciphertext, &chained_aes128_done, NULL);
+    // CMAC queued by callback is done before btstack_crypto_aes128_encrypt returns
+    CHECK_EQUAL(2, callbacks);
+    aes_cmac(expected, chained_key, NULL, 0);
+    MEMCMP_EQUAL(expected, chained_hash, 16);
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -9,6 +9,12 @@ static uint8_t packet_buffer[256];
 static uint16_t packet_buffer_len;
 
 static uint8_t aes128_cyphertext[16];
+static int hci_le_encrypt_count;
+
+int mock_get_hci_le_encrypt_count(void){
+	return hci_le_encrypt_count;
+}
+
 void hci_add_event_handler(btstack_packet_callback_registration_t * callback_handler){
 	btstack_linked_list_add(&event_packet_handlers, (btstack_linked_item_t *) callback_handler);
 }
@@ -49,6 +55,7 @@ int hci_send_cmd(const hci_cmd_t *cmd, ...){
 	// dump_packet(HCI_COMMAND_DATA_PACKET, packet_buffer, len);
 	packet_buffer_len = len;
 	if (cmd->opcode ==  hci_le_encrypt.opcode){
+		hci_le_encrypt_count++;
 	    uint8_t * key_flipped = &packet_buffer[3];
 	    uint8_t key[16];
 		reverse_128(key_flipped, key);
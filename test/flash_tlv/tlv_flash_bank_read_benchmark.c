@@ -0,0 +1,177 @@
+/*
+ * Benchmark: flash reads of btstack_tlv_flash_bank for init, lookups, and updates with bonding information
+ * for 16 Classic and 16 LE devices and 32 GATT Server CCC values. Build with -DENABLE_TLV_FLASH_BANK_INDEX
+ * to use the RAM index
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "btstack_tlv.h"
+#include "btstack_tlv_flash_bank.h"
+#include "btstack_util.h"
+#include "hal_flash_bank.h"
+#include "hal_flash_bank_memory.h"
+#include "hci_dump.h"
+
+#define BANK_SIZE        4096
+#define NUM_LINK_KEYS    16
+#define NUM_LE_DEVICES   16
+#define NUM_CCC          32
+#define NUM_TAGS         (NUM_LINK_KEYS + NUM_LE_DEVICES + NUM_CCC)
+#define LOOKUP_ROUNDS    10
+#define UPDATE_ROUNDS    20
+
+static uint8_t hal_flash_bank_memory_storage[2 * BANK_SIZE];
+static hal_flash_bank_memory_t hal_flash_bank_memory_context;
+static const hal_flash_bank_t * hal_flash_bank_memory_impl;
+
+static btstack_tlv_flash_bank_t btstack_tlv_flash_bank_context;
+static const btstack_tlv_t * btstack_tlv_impl;
+
+static uint32_t num_reads;
+static uint32_t num_bytes_read;
+
+// hal_flash_bank that counts reads
+
+static uint32_t counting_get_size(void * context){
+    return hal_flash_bank_memory_impl->get_size(context);
+}
+
+static uint32_t counting_get_alignment(void * context){
+    return hal_flash_bank_memory_impl->get_alignment(context);
+}
+
+static void counting_erase(void * context, int bank){
+    hal_flash_bank_memory_impl->erase(context, bank);
+}
+
+static void counting_read(void * context, int bank, uint32_t offset, uint8_t * buffer, uint32_t size){
+    num_reads++;
+    num_bytes_read += size;
+    hal_flash_bank_memory_impl->read(context, bank, offset, buffer, size);
+}
+
+static void counting_write(void * context, int bank, uint32_t offset, const uint8_t * data, uint32_t size){
+    hal_flash_bank_memory_impl->write(context, bank, offset, data, size);
+}
+
+static const hal_flash_bank_t hal_flash_bank_counting = {
+    &counting_get_size,
+    &counting_get_alignment,
+    &counting_erase,
+    &counting_read,
+    &counting_write,
+};
+
+static uint32_t tags[NUM_TAGS];
+static uint32_t sizes[NUM_TAGS];
+
+static void setup_tags(void){
+    int i;
+    int pos = 0;
+    // link key: tag 'BTLx', link key + type
+    for (i=0;i<NUM_LINK_KEYS;i++){
+        tags[pos] = ('B' << 24) | ('T' << 16) | ('L' << 8) | i;
+        sizes[pos++] = 17;
+    }
+    // le device db: tag 'BTDx', addr, keys, counter
+    for (i=0;i<NUM_LE_DEVICES;i++){
+        tags[pos] = ('B' << 24) | ('T' << 16) | ('D' << 8) | i;
+        sizes[pos++] = 60;
+    }
+    // ccc: tag 'BTCx', addr + handle + value
+    for (i=0;i<NUM_CCC;i++){
+        tags[pos] = ('B' << 24) | ('T' << 16) | ('C' << 8) | i;
+        sizes[pos++] = 12;
+    }
+}
+
+static void store(int index, int round){
+    uint8_t value[64];
+    memset(value, round, sizeof(value));
+    btstack_tlv_impl->store_tag(&btstack_tlv_flash_bank_context, tags[index], value, sizes[index]);
+}
+
+static void report(const char * name, uint32_t reads_start, uint32_t bytes_start, int operations){
+    printf("  %-24s %8.1f reads, %8.1f bytes per operation\n", name,
+        (double) (num_reads - reads_start) / operations, (double) (num_bytes_read - bytes_start) / operations);
+}
+
+int main (int argc, const char * argv[]){
+    (void) argc;
+    (void) argv;
+    hci_dump_enable_log_level(HCI_DUMP_LOG_LEVEL_INFO, 0);
+
+#ifdef ENABLE_TLV_FLASH_BANK_INDEX
+    printf("TLV Flash Bank with RAM index for %u tags, %u tags stored\n", TLV_FLASH_BANK_INDEX_SIZE, NUM_TAGS);
+#else
+    printf("TLV Flash Bank, %u tags stored\n", NUM_TAGS);
+#endif
+
+    setup_tags();
+    hal_flash_bank_memory_impl = hal_flash_bank_memory_init_instance(&hal_flash_bank_memory_context, hal_flash_bank_memory_storage, sizeof(hal_flash_bank_memory_storage));
+    btstack_tlv_impl = btstack_tlv_flash_bank_init_instance(&btstack_tlv_flash_bank_context, &hal_flash_bank_counting, &hal_flash_bank_memory_context);
+
+    int i;
+    int round;
+    for (i=0;i<NUM_TAGS;i++){
+        store(i, 0);
+    }
+
+    uint32_t reads_start = num_reads;
+    uint32_t bytes_start = num_bytes_read;
+    btstack_tlv_impl = btstack_tlv_flash_bank_init_instance(&btstack_tlv_flash_bank_context, &hal_flash_bank_counting, &hal_flash_bank_memory_context);
+    report("init", reads_start, bytes_start, 1);
+
+    // lookups, e.g. link key request, reconnect, CCC restore
+    int errors = 0;
+    reads_start = num_reads;
+    bytes_start = num_bytes_read;
+    for (round=0;round<LOOKUP_ROUNDS;round++){
+        for (i=0;i<NUM_TAGS;i++){
+            uint8_t value[64];
+            if ((uint32_t) btstack_tlv_impl->get_tag(&btstack_tlv_flash_bank_context, tags[i], value, sizeof(value)) != sizes[i]){
+                errors++;
+            }
+        }
+    }
+    report("get_tag", reads_start, bytes_start, LOOKUP_ROUNDS * NUM_TAGS);
+
+    reads_start = num_reads;
+    bytes_start = num_bytes_read;
+    for (round=0;round<LOOKUP_ROUNDS;round++){
+        uint8_t value[64];
+        if (btstack_tlv_impl->get_tag(&btstack_tlv_flash_bank_context, 0x12345678, value, sizeof(value)) != 0){
+            errors++;
+        }
+    }
+    report("get_tag, unknown tag", reads_start, bytes_start, LOOKUP_ROUNDS);
+
+    // updates, e.g. LE signing counter and CCC writes, including migration to other bank
+    reads_start = num_reads;
+    bytes_start = num_bytes_read;
+    for (round=1;round<=UPDATE_ROUNDS;round++){
+        for (i=NUM_LINK_KEYS;i<NUM_TAGS;i++){
+            store(i, round);
+        }
+    }
+    report("store_tag", reads_start, bytes_start, UPDATE_ROUNDS * (NUM_TAGS - NUM_LINK_KEYS));
+
+    // verify
+    for (i=0;i<NUM_TAGS;i++){
+        uint8_t value[64];
+        int expected = i < NUM_LINK_KEYS ? 0 : UPDATE_ROUNDS;
+        int size = btstack_tlv_impl->get_tag(&btstack_tlv_flash_bank_context, tags[i], value, sizeof(value));
+        if ((uint32_t) size != sizes[i] || value[0] != expected){
+            errors++;
+        }
+    }
+
+    if (errors){
+        printf("FAILED: %u errors\n", errors);
+        return 1;
+    }
+    return 0;
+}
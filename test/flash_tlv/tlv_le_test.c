@@ -116,6 +116,27 @@ TEST(LE_DEVICE_DB, AddOTwoRemoveOneAddOne){
     CHECK_EQUAL_ARRAY(addr_cc, addr, 6);
 }
 
+TEST(LE_DEVICE_DB, AddExistingAfterScan){
+    int index_aa = le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_aa, sm_key_aa);
+    int index_bb = le_device_db_add(BD_ADDR_TYPE_LE_RANDOM, addr_bb, sm_key_bb);
+    // rescan
+    le_device_db_tlv_configure(btstack_tlv_impl, &btstack_tlv_context);
+    CHECK_EQUAL(2, le_device_db_count());
+    // remove first, each flash bank only has room for two entries
+    le_device_db_remove(index_aa);
+    CHECK_EQUAL(index_bb, le_device_db_add(BD_ADDR_TYPE_LE_RANDOM, addr_bb, sm_key_cc));
+    CHECK_EQUAL(1, le_device_db_count());
+    // same address with other type is new entry
+    le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_bb, sm_key_aa);
+    CHECK_EQUAL(2, le_device_db_count());
+    bd_addr_t addr;
+    sm_key_t sm_key;
+    int addr_type;
+    le_device_db_info(index_bb, &addr_type, addr, sm_key);
+    CHECK_EQUAL(BD_ADDR_TYPE_LE_RANDOM, addr_type);
+    CHECK_EQUAL_ARRAY(sm_key_cc, sm_key, 16);
+    CHECK_EQUAL_ARRAY(addr_bb, addr, 6);
+}
 
 int main (int argc, const char * argv[]){
     hci_dump_open("tlv_le_test.pklg", HCI_DUMP_PACKETLOGGER);
@@ -239,6 +239,49 @@ TEST(BSTACK_TLV, TestWriteResetRead){
     CHECK_EQUAL(buffer, data);
 }
 
+TEST(BSTACK_TLV, TestManyTags){
+    btstack_tlv_impl = btstack_tlv_flash_bank_init_instance(&btstack_tlv_context, hal_flash_bank_impl, &hal_flash_bank_context);
+    // more tags than a small index can hold, entry 8 + data 1 = 9
+    uint32_t tags[8];
+    uint8_t  values[8];
+    int i;
+    for (i=0;i<8;i++){
+        tags[i]   = 0x11110000 + i;
+        values[i] = i;
+        btstack_tlv_impl->store_tag(&btstack_tlv_context, tags[i], &values[i], 1);
+    }
+    values[3] = 0x33;
+    btstack_tlv_impl->store_tag(&btstack_tlv_context, tags[3], &values[3], 1);
+    values[6] = 0x66;
+    btstack_tlv_impl->store_tag(&btstack_tlv_context, tags[6], &values[6], 1);
+    btstack_tlv_impl->delete_tag(&btstack_tlv_context, tags[5]);
+    btstack_tlv_impl->delete_tag(&btstack_tlv_context, tags[1]);
+
+    int round;
+    for (round=0;round<3;round++){
+        for (i=0;i<8;i++){
+            uint8_t buffer = 0xff;
+            int size = btstack_tlv_impl->get_tag(&btstack_tlv_context, tags[i], &buffer, 1);
+            if (i == 1 || i == 5){
+                CHECK_EQUAL(0, size);
+            } else {
+                CHECK_EQUAL(1, size);
+                CHECK_EQUAL(values[i], buffer);
+            }
+        }
+        if (round == 0){
+            // reset
+            btstack_tlv_impl = btstack_tlv_flash_bank_init_instance(&btstack_tlv_context, hal_flash_bank_impl, &hal_flash_bank_context);
+        } else {
+            // fill bank to trigger migration
+            for (i=0;i<8;i++){
+                values[7]++;
+                btstack_tlv_impl->store_tag(&btstack_tlv_context, tags[7], &values[7], 1);
+            }
+        }
+    }
+}
+
 //
 TEST_GROUP(LINK_KEY_DB){
 	const hal_flash_bank_t * hal_flash_bank_impl;
@@ -321,6 +364,43 @@ TEST(LINK_KEY_DB, KeyReplacement){
     CHECK_EQUAL_ARRAY(link_key1, test_link_key, 16);
 }
 
+TEST(LINK_KEY_DB, DeleteAfterReplacement){
+	link_key_t test_link_key;
+    link_key_type_t test_link_key_type;
+
+	btstack_link_key_db->put_link_key(addr1, link_key1, link_key_type);
+	btstack_link_key_db->put_link_key(addr2, link_key1, link_key_type);
+	btstack_link_key_db->put_link_key(addr3, link_key2, link_key_type);
+	btstack_link_key_db->delete_link_key(addr2);
+
+    CHECK(btstack_link_key_db->get_link_key(addr1, test_link_key, &test_link_key_type) == 0);
+    CHECK(btstack_link_key_db->get_link_key(addr2, test_link_key, &test_link_key_type) == 0);
+    CHECK(btstack_link_key_db->get_link_key(addr3, test_link_key, &test_link_key_type) == 1);
+    CHECK_EQUAL_ARRAY(link_key2, test_link_key, 16);
+
+	btstack_link_key_db->put_link_key(addr1, link_key1, link_key_type);
+    CHECK(btstack_link_key_db->get_link_key(addr1, test_link_key, &test_link_key_type) == 1);
+    CHECK(btstack_link_key_db->get_link_key(addr3, test_link_key, &test_link_key_type) == 1);
+}
+
+TEST(LINK_KEY_DB, ResetRetrieve){
+	link_key_t test_link_key;
+    link_key_type_t test_link_key_type;
+
+	btstack_link_key_db->put_link_key(addr1, link_key1, link_key_type);
+	btstack_link_key_db->put_link_key(addr2, link_key2, link_key_type);
+
+	// reset
+	btstack_tlv_impl = btstack_tlv_flash_bank_init_instance(&btstack_tlv_context, hal_flash_bank_impl, &hal_flash_bank_context);
+	btstack_link_key_db = btstack_link_key_db_tlv_get_instance(btstack_tlv_impl, &btstack_tlv_context);
+
+    CHECK(btstack_link_key_db->get_link_key(addr2, test_link_key, &test_link_key_type) == 1);
+    CHECK_EQUAL_ARRAY(link_key2, test_link_key, 16);
+	btstack_link_key_db->put_link_key(addr1, link_key2, link_key_type);
+    CHECK(btstack_link_key_db->get_link_key(addr1, test_link_key, &test_link_key_type) == 1);
+    CHECK_EQUAL_ARRAY(link_key2, test_link_key, 16);
+}
+
 int main (int argc, const char * argv[]){
 	hci_dump_open("tlv_test.pklg", HCI_DUMP_PACKETLOGGER);
     return CommandLineTestRunner::RunAllTests(argc, argv);
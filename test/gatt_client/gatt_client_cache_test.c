@@ -0,0 +1,365 @@
+
+// *****************************************************************************
+//
+// test GATT Client discovery cache (ENABLE_GATT_CLIENT_CACHE)
+//
+// *****************************************************************************
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "bluetooth_gatt.h"
+#include "btstack_memory.h"
+#include "btstack_tlv.h"
+#include "btstack_tlv_flash_bank.h"
+#include "btstack_util.h"
+#include "hal_flash_bank_memory.h"
+#include "hci.h"
+#include "ble/gatt_client.h"
+#include "ble/att_db.h"
+#include "ble/le_device_db.h"
+#include "profile.h"
+
+void mock_simulate_disconnect(void);
+void mock_simulate_att_packet(hci_con_handle_t con_handle, const uint8_t * pdu, uint16_t pdu_len);
+void mock_set_deferred_responses(int enabled);
+int  mock_deliver_deferred_response(void);
+int  mock_get_att_requests_sent(void);
+void mock_set_le_device_index(int index);
+void mock_set_encryption_key_size(int size);
+void mock_run_expired_timers(void);
+
+static const hci_con_handle_t gatt_client_handle = 0x40;
+
+#define HAL_FLASH_BANK_MEMORY_STORAGE_SIZE 4096
+static uint8_t hal_flash_bank_memory_storage[HAL_FLASH_BANK_MEMORY_STORAGE_SIZE];
+static hal_flash_bank_memory_t  hal_flash_bank_context;
+static btstack_tlv_flash_bank_t btstack_tlv_context;
+
+static bd_addr_t peer_address = { 0x00, 0x1B, 0xDC, 0x07, 0x32, 0xEF };
+static sm_key_t  peer_irk;
+
+static gatt_client_service_t services[20];
+static int services_count;
+static gatt_client_characteristic_t characteristics[20];
+static int characteristics_count;
+static gatt_client_characteristic_descriptor_t descriptors[20];
+static int descriptors_count;
+static int query_complete;
+static uint8_t query_status;
+
+static void reset_query_state(void){
+    memset(services, 0, sizeof(services));
+    memset(characteristics, 0, sizeof(characteristics));
+    memset(descriptors, 0, sizeof(descriptors));
+    services_count = 0;
+    characteristics_count = 0;
+    descriptors_count = 0;
+    query_complete = 0;
+    query_status = 0xff;
+}
+
+static void handle_ble_client_event(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    switch (packet[0]){
+        case GATT_EVENT_SERVICE_QUERY_RESULT:
+            CHECK_EQUAL(gatt_client_handle, little_endian_read_16(packet, 2));
+            CHECK(services_count < 20);
+            gatt_client_deserialize_service(packet, 4, &services[services_count++]);
+            break;
+        case GATT_EVENT_CHARACTERISTIC_QUERY_RESULT:
+            CHECK_EQUAL(gatt_client_handle, little_endian_read_16(packet, 2));
+            CHECK(characteristics_count < 20);
+            gatt_client_deserialize_characteristic(packet, 4, &characteristics[characteristics_count++]);
+            break;
+        case GATT_EVENT_ALL_CHARACTERISTIC_DESCRIPTORS_QUERY_RESULT:
+            CHECK(descriptors_count < 20);
+            gatt_client_deserialize_characteristic_descriptor(packet, 4, &descriptors[descriptors_count++]);
+            break;
+        case GATT_EVENT_QUERY_COMPLETE:
+            query_complete = 1;
+            query_status = packet[4];
+            break;
+        default:
+            break;
+    }
+}
+
+// cached results are emitted from timer
+static void deliver_cached_results(void){
+    mock_run_expired_timers();
+}
+
+// returns number of ATT requests sent for the query
+static int discover_primary_services(void){
+    reset_query_state();
+    int requests_sent = mock_get_att_requests_sent();
+    CHECK_EQUAL(0, gatt_client_discover_primary_services(handle_ble_client_event, gatt_client_handle));
+    deliver_cached_results();
+    CHECK_EQUAL(1, query_complete);
+    CHECK_EQUAL(0, query_status);
+    return mock_get_att_requests_sent() - requests_sent;
+}
+
+static int discover_characteristics_for_service(gatt_client_service_t * service){
+    reset_query_state();
+    int requests_sent = mock_get_att_requests_sent();
+    CHECK_EQUAL(0, gatt_client_discover_characteristics_for_service(handle_ble_client_event, gatt_client_handle, service));
+    deliver_cached_results();
+    CHECK_EQUAL(1, query_complete);
+    CHECK_EQUAL(0, query_status);
+    return mock_get_att_requests_sent() - requests_sent;
+}
+
+static int discover_characteristic_descriptors(gatt_client_characteristic_t * characteristic){
+    reset_query_state();
+    int requests_sent = mock_get_att_requests_sent();
+    CHECK_EQUAL(0, gatt_client_discover_characteristic_descriptors(handle_ble_client_event, gatt_client_handle, characteristic));
+    deliver_cached_results();
+    CHECK_EQUAL(1, query_complete);
+    CHECK_EQUAL(0, query_status);
+    return mock_get_att_requests_sent() - requests_sent;
+}
+
+static gatt_client_service_t find_service(uint16_t uuid16){
+    discover_primary_services();
+    int i;
+    for (i=0;i<services_count;i++){
+        if (services[i].uuid16 == uuid16) return services[i];
+    }
+    FAIL("service not found");
+    return services[0];
+}
+
+// peer reports Database Hash characteristic value, read by UUID
+static void read_database_hash(uint8_t hash_byte){
+    uint8_t response[2 + 2 + 16];
+    response[0] = ATT_READ_BY_TYPE_RESPONSE;
+    response[1] = 2 + 16;
+    little_endian_store_16(response, 2, 0x0010);
+    memset(&response[4], hash_byte, 16);
+
+    reset_query_state();
+    mock_set_deferred_responses(1);
+    CHECK_EQUAL(0, gatt_client_read_value_of_characteristics_by_uuid16(handle_ble_client_event, gatt_client_handle, 0x0001, 0xffff, 0x2B2A));
+    // replace 'attribute not found' from test ATT server
+    mock_set_deferred_responses(1);
+    mock_simulate_att_packet(gatt_client_handle, response, sizeof(response));
+    while (mock_deliver_deferred_response()){
+    }
+    mock_set_deferred_responses(0);
+    CHECK_EQUAL(1, query_complete);
+}
+
+TEST_GROUP(GATTClientCache){
+    const btstack_tlv_t * btstack_tlv_impl;
+
+    void setup(void){
+        memset(hal_flash_bank_memory_storage, 0xff, sizeof(hal_flash_bank_memory_storage));
+        const hal_flash_bank_t * hal_flash_bank_impl = hal_flash_bank_memory_init_instance(&hal_flash_bank_context, hal_flash_bank_memory_storage, HAL_FLASH_BANK_MEMORY_STORAGE_SIZE);
+        btstack_tlv_impl = btstack_tlv_flash_bank_init_instance(&btstack_tlv_context, hal_flash_bank_impl, &hal_flash_bank_context);
+        btstack_tlv_set_instance(btstack_tlv_impl, &btstack_tlv_context);
+
+        le_device_db_init();
+        CHECK_EQUAL(0, le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, peer_address, peer_irk));
+        mock_set_le_device_index(0);
+        mock_set_encryption_key_size(16);
+    }
+    void teardown(void){
+        // free client context
+        mock_simulate_disconnect();
+        mock_set_le_device_index(-1);
+        mock_set_encryption_key_size(0);
+    }
+    int num_cache_entries(void){
+        int count = 0;
+        uint32_t id;
+        for (id = 1; id <= 0xffff; id++){
+            uint32_t tag = ((uint32_t) 'G' << 24) | id;
+            if (btstack_tlv_impl->get_tag(&btstack_tlv_context, tag, NULL, 0) > 0) count++;
+        }
+        return count;
+    }
+};
+
+TEST(GATTClientCache, NotBondedNotCached){
+    mock_set_le_device_index(-1);
+    CHECK(discover_primary_services() > 0);
+    CHECK(discover_primary_services() > 0);
+}
+
+TEST(GATTClientCache, NotEncryptedNotCached){
+    mock_set_encryption_key_size(0);
+    CHECK(discover_primary_services() > 0);
+    CHECK(discover_primary_services() > 0);
+    CHECK_EQUAL(0, num_cache_entries());
+    // entry stored on encrypted connection is not used without encryption
+    mock_set_encryption_key_size(16);
+    CHECK(discover_primary_services() > 0);
+    mock_set_encryption_key_size(0);
+    CHECK(discover_primary_services() > 0);
+}
+
+TEST(GATTClientCache, ResultsEmittedFromRunLoop){
+    CHECK(discover_primary_services() > 0);
+    reset_query_state();
+    CHECK_EQUAL(0, gatt_client_discover_primary_services(handle_ble_client_event, gatt_client_handle));
+    CHECK_EQUAL(0, services_count);
+    CHECK_EQUAL(0, query_complete);
+    // busy until complete
+    CHECK_EQUAL(GATT_CLIENT_IN_WRONG_STATE, gatt_client_discover_primary_services(handle_ble_client_event, gatt_client_handle));
+    deliver_cached_results();
+    CHECK(services_count > 2);
+    CHECK_EQUAL(1, query_complete);
+}
+
+TEST(GATTClientCache, ServicesFromCache){
+    CHECK(discover_primary_services() > 0);
+    gatt_client_service_t expected_services[20];
+    int expected_services_count = services_count;
+    memcpy(expected_services, services, sizeof(services));
+    CHECK(expected_services_count > 2);
+
+    // same results without ATT requests, also on reconnect
+    CHECK_EQUAL(0, discover_primary_services());
+    mock_simulate_disconnect();
+    CHECK_EQUAL(0, discover_primary_services());
+    CHECK_EQUAL(expected_services_count, services_count);
+    MEMCMP_EQUAL(expected_services, services, sizeof(services));
+}
+
+TEST(GATTClientCache, ServicesByUUIDFromCache){
+    reset_query_state();
+    CHECK_EQUAL(0, gatt_client_discover_primary_services_by_uuid16(handle_ble_client_event, gatt_client_handle, 0xffff));
+    CHECK_EQUAL(2, services_count);
+
+    int requests_sent = mock_get_att_requests_sent();
+    reset_query_state();
+    CHECK_EQUAL(0, gatt_client_discover_primary_services_by_uuid16(handle_ble_client_event, gatt_client_handle, 0xffff));
+    deliver_cached_results();
+    CHECK_EQUAL(requests_sent, mock_get_att_requests_sent());
+    CHECK_EQUAL(2, services_count);
+    CHECK_EQUAL(0xffff, services[0].uuid16);
+
+    // different UUID is a different query
+    reset_query_state();
+    CHECK_EQUAL(0, gatt_client_discover_primary_services_by_uuid16(handle_ble_client_event, gatt_client_handle, 0x1800));
+    CHECK(mock_get_att_requests_sent() > requests_sent);
+    CHECK_EQUAL(1, services_count);
+}
+
+TEST(GATTClientCache, CharacteristicsAndDescriptorsFromCache){
+    gatt_client_service_t service = find_service(0xF000);
+
+    CHECK(discover_characteristics_for_service(&service) > 0);
+    gatt_client_characteristic_t expected_characteristics[20];
+    int expected_characteristics_count = characteristics_count;
+    memcpy(expected_characteristics, characteristics, sizeof(characteristics));
+    CHECK(expected_characteristics_count > 0);
+
+    CHECK_EQUAL(0, discover_characteristics_for_service(&service));
+    CHECK_EQUAL(expected_characteristics_count, characteristics_count);
+    MEMCMP_EQUAL(expected_characteristics, characteristics, sizeof(characteristics));
+
+    // first characteristic has descriptors
+    gatt_client_characteristic_t characteristic = expected_characteristics[0];
+    CHECK(characteristic.end_handle > characteristic.value_handle);
+    CHECK(discover_characteristic_descriptors(&characteristic) > 0);
+    gatt_client_characteristic_descriptor_t expected_descriptors[20];
+    int expected_descriptors_count = descriptors_count;
+    memcpy(expected_descriptors, descriptors, sizeof(descriptors));
+    CHECK(expected_descriptors_count > 0);
+
+    CHECK_EQUAL(0, discover_characteristic_descriptors(&characteristic));
+    CHECK_EQUAL(expected_descriptors_count, descriptors_count);
+    MEMCMP_EQUAL(expected_descriptors, descriptors, sizeof(descriptors));
+}
+
+TEST(GATTClientCache, ServiceChangedIndicationInvalidates){
+    gatt_client_service_t service = find_service(ORG_BLUETOOTH_SERVICE_GENERIC_ATTRIBUTE);
+    discover_characteristics_for_service(&service);
+    CHECK_EQUAL(1, characteristics_count);
+    uint16_t service_changed_handle = characteristics[0].value_handle;
+    CHECK_EQUAL(0, discover_primary_services());
+
+    // indication for other characteristic does not invalidate cache
+    uint8_t indication[] = { ATT_HANDLE_VALUE_INDICATION, 0, 0, 0x01, 0x00, 0xff, 0xff };
+    little_endian_store_16(indication, 1, service_changed_handle + 1);
+    mock_simulate_att_packet(gatt_client_handle, indication, sizeof(indication));
+    CHECK_EQUAL(0, discover_primary_services());
+
+    // indication on unencrypted link does not invalidate cache
+    little_endian_store_16(indication, 1, service_changed_handle);
+    mock_set_encryption_key_size(0);
+    mock_simulate_att_packet(gatt_client_handle, indication, sizeof(indication));
+    mock_set_encryption_key_size(16);
+    CHECK_EQUAL(0, discover_primary_services());
+
+    mock_simulate_att_packet(gatt_client_handle, indication, sizeof(indication));
+    CHECK(discover_primary_services() > 0);
+    CHECK_EQUAL(0, discover_primary_services());
+}
+
+TEST(GATTClientCache, DatabaseHashChangeInvalidates){
+    read_database_hash(0x11);
+    CHECK(discover_primary_services() > 0);
+    CHECK_EQUAL(0, discover_primary_services());
+
+    read_database_hash(0x11);
+    CHECK_EQUAL(0, discover_primary_services());
+
+    read_database_hash(0x22);
+    CHECK(discover_primary_services() > 0);
+    CHECK_EQUAL(0, discover_primary_services());
+}
+
+TEST(GATTClientCache, Invalidate){
+    CHECK(discover_primary_services() > 0);
+    CHECK_EQUAL(1, num_cache_entries());
+    gatt_client_cache_invalidate(0);
+    CHECK_EQUAL(0, num_cache_entries());
+    CHECK(discover_primary_services() > 0);
+    CHECK_EQUAL(0, discover_primary_services());
+}
+
+TEST(GATTClientCache, InvalidateWithManyEntries){
+    // each UUID is a separate entry
+    uint16_t uuid16;
+    for (uuid16 = 0x1800; uuid16 < 0x1820; uuid16++){
+        reset_query_state();
+        CHECK_EQUAL(0, gatt_client_discover_primary_services_by_uuid16(handle_ble_client_event, gatt_client_handle, uuid16));
+        CHECK_EQUAL(1, query_complete);
+    }
+    // oldest entries replaced
+    CHECK_EQUAL(16, num_cache_entries());
+    gatt_client_cache_invalidate(0);
+    CHECK_EQUAL(0, num_cache_entries());
+}
+
+TEST(GATTClientCache, DeviceIndexReusedForOtherPeer){
+    CHECK(discover_primary_services() > 0);
+    CHECK_EQUAL(0, discover_primary_services());
+
+    bd_addr_t other_address = { 0x00, 0x1B, 0xDC, 0x07, 0x32, 0xF0 };
+    le_device_db_remove(0);
+    CHECK_EQUAL(0, le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, other_address, peer_irk));
+    CHECK(discover_primary_services() > 0);
+    // only entry of new peer left
+    CHECK_EQUAL(1, num_cache_entries());
+}
+
+int main (int argc, const char * argv[]){
+    att_set_db(profile_data);
+    gatt_client_init();
+    gatt_client_mtu_enable_auto_negotiation(0);
+
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,111 @@
+/*
+ * Benchmark: notifications per second delivered to 1000 GATT Client listeners on 10 connections.
+ * Build with -DENABLE_GATT_CLIENT_LISTENER_INDEX to use the hashed listener table
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "ble/att_db.h"
+#include "ble/gatt_client.h"
+#include "bluetooth.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "profile.h"
+
+#define NUM_CONNECTIONS    10
+#define NUM_VALUE_HANDLES  100
+#define NUM_LISTENERS      (NUM_CONNECTIONS * NUM_VALUE_HANDLES)
+#define ROUNDS             100
+
+void mock_simulate_att_packet(hci_con_handle_t con_handle, const uint8_t * pdu, uint16_t pdu_len);
+
+static gatt_client_notification_t listeners[NUM_LISTENERS];
+static uint32_t notifications_received;
+static uint32_t notifications_misrouted;
+
+static void handle_notification(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    (void) channel;
+    (void) size;
+    if (packet_type != HCI_EVENT_PACKET) return;
+    if (packet[0] != GATT_EVENT_NOTIFICATION) return;
+    notifications_received++;
+    // value contains low byte of value handle
+    if (packet[8] != (little_endian_read_16(packet, 4) & 0xff)){
+        notifications_misrouted++;
+    }
+}
+
+static double now_us(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+static hci_con_handle_t con_handle_for_index(int i){
+    return (hci_con_handle_t) (0x0040 + i);
+}
+
+static uint16_t value_handle_for_index(int i){
+    // every third handle, like characteristic declaration, value, and CCC
+    return (uint16_t) (0x0010 + 3 * i);
+}
+
+int main (int argc, const char * argv[]){
+    (void) argc;
+    (void) argv;
+
+    att_set_db(profile_data);
+    gatt_client_init();
+
+#ifdef ENABLE_GATT_CLIENT_LISTENER_INDEX
+    printf("GATT Client listeners with index of %u buckets, %u listeners\n", GATT_CLIENT_LISTENER_INDEX_SIZE, NUM_LISTENERS);
+#else
+    printf("GATT Client listeners in linked list, %u listeners\n", NUM_LISTENERS);
+#endif
+
+    int c;
+    int v;
+    for (c=0;c<NUM_CONNECTIONS;c++){
+        for (v=0;v<NUM_VALUE_HANDLES;v++){
+            gatt_client_characteristic_t characteristic;
+            memset(&characteristic, 0, sizeof(characteristic));
+            characteristic.value_handle = value_handle_for_index(v);
+            gatt_client_listen_for_characteristic_value_updates(&listeners[c * NUM_VALUE_HANDLES + v], &handle_notification, con_handle_for_index(c), &characteristic);
+        }
+    }
+
+    uint8_t pdu[23];
+    memset(pdu, 0, sizeof(pdu));
+    pdu[0] = ATT_HANDLE_VALUE_NOTIFICATION;
+
+    double start = now_us();
+    int round;
+    for (round=0;round<ROUNDS;round++){
+        for (v=0;v<NUM_VALUE_HANDLES;v++){
+            uint16_t value_handle = value_handle_for_index(v);
+            little_endian_store_16(pdu, 1, value_handle);
+            pdu[3] = value_handle & 0xff;
+            for (c=0;c<NUM_CONNECTIONS;c++){
+                mock_simulate_att_packet(con_handle_for_index(c), pdu, sizeof(pdu));
+            }
+        }
+    }
+    double duration_us = now_us() - start;
+    uint32_t notifications_sent = ROUNDS * NUM_LISTENERS;
+
+    printf("  %u notifications in %.1f ms: %.0f notifications/s, %.3f us per notification\n", notifications_sent,
+        duration_us / 1000.0, notifications_sent * 1000000.0 / duration_us, duration_us / notifications_sent);
+
+    for (c=0;c<NUM_LISTENERS;c++){
+        gatt_client_stop_listening_for_characteristic_value_updates(&listeners[c]);
+    }
+
+    if ((notifications_received != notifications_sent) || notifications_misrouted){
+        printf("FAILED: %u notifications received, %u misrouted\n", notifications_received, notifications_misrouted);
+        return 1;
+    }
+    return 0;
+}
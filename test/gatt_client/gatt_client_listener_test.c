@@ -0,0 +1,307 @@
+
+// *****************************************************************************
+//
+// test GATT Client notification and indication listeners, with and without ENABLE_GATT_CLIENT_LISTENER_INDEX
+//
+// *****************************************************************************
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_memory.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "ble/gatt_client.h"
+#include "ble/att_db.h"
+#include "profile.h"
+
+void mock_simulate_disconnect(void);
+void mock_simulate_att_packet(hci_con_handle_t con_handle, const uint8_t * pdu, uint16_t pdu_len);
+
+static const hci_con_handle_t con_handle_a = 0x40;
+static const hci_con_handle_t con_handle_b = 0x41;
+
+// log of received events: listener index, con handle, value handle, first byte of value
+typedef struct {
+    int      listener;
+    uint16_t con_handle;
+    uint16_t value_handle;
+    uint8_t  value;
+    uint8_t  event_type;
+} received_event_t;
+
+static received_event_t received[20];
+static int received_count;
+
+static void log_event(int listener, uint8_t * packet){
+    if (received_count >= 20) return;
+    received[received_count].listener     = listener;
+    received[received_count].event_type   = packet[0];
+    received[received_count].con_handle   = little_endian_read_16(packet, 2);
+    received[received_count].value_handle = little_endian_read_16(packet, 4);
+    received[received_count].value        = packet[8];
+    received_count++;
+}
+
+static void handle_listener_0(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    log_event(0, packet);
+}
+
+static void handle_listener_1(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    log_event(1, packet);
+}
+
+static gatt_client_notification_t listener_to_stop;
+
+static void handle_listener_stops_itself(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    log_event(2, packet);
+    gatt_client_stop_listening_for_characteristic_value_updates(&listener_to_stop);
+}
+
+// direct value handler: listener 3, value copied for checks
+static uint8_t direct_value[20];
+static uint16_t direct_value_len;
+
+static void handle_value_direct(hci_con_handle_t con_handle, uint16_t value_handle, const uint8_t * value, uint16_t value_len){
+    if (received_count >= 20) return;
+    received[received_count].listener     = 3;
+    received[received_count].event_type   = 0;
+    received[received_count].con_handle   = con_handle;
+    received[received_count].value_handle = value_handle;
+    received[received_count].value        = value[0];
+    received_count++;
+    direct_value_len = value_len;
+    memcpy(direct_value, value, value_len);
+}
+
+static void simulate_value_update(uint8_t opcode, hci_con_handle_t con_handle, uint16_t value_handle, uint8_t value){
+    uint8_t pdu[4];
+    pdu[0] = opcode;
+    little_endian_store_16(pdu, 1, value_handle);
+    pdu[3] = value;
+    mock_simulate_att_packet(con_handle, pdu, sizeof(pdu));
+}
+
+static void simulate_notification(hci_con_handle_t con_handle, uint16_t value_handle, uint8_t value){
+    simulate_value_update(ATT_HANDLE_VALUE_NOTIFICATION, con_handle, value_handle, value);
+}
+
+static gatt_client_characteristic_t characteristic_with_value_handle(uint16_t value_handle){
+    gatt_client_characteristic_t characteristic;
+    memset(&characteristic, 0, sizeof(characteristic));
+    characteristic.value_handle = value_handle;
+    return characteristic;
+}
+
+TEST_GROUP(GATTClientListener){
+    gatt_client_notification_t listeners[4];
+
+    void setup(void){
+        received_count = 0;
+        memset(listeners, 0, sizeof(listeners));
+    }
+    void teardown(void){
+        int i;
+        for (i=0;i<4;i++){
+            gatt_client_stop_listening_for_characteristic_value_updates(&listeners[i]);
+        }
+    }
+};
+
+TEST(GATTClientListener, NotificationForValueHandle){
+    gatt_client_characteristic_t characteristic = characteristic_with_value_handle(0x0010);
+    gatt_client_listen_for_characteristic_value_updates(&listeners[0], handle_listener_0, con_handle_a, &characteristic);
+
+    simulate_notification(con_handle_a, 0x0010, 0x55);
+    CHECK_EQUAL(1, received_count);
+    CHECK_EQUAL(0, received[0].listener);
+    CHECK_EQUAL(GATT_EVENT_NOTIFICATION, received[0].event_type);
+    CHECK_EQUAL(con_handle_a, received[0].con_handle);
+    CHECK_EQUAL(0x0010, received[0].value_handle);
+    CHECK_EQUAL(0x55, received[0].value);
+
+    // other value handle, other connection
+    simulate_notification(con_handle_a, 0x0011, 0x55);
+    simulate_notification(con_handle_b, 0x0010, 0x55);
+    CHECK_EQUAL(1, received_count);
+}
+
+TEST(GATTClientListener, StopListening){
+    gatt_client_characteristic_t characteristic = characteristic_with_value_handle(0x0010);
+    gatt_client_listen_for_characteristic_value_updates(&listeners[0], handle_listener_0, con_handle_a, &characteristic);
+    gatt_client_listen_for_characteristic_value_updates(&listeners[1], handle_listener_1, con_handle_a, &characteristic);
+    simulate_notification(con_handle_a, 0x0010, 0x01);
+    CHECK_EQUAL(2, received_count);
+
+    gatt_client_stop_listening_for_characteristic_value_updates(&listeners[0]);
+    simulate_notification(con_handle_a, 0x0010, 0x02);
+    CHECK_EQUAL(3, received_count);
+    CHECK_EQUAL(1, received[2].listener);
+}
+
+TEST(GATTClientListener, ManyValueHandlesAndConnections){
+    // more listeners than buckets in small index
+    static gatt_client_notification_t many_listeners[2][8];
+    int i;
+    int j;
+    for (i=0;i<2;i++){
+        for (j=0;j<8;j++){
+            gatt_client_characteristic_t characteristic = characteristic_with_value_handle(0x0010 + j);
+            gatt_client_listen_for_characteristic_value_updates(&many_listeners[i][j], i ? handle_listener_1 : handle_listener_0, i ? con_handle_b : con_handle_a, &characteristic);
+        }
+    }
+    for (j=0;j<8;j++){
+        received_count = 0;
+        simulate_notification(con_handle_b, 0x0010 + j, (uint8_t) j);
+        CHECK_EQUAL(1, received_count);
+        CHECK_EQUAL(1, received[0].listener);
+        CHECK_EQUAL(0x0010 + j, received[0].value_handle);
+    }
+    for (i=0;i<2;i++){
+        for (j=0;j<8;j++){
+            gatt_client_stop_listening_for_characteristic_value_updates(&many_listeners[i][j]);
+        }
+    }
+    received_count = 0;
+    simulate_notification(con_handle_a, 0x0010, 0);
+    CHECK_EQUAL(0, received_count);
+}
+
+TEST(GATTClientListener, AllValueHandlesOfConnection){
+    gatt_client_characteristic_t characteristic = characteristic_with_value_handle(0x0010);
+    gatt_client_listen_for_characteristic_value_updates(&listeners[0], handle_listener_0, con_handle_a, &characteristic);
+    gatt_client_listen_for_characteristic_value_updates(&listeners[1], handle_listener_1, con_handle_a, NULL);
+
+    simulate_notification(con_handle_a, 0x0010, 0x01);
+    simulate_notification(con_handle_a, 0x0020, 0x02);
+    simulate_notification(con_handle_b, 0x0020, 0x03);
+    CHECK_EQUAL(3, received_count);
+    // both listeners get the first notification
+    CHECK_EQUAL(1, received[0].listener + received[1].listener);
+    CHECK_EQUAL(0x0010, received[0].value_handle);
+    CHECK_EQUAL(0x0010, received[1].value_handle);
+    CHECK_EQUAL(1, received[2].listener);
+    CHECK_EQUAL(0x0020, received[2].value_handle);
+
+    gatt_client_stop_listening_for_characteristic_value_updates(&listeners[1]);
+    simulate_notification(con_handle_a, 0x0020, 0x04);
+    CHECK_EQUAL(3, received_count);
+}
+
+#ifdef ENABLE_GATT_CLIENT_LISTENER_INDEX
+TEST(GATTClientListener, ValueHandleBeforeAllValueHandles){
+    gatt_client_characteristic_t characteristic = characteristic_with_value_handle(0x0010);
+    gatt_client_listen_for_characteristic_value_updates(&listeners[0], handle_listener_0, con_handle_a, NULL);
+    gatt_client_listen_for_characteristic_value_updates(&listeners[1], handle_listener_1, con_handle_b, NULL);
+    gatt_client_listen_for_characteristic_value_updates(&listeners[2], handle_listener_1, con_handle_a, &characteristic);
+
+    // listener for value handle is called first, although registered last
+    simulate_notification(con_handle_a, 0x0010, 0x01);
+    CHECK_EQUAL(2, received_count);
+    CHECK_EQUAL(1, received[0].listener);
+    CHECK_EQUAL(0, received[1].listener);
+    CHECK_EQUAL(con_handle_a, received[1].con_handle);
+}
+#endif
+
+TEST(GATTClientListener, Indication){
+    gatt_client_characteristic_t characteristic = characteristic_with_value_handle(0x0010);
+    gatt_client_listen_for_characteristic_value_updates(&listeners[0], handle_listener_0, con_handle_a, &characteristic);
+    simulate_value_update(ATT_HANDLE_VALUE_INDICATION, con_handle_a, 0x0010, 0x77);
+    CHECK_EQUAL(1, received_count);
+    CHECK_EQUAL(GATT_EVENT_INDICATION, received[0].event_type);
+    CHECK_EQUAL(0x77, received[0].value);
+    // free client context created for indication
+    mock_simulate_disconnect();
+}
+
+TEST(GATTClientListener, ListenerStopsInCallback){
+    gatt_client_characteristic_t characteristic = characteristic_with_value_handle(0x0010);
+    // listeners are added at the head, listener that stops is called first
+    gatt_client_listen_for_characteristic_value_updates(&listeners[0], handle_listener_0, con_handle_a, &characteristic);
+    gatt_client_listen_for_characteristic_value_updates(&listener_to_stop, handle_listener_stops_itself, con_handle_a, &characteristic);
+    simulate_notification(con_handle_a, 0x0010, 0x01);
+    CHECK_EQUAL(2, received_count);
+    CHECK_EQUAL(2, received[0].listener);
+    CHECK_EQUAL(0, received[1].listener);
+    simulate_notification(con_handle_a, 0x0010, 0x02);
+    CHECK_EQUAL(3, received_count);
+    CHECK_EQUAL(0, received[2].listener);
+}
+
+TEST(GATTClientListener, DirectValueHandler){
+    const uint8_t pdu[] = { ATT_HANDLE_VALUE_NOTIFICATION, 0x10, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 };
+    gatt_client_characteristic_t characteristic = characteristic_with_value_handle(0x0010);
+    gatt_client_listen_for_characteristic_value_updates_direct(&listeners[0], handle_value_direct, con_handle_a, &characteristic);
+
+    mock_simulate_att_packet(con_handle_a, pdu, sizeof(pdu));
+    CHECK_EQUAL(1, received_count);
+    CHECK_EQUAL(3, received[0].listener);
+    CHECK_EQUAL(con_handle_a, received[0].con_handle);
+    CHECK_EQUAL(0x0010, received[0].value_handle);
+    CHECK_EQUAL(5, direct_value_len);
+    MEMCMP_EQUAL(&pdu[3], direct_value, 5);
+
+    simulate_notification(con_handle_b, 0x0010, 0x55);
+    simulate_value_update(ATT_HANDLE_VALUE_INDICATION, con_handle_a, 0x0010, 0x77);
+    CHECK_EQUAL(2, received_count);
+    CHECK_EQUAL(0x77, received[1].value);
+
+    // disconnect frees client context created for indication, listener stays registered until stopped
+    mock_simulate_disconnect();
+    simulate_notification(con_handle_a, 0x0010, 0x66);
+    CHECK_EQUAL(3, received_count);
+    CHECK_EQUAL(3, received[2].listener);
+    CHECK_EQUAL(0x66, received[2].value);
+
+    gatt_client_stop_listening_for_characteristic_value_updates(&listeners[0]);
+    simulate_notification(con_handle_a, 0x0010, 0x55);
+    CHECK_EQUAL(3, received_count);
+}
+
+TEST(GATTClientListener, DirectValueHandlerAndEvent){
+    gatt_client_characteristic_t characteristic = characteristic_with_value_handle(0x0010);
+    gatt_client_listen_for_characteristic_value_updates_direct(&listeners[0], handle_value_direct, con_handle_a, NULL);
+    gatt_client_listen_for_characteristic_value_updates(&listeners[1], handle_listener_1, con_handle_a, &characteristic);
+    gatt_client_listen_for_characteristic_value_updates_direct(&listeners[2], handle_value_direct, con_handle_a, &characteristic);
+
+    simulate_notification(con_handle_a, 0x0010, 0x42);
+    CHECK_EQUAL(3, received_count);
+    int i;
+    int events = 0;
+    for (i=0;i<3;i++){
+        CHECK_EQUAL(0x0010, received[i].value_handle);
+        CHECK_EQUAL(0x42, received[i].value);
+        if (received[i].listener == 1){
+            CHECK_EQUAL(GATT_EVENT_NOTIFICATION, received[i].event_type);
+            events++;
+        }
+    }
+    CHECK_EQUAL(1, events);
+
+    simulate_notification(con_handle_a, 0x0020, 0x43);
+    CHECK_EQUAL(4, received_count);
+    CHECK_EQUAL(3, received[3].listener);
+}
+
+int main (int argc, const char * argv[]){
+    att_set_db(profile_data);
+    gatt_client_init();
+
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,108 @@
+/*
+ * Benchmark: maximum notification throughput of a single GATT Client listener on the mock controller,
+ * with GATT_EVENT_NOTIFICATION packet handler and with direct value handler
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "ble/att_db.h"
+#include "ble/gatt_client.h"
+#include "bluetooth.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "profile.h"
+
+#define NUM_NOTIFICATIONS 2000000
+#define VALUE_LEN         20
+
+void mock_simulate_att_packet(hci_con_handle_t con_handle, const uint8_t * pdu, uint16_t pdu_len);
+
+static const hci_con_handle_t con_handle = 0x0040;
+static const uint16_t value_handle = 0x0010;
+
+static gatt_client_notification_t listener;
+static uint32_t notifications_received;
+static uint32_t bytes_received;
+static uint32_t checksum;
+
+static void handle_notification(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    (void) channel;
+    (void) size;
+    if (packet_type != HCI_EVENT_PACKET) return;
+    if (packet[0] != GATT_EVENT_NOTIFICATION) return;
+    uint16_t value_len = little_endian_read_16(packet, 6);
+    notifications_received++;
+    bytes_received += value_len;
+    checksum += packet[8 + value_len - 1];
+}
+
+static void handle_value(hci_con_handle_t handle, uint16_t attribute_handle, const uint8_t * value, uint16_t value_len){
+    (void) handle;
+    (void) attribute_handle;
+    notifications_received++;
+    bytes_received += value_len;
+    checksum += value[value_len - 1];
+}
+
+static double now_us(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+static int run(const char * name){
+    uint8_t pdu[3 + VALUE_LEN];
+    memset(pdu, 0, sizeof(pdu));
+    pdu[0] = ATT_HANDLE_VALUE_NOTIFICATION;
+    little_endian_store_16(pdu, 1, value_handle);
+
+    notifications_received = 0;
+    bytes_received = 0;
+    checksum = 0;
+
+    double start = now_us();
+    uint32_t i;
+    for (i=0;i<NUM_NOTIFICATIONS;i++){
+        pdu[sizeof(pdu)-1] = (uint8_t) i;
+        mock_simulate_att_packet(con_handle, pdu, sizeof(pdu));
+    }
+    double duration_us = now_us() - start;
+    gatt_client_stop_listening_for_characteristic_value_updates(&listener);
+
+    printf("%-16s %u notifications in %.1f ms: %.0f notifications/s, %.1f MB/s\n", name, NUM_NOTIFICATIONS,
+        duration_us / 1000.0, NUM_NOTIFICATIONS * 1000000.0 / duration_us, bytes_received / duration_us);
+
+    uint32_t expected_checksum = 0;
+    for (i=0;i<NUM_NOTIFICATIONS;i++){
+        expected_checksum += (uint8_t) i;
+    }
+    if ((notifications_received != NUM_NOTIFICATIONS) || (bytes_received != NUM_NOTIFICATIONS * VALUE_LEN) || (checksum != expected_checksum)){
+        printf("FAILED: %u notifications, %u bytes received\n", notifications_received, bytes_received);
+        return 1;
+    }
+    return 0;
+}
+
+int main (int argc, const char * argv[]){
+    (void) argc;
+    (void) argv;
+
+    att_set_db(profile_data);
+    gatt_client_init();
+
+    gatt_client_characteristic_t characteristic;
+    memset(&characteristic, 0, sizeof(characteristic));
+    characteristic.value_handle = value_handle;
+
+    printf("GATT Client notifications with %u byte value\n", VALUE_LEN);
+
+    int failed = 0;
+    gatt_client_listen_for_characteristic_value_updates(&listener, &handle_notification, con_handle, &characteristic);
+    failed |= run("packet handler");
+    gatt_client_listen_for_characteristic_value_updates_direct(&listener, &handle_value, con_handle, &characteristic);
+    failed |= run("value handler");
+    return failed;
+}
@@ -0,0 +1,259 @@
+
+// *****************************************************************************
+//
+// test GATT Client request queue (ENABLE_GATT_CLIENT_REQUEST_QUEUE)
+//
+// *****************************************************************************
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_memory.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "ble/gatt_client.h"
+#include "ble/att_db.h"
+#include "profile.h"
+
+void mock_simulate_disconnect(void);
+void mock_set_deferred_responses(int enabled);
+int  mock_deliver_deferred_response(void);
+int  mock_get_deferred_responses_overwritten(void);
+int  mock_simulate_timeout(void);
+int  mock_get_att_requests_sent(void);
+
+static const hci_con_handle_t gatt_client_handle = 0x40;
+
+static const uint16_t value_handles[] = {
+    ATT_CHARACTERISTIC_GAP_DEVICE_NAME_01_VALUE_HANDLE,
+    ATT_CHARACTERISTIC_GAP_APPEARANCE_01_VALUE_HANDLE,
+    ATT_CHARACTERISTIC_2A02_01_VALUE_HANDLE,
+    ATT_CHARACTERISTIC_2A03_01_VALUE_HANDLE,
+    ATT_CHARACTERISTIC_2A04_01_VALUE_HANDLE,
+};
+
+// log of received events: value handle for value results, 0xff00 | status for query complete
+static uint16_t event_log[20];
+static int      event_log_len;
+
+// log of write commands received by the ATT server
+static uint16_t write_log[10];
+static int      write_log_len;
+
+static int      read_on_complete;
+
+static void log_event(uint16_t entry){
+    if (event_log_len >= (int) (sizeof(event_log) / sizeof(uint16_t))) return;
+    event_log[event_log_len++] = entry;
+}
+
+static void handle_ble_client_event(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    switch (packet[0]){
+        case GATT_EVENT_QUERY_COMPLETE:
+            log_event(0xff00 | packet[4]);
+            if (read_on_complete){
+                read_on_complete = 0;
+                CHECK_EQUAL(0, gatt_client_read_value_of_characteristic_using_value_handle(handle_ble_client_event, gatt_client_handle, value_handles[4]));
+            }
+            break;
+        case GATT_EVENT_CHARACTERISTIC_VALUE_QUERY_RESULT:
+            // value is low byte of the handle
+            CHECK_EQUAL(1, little_endian_read_16(packet, 6));
+            CHECK_EQUAL(little_endian_read_16(packet, 4) & 0xff, packet[8]);
+            log_event(little_endian_read_16(packet, 4));
+            break;
+        default:
+            break;
+    }
+}
+
+extern "C" uint16_t att_read_callback(uint16_t handle, uint16_t attribute_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size){
+    UNUSED(handle);
+    UNUSED(offset);
+    if (buffer && buffer_size){
+        buffer[0] = attribute_handle & 0xff;
+    }
+    return 1;
+}
+
+extern "C" int att_write_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size){
+    UNUSED(con_handle);
+    UNUSED(transaction_mode);
+    UNUSED(offset);
+    UNUSED(buffer);
+    UNUSED(buffer_size);
+    if (write_log_len < (int) (sizeof(write_log) / sizeof(uint16_t))){
+        write_log[write_log_len++] = attribute_handle;
+    }
+    return 0;
+}
+
+static void deliver_all_responses(void){
+    while (mock_deliver_deferred_response()){
+    }
+}
+
+TEST_GROUP(GATTClientRequestQueue){
+    void setup(void){
+        event_log_len = 0;
+        write_log_len = 0;
+        read_on_complete = 0;
+        mock_set_deferred_responses(1);
+    }
+    void teardown(void){
+        // free client context
+        mock_simulate_disconnect();
+        mock_set_deferred_responses(0);
+    }
+};
+
+TEST(GATTClientRequestQueue, ReadsCompleteInOrder){
+    int i;
+    for (i=0;i<3;i++){
+        CHECK_EQUAL(0, gatt_client_read_value_of_characteristic_using_value_handle(handle_ble_client_event, gatt_client_handle, value_handles[i]));
+    }
+    CHECK_EQUAL(0, gatt_client_is_ready(gatt_client_handle));
+    CHECK_EQUAL(0, event_log_len);
+
+    deliver_all_responses();
+
+    CHECK_EQUAL(6, event_log_len);
+    for (i=0;i<3;i++){
+        CHECK_EQUAL(value_handles[i], event_log[2*i]);
+        CHECK_EQUAL(0xff00, event_log[2*i+1]);
+    }
+    CHECK_EQUAL(0, mock_get_deferred_responses_overwritten());
+    CHECK_EQUAL(1, gatt_client_is_ready(gatt_client_handle));
+}
+
+TEST(GATTClientRequestQueue, QueueFull){
+    int i;
+    // first read is sent, GATT_CLIENT_REQUEST_QUEUE_SIZE reads are queued
+    for (i=0;i<=GATT_CLIENT_REQUEST_QUEUE_SIZE;i++){
+        CHECK_EQUAL(0, gatt_client_read_value_of_characteristic_using_value_handle(handle_ble_client_event, gatt_client_handle, value_handles[i % 5]));
+    }
+    CHECK_EQUAL(GATT_CLIENT_BUSY, gatt_client_read_value_of_characteristic_using_value_handle(handle_ble_client_event, gatt_client_handle, value_handles[0]));
+
+    deliver_all_responses();
+    CHECK_EQUAL(2 * (GATT_CLIENT_REQUEST_QUEUE_SIZE + 1), event_log_len);
+}
+
+TEST(GATTClientRequestQueue, RequestFromCompleteEventIsQueuedLast){
+    read_on_complete = 1;
+    CHECK_EQUAL(0, gatt_client_read_value_of_characteristic_using_value_handle(handle_ble_client_event, gatt_client_handle, value_handles[0]));
+    CHECK_EQUAL(0, gatt_client_read_value_of_characteristic_using_value_handle(handle_ble_client_event, gatt_client_handle, value_handles[1]));
+
+    deliver_all_responses();
+
+    CHECK_EQUAL(6, event_log_len);
+    CHECK_EQUAL(value_handles[0], event_log[0]);
+    CHECK_EQUAL(value_handles[1], event_log[2]);
+    CHECK_EQUAL(value_handles[4], event_log[4]);
+}
+
+TEST(GATTClientRequestQueue, WriteCommandWhileRequestOngoing){
+    uint8_t value[] = { 0x01 };
+    CHECK_EQUAL(0, gatt_client_read_value_of_characteristic_using_value_handle(handle_ble_client_event, gatt_client_handle, value_handles[0]));
+    CHECK_EQUAL(0, gatt_client_read_value_of_characteristic_using_value_handle(handle_ble_client_event, gatt_client_handle, value_handles[1]));
+
+    // write commands are sent back to back without waiting for the reads
+    CHECK_EQUAL(0, gatt_client_write_value_of_characteristic_without_response(gatt_client_handle, ATT_CHARACTERISTIC_F10C_01_VALUE_HANDLE, sizeof(value), value));
+    CHECK_EQUAL(0, gatt_client_write_value_of_characteristic_without_response(gatt_client_handle, ATT_CHARACTERISTIC_F10D_01_VALUE_HANDLE, sizeof(value), value));
+    CHECK_EQUAL(2, write_log_len);
+    CHECK_EQUAL(ATT_CHARACTERISTIC_F10C_01_VALUE_HANDLE, write_log[0]);
+    CHECK_EQUAL(ATT_CHARACTERISTIC_F10D_01_VALUE_HANDLE, write_log[1]);
+    CHECK_EQUAL(0, event_log_len);
+
+    deliver_all_responses();
+    CHECK_EQUAL(4, event_log_len);
+    CHECK_EQUAL(0, mock_get_deferred_responses_overwritten());
+}
+
+TEST(GATTClientRequestQueue, WriteRequestsQueued){
+    uint8_t value[] = { 0x01 };
+    CHECK_EQUAL(0, gatt_client_write_value_of_characteristic(handle_ble_client_event, gatt_client_handle, value_handles[0], sizeof(value), value));
+    CHECK_EQUAL(0, gatt_client_read_value_of_characteristic_using_value_handle(handle_ble_client_event, gatt_client_handle, value_handles[1]));
+    CHECK_EQUAL(0, gatt_client_write_value_of_characteristic(handle_ble_client_event, gatt_client_handle, value_handles[2], sizeof(value), value));
+
+    deliver_all_responses();
+
+    CHECK_EQUAL(2, write_log_len);
+    CHECK_EQUAL(value_handles[0], write_log[0]);
+    CHECK_EQUAL(value_handles[2], write_log[1]);
+    CHECK_EQUAL(4, event_log_len);
+    CHECK_EQUAL(0xff00, event_log[0]);
+    CHECK_EQUAL(value_handles[1], event_log[1]);
+    CHECK_EQUAL(0xff00, event_log[2]);
+    CHECK_EQUAL(0xff00, event_log[3]);
+}
+
+TEST(GATTClientRequestQueue, EmptyDescriptorDiscoveryCompletesInOrder){
+    gatt_client_characteristic_t characteristic;
+    memset(&characteristic, 0, sizeof(characteristic));
+    characteristic.value_handle = value_handles[1];
+    characteristic.end_handle   = value_handles[1];
+
+    CHECK_EQUAL(0, gatt_client_read_value_of_characteristic_using_value_handle(handle_ble_client_event, gatt_client_handle, value_handles[0]));
+    CHECK_EQUAL(0, gatt_client_discover_characteristic_descriptors(handle_ble_client_event, gatt_client_handle, &characteristic));
+    CHECK_EQUAL(0, gatt_client_read_value_of_characteristic_using_value_handle(handle_ble_client_event, gatt_client_handle, value_handles[2]));
+    CHECK_EQUAL(0, event_log_len);
+
+    deliver_all_responses();
+
+    CHECK_EQUAL(5, event_log_len);
+    CHECK_EQUAL(value_handles[0], event_log[0]);
+    CHECK_EQUAL(0xff00, event_log[1]);
+    CHECK_EQUAL(0xff00, event_log[2]);
+    CHECK_EQUAL(value_handles[2], event_log[3]);
+    CHECK_EQUAL(0xff00, event_log[4]);
+}
+
+TEST(GATTClientRequestQueue, DisconnectReportsQueuedRequests){
+    int i;
+    for (i=0;i<3;i++){
+        CHECK_EQUAL(0, gatt_client_read_value_of_characteristic_using_value_handle(handle_ble_client_event, gatt_client_handle, value_handles[i]));
+    }
+    mock_simulate_disconnect();
+    CHECK_EQUAL(3, event_log_len);
+    for (i=0;i<3;i++){
+        CHECK_EQUAL(0xff00 | ATT_ERROR_HCI_DISCONNECT_RECEIVED, event_log[i]);
+    }
+}
+
+TEST(GATTClientRequestQueue, TimeoutReportsQueuedRequests){
+    int requests_sent = mock_get_att_requests_sent();
+    int i;
+    for (i=0;i<3;i++){
+        CHECK_EQUAL(0, gatt_client_read_value_of_characteristic_using_value_handle(handle_ble_client_event, gatt_client_handle, value_handles[i]));
+    }
+    CHECK_EQUAL(requests_sent + 1, mock_get_att_requests_sent());
+    // response to first read does not arrive
+    CHECK_EQUAL(1, mock_simulate_timeout());
+    CHECK_EQUAL(3, event_log_len);
+    for (i=0;i<3;i++){
+        CHECK_EQUAL(0xff00 | ATT_ERROR_TIMEOUT, event_log[i]);
+    }
+    // no queued request has been sent
+    CHECK_EQUAL(requests_sent + 1, mock_get_att_requests_sent());
+    CHECK_EQUAL(0, mock_simulate_timeout());
+    CHECK_EQUAL(3, event_log_len);
+}
+
+int main (int argc, const char * argv[]){
+    att_set_db(profile_data);
+    att_set_write_callback(&att_write_callback);
+    att_set_read_callback(&att_read_callback);
+
+    gatt_client_init();
+
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
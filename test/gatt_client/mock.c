@@ -20,6 +20,16 @@ static uint8_t  l2cap_stack_buffer[HCI_INCOMING_PRE_BUFFER_SIZE + 8 + max_mtu];
 static uint16_t gatt_client_handle = 0x40;
 static hci_connection_t hci_connection;
 
+// responses are delivered by mock_deliver_deferred_response if enabled
+static int      deferred_responses_enabled;
+static uint8_t  deferred_response[max_mtu];
+static uint16_t deferred_response_len;
+static int      deferred_responses_overwritten;
+
+static int      att_requests_sent;
+static int      le_device_index = -1;
+static int      encryption_key_size;
+
 uint16_t get_gatt_client_handle(void){
 	return gatt_client_handle;
 }
@@ -39,6 +49,60 @@ void mock_simulate_connected(void){
 	registered_hci_event_handler(HCI_EVENT_PACKET, 0, (uint8_t *)&packet, sizeof(packet));
 }
 
+void mock_simulate_disconnect(void){
+	uint8_t packet[] = {HCI_EVENT_DISCONNECTION_COMPLETE, 4, 0, (uint8_t) (gatt_client_handle & 0xff), (uint8_t) (gatt_client_handle >> 8), 0x13};
+	registered_hci_event_handler(HCI_EVENT_PACKET, 0, (uint8_t *)&packet, sizeof(packet));
+}
+
+void mock_set_deferred_responses(int enabled){
+	deferred_responses_enabled = enabled;
+	deferred_response_len = 0;
+	deferred_responses_overwritten = 0;
+}
+
+// returns number of requests sent while a response was still pending
+int mock_get_deferred_responses_overwritten(void){
+	return deferred_responses_overwritten;
+}
+
+// returns 1 if a response was delivered
+int mock_deliver_deferred_response(void){
+	if (deferred_response_len == 0) return 0;
+	uint8_t buffer[HCI_INCOMING_PRE_BUFFER_SIZE + 8 + max_mtu];
+	uint8_t * response = &buffer[HCI_INCOMING_PRE_BUFFER_SIZE + 8];
+	uint16_t response_len = deferred_response_len;
+	memcpy(response, deferred_response, response_len);
+	deferred_response_len = 0;
+	att_packet_handler(ATT_DATA_PACKET, gatt_client_handle, response, response_len);
+	return 1;
+}
+
+// ATT PDU from remote ATT server, e.g. indication
+void mock_simulate_att_packet(hci_con_handle_t con_handle, const uint8_t * pdu, uint16_t pdu_len){
+	uint8_t buffer[HCI_INCOMING_PRE_BUFFER_SIZE + 8 + max_mtu];
+	uint8_t * packet = &buffer[HCI_INCOMING_PRE_BUFFER_SIZE + 8];
+	memcpy(packet, pdu, pdu_len);
+	att_packet_handler(ATT_DATA_PACKET, con_handle, packet, pdu_len);
+}
+
+int mock_get_att_requests_sent(void){
+	return att_requests_sent;
+}
+
+// LE Device DB index returned by sm_le_device_index, -1 = not bonded
+void mock_set_le_device_index(int index){
+	le_device_index = index;
+}
+
+// encryption key size returned by gap_encryption_key_size, 0 = not encrypted
+void mock_set_encryption_key_size(int size){
+	encryption_key_size = size;
+}
+
+int gap_encryption_key_size(hci_con_handle_t con_handle){
+	return encryption_key_size;
+}
+
 void mock_simulate_scan_response(void){
 	uint8_t packet[] = {0xE2, 0x13, 0xE2, 0x01, 0x34, 0xB1, 0xF7, 0xD1, 0x77, 0x9B, 0xCC, 0x09, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
 	registered_hci_event_handler(HCI_EVENT_PACKET, 0, (uint8_t *)&packet, sizeof(packet));
@@ -53,6 +117,9 @@ uint8_t gap_connect(bd_addr_t addr, bd_addr_type_t addr_type){
 }
 void gap_set_scan_parameters(uint8_t scan_type, uint16_t scan_interval, uint16_t scan_window){
 }
+int gap_reconnect_security_setup_active(hci_con_handle_t con_handle){
+	return 0;
+}
 
 static void att_init_connection(att_connection_t * att_connection){
     att_connection->mtu = 23;
@@ -111,10 +178,19 @@ void l2cap_request_can_send_fix_channel_now_event(uint16_t handle, uint16_t chan
 int l2cap_send_prepared_connectionless(uint16_t handle, uint16_t cid, uint16_t len){
 	att_connection_t att_connection;
 	att_init_connection(&att_connection);
-	uint8_t response[max_mtu];
-	uint16_t response_len = att_handle_request(&att_connection, l2cap_get_outgoing_buffer(), len, &response[0]);
+	att_requests_sent++;
+	// gatt client reuses HCI + L2CAP header space in front of the ATT PDU
+	uint8_t buffer[HCI_INCOMING_PRE_BUFFER_SIZE + 8 + max_mtu];
+	uint8_t * response = &buffer[HCI_INCOMING_PRE_BUFFER_SIZE + 8];
+	uint16_t response_len = att_handle_request(&att_connection, l2cap_get_outgoing_buffer(), len, response);
+	if (response_len && deferred_responses_enabled){
+		if (deferred_response_len) deferred_responses_overwritten++;
+		memcpy(deferred_response, response, response_len);
+		deferred_response_len = response_len;
+		return 0;
+	}
 	if (response_len){
-		att_packet_handler(ATT_DATA_PACKET, gatt_client_handle, &response[0], response_len);
+		att_packet_handler(ATT_DATA_PACKET, gatt_client_handle, response, response_len);
 	}
 	return 0;
 }
@@ -126,24 +202,62 @@ void sm_cmac_signed_write_start(const sm_key_t key, uint8_t opcode, uint16_t att
 	//sm_notify_client(SM_EVENT_IDENTITY_RESOLVING_SUCCEEDED, sm_central_device_addr_type, sm_central_device_address, 0, sm_central_device_matched);      
 }
 int sm_le_device_index(uint16_t handle ){
-	return -1;
+	return le_device_index;
 }
 
+// active timers, fired by mock_simulate_timeout and mock_run_expired_timers
+static btstack_linked_list_t timers;
+
 void btstack_run_loop_set_timer(btstack_timer_source_t *a, uint32_t timeout_in_ms){
+	a->timeout = timeout_in_ms;
 }
 
 // Set callback that will be executed when timer expires.
 void btstack_run_loop_set_timer_handler(btstack_timer_source_t *ts, void (*process)(btstack_timer_source_t *_ts)){
+	ts->process = process;
 }
 
 // Add/Remove timer source.
 void btstack_run_loop_add_timer(btstack_timer_source_t *timer){
+	btstack_linked_list_remove(&timers, (btstack_linked_item_t *) timer);
+	btstack_linked_list_add_tail(&timers, (btstack_linked_item_t *) timer);
 }
 
 int  btstack_run_loop_remove_timer(btstack_timer_source_t *timer){
+	return btstack_linked_list_remove(&timers, (btstack_linked_item_t *) timer);
+}
+
+static btstack_timer_source_t * mock_next_timer(void){
+	btstack_timer_source_t * next = NULL;
+	btstack_linked_item_t * it;
+	for (it = (btstack_linked_item_t *) timers; it ; it = it->next){
+		btstack_timer_source_t * timer = (btstack_timer_source_t *) it;
+		if (!next || timer->timeout < next->timeout){
+			next = timer;
+		}
+	}
+	return next;
+}
+
+// fire timer that expires next, returns 0 if no timer is active
+int mock_simulate_timeout(void){
+	btstack_timer_source_t * timer = mock_next_timer();
+	if (!timer) return 0;
+	btstack_run_loop_remove_timer(timer);
+	(*timer->process)(timer);
 	return 1;
 }
 
+// fire all timers set with 0 ms timeout, including ones added by their handlers
+void mock_run_expired_timers(void){
+	while (1){
+		btstack_timer_source_t * timer = mock_next_timer();
+		if (!timer || timer->timeout) return;
+		btstack_run_loop_remove_timer(timer);
+		(*timer->process)(timer);
+	}
+}
+
 // todo:
 hci_connection_t * hci_connection_for_bd_addr_and_type(bd_addr_t addr, bd_addr_type_t addr_type){
 	printf("hci_connection_for_bd_addr_and_type not implemented in mock backend\n");
@@ -0,0 +1,28 @@
+//
+// btstack_config.h for hci tests
+//
+
+#ifndef __BTSTACK_CONFIG
+#define __BTSTACK_CONFIG
+
+// Port related features
+#define HAVE_MALLOC
+#define HAVE_POSIX_TIME
+
+// BTstack features that can be enabled
+#define ENABLE_BLE
+#define ENABLE_CLASSIC
+#define ENABLE_LE_PERIPHERAL
+#define ENABLE_LE_CENTRAL
+#define ENABLE_LOG_ERROR
+
+// use small connection index to test fallback to connections list
+#define ENABLE_HCI_CONNECTION_INDEX
+#define HCI_CONNECTION_INDEX_SIZE 8
+
+// BTstack configuration. buffers, sizes, ...
+#define HCI_ACL_PAYLOAD_SIZE 52
+#define HCI_OUTGOING_BUFFERS 4
+#define HCI_ACL_RECOMBINATION_BUFFERS 3
+
+#endif
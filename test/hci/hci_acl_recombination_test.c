@@ -0,0 +1,188 @@
+
+// *****************************************************************************
+//
+// test ACL recombination with buffers from shared pool
+//
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_memory.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_util.h"
+#include "hci.h"
+
+#define MAX_PACKET_SIZE 200
+
+static void (*hci_packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
+
+// last L2CAP packet received
+static uint8_t  received[MAX_PACKET_SIZE];
+static uint16_t received_len;
+static int      received_packets;
+
+static void dummy_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    hci_packet_handler = handler;
+}
+
+static int dummy_can_send_packet_now(uint8_t packet_type){
+    (void) packet_type;
+    return 0;
+}
+
+static hci_transport_t dummy_transport = {
+  /*  .transport.name                          = */  "DUMMY",
+  /*  .transport.init                          = */  NULL,
+  /*  .transport.open                          = */  NULL,
+  /*  .transport.close                         = */  NULL,
+  /*  .transport.register_packet_handler       = */  &dummy_register_packet_handler,
+  /*  .transport.can_send_packet_now           = */  &dummy_can_send_packet_now,
+  /*  .transport.send_packet                   = */  NULL,
+  /*  .transport.set_baudrate                  = */  NULL,
+};
+
+static void acl_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    (void) channel;
+    CHECK_EQUAL(HCI_ACL_DATA_PACKET, packet_type);
+    CHECK(size <= MAX_PACKET_SIZE);
+    memcpy(received, packet, size);
+    received_len = size;
+    received_packets++;
+}
+
+static void emit_le_connection_complete(hci_con_handle_t con_handle){
+    uint8_t event[21];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_LE_META;
+    event[1] = sizeof(event) - 2;
+    event[2] = HCI_SUBEVENT_LE_CONNECTION_COMPLETE;
+    event[3] = 0;   // status
+    little_endian_store_16(event, 4, con_handle);
+    event[6] = HCI_ROLE_SLAVE;
+    event[7] = BD_ADDR_TYPE_LE_PUBLIC;
+    memset(&event[8], (uint8_t) con_handle, 6);
+    little_endian_store_16(event, 14, 0x0018);  // conn interval
+    (*hci_packet_handler)(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static void emit_disconnection_complete(hci_con_handle_t con_handle){
+    uint8_t event[6];
+    event[0] = HCI_EVENT_DISCONNECTION_COMPLETE;
+    event[1] = sizeof(event) - 2;
+    event[2] = 0;   // status
+    little_endian_store_16(event, 3, con_handle);
+    event[5] = 0x13;    // remote user terminated connection
+    (*hci_packet_handler)(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+// first fragment with L2CAP header for l2cap_len bytes payload, filled with tag
+static void emit_first_fragment(hci_con_handle_t con_handle, uint16_t l2cap_len, uint16_t fragment_len, uint8_t tag){
+    uint8_t packet[4 + 4 + MAX_PACKET_SIZE];
+    little_endian_store_16(packet, 0, con_handle | (2 << 12));
+    little_endian_store_16(packet, 2, 4 + fragment_len);
+    little_endian_store_16(packet, 4, l2cap_len);
+    little_endian_store_16(packet, 6, 0x0004);
+    memset(&packet[8], tag, fragment_len);
+    (*hci_packet_handler)(HCI_ACL_DATA_PACKET, packet, 8 + fragment_len);
+}
+
+static void emit_continuation(hci_con_handle_t con_handle, uint16_t fragment_len, uint8_t tag){
+    uint8_t packet[4 + MAX_PACKET_SIZE];
+    little_endian_store_16(packet, 0, con_handle | (1 << 12));
+    little_endian_store_16(packet, 2, fragment_len);
+    memset(&packet[4], tag, fragment_len);
+    (*hci_packet_handler)(HCI_ACL_DATA_PACKET, packet, 4 + fragment_len);
+}
+
+static hci_acl_recombination_stats_t get_stats(void){
+    hci_acl_recombination_stats_t stats;
+    hci_get_acl_recombination_stats(&stats);
+    return stats;
+}
+
+TEST_GROUP(HCIACLRecombination){
+    void setup(void){
+        received_len = 0;
+        received_packets = 0;
+        btstack_memory_init();
+        hci_init(&dummy_transport, NULL);
+        hci_register_acl_packet_handler(&acl_packet_handler);
+        int i;
+        for (i = 0; i <= HCI_ACL_RECOMBINATION_BUFFERS; i++){
+            emit_le_connection_complete(0x40 + i);
+        }
+    }
+    void teardown(void){
+        hci_close();
+    }
+};
+
+TEST(HCIACLRecombination, SingleFragmentWithoutBuffer){
+    emit_first_fragment(0x40, 10, 10, 0x11);
+    CHECK_EQUAL(1, received_packets);
+    CHECK_EQUAL(4 + 4 + 10, received_len);
+    CHECK_EQUAL(0, get_stats().buffers_high_water_mark);
+}
+
+TEST(HCIACLRecombination, Fragments){
+    emit_first_fragment(0x40, 30, 10, 0x11);
+    CHECK_EQUAL(1, get_stats().buffers_used);
+    emit_continuation(0x40, 10, 0x11);
+    emit_continuation(0x40, 10, 0x11);
+    CHECK_EQUAL(1, received_packets);
+    CHECK_EQUAL(4 + 4 + 30, received_len);
+    CHECK_EQUAL(4 + 30, little_endian_read_16(received, 2));
+    uint8_t expected[30];
+    memset(expected, 0x11, sizeof(expected));
+    MEMCMP_EQUAL(expected, &received[8], sizeof(expected));
+    CHECK_EQUAL(0, get_stats().buffers_used);
+    CHECK_EQUAL(1, get_stats().buffers_high_water_mark);
+}
+
+TEST(HCIACLRecombination, PoolExhausted){
+    int i;
+    for (i = 0; i <= HCI_ACL_RECOMBINATION_BUFFERS; i++){
+        emit_first_fragment(0x40 + i, 20, 10, i);
+    }
+    hci_acl_recombination_stats_t stats = get_stats();
+    CHECK_EQUAL(HCI_ACL_RECOMBINATION_BUFFERS, stats.buffers_total);
+    CHECK_EQUAL(HCI_ACL_RECOMBINATION_BUFFERS, stats.buffers_used);
+    CHECK_EQUAL(HCI_ACL_RECOMBINATION_BUFFERS, stats.buffers_high_water_mark);
+    CHECK_EQUAL(1, stats.packets_dropped);
+
+    // continuation for dropped first fragment is ignored
+    emit_continuation(0x40 + HCI_ACL_RECOMBINATION_BUFFERS, 10, 0);
+    CHECK_EQUAL(0, received_packets);
+
+    // completed packet returns buffer
+    emit_continuation(0x40, 10, 0);
+    CHECK_EQUAL(1, received_packets);
+    CHECK_EQUAL(HCI_ACL_RECOMBINATION_BUFFERS - 1, get_stats().buffers_used);
+
+    // disconnect returns buffer of partial packet
+    emit_disconnection_complete(0x41);
+    CHECK_EQUAL(HCI_ACL_RECOMBINATION_BUFFERS - 2, get_stats().buffers_used);
+    CHECK_EQUAL(HCI_ACL_RECOMBINATION_BUFFERS, get_stats().buffers_high_water_mark);
+}
+
+TEST(HCIACLRecombination, StaleFragments){
+    emit_first_fragment(0x40, 30, 10, 0x22);
+    emit_first_fragment(0x40, 20, 10, 0x33);
+    CHECK_EQUAL(1, get_stats().buffers_used);
+    emit_continuation(0x40, 10, 0x33);
+    CHECK_EQUAL(1, received_packets);
+    CHECK_EQUAL(0x33, received[8]);
+    CHECK_EQUAL(0, get_stats().buffers_used);
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,237 @@
+
+// *****************************************************************************
+//
+// test hci connection lookup by con handle and by address,
+// results have to match a linear scan over the connections list
+//
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_memory.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_util.h"
+#include "hci.h"
+
+static void (*hci_packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
+
+static void dummy_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    hci_packet_handler = handler;
+}
+
+static int dummy_can_send_packet_now(uint8_t packet_type){
+    (void) packet_type;
+    return 0;
+}
+
+static hci_transport_t dummy_transport = {
+  /*  .transport.name                          = */  "DUMMY",
+  /*  .transport.init                          = */  NULL,
+  /*  .transport.open                          = */  NULL,
+  /*  .transport.close                         = */  NULL,
+  /*  .transport.register_packet_handler       = */  &dummy_register_packet_handler,
+  /*  .transport.can_send_packet_now           = */  &dummy_can_send_packet_now,
+  /*  .transport.send_packet                   = */  NULL,
+  /*  .transport.set_baudrate                  = */  NULL,
+};
+
+static void setup_address(bd_addr_t addr, int id){
+    memset(addr, 0, 6);
+    addr[0] = 0xC0;
+    addr[5] = (uint8_t) id;
+}
+
+static void emit_le_connection_complete(hci_con_handle_t con_handle, bd_addr_type_t addr_type, bd_addr_t addr){
+    uint8_t event[21];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_LE_META;
+    event[1] = sizeof(event) - 2;
+    event[2] = HCI_SUBEVENT_LE_CONNECTION_COMPLETE;
+    event[3] = 0;   // status
+    little_endian_store_16(event, 4, con_handle);
+    event[6] = HCI_ROLE_SLAVE;
+    event[7] = (uint8_t) addr_type;
+    reverse_bd_addr(addr, &event[8]);
+    little_endian_store_16(event, 14, 0x0018);  // conn interval
+    (*hci_packet_handler)(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static void emit_connection_request(bd_addr_t addr){
+    uint8_t event[12];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_CONNECTION_REQUEST;
+    event[1] = sizeof(event) - 2;
+    reverse_bd_addr(addr, &event[2]);
+    event[11] = 1;  // ACL
+    (*hci_packet_handler)(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static void emit_connection_complete(hci_con_handle_t con_handle, bd_addr_t addr){
+    uint8_t event[13];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_CONNECTION_COMPLETE;
+    event[1] = sizeof(event) - 2;
+    event[2] = 0;   // status
+    little_endian_store_16(event, 3, con_handle);
+    reverse_bd_addr(addr, &event[5]);
+    event[11] = 1;  // ACL
+    (*hci_packet_handler)(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static void emit_disconnection_complete(hci_con_handle_t con_handle){
+    uint8_t event[6];
+    event[0] = HCI_EVENT_DISCONNECTION_COMPLETE;
+    event[1] = sizeof(event) - 2;
+    event[2] = 0;   // status
+    little_endian_store_16(event, 3, con_handle);
+    event[5] = 0x13;    // remote user terminated connection
+    (*hci_packet_handler)(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static int number_of_connections(void){
+    int count = 0;
+    btstack_linked_list_iterator_t it;
+    hci_connections_get_iterator(&it);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        btstack_linked_list_iterator_next(&it);
+        count++;
+    }
+    return count;
+}
+
+static hci_connection_t * scan_for_handle(hci_con_handle_t con_handle){
+    btstack_linked_list_iterator_t it;
+    hci_connections_get_iterator(&it);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * conn = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        if (conn->con_handle == con_handle) return conn;
+    }
+    return NULL;
+}
+
+static hci_connection_t * scan_for_address(bd_addr_t addr, bd_addr_type_t addr_type){
+    btstack_linked_list_iterator_t it;
+    hci_connections_get_iterator(&it);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * conn = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        if (conn->address_type != addr_type) continue;
+        if (memcmp(conn->address, addr, 6) != 0) continue;
+        return conn;
+    }
+    return NULL;
+}
+
+// every connection in the list has to be found by both keys
+static void check_consistency(void){
+    btstack_linked_list_iterator_t it;
+    hci_connections_get_iterator(&it);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * conn = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        POINTERS_EQUAL(scan_for_handle(conn->con_handle), hci_connection_for_handle(conn->con_handle));
+        POINTERS_EQUAL(scan_for_address(conn->address, conn->address_type), hci_connection_for_bd_addr_and_type(conn->address, conn->address_type));
+    }
+}
+
+TEST_GROUP(HCIConnectionIndex){
+    void setup(void){
+        btstack_memory_init();
+        hci_init(&dummy_transport, NULL);
+    }
+    void teardown(void){
+        // also frees remaining connections
+        hci_close();
+    }
+};
+
+TEST(HCIConnectionIndex, LEConnectDisconnect){
+    bd_addr_t addr;
+    int i;
+    for (i = 0; i < 4; i++){
+        setup_address(addr, i);
+        emit_le_connection_complete(0x40 + i, BD_ADDR_TYPE_LE_PUBLIC, addr);
+    }
+    CHECK_EQUAL(4, number_of_connections());
+    check_consistency();
+
+    setup_address(addr, 2);
+    hci_connection_t * conn = hci_connection_for_handle(0x42);
+    CHECK(conn != NULL);
+    POINTERS_EQUAL(conn, hci_connection_for_bd_addr_and_type(addr, BD_ADDR_TYPE_LE_PUBLIC));
+    POINTERS_EQUAL(NULL, hci_connection_for_bd_addr_and_type(addr, BD_ADDR_TYPE_LE_RANDOM));
+
+    emit_disconnection_complete(0x42);
+    CHECK_EQUAL(3, number_of_connections());
+    POINTERS_EQUAL(NULL, hci_connection_for_handle(0x42));
+    POINTERS_EQUAL(NULL, hci_connection_for_bd_addr_and_type(addr, BD_ADDR_TYPE_LE_PUBLIC));
+    check_consistency();
+}
+
+TEST(HCIConnectionIndex, ClassicIncoming){
+    bd_addr_t addr;
+    setup_address(addr, 7);
+    emit_connection_request(addr);
+    hci_connection_t * conn = hci_connection_for_bd_addr_and_type(addr, BD_ADDR_TYPE_CLASSIC);
+    CHECK(conn != NULL);
+    CHECK_EQUAL(HCI_CON_HANDLE_INVALID, conn->con_handle);
+    check_consistency();
+
+    emit_connection_complete(0x0b, addr);
+    POINTERS_EQUAL(conn, hci_connection_for_handle(0x0b));
+    check_consistency();
+
+    emit_disconnection_complete(0x0b);
+    POINTERS_EQUAL(NULL, hci_connection_for_handle(0x0b));
+    POINTERS_EQUAL(NULL, hci_connection_for_bd_addr_and_type(addr, BD_ADDR_TYPE_CLASSIC));
+    CHECK_EQUAL(0, number_of_connections());
+}
+
+TEST(HCIConnectionIndex, MoreConnectionsThanSlots){
+    bd_addr_t addr;
+    int i;
+    for (i = 0; i < 3 * HCI_CONNECTION_INDEX_SIZE; i++){
+        setup_address(addr, i);
+        emit_le_connection_complete(0x100 + i, BD_ADDR_TYPE_LE_RANDOM, addr);
+        check_consistency();
+    }
+    CHECK_EQUAL(3 * HCI_CONNECTION_INDEX_SIZE, number_of_connections());
+    for (i = 0; i < 3 * HCI_CONNECTION_INDEX_SIZE; i += 2){
+        emit_disconnection_complete(0x100 + i);
+        POINTERS_EQUAL(NULL, hci_connection_for_handle(0x100 + i));
+        check_consistency();
+    }
+}
+
+// random connects, re-connects with new handle, duplicate handles, and disconnects
+TEST(HCIConnectionIndex, Random){
+    bd_addr_t addr;
+    int i;
+    srand(1234);
+    for (i = 0; i < 5000; i++){
+        hci_con_handle_t con_handle = rand() % 24;
+        int action = rand() % 3;
+        if (action == 0 || number_of_connections() >= 12){
+            emit_disconnection_complete(con_handle);
+        } else {
+            setup_address(addr, rand() % 16);
+            bd_addr_type_t addr_type = (rand() & 1) ? BD_ADDR_TYPE_LE_RANDOM : BD_ADDR_TYPE_LE_PUBLIC;
+            emit_le_connection_complete(con_handle, addr_type, addr);
+        }
+        check_consistency();
+        // unused keys
+        POINTERS_EQUAL(scan_for_handle(con_handle), hci_connection_for_handle(con_handle));
+        setup_address(addr, rand() % 20);
+        POINTERS_EQUAL(scan_for_address(addr, BD_ADDR_TYPE_LE_PUBLIC), hci_connection_for_bd_addr_and_type(addr, BD_ADDR_TYPE_LE_PUBLIC));
+    }
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
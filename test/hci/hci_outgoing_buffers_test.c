@@ -0,0 +1,258 @@
+
+// *****************************************************************************
+//
+// test queueing of ACL packets in outgoing buffers while the HCI Transport is busy
+//
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_memory.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_util.h"
+#include "hci.h"
+
+#define CONTROLLER_ACL_PACKET_LEN 20
+#define CONTROLLER_ACL_PACKET_NUM 20
+#define MAX_SENT_SIZE             2000
+
+static void (*hci_packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
+
+// last command sent by hci, answered by fake controller
+static uint16_t pending_opcode;
+static int      command_pending;
+
+// asynchronous transport: packet sent event is emitted by fake controller
+static int      packet_in_flight;
+
+// ACL packets sent, stored with H4 packet type
+static uint8_t  sent[MAX_SENT_SIZE];
+static uint16_t sent_len;
+static int      sent_packets;
+
+static void dummy_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    hci_packet_handler = handler;
+}
+
+static int dummy_open(void){
+    return 0;
+}
+
+static int dummy_close(void){
+    return 0;
+}
+
+static int dummy_can_send_packet_now(uint8_t packet_type){
+    (void) packet_type;
+    return !packet_in_flight;
+}
+
+static int dummy_send_packet(uint8_t packet_type, uint8_t *packet, int size){
+    CHECK(!packet_in_flight);
+    packet_in_flight = 1;
+    if (packet_type == HCI_COMMAND_DATA_PACKET){
+        pending_opcode  = little_endian_read_16(packet, 0);
+        command_pending = 1;
+        return 0;
+    }
+    CHECK(sent_len + 1 + size <= MAX_SENT_SIZE);
+    sent[sent_len++] = packet_type;
+    memcpy(&sent[sent_len], packet, size);
+    sent_len += size;
+    sent_packets++;
+    return 0;
+}
+
+static hci_transport_t dummy_transport = {
+  /*  .transport.name                          = */  "DUMMY",
+  /*  .transport.init                          = */  NULL,
+  /*  .transport.open                          = */  &dummy_open,
+  /*  .transport.close                         = */  &dummy_close,
+  /*  .transport.register_packet_handler       = */  &dummy_register_packet_handler,
+  /*  .transport.can_send_packet_now           = */  &dummy_can_send_packet_now,
+  /*  .transport.send_packet                   = */  &dummy_send_packet,
+  /*  .transport.set_baudrate                  = */  NULL,
+};
+
+// complete sending of current packet, answer command with command complete, report small ACL buffers
+static void complete_packet(void){
+    CHECK(packet_in_flight);
+    packet_in_flight = 0;
+    uint8_t packet_sent_event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
+    (*hci_packet_handler)(HCI_EVENT_PACKET, packet_sent_event, sizeof(packet_sent_event));
+    if (!command_pending) return;
+    command_pending = 0;
+    uint8_t event[70];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_COMMAND_COMPLETE;
+    event[1] = sizeof(event) - 2;
+    event[2] = 1;   // num hci command packets
+    little_endian_store_16(event, 3, pending_opcode);
+    event[5] = 0;   // status
+    if (pending_opcode == hci_read_local_supported_commands.opcode){
+        event[6 + 14] = 0x80;   // read buffer size
+    }
+    if (pending_opcode == hci_read_buffer_size.opcode){
+        little_endian_store_16(event, 6, CONTROLLER_ACL_PACKET_LEN);
+        event[8] = 64;
+        little_endian_store_16(event, 9, CONTROLLER_ACL_PACKET_NUM);
+        little_endian_store_16(event, 11, 8);
+    }
+    (*hci_packet_handler)(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static void run_fake_controller(void){
+    while (packet_in_flight){
+        complete_packet();
+    }
+}
+
+static void emit_connection_request(bd_addr_t addr){
+    uint8_t event[12];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_CONNECTION_REQUEST;
+    event[1] = sizeof(event) - 2;
+    reverse_bd_addr(addr, &event[2]);
+    event[11] = 1;  // ACL
+    (*hci_packet_handler)(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static void emit_connection_complete(hci_con_handle_t con_handle, bd_addr_t addr){
+    uint8_t event[13];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_CONNECTION_COMPLETE;
+    event[1] = sizeof(event) - 2;
+    event[2] = 0;   // status
+    little_endian_store_16(event, 3, con_handle);
+    reverse_bd_addr(addr, &event[5]);
+    event[11] = 1;  // ACL
+    (*hci_packet_handler)(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static void emit_disconnection_complete(hci_con_handle_t con_handle){
+    uint8_t event[6];
+    event[0] = HCI_EVENT_DISCONNECTION_COMPLETE;
+    event[1] = sizeof(event) - 2;
+    event[2] = 0;   // status
+    little_endian_store_16(event, 3, con_handle);
+    event[5] = 0x13;    // remote user terminated connection
+    (*hci_packet_handler)(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static void connect(hci_con_handle_t con_handle, uint8_t id){
+    bd_addr_t addr;
+    memset(addr, id, 6);
+    emit_connection_request(addr);
+    run_fake_controller();
+    emit_connection_complete(con_handle, addr);
+    run_fake_controller();
+}
+
+// L2CAP packet with payload filled with tag, returns result of hci_send_acl_packet_buffer
+static int send_packet(hci_con_handle_t con_handle, uint8_t tag, uint16_t len){
+    CHECK(hci_can_send_acl_packet_now(con_handle));
+    hci_reserve_packet_buffer();
+    uint8_t * buffer = hci_get_outgoing_packet_buffer();
+    little_endian_store_16(buffer, 0, con_handle | (2 << 12));
+    little_endian_store_16(buffer, 2, len + 4);
+    little_endian_store_16(buffer, 4, len);
+    little_endian_store_16(buffer, 6, 0x0040);
+    memset(&buffer[8], tag, len);
+    return hci_send_acl_packet_buffer(8 + len);
+}
+
+// tag of n-th sent packet
+static uint8_t sent_tag(int n){
+    uint16_t pos = 0;
+    while (n--){
+        pos += 1 + 4 + little_endian_read_16(sent, pos + 3);
+    }
+    return sent[pos + 1 + 8];
+}
+
+TEST_GROUP(HCIOutgoingBuffers){
+    void setup(void){
+        sent_len = 0;
+        sent_packets = 0;
+        command_pending = 0;
+        packet_in_flight = 0;
+        btstack_memory_init();
+        hci_init(&dummy_transport, NULL);
+        hci_power_control(HCI_POWER_ON);
+        run_fake_controller();
+        CHECK_EQUAL(HCI_STATE_WORKING, hci_get_state());
+        connect(0x0001, 0x11);
+        connect(0x0002, 0x22);
+    }
+    void teardown(void){
+        hci_close();
+    }
+};
+
+TEST(HCIOutgoingBuffers, QueueWhileBusy){
+    // one buffer is used to prepare the next packet
+    int i;
+    for (i = 0; i < HCI_OUTGOING_BUFFERS - 1; i++){
+        CHECK_EQUAL(0, send_packet(0x0001, i, 10));
+    }
+    CHECK_EQUAL(1, sent_packets);
+    CHECK_EQUAL(0, hci_can_send_acl_packet_now(0x0001));
+
+    complete_packet();
+    CHECK_EQUAL(2, sent_packets);
+    CHECK(hci_can_send_acl_packet_now(0x0001));
+    CHECK_EQUAL(0, send_packet(0x0001, i, 10));
+
+    run_fake_controller();
+    CHECK_EQUAL(HCI_OUTGOING_BUFFERS, sent_packets);
+    for (i = 0; i < HCI_OUTGOING_BUFFERS; i++){
+        CHECK_EQUAL(i, sent_tag(i));
+    }
+    CHECK(hci_can_send_acl_packet_now(0x0001));
+}
+
+TEST(HCIOutgoingBuffers, FragmentsAfterQueue){
+    send_packet(0x0001, 1, 10);
+    send_packet(0x0001, 2, 10);
+    // larger than controller ACL buffer, sent in fragments after queued packets
+    send_packet(0x0001, 3, 30);
+    CHECK_EQUAL(0, hci_can_send_acl_packet_now(0x0001));
+    run_fake_controller();
+    // 2 queued + 2 fragments
+    CHECK_EQUAL(4, sent_packets);
+    CHECK_EQUAL(1, sent_tag(0));
+    CHECK_EQUAL(2, sent_tag(1));
+    CHECK_EQUAL(3, sent_tag(2));
+    CHECK_EQUAL(2 * (1 + 4 + 14) + (1 + 4 + 20) + (1 + 4 + 14), sent_len);
+    CHECK(hci_can_send_acl_packet_now(0x0001));
+}
+
+TEST(HCIOutgoingBuffers, DisconnectDropsQueuedPackets){
+    send_packet(0x0001, 1, 10);
+    send_packet(0x0002, 2, 10);
+    send_packet(0x0001, 3, 10);
+    emit_disconnection_complete(0x0002);
+    run_fake_controller();
+    CHECK_EQUAL(2, sent_packets);
+    CHECK_EQUAL(1, sent_tag(0));
+    CHECK_EQUAL(3, sent_tag(1));
+    // all buffers returned to pool
+    int i;
+    for (i = 0; i < HCI_OUTGOING_BUFFERS - 1; i++){
+        send_packet(0x0001, i, 10);
+    }
+    run_fake_controller();
+    CHECK_EQUAL(2 + HCI_OUTGOING_BUFFERS - 1, sent_packets);
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
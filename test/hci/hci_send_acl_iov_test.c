@@ -0,0 +1,277 @@
+
+// *****************************************************************************
+//
+// test sending ACL packets with payload gathered from segments,
+// fragments have to match the ones sent from the contiguous packet buffer
+//
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_memory.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_util.h"
+#include "hci.h"
+
+#define CONTROLLER_ACL_PACKET_LEN 20
+#define CONTROLLER_ACL_PACKET_NUM 20
+#define MAX_SENT_SIZE             2000
+
+static void (*hci_packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
+
+// last command sent by hci, answered by fake controller
+static uint16_t pending_opcode;
+static int      command_pending;
+
+// asynchronous transport: packet sent event is emitted by fake controller
+static int      packet_in_flight;
+
+// ACL fragments sent, stored with H4 packet type
+static uint8_t  sent[MAX_SENT_SIZE];
+static uint16_t sent_len;
+static int      sent_packets;
+static int      sent_segments_in_payload;
+
+static const uint8_t * payload;
+
+static void dummy_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    hci_packet_handler = handler;
+}
+
+static int dummy_open(void){
+    return 0;
+}
+
+static int dummy_close(void){
+    return 0;
+}
+
+static int dummy_can_send_packet_now(uint8_t packet_type){
+    (void) packet_type;
+    return !packet_in_flight;
+}
+
+static void store_sent(const uint8_t * data, uint16_t len){
+    CHECK(sent_len + len <= MAX_SENT_SIZE);
+    memcpy(&sent[sent_len], data, len);
+    sent_len += len;
+}
+
+static int dummy_send_packet(uint8_t packet_type, uint8_t *packet, int size){
+    CHECK(!packet_in_flight);
+    packet_in_flight = 1;
+    if (packet_type == HCI_COMMAND_DATA_PACKET){
+        pending_opcode  = little_endian_read_16(packet, 0);
+        command_pending = 1;
+        return 0;
+    }
+    sent[sent_len++] = packet_type;
+    store_sent(packet, size);
+    sent_packets++;
+    return 0;
+}
+
+static int dummy_send_packet_iov(uint8_t packet_type, const btstack_iovec_t * iov, int iovcnt){
+    CHECK(!packet_in_flight);
+    packet_in_flight = 1;
+    sent[sent_len++] = packet_type;
+    int i;
+    for (i = 0; i < iovcnt; i++){
+        store_sent(iov[i].data, iov[i].len);
+        // payload has not been copied
+        if (iov[i].data >= payload && iov[i].data < payload + MAX_SENT_SIZE){
+            sent_segments_in_payload++;
+        }
+    }
+    sent_packets++;
+    return 0;
+}
+
+static hci_transport_t dummy_transport = {
+  /*  .transport.name                          = */  "DUMMY",
+  /*  .transport.init                          = */  NULL,
+  /*  .transport.open                          = */  &dummy_open,
+  /*  .transport.close                         = */  &dummy_close,
+  /*  .transport.register_packet_handler       = */  &dummy_register_packet_handler,
+  /*  .transport.can_send_packet_now           = */  &dummy_can_send_packet_now,
+  /*  .transport.send_packet                   = */  &dummy_send_packet,
+  /*  .transport.set_baudrate                  = */  NULL,
+  /*  .transport.reset_link                    = */  NULL,
+  /*  .transport.set_sco_config                = */  NULL,
+  /*  .transport.send_packet_iov               = */  &dummy_send_packet_iov,
+};
+
+// complete sending of packets and answer all commands with command complete, report small ACL buffers
+static void run_fake_controller(void){
+    while (packet_in_flight){
+        packet_in_flight = 0;
+        uint8_t packet_sent_event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
+        (*hci_packet_handler)(HCI_EVENT_PACKET, packet_sent_event, sizeof(packet_sent_event));
+        if (!command_pending) continue;
+        command_pending = 0;
+        uint8_t event[70];
+        memset(event, 0, sizeof(event));
+        event[0] = HCI_EVENT_COMMAND_COMPLETE;
+        event[1] = sizeof(event) - 2;
+        event[2] = 1;   // num hci command packets
+        little_endian_store_16(event, 3, pending_opcode);
+        event[5] = 0;   // status
+        if (pending_opcode == hci_read_local_supported_commands.opcode){
+            event[6 + 14] = 0x80;   // read buffer size
+        }
+        if (pending_opcode == hci_read_buffer_size.opcode){
+            little_endian_store_16(event, 6, CONTROLLER_ACL_PACKET_LEN);
+            event[8] = 64;
+            little_endian_store_16(event, 9, CONTROLLER_ACL_PACKET_NUM);
+            little_endian_store_16(event, 11, 8);
+        }
+        (*hci_packet_handler)(HCI_EVENT_PACKET, event, sizeof(event));
+    }
+}
+
+static void emit_connection_request(bd_addr_t addr){
+    uint8_t event[12];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_CONNECTION_REQUEST;
+    event[1] = sizeof(event) - 2;
+    reverse_bd_addr(addr, &event[2]);
+    event[11] = 1;  // ACL
+    (*hci_packet_handler)(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static void emit_connection_complete(hci_con_handle_t con_handle, bd_addr_t addr){
+    uint8_t event[13];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_CONNECTION_COMPLETE;
+    event[1] = sizeof(event) - 2;
+    event[2] = 0;   // status
+    little_endian_store_16(event, 3, con_handle);
+    reverse_bd_addr(addr, &event[5]);
+    event[11] = 1;  // ACL
+    (*hci_packet_handler)(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+// ACL header in packet buffer, L2CAP header and trailer in packet buffer, payload in application memory
+static void send_gathered(hci_con_handle_t con_handle, const uint8_t * data, uint16_t len){
+    CHECK(hci_can_send_acl_packet_now(con_handle));
+    hci_reserve_packet_buffer();
+    uint8_t * buffer = hci_get_outgoing_packet_buffer();
+    little_endian_store_16(buffer, 0, con_handle | (2 << 12));
+    little_endian_store_16(buffer, 4, len + 1);
+    little_endian_store_16(buffer, 6, 0x0040);
+    buffer[8] = 0x55;
+    btstack_iovec_t iov[3];
+    iov[0].data = &buffer[4];
+    iov[0].len  = 4;
+    iov[1].data = data;
+    iov[1].len  = len;
+    iov[2].data = &buffer[8];
+    iov[2].len  = 1;
+    hci_send_acl_packet_buffer_iov(iov, 3);
+    run_fake_controller();
+}
+
+// expected fragments for ACL payload
+static uint16_t expected_fragments(uint8_t * out, hci_con_handle_t con_handle, const uint8_t * acl_payload, uint16_t acl_len){
+    uint16_t pos = 0;
+    uint16_t offset = 0;
+    while (offset < acl_len){
+        uint16_t fragment_len = btstack_min(CONTROLLER_ACL_PACKET_LEN, acl_len - offset);
+        out[pos++] = HCI_ACL_DATA_PACKET;
+        little_endian_store_16(out, pos, con_handle | ((offset ? 1 : 2) << 12));
+        little_endian_store_16(out, pos + 2, fragment_len);
+        memcpy(&out[pos+4], &acl_payload[offset], fragment_len);
+        pos    += 4 + fragment_len;
+        offset += fragment_len;
+    }
+    return pos;
+}
+
+static void check_sent(hci_con_handle_t con_handle, const uint8_t * data, uint16_t len){
+    static uint8_t acl_payload[MAX_SENT_SIZE];
+    static uint8_t expected[MAX_SENT_SIZE];
+    little_endian_store_16(acl_payload, 0, len + 1);
+    little_endian_store_16(acl_payload, 2, 0x0040);
+    memcpy(&acl_payload[4], data, len);
+    acl_payload[4 + len] = 0x55;
+    uint16_t expected_len = expected_fragments(expected, con_handle, acl_payload, len + 5);
+    CHECK_EQUAL(expected_len, sent_len);
+    MEMCMP_EQUAL(expected, sent, expected_len);
+}
+
+static uint8_t data[1000];
+
+TEST_GROUP(HCISendACLIov){
+    bd_addr_t addr;
+    void setup(void){
+        sent_len = 0;
+        sent_packets = 0;
+        sent_segments_in_payload = 0;
+        command_pending = 0;
+        packet_in_flight = 0;
+        dummy_transport.send_packet_iov = &dummy_send_packet_iov;
+        unsigned int i;
+        for (i = 0; i < sizeof(data); i++){
+            data[i] = (uint8_t) i;
+        }
+        payload = data;
+        btstack_memory_init();
+        hci_init(&dummy_transport, NULL);
+        hci_power_control(HCI_POWER_ON);
+        run_fake_controller();
+        CHECK_EQUAL(HCI_STATE_WORKING, hci_get_state());
+        memset(addr, 0x11, 6);
+        emit_connection_request(addr);
+        run_fake_controller();
+        emit_connection_complete(0x0001, addr);
+        run_fake_controller();
+    }
+    void teardown(void){
+        hci_close();
+    }
+};
+
+TEST(HCISendACLIov, SingleFragment){
+    send_gathered(0x0001, data, 10);
+    check_sent(0x0001, data, 10);
+    CHECK_EQUAL(1, sent_packets);
+    CHECK_EQUAL(1, sent_segments_in_payload);
+    CHECK(hci_can_send_acl_packet_now(0x0001));
+}
+
+TEST(HCISendACLIov, Fragments){
+    // 4 byte L2CAP header + 45 byte payload + 1 byte trailer -> 3 fragments, payload split over all of them
+    send_gathered(0x0001, data, 45);
+    check_sent(0x0001, data, 45);
+    CHECK_EQUAL(3, sent_packets);
+    CHECK_EQUAL(3, sent_segments_in_payload);
+}
+
+TEST(HCISendACLIov, LargerThanPacketBuffer){
+    // only possible with gather support in transport
+    send_gathered(0x0001, data, 300);
+    check_sent(0x0001, data, 300);
+    CHECK_EQUAL(16, sent_packets);
+}
+
+TEST(HCISendACLIov, FallbackCopy){
+    // same fragments when transport cannot gather
+    dummy_transport.send_packet_iov = NULL;
+    send_gathered(0x0001, data, 45);
+    check_sent(0x0001, data, 45);
+    CHECK_EQUAL(3, sent_packets);
+    CHECK_EQUAL(0, sent_segments_in_payload);
+    CHECK(hci_can_send_acl_packet_now(0x0001));
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
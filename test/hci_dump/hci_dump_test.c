@@ -0,0 +1,286 @@
+
+// *****************************************************************************
+//
+// HCI Dump test: records written in BlueZ and PacketLogger format, truncation
+// after max packets, rotation to numbered files, and dropped packets reported
+// by the asynchronous writer (ENABLE_HCI_DUMP_ASYNC)
+//
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_config.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "hci_dump.h"
+
+// with a tiny ring buffer, packets get dropped and only few packets can be checked
+#if defined(ENABLE_HCI_DUMP_ASYNC) && defined(HCI_DUMP_ASYNC_BUFFER_SIZE) && (HCI_DUMP_ASYNC_BUFFER_SIZE < 4096)
+#define DROPS_EXPECTED
+#endif
+
+#define TEST_FILE "/tmp/hci_dump_test.pklg"
+#define MAX_FILE  500000
+
+typedef struct {
+    uint8_t  type;
+    uint8_t  in;
+    uint16_t len;
+    uint8_t  data[300];
+} record_t;
+
+static record_t records[2100];
+static int      num_records;
+
+static uint8_t file_buffer[MAX_FILE];
+
+#ifndef DROPS_EXPECTED
+static long file_size(const char * path){
+    FILE * file = fopen(path, "rb");
+    if (!file) return -1;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+#endif
+
+// parse all records of file and append to records, returns -1 if file does not exist or is corrupt
+static int read_records(const char * path, hci_dump_format_t format){
+    FILE * file = fopen(path, "rb");
+    if (!file) return -1;
+    int size = fread(file_buffer, 1, sizeof(file_buffer), file);
+    fclose(file);
+    int pos = 0;
+    while (pos < size){
+        record_t * record = &records[num_records++];
+        int record_size;
+        if (format == HCI_DUMP_BLUEZ){
+            record_size  = 12 + little_endian_read_16(file_buffer, pos);
+            record->in   = file_buffer[pos + 2];
+            record->type = file_buffer[pos + 12];
+        } else {
+            record_size  = 4 + big_endian_read_32(file_buffer, pos);
+            record->in   = 0;
+            record->type = file_buffer[pos + 12];
+        }
+        if (pos + record_size > size) return -1;
+        record->len = record_size - 13;
+        memcpy(record->data, &file_buffer[pos + 13], record->len);
+        pos += record_size;
+    }
+    return 0;
+}
+
+static void remove_files(void){
+    char path[100];
+    unlink(TEST_FILE);
+    int i;
+    for (i=1;i<10;i++){
+        snprintf(path, sizeof(path), "%s.%u", TEST_FILE, i);
+        unlink(path);
+    }
+}
+
+static void dump_numbered_packet(int nr, uint16_t len){
+    uint8_t packet[300];
+    memset(packet, nr, len);
+    little_endian_store_16(packet, 0, nr);
+    hci_dump_packet(HCI_EVENT_PACKET, 1, packet, len);
+}
+
+static int numbered_packet_nr(const record_t * record){
+    return little_endian_read_16(record->data, 0);
+}
+
+TEST_GROUP(HCI_DUMP){
+    void setup(void){
+        remove_files();
+        num_records = 0;
+        hci_dump_set_max_packets(-1);
+        hci_dump_set_rotation(0, 0);
+    }
+    void teardown(void){
+        remove_files();
+    }
+};
+
+TEST(HCI_DUMP, PacketLogger){
+    const uint8_t cmd[] = { 0x03, 0x0c, 0x00 };
+    const uint8_t evt[] = { 0x0e, 0x04, 0x01, 0x03, 0x0c, 0x00 };
+    const uint8_t acl_header[] = { 0x01, 0x20, 0x05, 0x00 };
+    const uint8_t acl_payload_1[] = { 1, 2 };
+    const uint8_t acl_payload_2[] = { 3, 4, 5 };
+    btstack_iovec_t iov[3];
+    iov[0].data = acl_header;
+    iov[0].len  = sizeof(acl_header);
+    iov[1].data = acl_payload_1;
+    iov[1].len  = sizeof(acl_payload_1);
+    iov[2].data = acl_payload_2;
+    iov[2].len  = sizeof(acl_payload_2);
+
+    hci_dump_open(TEST_FILE, HCI_DUMP_PACKETLOGGER);
+    hci_dump_packet(HCI_COMMAND_DATA_PACKET, 0, (uint8_t *) cmd, sizeof(cmd));
+    hci_dump_packet(HCI_EVENT_PACKET, 1, (uint8_t *) evt, sizeof(evt));
+    hci_dump_packet_iov(HCI_ACL_DATA_PACKET, 0, iov, 3);
+    hci_dump_log(HCI_DUMP_LOG_LEVEL_INFO, "hello %u", 42);
+    hci_dump_close();
+
+    CHECK_EQUAL(0, read_records(TEST_FILE, HCI_DUMP_PACKETLOGGER));
+    CHECK_EQUAL(4, num_records);
+    CHECK_EQUAL(0x00, records[0].type);
+    CHECK_EQUAL(sizeof(cmd), records[0].len);
+    MEMCMP_EQUAL(cmd, records[0].data, sizeof(cmd));
+    CHECK_EQUAL(0x01, records[1].type);
+    MEMCMP_EQUAL(evt, records[1].data, sizeof(evt));
+    CHECK_EQUAL(0x02, records[2].type);
+    CHECK_EQUAL(9, records[2].len);
+    const uint8_t acl[] = { 0x01, 0x20, 0x05, 0x00, 1, 2, 3, 4, 5 };
+    MEMCMP_EQUAL(acl, records[2].data, sizeof(acl));
+    CHECK_EQUAL(0xfc, records[3].type);
+    MEMCMP_EQUAL("hello 42", records[3].data, 8);
+    CHECK_EQUAL(0, hci_dump_get_dropped_packets());
+}
+
+TEST(HCI_DUMP, BlueZ){
+    const uint8_t evt[] = { 0x0e, 0x04, 0x01, 0x03, 0x0c, 0x00 };
+    hci_dump_open(TEST_FILE, HCI_DUMP_BLUEZ);
+    hci_dump_packet(HCI_EVENT_PACKET, 1, (uint8_t *) evt, sizeof(evt));
+    hci_dump_packet(HCI_SCO_DATA_PACKET, 0, (uint8_t *) evt, 3);
+    hci_dump_close();
+
+    CHECK_EQUAL(0, read_records(TEST_FILE, HCI_DUMP_BLUEZ));
+    CHECK_EQUAL(2, num_records);
+    CHECK_EQUAL(HCI_EVENT_PACKET, records[0].type);
+    CHECK_EQUAL(1, records[0].in);
+    MEMCMP_EQUAL(evt, records[0].data, sizeof(evt));
+    CHECK_EQUAL(HCI_SCO_DATA_PACKET, records[1].type);
+    CHECK_EQUAL(0, records[1].in);
+    CHECK_EQUAL(3, records[1].len);
+}
+
+TEST(HCI_DUMP, ReopenWithoutClose){
+    hci_dump_open(TEST_FILE ".1", HCI_DUMP_PACKETLOGGER);
+    dump_numbered_packet(1, 10);
+    // previous file gets closed
+    hci_dump_open(TEST_FILE, HCI_DUMP_PACKETLOGGER);
+    dump_numbered_packet(2, 10);
+    hci_dump_close();
+    // packets dumped after close are ignored
+    dump_numbered_packet(3, 10);
+
+    CHECK_EQUAL(0, read_records(TEST_FILE ".1", HCI_DUMP_PACKETLOGGER));
+    CHECK_EQUAL(1, num_records);
+    CHECK_EQUAL(1, numbered_packet_nr(&records[0]));
+    CHECK_EQUAL(0, read_records(TEST_FILE, HCI_DUMP_PACKETLOGGER));
+    CHECK_EQUAL(2, num_records);
+    CHECK_EQUAL(2, numbered_packet_nr(&records[1]));
+}
+
+#ifndef DROPS_EXPECTED
+TEST(HCI_DUMP, MaxPacketsTruncates){
+    hci_dump_set_max_packets(10);
+    hci_dump_open(TEST_FILE, HCI_DUMP_PACKETLOGGER);
+    int i;
+    for (i=0;i<25;i++){
+        dump_numbered_packet(i, 20);
+    }
+    hci_dump_close();
+
+    CHECK_EQUAL(0, read_records(TEST_FILE, HCI_DUMP_PACKETLOGGER));
+    CHECK_EQUAL(5, num_records);
+    CHECK_EQUAL(20, numbered_packet_nr(&records[0]));
+    CHECK_EQUAL(-1, file_size(TEST_FILE ".1"));
+}
+
+TEST(HCI_DUMP, RotationBySize){
+    // 10 records of 13 + 87 bytes per file, keep 3 old files
+    hci_dump_set_rotation(1000, 3);
+    hci_dump_open(TEST_FILE, HCI_DUMP_PACKETLOGGER);
+    int i;
+    for (i=0;i<55;i++){
+        dump_numbered_packet(i, 87);
+    }
+    hci_dump_close();
+
+    CHECK_EQUAL(1000, file_size(TEST_FILE ".3"));
+    CHECK_EQUAL(1000, file_size(TEST_FILE ".2"));
+    CHECK_EQUAL(1000, file_size(TEST_FILE ".1"));
+    CHECK_EQUAL(500,  file_size(TEST_FILE));
+    CHECK_EQUAL(-1,   file_size(TEST_FILE ".4"));
+
+    // oldest to newest
+    CHECK_EQUAL(0, read_records(TEST_FILE ".3", HCI_DUMP_PACKETLOGGER));
+    CHECK_EQUAL(0, read_records(TEST_FILE ".2", HCI_DUMP_PACKETLOGGER));
+    CHECK_EQUAL(0, read_records(TEST_FILE ".1", HCI_DUMP_PACKETLOGGER));
+    CHECK_EQUAL(0, read_records(TEST_FILE, HCI_DUMP_PACKETLOGGER));
+    CHECK_EQUAL(35, num_records);
+    for (i=0;i<num_records;i++){
+        CHECK_EQUAL(20 + i, numbered_packet_nr(&records[i]));
+    }
+}
+
+TEST(HCI_DUMP, RotationByPackets){
+    hci_dump_set_max_packets(10);
+    hci_dump_set_rotation(0, 1);
+    hci_dump_open(TEST_FILE, HCI_DUMP_BLUEZ);
+    int i;
+    for (i=0;i<25;i++){
+        dump_numbered_packet(i, 20);
+    }
+    hci_dump_close();
+
+    CHECK_EQUAL(0, read_records(TEST_FILE ".1", HCI_DUMP_BLUEZ));
+    CHECK_EQUAL(0, read_records(TEST_FILE, HCI_DUMP_BLUEZ));
+    CHECK_EQUAL(15, num_records);
+    CHECK_EQUAL(10, numbered_packet_nr(&records[0]));
+    CHECK_EQUAL(24, numbered_packet_nr(&records[14]));
+}
+#endif
+
+TEST(HCI_DUMP, DroppedPackets){
+    const int num_packets = 2000;
+    hci_dump_open(TEST_FILE, HCI_DUMP_PACKETLOGGER);
+    int i;
+    for (i=0;i<num_packets;i++){
+        dump_numbered_packet(i, 200);
+    }
+    hci_dump_close();
+    uint32_t dropped = hci_dump_get_dropped_packets();
+
+    CHECK_EQUAL(0, read_records(TEST_FILE, HCI_DUMP_PACKETLOGGER));
+    int num_packets_written = 0;
+    int num_reported = 0;
+    for (i=0;i<num_records;i++){
+        if (records[i].type == 0xfc){
+            unsigned int count;
+            records[i].data[records[i].len] = 0;
+            CHECK_EQUAL(1, sscanf((const char *) records[i].data, "hci_dump: %u packets dropped", &count));
+            num_reported += count;
+            continue;
+        }
+        // packets in order, gaps only where drops were reported
+        int nr = numbered_packet_nr(&records[i]);
+        CHECK_EQUAL(num_packets_written + num_reported, nr);
+        num_packets_written++;
+    }
+    CHECK_EQUAL(num_packets, num_packets_written + (int) dropped);
+    CHECK_EQUAL((int) dropped, num_reported);
+#ifdef DROPS_EXPECTED
+    // writer thread cannot keep up with tight loop
+    CHECK(dropped > 0);
+#elif !defined(ENABLE_HCI_DUMP_ASYNC)
+    CHECK_EQUAL(0, dropped);
+#endif
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
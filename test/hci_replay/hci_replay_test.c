@@ -0,0 +1,299 @@
+
+// *****************************************************************************
+//
+// HCI Replay test: packet logs written by hci_dump are read back by the
+// memory-mapped reader in both formats, and the replay transport delivers
+// Controller to Host packets in order, synchronized to commands from the host
+//
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_config.h"
+#include "btstack_run_loop.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "hci_dump.h"
+#include "hci_dump_reader_posix.h"
+#include "hci_transport_replay_posix.h"
+
+#define TEST_FILE "/tmp/hci_replay_test.pklg"
+
+static const uint8_t cmd_reset[]         = { 0x03, 0x0c, 0x00 };
+static const uint8_t evt_reset_complete[] = { 0x0e, 0x04, 0x01, 0x03, 0x0c, 0x00 };
+static const uint8_t cmd_read_bd_addr[]  = { 0x09, 0x10, 0x00 };
+static const uint8_t evt_bd_addr_complete[] = { 0x0e, 0x0a, 0x01, 0x09, 0x10, 0x00, 1, 2, 3, 4, 5, 6 };
+static const uint8_t acl_out[]           = { 0x01, 0x20, 0x02, 0x00, 0xaa, 0xbb };
+static const uint8_t acl_in[]            = { 0x01, 0x20, 0x03, 0x00, 0x11, 0x22, 0x33 };
+static const uint8_t evt_completed[]     = { 0x13, 0x05, 0x01, 0x01, 0x00, 0x01, 0x00 };
+
+// mock run loop with single timer fired by test
+static btstack_timer_source_t * mock_timer;
+static uint64_t mock_timer_timeout_us;
+static uint64_t mock_time_us;
+
+static void mock_run_loop_init(void){
+}
+static void mock_run_loop_set_timer(btstack_timer_source_t * timer, uint32_t timeout_in_ms){
+    UNUSED(timer);
+    mock_timer_timeout_us = mock_time_us + ((uint64_t) timeout_in_ms) * 1000;
+}
+static void mock_run_loop_set_timer_us(btstack_timer_source_t * timer, uint32_t timeout_in_us){
+    UNUSED(timer);
+    mock_timer_timeout_us = mock_time_us + timeout_in_us;
+}
+static void mock_run_loop_add_timer(btstack_timer_source_t * timer){
+    mock_timer = timer;
+}
+static int mock_run_loop_remove_timer(btstack_timer_source_t * timer){
+    if (mock_timer != timer) return 0;
+    mock_timer = NULL;
+    return 1;
+}
+static uint32_t mock_run_loop_get_time_ms(void){
+    return (uint32_t) (mock_time_us / 1000);
+}
+static uint64_t mock_run_loop_get_time_us(void){
+    return mock_time_us;
+}
+
+static const btstack_run_loop_t mock_run_loop = {
+    &mock_run_loop_init,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    &mock_run_loop_set_timer,
+    &mock_run_loop_add_timer,
+    &mock_run_loop_remove_timer,
+    NULL,
+    NULL,
+    &mock_run_loop_get_time_ms,
+    &mock_run_loop_set_timer_us,
+    &mock_run_loop_get_time_us,
+};
+
+// advance time to pending timer and fire it, returns 0 if no timer pending
+static int mock_run_loop_fire_timer(void){
+    if (mock_timer == NULL) return 0;
+    btstack_timer_source_t * timer = mock_timer;
+    mock_timer = NULL;
+    if (mock_timer_timeout_us > mock_time_us){
+        mock_time_us = mock_timer_timeout_us;
+    }
+    timer->process(timer);
+    return 1;
+}
+
+// packets received via transport
+static uint8_t  received_types[20];
+static uint8_t  received_packets[20][20];
+static uint16_t received_sizes[20];
+static uint64_t received_times[20];
+static int      num_received;
+static int      replay_done;
+
+static void packet_handler(uint8_t packet_type, uint8_t * packet, uint16_t size){
+    received_types[num_received] = packet_type;
+    memcpy(received_packets[num_received], packet, size);
+    received_sizes[num_received] = size;
+    received_times[num_received] = mock_time_us;
+    num_received++;
+}
+
+static void done_handler(void){
+    replay_done = 1;
+}
+
+static void write_log(hci_dump_format_t format){
+    hci_dump_open(TEST_FILE, format);
+    hci_dump_packet(HCI_COMMAND_DATA_PACKET, 0, (uint8_t *) cmd_reset, sizeof(cmd_reset));
+    hci_dump_packet(HCI_EVENT_PACKET, 1, (uint8_t *) evt_reset_complete, sizeof(evt_reset_complete));
+    hci_dump_log(HCI_DUMP_LOG_LEVEL_INFO, "log message");
+    hci_dump_packet(HCI_COMMAND_DATA_PACKET, 0, (uint8_t *) cmd_read_bd_addr, sizeof(cmd_read_bd_addr));
+    hci_dump_packet(HCI_EVENT_PACKET, 1, (uint8_t *) evt_bd_addr_complete, sizeof(evt_bd_addr_complete));
+    hci_dump_packet(HCI_ACL_DATA_PACKET, 0, (uint8_t *) acl_out, sizeof(acl_out));
+    hci_dump_packet(HCI_ACL_DATA_PACKET, 1, (uint8_t *) acl_in, sizeof(acl_in));
+    hci_dump_packet(HCI_EVENT_PACKET, 1, (uint8_t *) evt_completed, sizeof(evt_completed));
+    hci_dump_close();
+}
+
+static void check_record(hci_dump_reader_posix_t * reader, uint8_t packet_type, uint8_t in, const uint8_t * packet, uint16_t size){
+    hci_dump_record_t record;
+    CHECK_EQUAL(1, hci_dump_reader_posix_next(reader, &record));
+    CHECK_EQUAL(packet_type, record.packet_type);
+    CHECK_EQUAL(in, record.in);
+    CHECK_EQUAL(size, record.size);
+    MEMCMP_EQUAL(packet, record.packet, size);
+}
+
+static void check_log(hci_dump_format_t format){
+    hci_dump_reader_posix_t reader;
+    CHECK_EQUAL(0, hci_dump_reader_posix_open(&reader, TEST_FILE));
+    CHECK_EQUAL(format, hci_dump_reader_posix_get_format(&reader));
+    check_record(&reader, HCI_COMMAND_DATA_PACKET, 0, cmd_reset, sizeof(cmd_reset));
+    check_record(&reader, HCI_EVENT_PACKET, 1, evt_reset_complete, sizeof(evt_reset_complete));
+    check_record(&reader, LOG_MESSAGE_PACKET, 0, (const uint8_t *) "log message", 11);
+    check_record(&reader, HCI_COMMAND_DATA_PACKET, 0, cmd_read_bd_addr, sizeof(cmd_read_bd_addr));
+    check_record(&reader, HCI_EVENT_PACKET, 1, evt_bd_addr_complete, sizeof(evt_bd_addr_complete));
+    check_record(&reader, HCI_ACL_DATA_PACKET, 0, acl_out, sizeof(acl_out));
+    check_record(&reader, HCI_ACL_DATA_PACKET, 1, acl_in, sizeof(acl_in));
+    check_record(&reader, HCI_EVENT_PACKET, 1, evt_completed, sizeof(evt_completed));
+    hci_dump_record_t record;
+    CHECK_EQUAL(0, hci_dump_reader_posix_next(&reader, &record));
+
+    hci_dump_reader_posix_rewind(&reader);
+    check_record(&reader, HCI_COMMAND_DATA_PACKET, 0, cmd_reset, sizeof(cmd_reset));
+    hci_dump_reader_posix_close(&reader);
+}
+
+TEST_GROUP(HCI_DUMP_READER){
+    void setup(void){
+        unlink(TEST_FILE);
+    }
+    void teardown(void){
+        unlink(TEST_FILE);
+    }
+};
+
+TEST(HCI_DUMP_READER, PacketLogger){
+    write_log(HCI_DUMP_PACKETLOGGER);
+    check_log(HCI_DUMP_PACKETLOGGER);
+}
+
+TEST(HCI_DUMP_READER, BlueZ){
+    write_log(HCI_DUMP_BLUEZ);
+    check_log(HCI_DUMP_BLUEZ);
+}
+
+TEST(HCI_DUMP_READER, IncompleteRecord){
+    write_log(HCI_DUMP_PACKETLOGGER);
+    long size;
+    FILE * file = fopen(TEST_FILE, "rb");
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fclose(file);
+    CHECK_EQUAL(0, truncate(TEST_FILE, size - 2));
+
+    hci_dump_reader_posix_t reader;
+    CHECK_EQUAL(0, hci_dump_reader_posix_open(&reader, TEST_FILE));
+    hci_dump_record_t record;
+    int num_records = 0;
+    while (hci_dump_reader_posix_next(&reader, &record)){
+        num_records++;
+    }
+    CHECK_EQUAL(7, num_records);
+    hci_dump_reader_posix_close(&reader);
+}
+
+TEST(HCI_DUMP_READER, UnknownFormat){
+    FILE * file = fopen(TEST_FILE, "wb");
+    int i;
+    for (i=0;i<100;i++){
+        fputc(0xff, file);
+    }
+    fclose(file);
+    hci_dump_reader_posix_t reader;
+    CHECK(hci_dump_reader_posix_open(&reader, TEST_FILE) != 0);
+    CHECK(hci_dump_reader_posix_open(&reader, "/tmp/does_not_exist.pklg") != 0);
+}
+
+TEST_GROUP(HCI_TRANSPORT_REPLAY){
+    hci_dump_reader_posix_t reader;
+    const hci_transport_t * transport;
+    void setup(void){
+        unlink(TEST_FILE);
+        mock_timer = NULL;
+        mock_time_us = 1000000;
+        num_received = 0;
+        replay_done = 0;
+        write_log(HCI_DUMP_PACKETLOGGER);
+        CHECK_EQUAL(0, hci_dump_reader_posix_open(&reader, TEST_FILE));
+        transport = hci_transport_replay_posix_instance(&reader);
+        hci_transport_replay_posix_register_done_handler(&done_handler);
+        transport->init(NULL);
+        transport->register_packet_handler(&packet_handler);
+    }
+    void teardown(void){
+        transport->close();
+        hci_transport_replay_posix_set_timing_accurate(0);
+        hci_dump_reader_posix_close(&reader);
+        unlink(TEST_FILE);
+    }
+};
+
+TEST(HCI_TRANSPORT_REPLAY, WaitsForCommands){
+    transport->open();
+    // Command Complete for HCI Reset not delivered before command was sent
+    mock_run_loop_fire_timer();
+    CHECK_EQUAL(0, num_received);
+    transport->send_packet(HCI_COMMAND_DATA_PACKET, (uint8_t *) cmd_reset, sizeof(cmd_reset));
+    mock_run_loop_fire_timer();
+    CHECK_EQUAL(1, num_received);
+    MEMCMP_EQUAL(evt_reset_complete, received_packets[0], sizeof(evt_reset_complete));
+
+    transport->send_packet(HCI_COMMAND_DATA_PACKET, (uint8_t *) cmd_read_bd_addr, sizeof(cmd_read_bd_addr));
+    while (mock_run_loop_fire_timer());
+    CHECK_EQUAL(1, replay_done);
+    CHECK_EQUAL(4, num_received);
+    CHECK_EQUAL(HCI_EVENT_PACKET, received_types[1]);
+    MEMCMP_EQUAL(evt_bd_addr_complete, received_packets[1], sizeof(evt_bd_addr_complete));
+    CHECK_EQUAL(HCI_ACL_DATA_PACKET, received_types[2]);
+    CHECK_EQUAL(sizeof(acl_in), received_sizes[2]);
+    MEMCMP_EQUAL(acl_in, received_packets[2], sizeof(acl_in));
+    CHECK_EQUAL(HCI_EVENT_PACKET, received_types[3]);
+
+    hci_transport_replay_posix_stats_t stats;
+    hci_transport_replay_posix_get_stats(&stats);
+    CHECK_EQUAL(3, stats.num_events);
+    CHECK_EQUAL(1, stats.num_acl_packets);
+    CHECK_EQUAL(2, stats.num_host_commands);
+    CHECK_EQUAL(0, stats.num_command_timeouts);
+}
+
+TEST(HCI_TRANSPORT_REPLAY, CommandTimeout){
+    transport->open();
+    // host does not send any commands
+    while (mock_run_loop_fire_timer());
+    CHECK_EQUAL(1, replay_done);
+    CHECK_EQUAL(4, num_received);
+    hci_transport_replay_posix_stats_t stats;
+    hci_transport_replay_posix_get_stats(&stats);
+    CHECK_EQUAL(2, stats.num_command_timeouts);
+}
+
+TEST(HCI_TRANSPORT_REPLAY, TimingAccurate){
+    hci_dump_reader_posix_close(&reader);
+    // packet log with 10 ms between events
+    hci_dump_reader_posix_open(&reader, TEST_FILE);
+    hci_dump_record_t record;
+    uint32_t ts_usec = 0;
+    while (hci_dump_reader_posix_next(&reader, &record)){
+        // timestamps are stored in the mapping, rewrite them in place
+        uint8_t * header = record.packet - 13;
+        big_endian_store_32(header, 4, 100);
+        big_endian_store_32(header, 8, ts_usec);
+        ts_usec += 10000;
+    }
+    hci_transport_replay_posix_set_timing_accurate(1);
+    transport->open();
+    transport->send_packet(HCI_COMMAND_DATA_PACKET, (uint8_t *) cmd_reset, sizeof(cmd_reset));
+    transport->send_packet(HCI_COMMAND_DATA_PACKET, (uint8_t *) cmd_read_bd_addr, sizeof(cmd_read_bd_addr));
+    while (mock_run_loop_fire_timer());
+    CHECK_EQUAL(4, num_received);
+    // records 1, 4, 6, 7
+    CHECK_EQUAL(30000, received_times[1] - received_times[0]);
+    CHECK_EQUAL(20000, received_times[2] - received_times[1]);
+    CHECK_EQUAL(10000, received_times[3] - received_times[2]);
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(&mock_run_loop);
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
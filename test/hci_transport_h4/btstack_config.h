@@ -0,0 +1,24 @@
+//
+// btstack_config.h for hci transport h4 tests
+//
+
+#ifndef __BTSTACK_CONFIG
+#define __BTSTACK_CONFIG
+
+// Port related features
+#define HAVE_MALLOC
+#define HAVE_POSIX_TIME
+
+// BTstack features that can be enabled
+#define ENABLE_BLE
+#define ENABLE_CLASSIC
+#define ENABLE_LOG_ERROR
+#define ENABLE_H4_READ_AHEAD
+
+// small read ahead buffer to test packets spanning several reads
+#define H4_READ_AHEAD_BUFFER_SIZE 100
+
+// BTstack configuration. buffers, sizes, ...
+#define HCI_ACL_PAYLOAD_SIZE 1021
+
+#endif
@@ -0,0 +1,325 @@
+
+// *****************************************************************************
+//
+// test H4 packet parsing with exact block reads and with read ahead
+//
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_uart_block.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "hci_transport.h"
+
+#define MAX_STREAM_SIZE 20000
+#define MAX_PACKETS     200
+
+// H4 stream sent by fake controller
+static uint8_t  stream[MAX_STREAM_SIZE];
+static uint16_t stream_len;
+static uint16_t stream_pos;
+
+// packets received by host, stored with H4 packet type
+static uint8_t  received[MAX_STREAM_SIZE];
+static uint16_t received_len;
+static int      received_packets;
+
+// fake UART driver
+static void (*block_received)(void);
+static void (*data_received)(uint16_t len);
+static uint8_t * read_buffer;
+static uint16_t  read_len;
+static int       read_available_pending;
+static int       read_block_pending;
+static int       num_reads;
+static uint16_t  max_chunk_size;
+
+// data sent by host
+static uint8_t   sent[MAX_STREAM_SIZE];
+static uint16_t  sent_len;
+static int       sent_blocks;
+static void (*block_sent)(void);
+
+static int  fake_uart_init(const btstack_uart_config_t * config){ (void) config; return 0; }
+static int  fake_uart_open(void){ return 0; }
+static int  fake_uart_close(void){ return 0; }
+static void fake_uart_set_block_received(void (*handler)(void)){ block_received = handler; }
+static void fake_uart_set_block_sent(void (*handler)(void)){ block_sent = handler; }
+static void fake_uart_set_data_received(void (*handler)(uint16_t len)){ data_received = handler; }
+
+static void fake_uart_receive_block(uint8_t *buffer, uint16_t len){
+    read_buffer = buffer;
+    read_len = len;
+    read_block_pending = 1;
+}
+
+static void fake_uart_receive_available(uint8_t *buffer, uint16_t max_len){
+    read_buffer = buffer;
+    read_len = max_len;
+    read_available_pending = 1;
+}
+
+static void fake_uart_send_block(const uint8_t *buffer, uint16_t len){
+    memcpy(&sent[sent_len], buffer, len);
+    sent_len += len;
+    sent_blocks++;
+    (*block_sent)();
+}
+
+static void fake_uart_send_block_iov(const btstack_iovec_t * iov, int iovcnt){
+    int i;
+    for (i = 0; i < iovcnt; i++){
+        memcpy(&sent[sent_len], iov[i].data, iov[i].len);
+        sent_len += iov[i].len;
+    }
+    sent_blocks++;
+    (*block_sent)();
+}
+
+static btstack_uart_block_t fake_uart = {
+    /* int  (*init)(hci_transport_config_uart_t * config); */         &fake_uart_init,
+    /* int  (*open)(void); */                                         &fake_uart_open,
+    /* int  (*close)(void); */                                        &fake_uart_close,
+    /* void (*set_block_received)(void (*handler)(void)); */          &fake_uart_set_block_received,
+    /* void (*set_block_sent)(void (*handler)(void)); */              &fake_uart_set_block_sent,
+    /* int  (*set_baudrate)(uint32_t baudrate); */                    NULL,
+    /* int  (*set_parity)(int parity); */                             NULL,
+    /* int  (*set_flowcontrol)(int flowcontrol); */                   NULL,
+    /* void (*receive_block)(uint8_t *buffer, uint16_t len); */       &fake_uart_receive_block,
+    /* void (*send_block)(const uint8_t *buffer, uint16_t length); */ &fake_uart_send_block,
+    /* int (*get_supported_sleep_modes); */                           NULL,
+    /* void (*set_sleep)(btstack_uart_sleep_mode_t sleep_mode); */    NULL,
+    /* void (*set_wakeup_handler)(void (*handler)(void)); */          NULL,
+    /* void (*receive_available)(uint8_t *buffer, uint16_t max_len); */ &fake_uart_receive_available,
+    /* void (*set_data_received)(void (*handler)(uint16_t len)); */   &fake_uart_set_data_received,
+    /* void (*send_block_iov)(const btstack_iovec_t * iov, int iovcnt); */ &fake_uart_send_block_iov,
+};
+
+static hci_transport_config_uart_t config = {
+    HCI_TRANSPORT_CONFIG_UART,
+    115200,
+    0,
+    0,
+    NULL,
+};
+
+static void packet_handler(uint8_t packet_type, uint8_t *packet, uint16_t size){
+    if (packet_type == HCI_EVENT_PACKET && packet[0] == HCI_EVENT_TRANSPORT_PACKET_SENT) return;
+    CHECK(received_len + 1 + size <= MAX_STREAM_SIZE);
+    received[received_len++] = packet_type;
+    memcpy(&received[received_len], packet, size);
+    received_len += size;
+    received_packets++;
+}
+
+static void stream_add_packet(uint8_t packet_type, const uint8_t * header, uint16_t header_len, uint16_t payload_len){
+    stream[stream_len++] = packet_type;
+    memcpy(&stream[stream_len], header, header_len);
+    stream_len += header_len;
+    uint16_t i;
+    for (i = 0; i < payload_len; i++){
+        stream[stream_len++] = (uint8_t) rand();
+    }
+}
+
+static void stream_add_event(uint8_t param_len){
+    uint8_t header[] = { HCI_EVENT_VENDOR_SPECIFIC, param_len };
+    stream_add_packet(HCI_EVENT_PACKET, header, sizeof(header), param_len);
+}
+
+static void stream_add_acl(uint16_t len){
+    uint8_t header[4];
+    little_endian_store_16(header, 0, 0x2001);
+    little_endian_store_16(header, 2, len);
+    stream_add_packet(HCI_ACL_DATA_PACKET, header, sizeof(header), len);
+}
+
+static void stream_add_sco(uint8_t len){
+    uint8_t header[3];
+    little_endian_store_16(header, 0, 0x0002);
+    header[2] = len;
+    stream_add_packet(HCI_SCO_DATA_PACKET, header, sizeof(header), len);
+}
+
+// deliver stream to transport, either as requested blocks or as chunks of random size
+static void run_fake_uart(void){
+    while (stream_pos < stream_len){
+        if (read_block_pending){
+            read_block_pending = 0;
+            CHECK(stream_pos + read_len <= stream_len);
+            memcpy(read_buffer, &stream[stream_pos], read_len);
+            stream_pos += read_len;
+            num_reads++;
+            (*block_received)();
+            continue;
+        }
+        if (read_available_pending){
+            read_available_pending = 0;
+            uint16_t len = 1 + (rand() % max_chunk_size);
+            len = btstack_min(len, read_len);
+            len = btstack_min(len, stream_len - stream_pos);
+            memcpy(read_buffer, &stream[stream_pos], len);
+            stream_pos += len;
+            num_reads++;
+            (*data_received)(len);
+            continue;
+        }
+        FAIL("no read pending");
+    }
+}
+
+static void run_transport(int read_ahead){
+    fake_uart.receive_available = read_ahead ? &fake_uart_receive_available : NULL;
+    const hci_transport_t * transport = hci_transport_h4_instance(&fake_uart);
+    transport->init(&config);
+    transport->register_packet_handler(&packet_handler);
+    transport->open();
+    run_fake_uart();
+    transport->close();
+}
+
+static void check_received_stream(void){
+    CHECK_EQUAL(stream_len, received_len);
+    MEMCMP_EQUAL(stream, received, stream_len);
+}
+
+TEST_GROUP(H4Transport){
+    void setup(void){
+        stream_len = 0;
+        stream_pos = 0;
+        received_len = 0;
+        received_packets = 0;
+        read_block_pending = 0;
+        read_available_pending = 0;
+        num_reads = 0;
+        max_chunk_size = 1000;
+        sent_len = 0;
+        sent_blocks = 0;
+        fake_uart.send_block_iov = &fake_uart_send_block_iov;
+        srand(1);
+    }
+};
+
+TEST(H4Transport, ExactReads){
+    stream_add_event(3);
+    stream_add_acl(27);
+    stream_add_sco(60);
+    run_transport(0);
+    check_received_stream();
+    CHECK_EQUAL(3, received_packets);
+    // packet type, header, payload
+    CHECK_EQUAL(9, num_reads);
+}
+
+TEST(H4Transport, ReadAheadSingleBytes){
+    stream_add_event(3);
+    stream_add_acl(27);
+    stream_add_sco(40);
+    max_chunk_size = 1;
+    run_transport(1);
+    check_received_stream();
+    CHECK_EQUAL(3, received_packets);
+}
+
+TEST(H4Transport, ReadAheadEmptyPayload){
+    // event without parameters at end of read
+    stream_add_event(0);
+    stream_add_event(0);
+    max_chunk_size = 2;
+    run_transport(1);
+    check_received_stream();
+    CHECK_EQUAL(2, received_packets);
+}
+
+TEST(H4Transport, ReadAheadRandom){
+    int num_packets = 0;
+    while (num_packets < MAX_PACKETS && stream_len < MAX_STREAM_SIZE - HCI_ACL_BUFFER_SIZE - 1){
+        num_packets++;
+        switch (rand() % 3){
+            case 0:
+                stream_add_event(rand() % 256);
+                break;
+            case 1:
+                stream_add_acl(rand() % (HCI_ACL_PAYLOAD_SIZE + 1));
+                break;
+            default:
+                stream_add_sco(rand() % 256);
+                break;
+        }
+    }
+    uint16_t chunk_sizes[] = { 1, 5, 64, 1000 };
+    unsigned int j;
+    for (j = 0 ; j < sizeof(chunk_sizes) / sizeof(uint16_t); j++){
+        stream_pos = 0;
+        received_len = 0;
+        received_packets = 0;
+        num_reads = 0;
+        max_chunk_size = chunk_sizes[j];
+        run_transport(1);
+        check_received_stream();
+        CHECK_EQUAL(num_packets, received_packets);
+    }
+}
+
+TEST(H4Transport, ReadAheadFewerReads){
+    int i;
+    for (i = 0; i < 20; i++){
+        stream_add_event(10);
+    }
+    run_transport(1);
+    check_received_stream();
+    CHECK_EQUAL(20, received_packets);
+    // 20 x 13 bytes in reads of up to H4_READ_AHEAD_BUFFER_SIZE
+    CHECK(num_reads < 20);
+}
+
+TEST(H4Transport, SendPacketIov){
+    // ACL packet in outgoing buffer with space for packet type, and same packet as segments
+    uint8_t buffer[1 + 4 + 20];
+    uint8_t * packet = &buffer[1];
+    little_endian_store_16(packet, 0, 0x2001);
+    little_endian_store_16(packet, 2, 20);
+    int i;
+    for (i = 0; i < 20; i++){
+        packet[4+i] = (uint8_t) i;
+    }
+    btstack_iovec_t iov[3];
+    iov[0].data = &packet[0];
+    iov[0].len  = 4;
+    iov[1].data = &packet[4];
+    iov[1].len  = 15;
+    iov[2].data = &packet[19];
+    iov[2].len  = 5;
+
+    const hci_transport_t * transport = hci_transport_h4_instance(&fake_uart);
+    transport->init(&config);
+    transport->register_packet_handler(&packet_handler);
+    transport->open();
+    CHECK(transport->send_packet_iov != NULL);
+    transport->send_packet_iov(HCI_ACL_DATA_PACKET, iov, 3);
+    CHECK(transport->can_send_packet_now(HCI_ACL_DATA_PACKET));
+    transport->send_packet(HCI_ACL_DATA_PACKET, packet, 24);
+    transport->close();
+
+    CHECK_EQUAL(2, sent_blocks);
+    CHECK_EQUAL(2 * 25, sent_len);
+    CHECK_EQUAL(HCI_ACL_DATA_PACKET, sent[0]);
+    MEMCMP_EQUAL(&sent[0], &sent[25], 25);
+}
+
+TEST(H4Transport, SendPacketIovNotSupported){
+    fake_uart.send_block_iov = NULL;
+    const hci_transport_t * transport = hci_transport_h4_instance(&fake_uart);
+    POINTERS_EQUAL(NULL, (void *) transport->send_packet_iov);
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
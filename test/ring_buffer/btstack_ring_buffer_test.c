@@ -93,6 +93,49 @@ TEST(RingBuffer, ReadWriteChunks){
     }
 }
 
+TEST(RingBuffer, PeekSkip){
+    uint8_t test_write_data[] = {1,2,3,4,5,6,7,8};
+    int test_data_size = sizeof(test_write_data);
+    uint8_t test_read_data[test_data_size];
+    uint32_t number_of_bytes_read = 0;
+
+    // move read index to 6, data wraps around end of storage
+    btstack_ring_buffer_write(&ring_buffer, test_write_data, 6);
+    btstack_ring_buffer_skip(&ring_buffer, 6);
+    CHECK_TRUE(btstack_ring_buffer_empty(&ring_buffer));
+    btstack_ring_buffer_write(&ring_buffer, test_write_data, test_data_size);
+
+    uint32_t length;
+    uint8_t * data = btstack_ring_buffer_peek_contiguous(&ring_buffer, &length);
+    CHECK_EQUAL(4, length);
+    CHECK_EQUAL(0, memcmp(test_write_data, data, length));
+
+    memset(test_read_data, 0, test_data_size);
+    btstack_ring_buffer_peek(&ring_buffer, test_read_data, test_data_size, &number_of_bytes_read);
+    CHECK_EQUAL(test_data_size, number_of_bytes_read);
+    CHECK_EQUAL(0, memcmp(test_write_data, test_read_data, test_data_size));
+    CHECK_EQUAL(test_data_size, btstack_ring_buffer_bytes_available(&ring_buffer));
+
+    btstack_ring_buffer_skip(&ring_buffer, 5);
+    data = btstack_ring_buffer_peek_contiguous(&ring_buffer, &length);
+    CHECK_EQUAL(3, length);
+    CHECK_EQUAL(0, memcmp(&test_write_data[5], data, length));
+
+    // skip is limited to available data
+    btstack_ring_buffer_skip(&ring_buffer, 20);
+    CHECK_TRUE(btstack_ring_buffer_empty(&ring_buffer));
+}
+
+TEST(RingBuffer, SkipFullBuffer){
+    uint8_t test_write_data[] = {1,2,3,4,5,6,7,8,9,10};
+    int test_data_size = sizeof(test_write_data);
+
+    btstack_ring_buffer_write(&ring_buffer, test_write_data, test_data_size);
+    CHECK_EQUAL(0, btstack_ring_buffer_bytes_free(&ring_buffer));
+    btstack_ring_buffer_skip(&ring_buffer, 1);
+    CHECK_EQUAL(1, btstack_ring_buffer_bytes_free(&ring_buffer));
+}
+
 int main (int argc, const char * argv[]){
     return CommandLineTestRunner::RunAllTests(argc, argv);
 }
\ No newline at end of file
@@ -0,0 +1,217 @@
+
+// *****************************************************************************
+//
+// epoll run loop test: timer expiry via timerfd, data sources added and removed
+// from within callbacks. The run loop does not return, tests leave it via longjmp
+// from a stop timer
+//
+// *****************************************************************************
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include <setjmp.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_epoll.h"
+
+static jmp_buf run_loop_exit;
+static btstack_timer_source_t stop_timer;
+
+static void stop_timer_handler(btstack_timer_source_t * ts){
+    (void) ts;
+    longjmp(run_loop_exit, 1);
+}
+
+// execute run loop for timeout_ms
+static void run_loop_execute_for(uint32_t timeout_ms){
+    btstack_run_loop_set_timer_handler(&stop_timer, &stop_timer_handler);
+    btstack_run_loop_set_timer(&stop_timer, timeout_ms);
+    btstack_run_loop_add_timer(&stop_timer);
+    if (setjmp(run_loop_exit) == 0){
+        btstack_run_loop_execute();
+    }
+}
+
+// timers: log of fired timers by index
+static btstack_timer_source_t timers[3];
+static int fired_timers[3];
+static int num_fired_timers;
+
+static void timer_handler(btstack_timer_source_t * ts){
+    fired_timers[num_fired_timers++] = (int) (ts - timers);
+}
+
+// data sources: pipe or socket pair per data source, callbacks counted by type
+static btstack_data_source_t data_sources[2];
+static int fds[2][2];
+static int reads[2];
+static int writes[2];
+
+static int data_source_index(btstack_data_source_t * ds){
+    return (int) (ds - data_sources);
+}
+
+static void data_source_read(btstack_data_source_t * ds){
+    uint8_t buffer[10];
+    if (read(ds->source.fd, buffer, sizeof(buffer)) < 0) return;
+    reads[data_source_index(ds)]++;
+}
+
+static void data_source_handler(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    switch (callback_type){
+        case DATA_SOURCE_CALLBACK_READ:
+            data_source_read(ds);
+            break;
+        case DATA_SOURCE_CALLBACK_WRITE:
+            writes[data_source_index(ds)]++;
+            // only report once
+            btstack_run_loop_disable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_WRITE);
+            break;
+        default:
+            break;
+    }
+}
+
+// removes the other data source, whichever is dispatched first
+static void data_source_handler_removes_other(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    (void) callback_type;
+    data_source_read(ds);
+    btstack_run_loop_remove_data_source(&data_sources[1 - data_source_index(ds)]);
+}
+
+// removes itself and reuses the memory of the data source, as if it was freed and allocated again
+static void data_source_handler_removes_itself(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    if (callback_type == DATA_SOURCE_CALLBACK_WRITE){
+        writes[data_source_index(ds)]++;
+        return;
+    }
+    data_source_read(ds);
+    btstack_run_loop_remove_data_source(ds);
+    ds->flags = 0xffff;
+}
+
+// adds second data source from read callback of first one
+static void data_source_handler_adds_other(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    (void) callback_type;
+    data_source_read(ds);
+    btstack_run_loop_add_data_source(&data_sources[1]);
+}
+
+static void data_source_setup(int index, int fd, void (*process)(btstack_data_source_t *, btstack_data_source_callback_type_t)){
+    btstack_run_loop_set_data_source_fd(&data_sources[index], fd);
+    btstack_run_loop_set_data_source_handler(&data_sources[index], process);
+    btstack_run_loop_enable_data_source_callbacks(&data_sources[index], DATA_SOURCE_CALLBACK_READ);
+}
+
+static void make_readable(int index){
+    uint8_t data = 0x55;
+    CHECK_EQUAL(1, write(fds[index][1], &data, 1));
+}
+
+TEST_GROUP(RunLoopEpoll){
+    void setup(void){
+        btstack_run_loop_epoll_get_instance()->init();
+        memset(timers, 0, sizeof(timers));
+        memset(data_sources, 0, sizeof(data_sources));
+        memset(reads, 0, sizeof(reads));
+        memset(writes, 0, sizeof(writes));
+        num_fired_timers = 0;
+        int i;
+        for (i=0;i<2;i++){
+            CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds[i]));
+        }
+    }
+    void teardown(void){
+        int i;
+        for (i=0;i<2;i++){
+            btstack_run_loop_remove_data_source(&data_sources[i]);
+            close(fds[i][0]);
+            close(fds[i][1]);
+        }
+    }
+};
+
+TEST(RunLoopEpoll, TimerExpiry){
+    uint32_t start_ms = btstack_run_loop_get_time_ms();
+    uint32_t timeouts_ms[] = { 30, 10, 20 };
+    int i;
+    for (i=0;i<3;i++){
+        btstack_run_loop_set_timer_handler(&timers[i], &timer_handler);
+        btstack_run_loop_set_timer(&timers[i], timeouts_ms[i]);
+        btstack_run_loop_add_timer(&timers[i]);
+    }
+    run_loop_execute_for(50);
+    CHECK(btstack_run_loop_get_time_ms() - start_ms >= 50);
+    CHECK_EQUAL(3, num_fired_timers);
+    CHECK_EQUAL(1, fired_timers[0]);
+    CHECK_EQUAL(2, fired_timers[1]);
+    CHECK_EQUAL(0, fired_timers[2]);
+}
+
+TEST(RunLoopEpoll, TimerRemoved){
+    btstack_run_loop_set_timer_handler(&timers[0], &timer_handler);
+    btstack_run_loop_set_timer(&timers[0], 10);
+    btstack_run_loop_add_timer(&timers[0]);
+    CHECK_EQUAL(1, btstack_run_loop_remove_timer(&timers[0]));
+    run_loop_execute_for(20);
+    CHECK_EQUAL(0, num_fired_timers);
+}
+
+TEST(RunLoopEpoll, ReadAndWriteCallbacks){
+    data_source_setup(0, fds[0][0], &data_source_handler);
+    btstack_run_loop_enable_data_source_callbacks(&data_sources[0], DATA_SOURCE_CALLBACK_WRITE);
+    btstack_run_loop_add_data_source(&data_sources[0]);
+    make_readable(0);
+    run_loop_execute_for(10);
+    CHECK_EQUAL(1, reads[0]);
+    CHECK_EQUAL(1, writes[0]);
+
+    // no callbacks after remove
+    CHECK_EQUAL(1, btstack_run_loop_remove_data_source(&data_sources[0]));
+    make_readable(0);
+    run_loop_execute_for(10);
+    CHECK_EQUAL(1, reads[0]);
+}
+
+TEST(RunLoopEpoll, RemoveOtherDataSourceInCallback){
+    int i;
+    for (i=0;i<2;i++){
+        data_source_setup(i, fds[i][0], &data_source_handler_removes_other);
+        btstack_run_loop_add_data_source(&data_sources[i]);
+        make_readable(i);
+    }
+    run_loop_execute_for(10);
+    CHECK_EQUAL(1, reads[0] + reads[1]);
+}
+
+TEST(RunLoopEpoll, RemoveDataSourceInReadCallback){
+    data_source_setup(0, fds[0][0], &data_source_handler_removes_itself);
+    btstack_run_loop_enable_data_source_callbacks(&data_sources[0], DATA_SOURCE_CALLBACK_WRITE);
+    btstack_run_loop_add_data_source(&data_sources[0]);
+    make_readable(0);
+    run_loop_execute_for(10);
+    CHECK_EQUAL(1, reads[0]);
+    CHECK_EQUAL(0, writes[0]);
+    data_sources[0].flags = 0;
+}
+
+TEST(RunLoopEpoll, AddDataSourceInCallback){
+    data_source_setup(0, fds[0][0], &data_source_handler_adds_other);
+    data_source_setup(1, fds[1][0], &data_source_handler);
+    btstack_run_loop_add_data_source(&data_sources[0]);
+    make_readable(0);
+    make_readable(1);
+    run_loop_execute_for(10);
+    CHECK_EQUAL(1, reads[0]);
+    CHECK_EQUAL(1, reads[1]);
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(btstack_run_loop_epoll_get_instance());
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
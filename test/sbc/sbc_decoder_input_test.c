@@ -0,0 +1,240 @@
+
+// *****************************************************************************
+//
+// SBC decoder input test: SBC stream decoded in place from large buffers, in small
+// chunks via the frame buffer, and from a ring buffer with frames wrapping around
+// have to produce the same output. mSBC stream decoded from SCO packets of
+// different sizes has to produce the same output.
+//
+// *****************************************************************************
+
+#include "btstack_config.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "btstack_ring_buffer.h"
+#include "btstack_sbc.h"
+#include "btstack_util.h"
+#include "hci_dump.h"
+#include "sbc_test_util.h"
+
+#define NUM_FRAMES       300
+#define MAX_SBC_FRAME    512
+#define MAX_PCM_SAMPLES  (16 * 8 * 2)
+#define RING_BUFFER_SIZE 1031
+
+typedef struct {
+    int16_t  pcm_storage[NUM_FRAMES * MAX_PCM_SAMPLES];
+    sbc_test_pcm_buffer_t pcm;
+    int      good_frames_nr;
+    int      bad_frames_nr;
+    int      zero_frames_nr;
+} decoder_output_t;
+
+static uint8_t  sbc_stream[NUM_FRAMES * (MAX_SBC_FRAME + 16)];
+static uint32_t sbc_stream_len;
+
+static decoder_output_t reference_output;
+static decoder_output_t test_output;
+
+static uint8_t ring_buffer_storage[RING_BUFFER_SIZE];
+
+static int errors;
+
+static void decoder_output_init(decoder_output_t * output){
+    memset(output, 0, sizeof(decoder_output_t));
+    sbc_test_pcm_buffer_init(&output->pcm, output->pcm_storage, sizeof(output->pcm_storage) / sizeof(int16_t));
+}
+
+// triangle wave with noise, corrupt frames and garbage between frames if requested
+static void create_stream(btstack_sbc_mode_t mode, int corrupt){
+    btstack_sbc_encoder_state_t encoder_state;
+    if (mode == SBC_MODE_mSBC){
+        btstack_sbc_encoder_init(&encoder_state, SBC_MODE_mSBC, 15, 8, 0, 16000, 26, 0);
+    } else {
+        btstack_sbc_encoder_init(&encoder_state, SBC_MODE_STANDARD, 16, 8, 0, 44100, 53, 3);
+    }
+    int num_channels = mode == SBC_MODE_mSBC ? 1 : 2;
+    uint32_t seed = 1;
+    int frame;
+    sbc_stream_len = 0;
+    for (frame = 0; frame < NUM_FRAMES; frame++){
+        int16_t pcm[MAX_PCM_SAMPLES];
+        int num_values = btstack_sbc_encoder_num_audio_frames(&encoder_state) * num_channels;
+        sbc_test_pcm_generate(pcm, num_values, frame * num_values, &seed);
+        btstack_sbc_encoder_process_data(&encoder_state, pcm);
+
+        uint8_t * frame_data = btstack_sbc_encoder_sbc_buffer(&encoder_state);
+        uint16_t  frame_len  = btstack_sbc_encoder_sbc_buffer_length(&encoder_state);
+        if (mode == SBC_MODE_mSBC){
+            sbc_stream[sbc_stream_len++] = 0x01;
+            sbc_stream[sbc_stream_len++] = sbc_test_msbc_h2_header_byte_1(frame);
+        }
+        memcpy(&sbc_stream[sbc_stream_len], frame_data, frame_len);
+        if (corrupt && (frame % 7) == 3){
+            // checksum error
+            sbc_stream[sbc_stream_len + 10] ^= 0x55;
+        }
+        if (corrupt && (frame % 11) == 5 && mode == SBC_MODE_mSBC){
+            // zero frame
+            memset(&sbc_stream[sbc_stream_len + 5], 0, 30);
+        }
+        sbc_stream_len += frame_len;
+        if (mode == SBC_MODE_mSBC){
+            sbc_stream[sbc_stream_len++] = 0;
+        }
+        if (corrupt && (frame % 5) == 2 && mode == SBC_MODE_STANDARD){
+            // garbage without syncword
+            memset(&sbc_stream[sbc_stream_len], 0x11, 13);
+            sbc_stream_len += 13;
+        }
+    }
+}
+
+static void decode_in_chunks(btstack_sbc_mode_t mode, decoder_output_t * output, uint32_t chunk_size){
+    btstack_sbc_decoder_state_t decoder_state;
+    decoder_output_init(output);
+    btstack_sbc_decoder_init(&decoder_state, mode, &sbc_test_handle_pcm_data, &output->pcm);
+    uint32_t pos = 0;
+    while (pos < sbc_stream_len){
+        uint32_t len = btstack_min(chunk_size, sbc_stream_len - pos);
+        btstack_sbc_decoder_process_data(&decoder_state, 0, &sbc_stream[pos], len);
+        pos += len;
+    }
+    output->good_frames_nr = decoder_state.good_frames_nr;
+    output->bad_frames_nr  = decoder_state.bad_frames_nr;
+    output->zero_frames_nr = decoder_state.zero_frames_nr;
+}
+
+static void decode_from_ring_buffer(decoder_output_t * output, uint32_t chunk_size, int max_frames){
+    btstack_sbc_decoder_state_t decoder_state;
+    btstack_ring_buffer_t ring_buffer;
+    decoder_output_init(output);
+    btstack_sbc_decoder_init(&decoder_state, SBC_MODE_STANDARD, &sbc_test_handle_pcm_data, &output->pcm);
+    btstack_ring_buffer_init(&ring_buffer, ring_buffer_storage, sizeof(ring_buffer_storage));
+    uint32_t pos = 0;
+    while (pos < sbc_stream_len){
+        uint32_t len = btstack_min(btstack_min(chunk_size, sbc_stream_len - pos), btstack_ring_buffer_bytes_free(&ring_buffer));
+        btstack_ring_buffer_write(&ring_buffer, &sbc_stream[pos], len);
+        pos += len;
+        btstack_sbc_decoder_process_ring_buffer(&decoder_state, &ring_buffer, max_frames);
+    }
+    while (btstack_sbc_decoder_process_ring_buffer(&decoder_state, &ring_buffer, max_frames) > 0);
+    if (btstack_ring_buffer_bytes_available(&ring_buffer) >= MAX_SBC_FRAME){
+        printf("ring buffer not drained\n");
+        errors++;
+    }
+    output->good_frames_nr = decoder_state.good_frames_nr;
+    output->bad_frames_nr  = decoder_state.bad_frames_nr;
+    output->zero_frames_nr = decoder_state.zero_frames_nr;
+}
+
+static void compare_output(const char * name){
+    if (reference_output.pcm.len == 0){
+        printf("%s: no PCM data decoded\n", name);
+        errors++;
+    }
+    if (reference_output.pcm.overflow || test_output.pcm.overflow){
+        printf("%s: too much PCM data\n", name);
+        errors++;
+    }
+    if (reference_output.pcm.len != test_output.pcm.len || memcmp(reference_output.pcm.data, test_output.pcm.data, reference_output.pcm.len * sizeof(int16_t)) != 0){
+        printf("%s: PCM data differs\n", name);
+        errors++;
+    }
+    if (reference_output.good_frames_nr != test_output.good_frames_nr || reference_output.bad_frames_nr != test_output.bad_frames_nr
+        || reference_output.zero_frames_nr != test_output.zero_frames_nr){
+        printf("%s: frame count differs\n", name);
+        errors++;
+    }
+    printf("%-45s %4u good, %3u bad, %3u zero frames\n", name, test_output.good_frames_nr, test_output.bad_frames_nr, test_output.zero_frames_nr);
+}
+
+// simulated corrupt frames must not modify input
+static void check_simulated_corruption(btstack_sbc_mode_t mode, const char * name){
+    static uint8_t sbc_stream_copy[sizeof(sbc_stream)];
+    memcpy(sbc_stream_copy, sbc_stream, sbc_stream_len);
+    btstack_sbc_decoder_test_simulate_corrupt_frames(10);
+    // complete frames are decoded in place
+    decode_in_chunks(mode, &test_output, sbc_stream_len);
+    btstack_sbc_decoder_test_simulate_corrupt_frames(0);
+    if (test_output.good_frames_nr == NUM_FRAMES){
+        printf("%s: no corrupt frames simulated\n", name);
+        errors++;
+    }
+    if (memcmp(sbc_stream_copy, sbc_stream, sbc_stream_len) != 0){
+        printf("%s: input modified\n", name);
+        errors++;
+    }
+    printf("%-45s %4u good, %3u bad, %3u zero frames\n", name, test_output.good_frames_nr, test_output.bad_frames_nr, test_output.zero_frames_nr);
+}
+
+int main (int argc, const char * argv[]){
+    (void) argc;
+    (void) argv;
+    hci_dump_enable_log_level(HCI_DUMP_LOG_LEVEL_INFO, 0);
+
+    int corrupt;
+    for (corrupt = 0; corrupt < 2; corrupt++){
+        char name[60];
+
+        // SBC: reference decodes byte by byte via frame buffer
+        create_stream(SBC_MODE_STANDARD, corrupt);
+        decode_in_chunks(SBC_MODE_STANDARD, &reference_output, 1);
+        if (!corrupt && reference_output.good_frames_nr != NUM_FRAMES){
+            printf("SBC: not all frames decoded\n");
+            errors++;
+        }
+
+        snprintf(name, sizeof(name), "SBC%s, complete stream", corrupt ? " corrupt" : "");
+        decode_in_chunks(SBC_MODE_STANDARD, &test_output, sbc_stream_len);
+        compare_output(name);
+
+        snprintf(name, sizeof(name), "SBC%s, chunks of 7 bytes", corrupt ? " corrupt" : "");
+        decode_in_chunks(SBC_MODE_STANDARD, &test_output, 7);
+        compare_output(name);
+
+        snprintf(name, sizeof(name), "SBC%s, chunks of 900 bytes", corrupt ? " corrupt" : "");
+        decode_in_chunks(SBC_MODE_STANDARD, &test_output, 900);
+        compare_output(name);
+
+        snprintf(name, sizeof(name), "SBC%s, ring buffer, single frames", corrupt ? " corrupt" : "");
+        decode_from_ring_buffer(&test_output, 333, 1);
+        compare_output(name);
+
+        snprintf(name, sizeof(name), "SBC%s, ring buffer, all frames", corrupt ? " corrupt" : "");
+        decode_from_ring_buffer(&test_output, 500, 0);
+        compare_output(name);
+
+        // mSBC: reference decodes 60 byte SCO packets
+        create_stream(SBC_MODE_mSBC, corrupt);
+        decode_in_chunks(SBC_MODE_mSBC, &reference_output, 60);
+        if (!corrupt && reference_output.good_frames_nr != NUM_FRAMES){
+            printf("mSBC: not all frames decoded\n");
+            errors++;
+        }
+
+        snprintf(name, sizeof(name), "mSBC%s, 24 byte packets", corrupt ? " corrupt" : "");
+        decode_in_chunks(SBC_MODE_mSBC, &test_output, 24);
+        compare_output(name);
+
+        snprintf(name, sizeof(name), "mSBC%s, 120 byte packets", corrupt ? " corrupt" : "");
+        decode_in_chunks(SBC_MODE_mSBC, &test_output, 120);
+        compare_output(name);
+    }
+
+    create_stream(SBC_MODE_STANDARD, 0);
+    check_simulated_corruption(SBC_MODE_STANDARD, "SBC, simulated corrupt frames");
+    create_stream(SBC_MODE_mSBC, 0);
+    check_simulated_corruption(SBC_MODE_mSBC, "mSBC, simulated corrupt frames");
+
+    if (errors){
+        printf("FAILED: %u errors\n", errors);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,179 @@
+
+// *****************************************************************************
+//
+// SBC multi-instance test: several encoders and decoders used concurrently
+// have to produce the same output as a single encoder / decoder per stream
+//
+// *****************************************************************************
+
+#include "btstack_config.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "btstack_sbc.h"
+#include "btstack_util.h"
+#include "hci_dump.h"
+#include "sbc_test_util.h"
+
+#define NUM_FRAMES       200
+#define MAX_SBC_FRAME    512
+#define MAX_PCM_SAMPLES  (16 * 8 * 2)
+#define DECODER_CHUNK    7
+
+typedef struct {
+    const char * name;
+    btstack_sbc_mode_t mode;
+    int blocks;
+    int subbands;
+    int allocation_method;
+    int sample_rate;
+    int bitpool;
+    int channel_mode;
+} stream_config_t;
+
+// channel mode: 0 = mono, 1 = dual channel, 2 = stereo, 3 = joint stereo
+static const stream_config_t stream_configs[] = {
+    { "A2DP 44.1 kHz joint stereo, bitpool 53", SBC_MODE_STANDARD, 16, 8, 0, 44100, 53, 3 },
+    { "A2DP 44.1 kHz joint stereo, bitpool 35", SBC_MODE_STANDARD, 16, 8, 0, 44100, 35, 3 },
+    { "A2DP 48 kHz stereo, 4 subbands",         SBC_MODE_STANDARD,  8, 4, 1, 48000, 30, 2 },
+    { "A2DP 32 kHz dual channel",               SBC_MODE_STANDARD, 12, 8, 1, 32000, 20, 1 },
+    { "A2DP 16 kHz mono",                       SBC_MODE_STANDARD,  4, 8, 0, 16000, 31, 0 },
+    { "HFP mSBC",                               SBC_MODE_mSBC,     15, 8, 0, 16000, 26, 0 },
+};
+
+#define NUM_STREAMS (sizeof(stream_configs) / sizeof(stream_config_t))
+
+typedef struct {
+    const stream_config_t * config;
+    btstack_sbc_encoder_state_t encoder_state;
+    btstack_sbc_decoder_state_t decoder_state;
+    uint32_t pcm_seed;
+    int frame_nr;
+    // SBC stream, for mSBC with H2 header and padding
+    uint8_t  sbc_data[NUM_FRAMES * (MAX_SBC_FRAME + 3)];
+    uint32_t sbc_len;
+    // decoded samples
+    int16_t  pcm_storage[NUM_FRAMES * MAX_PCM_SAMPLES];
+    sbc_test_pcm_buffer_t pcm;
+} stream_t;
+
+static stream_t reference_streams[NUM_STREAMS];
+static stream_t concurrent_streams[NUM_STREAMS];
+
+static int errors;
+
+static void stream_init(stream_t * stream, const stream_config_t * config, uint32_t seed){
+    memset(stream, 0, sizeof(stream_t));
+    stream->config = config;
+    stream->pcm_seed = seed;
+    btstack_sbc_encoder_init(&stream->encoder_state, config->mode, config->blocks, config->subbands,
+        config->allocation_method, config->sample_rate, config->bitpool, config->channel_mode);
+    sbc_test_pcm_buffer_init(&stream->pcm, stream->pcm_storage, sizeof(stream->pcm_storage) / sizeof(int16_t));
+    btstack_sbc_decoder_init(&stream->decoder_state, config->mode, &sbc_test_handle_pcm_data, &stream->pcm);
+}
+
+// triangle wave with noise, different per stream
+static void stream_encode_frame(stream_t * stream){
+    int16_t pcm[MAX_PCM_SAMPLES];
+    int num_channels = (stream->config->mode == SBC_MODE_mSBC || stream->config->channel_mode == 0) ? 1 : 2;
+    int num_values = btstack_sbc_encoder_num_audio_frames(&stream->encoder_state) * num_channels;
+    sbc_test_pcm_generate(pcm, num_values, stream->frame_nr * num_values, &stream->pcm_seed);
+    btstack_sbc_encoder_process_data(&stream->encoder_state, pcm);
+
+    uint8_t * frame = btstack_sbc_encoder_sbc_buffer(&stream->encoder_state);
+    uint16_t  frame_len = btstack_sbc_encoder_sbc_buffer_length(&stream->encoder_state);
+    if (stream->config->mode == SBC_MODE_mSBC){
+        stream->sbc_data[stream->sbc_len++] = 0x01;
+        stream->sbc_data[stream->sbc_len++] = sbc_test_msbc_h2_header_byte_1(stream->frame_nr);
+    }
+    memcpy(&stream->sbc_data[stream->sbc_len], frame, frame_len);
+    stream->sbc_len += frame_len;
+    if (stream->config->mode == SBC_MODE_mSBC){
+        stream->sbc_data[stream->sbc_len++] = 0;
+    }
+    stream->frame_nr++;
+}
+
+static void stream_decode(stream_t * stream, uint32_t offset, uint32_t len){
+    btstack_sbc_decoder_process_data(&stream->decoder_state, 0, &stream->sbc_data[offset], len);
+}
+
+static void compare_streams(const stream_t * reference, const stream_t * concurrent){
+    const char * name = reference->config->name;
+    if (reference->sbc_len != concurrent->sbc_len || memcmp(reference->sbc_data, concurrent->sbc_data, reference->sbc_len) != 0){
+        printf("%s: SBC data differs\n", name);
+        errors++;
+    }
+    if (reference->pcm.len == 0){
+        printf("%s: no PCM data decoded\n", name);
+        errors++;
+    }
+    if (reference->pcm.overflow || concurrent->pcm.overflow){
+        printf("%s: too much PCM data\n", name);
+        errors++;
+    }
+    if (reference->pcm.len != concurrent->pcm.len || memcmp(reference->pcm.data, concurrent->pcm.data, reference->pcm.len * sizeof(int16_t)) != 0){
+        printf("%s: PCM data differs\n", name);
+        errors++;
+    }
+    printf("%-40s %6u SBC bytes, %7u PCM samples\n", name, reference->sbc_len, reference->pcm.len);
+}
+
+int main (int argc, const char * argv[]){
+    (void) argc;
+    (void) argv;
+    hci_dump_enable_log_level(HCI_DUMP_LOG_LEVEL_INFO, 0);
+
+    unsigned int i;
+    int frame;
+
+    // single instance path: one encoder and decoder at a time, SBC stream decoded at once,
+    // mSBC decoder expects complete packets from SCO
+    for (i = 0; i < NUM_STREAMS; i++){
+        stream_t * stream = &reference_streams[i];
+        stream_init(stream, &stream_configs[i], i + 1);
+        uint32_t decoded_bytes = 0;
+        for (frame = 0; frame < NUM_FRAMES; frame++){
+            stream_encode_frame(stream);
+            if (stream->config->mode == SBC_MODE_mSBC){
+                stream_decode(stream, decoded_bytes, stream->sbc_len - decoded_bytes);
+                decoded_bytes = stream->sbc_len;
+            }
+        }
+        stream_decode(stream, decoded_bytes, stream->sbc_len - decoded_bytes);
+    }
+
+    // all encoders and decoders active at the same time, frames interleaved,
+    // SBC data fed to decoders in small chunks
+    for (i = 0; i < NUM_STREAMS; i++){
+        stream_init(&concurrent_streams[i], &stream_configs[i], i + 1);
+    }
+    uint32_t decoded_bytes[NUM_STREAMS];
+    memset(decoded_bytes, 0, sizeof(decoded_bytes));
+    for (frame = 0; frame < NUM_FRAMES; frame++){
+        for (i = 0; i < NUM_STREAMS; i++){
+            stream_t * stream = &concurrent_streams[i];
+            stream_encode_frame(stream);
+            uint32_t chunk = stream->config->mode == SBC_MODE_mSBC ? stream->sbc_len - decoded_bytes[i] : DECODER_CHUNK;
+            while (stream->sbc_len - decoded_bytes[i] >= chunk){
+                stream_decode(stream, decoded_bytes[i], chunk);
+                decoded_bytes[i] += chunk;
+            }
+        }
+    }
+    for (i = 0; i < NUM_STREAMS; i++){
+        stream_t * stream = &concurrent_streams[i];
+        stream_decode(stream, decoded_bytes[i], stream->sbc_len - decoded_bytes[i]);
+        compare_streams(&reference_streams[i], stream);
+    }
+
+    if (errors){
+        printf("FAILED: %u errors\n", errors);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
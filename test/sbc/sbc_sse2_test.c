@@ -0,0 +1,128 @@
+
+// *****************************************************************************
+//
+// SBC SSE2 test: encodes and decodes a test signal with various configurations
+// and writes SBC and PCM data to a file. Built with and without DISABLE_SBC_SSE2,
+// the output of both builds has to be identical
+//
+// *****************************************************************************
+
+#include "btstack_config.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "btstack_sbc.h"
+#include "btstack_util.h"
+#include "hci_dump.h"
+#include "sbc_test_util.h"
+
+#define NUM_FRAMES       100
+#define MAX_SBC_FRAME    512
+#define MAX_PCM_SAMPLES  (16 * 8 * 2)
+
+typedef struct {
+    const char * name;
+    btstack_sbc_mode_t mode;
+    int blocks;
+    int subbands;
+    int allocation_method;
+    int sample_rate;
+    int bitpool;
+    int channel_mode;
+} stream_config_t;
+
+// channel mode: 0 = mono, 1 = dual channel, 2 = stereo, 3 = joint stereo
+static const stream_config_t stream_configs[] = {
+    { "A2DP 44.1 kHz joint stereo, bitpool 53", SBC_MODE_STANDARD, 16, 8, 0, 44100, 53, 3 },
+    { "A2DP 48 kHz stereo, 4 subbands",         SBC_MODE_STANDARD,  8, 4, 1, 48000, 30, 2 },
+    { "A2DP 32 kHz dual channel",               SBC_MODE_STANDARD, 12, 8, 1, 32000, 20, 1 },
+    { "A2DP 16 kHz mono, 4 subbands",           SBC_MODE_STANDARD,  4, 4, 0, 16000, 31, 0 },
+    { "HFP mSBC",                               SBC_MODE_mSBC,     15, 8, 0, 16000, 26, 0 },
+};
+
+#define NUM_STREAMS (sizeof(stream_configs) / sizeof(stream_config_t))
+
+static int16_t pcm_storage[NUM_FRAMES * MAX_PCM_SAMPLES];
+
+static int encode_and_decode(const stream_config_t * config, FILE * output){
+    btstack_sbc_encoder_state_t encoder_state;
+    btstack_sbc_decoder_state_t decoder_state;
+    sbc_test_pcm_buffer_t pcm_buffer;
+    btstack_sbc_encoder_init(&encoder_state, config->mode, config->blocks, config->subbands,
+        config->allocation_method, config->sample_rate, config->bitpool, config->channel_mode);
+    sbc_test_pcm_buffer_init(&pcm_buffer, pcm_storage, sizeof(pcm_storage) / sizeof(int16_t));
+    btstack_sbc_decoder_init(&decoder_state, config->mode, &sbc_test_handle_pcm_data, &pcm_buffer);
+
+    int num_channels = (config->mode == SBC_MODE_mSBC || config->channel_mode == 0) ? 1 : 2;
+    uint32_t seed = 1;
+    uint32_t sbc_len = 0;
+    int frame;
+    for (frame = 0; frame < NUM_FRAMES; frame++){
+        int16_t pcm[MAX_PCM_SAMPLES];
+        int num_values = btstack_sbc_encoder_num_audio_frames(&encoder_state) * num_channels;
+        sbc_test_pcm_generate(pcm, num_values, frame * num_values, &seed);
+        btstack_sbc_encoder_process_data(&encoder_state, pcm);
+
+        uint8_t * frame_data = btstack_sbc_encoder_sbc_buffer(&encoder_state);
+        uint16_t  frame_len  = btstack_sbc_encoder_sbc_buffer_length(&encoder_state);
+        fwrite(frame_data, 1, frame_len, output);
+        sbc_len += frame_len;
+
+        if (config->mode == SBC_MODE_mSBC){
+            uint8_t packet[MAX_SBC_FRAME + 3];
+            packet[0] = 0x01;
+            packet[1] = sbc_test_msbc_h2_header_byte_1(frame);
+            memcpy(&packet[2], frame_data, frame_len);
+            packet[2 + frame_len] = 0;
+            btstack_sbc_decoder_process_data(&decoder_state, 0, packet, frame_len + 3);
+        } else {
+            btstack_sbc_decoder_process_data(&decoder_state, 0, frame_data, frame_len);
+        }
+    }
+
+    fwrite(pcm_buffer.data, sizeof(int16_t), pcm_buffer.len, output);
+    printf("%-40s %6u SBC bytes, %7u PCM samples\n", config->name, sbc_len, pcm_buffer.len);
+
+    if (pcm_buffer.overflow || pcm_buffer.len == 0 || decoder_state.good_frames_nr != NUM_FRAMES){
+        printf("%s: decoding failed\n", config->name);
+        return 1;
+    }
+    return 0;
+}
+
+int main (int argc, const char * argv[]){
+    if (argc < 2){
+        printf("Usage: %s output-file\n", argv[0]);
+        return 1;
+    }
+    hci_dump_enable_log_level(HCI_DUMP_LOG_LEVEL_INFO, 0);
+
+#if defined(__SSE2__) && !defined(DISABLE_SBC_SSE2)
+    printf("SSE2 filterbanks\n");
+#else
+    printf("C filterbanks\n");
+#endif
+
+    FILE * output = fopen(argv[1], "wb");
+    if (!output){
+        printf("Cannot create %s\n", argv[1]);
+        return 1;
+    }
+
+    int errors = 0;
+    unsigned int i;
+    for (i = 0; i < NUM_STREAMS; i++){
+        errors += encode_and_decode(&stream_configs[i], output);
+    }
+    fclose(output);
+
+    if (errors){
+        printf("FAILED: %u errors\n", errors);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// *****************************************************************************
+//
+// SBC test helpers: PCM test signal and decoder output collection
+//
+// *****************************************************************************
+
+#include "sbc_test_util.h"
+
+#include <string.h>
+
+#include "btstack_util.h"
+
+static const uint8_t msbc_header_h2_byte_1_table[] = { 0x08, 0x38, 0xc8, 0xf8 };
+
+// triangle wave with noise
+void sbc_test_pcm_generate(int16_t * pcm, int num_values, uint32_t offset, uint32_t * seed){
+    int i;
+    for (i = 0; i < num_values; i++){
+        *seed = *seed * 1103515245 + 12345;
+        int phase = (offset + i) % 200;
+        int triangle = phase < 100 ? phase : 200 - phase;
+        pcm[i] = (int16_t) ((triangle - 50) * 300 + (int) ((*seed >> 16) & 0x3ff) - 512);
+    }
+}
+
+void sbc_test_pcm_buffer_init(sbc_test_pcm_buffer_t * buffer, int16_t * storage, uint32_t size){
+    buffer->data = storage;
+    buffer->size = size;
+    buffer->len  = 0;
+    buffer->overflow = 0;
+}
+
+void sbc_test_handle_pcm_data(int16_t * data, int num_samples, int num_channels, int sample_rate, void * context){
+    UNUSED(sample_rate);
+    sbc_test_pcm_buffer_t * buffer = (sbc_test_pcm_buffer_t *) context;
+    uint32_t num_values = num_samples * num_channels;
+    if (buffer->len + num_values > buffer->size) {
+        buffer->overflow = 1;
+        return;
+    }
+    memcpy(&buffer->data[buffer->len], data, num_values * sizeof(int16_t));
+    buffer->len += num_values;
+}
+
+uint8_t sbc_test_msbc_h2_header_byte_1(int frame_nr){
+    return msbc_header_h2_byte_1_table[frame_nr & 3];
+}
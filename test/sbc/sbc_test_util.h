@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// *****************************************************************************
+//
+// SBC test helpers: PCM test signal and decoder output collection
+//
+// *****************************************************************************
+
+#ifndef __SBC_TEST_UTIL_H
+#define __SBC_TEST_UTIL_H
+
+#include <stdint.h>
+
+typedef struct {
+    int16_t * data;
+    uint32_t  size;     // in samples
+    uint32_t  len;      // in samples
+    int       overflow;
+} sbc_test_pcm_buffer_t;
+
+/**
+ * @brief Fill pcm with triangle wave with noise
+ * @param pcm
+ * @param num_values to generate, (interleaved) samples
+ * @param offset of first value in signal
+ * @param seed of noise generator, updated
+ */
+void sbc_test_pcm_generate(int16_t * pcm, int num_values, uint32_t offset, uint32_t * seed);
+
+/**
+ * @brief Init PCM buffer for decoder output
+ * @param buffer
+ * @param storage
+ * @param size in samples
+ */
+void sbc_test_pcm_buffer_init(sbc_test_pcm_buffer_t * buffer, int16_t * storage, uint32_t size);
+
+/**
+ * @brief Decoder PCM handler, appends samples to sbc_test_pcm_buffer_t provided as context
+ */
+void sbc_test_handle_pcm_data(int16_t * data, int num_samples, int num_channels, int sample_rate, void * context);
+
+/**
+ * @brief Get second byte of mSBC H2 header
+ * @param frame_nr
+ */
+uint8_t sbc_test_msbc_h2_header_byte_1(int frame_nr);
+
+#endif
@@ -0,0 +1,123 @@
+
+// *****************************************************************************
+//
+// test synchronous address resolution with cache
+//
+// *****************************************************************************
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_run_loop_posix.h"
+#include "btstack_memory.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "ble/le_device_db.h"
+#include "ble/sm.h"
+
+void aes128_calc_cyphertext(uint8_t key[16], uint8_t plaintext[16], uint8_t cyphertext[16]);
+
+// Core Spec, Vol 3, Part H, D.7: ah random address hash function
+static sm_key_t  irk_a   = { 0xec, 0x02, 0x34, 0xa3, 0x57, 0xc8, 0xad, 0x05, 0x34, 0x10, 0x10, 0xa6, 0x0a, 0x39, 0x7d, 0x9b };
+static bd_addr_t rpa_a   = { 0x70, 0x81, 0x94, 0x0d, 0xfb, 0xaa };
+
+static sm_key_t  irk_b   = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+
+static bd_addr_t addr_a  = { 0x00, 0x1b, 0xdc, 0x00, 0x00, 0x0a };
+static bd_addr_t addr_b  = { 0x00, 0x1b, 0xdc, 0x00, 0x00, 0x0b };
+
+// rpa = prand || ah(irk, prand), calculated with reference AES implementation
+static void create_resolvable_private_address(sm_key_t irk, uint8_t prand_byte, bd_addr_t rpa){
+    sm_key_t r_prime;
+    sm_key_t hash;
+    memset(r_prime, 0, 16);
+    r_prime[13] = 0x40 | (prand_byte & 0x3f);
+    r_prime[14] = prand_byte;
+    r_prime[15] = prand_byte;
+    aes128_calc_cyphertext(irk, r_prime, hash);
+    memcpy(&rpa[0], &r_prime[13], 3);
+    memcpy(&rpa[3], &hash[13], 3);
+}
+
+TEST_GROUP(AddressResolution){
+    void setup(void){
+        static int first = 1;
+        if (first){
+            first = 0;
+            btstack_memory_init();
+            btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+        }
+        le_device_db_init();
+        sm_init();
+    }
+};
+
+TEST(AddressResolution, SpecSampleData){
+    int index = le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_a, irk_a);
+    CHECK(index >= 0);
+    CHECK_EQUAL(index, sm_address_resolution_resolve(BD_ADDR_TYPE_LE_RANDOM, rpa_a));
+    // cached result
+    CHECK_EQUAL(index, sm_address_resolution_resolve(BD_ADDR_TYPE_LE_RANDOM, rpa_a));
+}
+
+TEST(AddressResolution, IdentityAddress){
+    le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_a, irk_a);
+    int index = le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_b, irk_b);
+    CHECK_EQUAL(index, sm_address_resolution_resolve(BD_ADDR_TYPE_LE_PUBLIC, addr_b));
+    CHECK_EQUAL(-1, sm_address_resolution_resolve(BD_ADDR_TYPE_LE_RANDOM, addr_b));
+}
+
+TEST(AddressResolution, GeneratedAddresses){
+    int index_a = le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_a, irk_a);
+    int index_b = le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_b, irk_b);
+    int i;
+    for (i=0;i<20;i++){
+        bd_addr_t rpa;
+        create_resolvable_private_address(irk_b, i, rpa);
+        CHECK_EQUAL(index_b, sm_address_resolution_resolve(BD_ADDR_TYPE_LE_RANDOM, rpa));
+        create_resolvable_private_address(irk_a, i, rpa);
+        CHECK_EQUAL(index_a, sm_address_resolution_resolve(BD_ADDR_TYPE_LE_RANDOM, rpa));
+    }
+    // addresses of first iterations have been evicted from cache
+    bd_addr_t rpa;
+    create_resolvable_private_address(irk_b, 0, rpa);
+    CHECK_EQUAL(index_b, sm_address_resolution_resolve(BD_ADDR_TYPE_LE_RANDOM, rpa));
+}
+
+TEST(AddressResolution, NegativeCacheFlushedOnAdd){
+    bd_addr_t rpa;
+    create_resolvable_private_address(irk_b, 0x12, rpa);
+    le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_a, irk_a);
+    CHECK_EQUAL(-1, sm_address_resolution_resolve(BD_ADDR_TYPE_LE_RANDOM, rpa));
+    int index = le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_b, irk_b);
+    CHECK_EQUAL(index, sm_address_resolution_resolve(BD_ADDR_TYPE_LE_RANDOM, rpa));
+}
+
+TEST(AddressResolution, NegativeCacheFlushedOnReplaceWithSameCount){
+    bd_addr_t rpa;
+    create_resolvable_private_address(irk_b, 0x34, rpa);
+    int index = le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_a, irk_a);
+    CHECK_EQUAL(-1, sm_address_resolution_resolve(BD_ADDR_TYPE_LE_RANDOM, rpa));
+    // device count stays the same, IRK changes
+    le_device_db_remove(index);
+    index = le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_b, irk_b);
+    CHECK_EQUAL(1, le_device_db_count());
+    CHECK_EQUAL(index, sm_address_resolution_resolve(BD_ADDR_TYPE_LE_RANDOM, rpa));
+}
+
+TEST(AddressResolution, PositiveCacheFlushedOnRemove){
+    int index = le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_a, irk_a);
+    CHECK_EQUAL(index, sm_address_resolution_resolve(BD_ADDR_TYPE_LE_RANDOM, rpa_a));
+    le_device_db_remove(index);
+    CHECK_EQUAL(-1, sm_address_resolution_resolve(BD_ADDR_TYPE_LE_RANDOM, rpa_a));
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,170 @@
+
+// *****************************************************************************
+//
+// test SLIP decoder: processing blocks has to yield the same frames as processing single bytes
+//
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_slip.h"
+#include "btstack_util.h"
+
+#define MAX_FRAME_SIZE   300
+#define MAX_FRAMES       100
+#define MAX_STREAM_SIZE  (MAX_FRAMES * (2 * MAX_FRAME_SIZE + 2) + 100)
+
+static uint8_t  stream[MAX_STREAM_SIZE];
+static uint16_t stream_len;
+
+static uint8_t  decoder_buffer[MAX_FRAME_SIZE];
+
+static uint8_t  frames[MAX_FRAMES][MAX_FRAME_SIZE];
+static uint16_t frame_sizes[MAX_FRAMES];
+static int      num_frames;
+
+static void stream_add_byte(uint8_t byte){
+    stream[stream_len++] = byte;
+}
+
+static void stream_add_frame(const uint8_t * data, uint16_t len){
+    stream_add_byte(BTSTACK_SLIP_SOF);
+    btstack_slip_encoder_start(data, len);
+    while (btstack_slip_encoder_has_data()){
+        stream_add_byte(btstack_slip_encoder_get_byte());
+    }
+    stream_add_byte(BTSTACK_SLIP_SOF);
+}
+
+static void frame_received(uint16_t frame_size){
+    CHECK(num_frames < MAX_FRAMES);
+    memcpy(frames[num_frames], decoder_buffer, frame_size);
+    frame_sizes[num_frames] = frame_size;
+    num_frames++;
+    btstack_slip_decoder_init(decoder_buffer, sizeof(decoder_buffer));
+}
+
+static void decode_bytewise(void){
+    num_frames = 0;
+    btstack_slip_decoder_init(decoder_buffer, sizeof(decoder_buffer));
+    uint16_t i;
+    for (i = 0; i < stream_len; i++){
+        btstack_slip_decoder_process(stream[i]);
+        uint16_t frame_size = btstack_slip_decoder_frame_size();
+        if (frame_size){
+            frame_received(frame_size);
+        }
+    }
+}
+
+static void decode_blockwise(uint16_t block_size){
+    num_frames = 0;
+    btstack_slip_decoder_init(decoder_buffer, sizeof(decoder_buffer));
+    uint16_t offset;
+    for (offset = 0; offset < stream_len; offset += block_size){
+        uint16_t len = btstack_min(block_size, stream_len - offset);
+        uint16_t pos = 0;
+        while (pos < len){
+            pos += btstack_slip_decoder_process_buffer(&stream[offset + pos], len - pos);
+            uint16_t frame_size = btstack_slip_decoder_frame_size();
+            if (frame_size){
+                frame_received(frame_size);
+            }
+        }
+    }
+}
+
+// decode stream byte by byte and in blocks of various sizes and compare results
+static void check_decoders_match(void){
+    static uint8_t  expected_frames[MAX_FRAMES][MAX_FRAME_SIZE];
+    static uint16_t expected_frame_sizes[MAX_FRAMES];
+    decode_bytewise();
+    int expected_num_frames = num_frames;
+    memcpy(expected_frames, frames, sizeof(frames));
+    memcpy(expected_frame_sizes, frame_sizes, sizeof(frame_sizes));
+
+    const uint16_t block_sizes[] = { 1, 2, 3, 7, 64, 256, MAX_STREAM_SIZE };
+    unsigned int i;
+    for (i = 0; i < sizeof(block_sizes) / sizeof(uint16_t); i++){
+        decode_blockwise(block_sizes[i]);
+        CHECK_EQUAL(expected_num_frames, num_frames);
+        int j;
+        for (j = 0; j < num_frames; j++){
+            CHECK_EQUAL(expected_frame_sizes[j], frame_sizes[j]);
+            MEMCMP_EQUAL(expected_frames[j], frames[j], frame_sizes[j]);
+        }
+    }
+}
+
+TEST_GROUP(SLIPDecoder){
+    void setup(void){
+        stream_len = 0;
+        num_frames = 0;
+    }
+};
+
+TEST(SLIPDecoder, SingleFrame){
+    const uint8_t data[] = { 0x01, 0xc0, 0x02, 0xdb, 0x03, 0xdc, 0xdd };
+    stream_add_frame(data, sizeof(data));
+    decode_blockwise(sizeof(stream));
+    CHECK_EQUAL(1, num_frames);
+    CHECK_EQUAL(sizeof(data), frame_sizes[0]);
+    MEMCMP_EQUAL(data, frames[0], sizeof(data));
+}
+
+TEST(SLIPDecoder, PartialFrames){
+    const uint8_t data[] = { 0x01, 0x02, 0x03, 0x04 };
+    stream_add_byte(0x55);                      // garbage before first SOF
+    stream_add_frame(data, sizeof(data));
+    stream_add_byte(BTSTACK_SLIP_SOF);          // empty frame
+    stream_add_byte(0xdb);                      // invalid escape
+    stream_add_byte(0x00);
+    stream_add_frame(data, sizeof(data));
+    check_decoders_match();
+    CHECK_EQUAL(2, num_frames);
+}
+
+TEST(SLIPDecoder, FrameTooLong){
+    static uint8_t data[MAX_FRAME_SIZE + 10];
+    memset(data, 0x11, sizeof(data));
+    stream_add_frame(data, sizeof(data));
+    stream_add_frame(data, 10);
+    check_decoders_match();
+}
+
+TEST(SLIPDecoder, Random){
+    uint8_t data[MAX_FRAME_SIZE];
+    srand(42);
+    int i;
+    for (i = 0; i < MAX_FRAMES; i++){
+        uint16_t len = 1 + (rand() % (MAX_FRAME_SIZE - 1));
+        uint16_t j;
+        for (j = 0; j < len; j++){
+            // favour special characters
+            switch (rand() % 8){
+                case 0:
+                    data[j] = BTSTACK_SLIP_SOF;
+                    break;
+                case 1:
+                    data[j] = 0xdb;
+                    break;
+                default:
+                    data[j] = (uint8_t) rand();
+                    break;
+            }
+        }
+        stream_add_frame(data, len);
+    }
+    check_decoders_match();
+    CHECK_EQUAL(MAX_FRAMES, num_frames);
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
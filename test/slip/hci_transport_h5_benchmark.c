@@ -0,0 +1,301 @@
+/*
+ * Throughput benchmark: H5 transport receiving ACL packets from a fake controller over a pty
+ *
+ * Runs the H5 transport with the POSIX UART driver once with single byte reads and once
+ * with streaming reads (receive_available) and reports throughput and number of UART callbacks.
+ */
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "btstack_debug.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_uart_block.h"
+#include "hci.h"
+#include "hci_dump.h"
+#include "hci_transport.h"
+
+#define NUM_PACKETS     1000
+#define ACL_PAYLOAD_LEN 1000
+
+// link control messages
+static const uint8_t link_control_sync[]            = { 0x01, 0x7e };
+static const uint8_t link_control_sync_response[]   = { 0x02, 0x7d };
+static const uint8_t link_control_config[]          = { 0x03, 0xfc };
+static const uint8_t link_control_config_response[] = { 0x04, 0x7b, 0x01 };   // window 1, no data integrity check
+
+// fake controller
+static int             controller_fd;
+static pthread_mutex_t controller_write_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  controller_link_active = PTHREAD_COND_INITIALIZER;
+static int             controller_config_sent;
+
+// host
+static btstack_uart_block_t uart_driver;
+static void (*uart_block_received)(void);
+static void (*uart_data_received)(uint16_t len);
+static uint32_t num_uart_callbacks;
+static uint32_t num_packets_received;
+static uint32_t num_bytes_received;
+static struct timespec start_ts;
+
+static double time_since_start_ms(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start_ts.tv_sec) * 1000.0 + (now.tv_nsec - start_ts.tv_nsec) / 1000000.0;
+}
+
+// SLIP encoder for controller, btstack_slip is used by the host
+static int slip_encode(uint8_t * out, const uint8_t * data, int len){
+    int pos = 0;
+    int i;
+    for (i = 0; i < len; i++){
+        switch (data[i]){
+            case 0xc0:
+                out[pos++] = 0xdb;
+                out[pos++] = 0xdc;
+                break;
+            case 0xdb:
+                out[pos++] = 0xdb;
+                out[pos++] = 0xdd;
+                break;
+            default:
+                out[pos++] = data[i];
+                break;
+        }
+    }
+    return pos;
+}
+
+static int h5_encode_frame(uint8_t * out, int reliable, uint8_t seq_nr, uint8_t packet_type, const uint8_t * payload, uint16_t len){
+    uint8_t header[4];
+    header[0] = seq_nr | (reliable << 7);
+    header[1] = packet_type | ((len & 0x0f) << 4);
+    header[2] = len >> 4;
+    header[3] = 0xff - (header[0] + header[1] + header[2]);
+    int pos = 0;
+    out[pos++] = 0xc0;
+    pos += slip_encode(&out[pos], header, 4);
+    pos += slip_encode(&out[pos], payload, len);
+    out[pos++] = 0xc0;
+    return pos;
+}
+
+static void controller_write(const uint8_t * data, int len){
+    while (len > 0){
+        int res = (int) write(controller_fd, data, len);
+        if (res < 0) {
+            usleep(100);
+            continue;
+        }
+        data += res;
+        len  -= res;
+    }
+}
+
+static void controller_send_link_control(const uint8_t * message, uint16_t len){
+    uint8_t frame[32];
+    int frame_len = h5_encode_frame(frame, 0, 0, 0x0f, message, len);
+    pthread_mutex_lock(&controller_write_mutex);
+    controller_write(frame, frame_len);
+    pthread_mutex_unlock(&controller_write_mutex);
+}
+
+// reads host frames, answers sync and config, drains acks
+static void * controller_reader_thread(void * context){
+    (void) context;
+    uint8_t frame[2000];
+    int frame_len = 0;
+    int escape = 0;
+    while (1){
+        uint8_t buffer[1000];
+        int res = (int) read(controller_fd, buffer, sizeof(buffer));
+        if (res <= 0) {
+            usleep(100);
+            continue;
+        }
+        int i;
+        for (i = 0; i < res; i++){
+            uint8_t byte = buffer[i];
+            if (byte == 0xc0){
+                // frame complete, payload starts after 4 byte header
+                if (frame_len >= 6 && (frame[1] & 0x0f) == 0x0f){
+                    if (memcmp(&frame[4], link_control_sync, 2) == 0){
+                        controller_send_link_control(link_control_sync_response, sizeof(link_control_sync_response));
+                    }
+                    if (memcmp(&frame[4], link_control_config, 2) == 0){
+                        controller_send_link_control(link_control_config_response, sizeof(link_control_config_response));
+                        pthread_mutex_lock(&controller_write_mutex);
+                        controller_config_sent = 1;
+                        pthread_cond_signal(&controller_link_active);
+                        pthread_mutex_unlock(&controller_write_mutex);
+                    }
+                }
+                frame_len = 0;
+                escape = 0;
+                continue;
+            }
+            if (escape){
+                byte = (byte == 0xdc) ? 0xc0 : 0xdb;
+                escape = 0;
+            } else if (byte == 0xdb){
+                escape = 1;
+                continue;
+            }
+            if (frame_len < (int) sizeof(frame)){
+                frame[frame_len++] = byte;
+            }
+        }
+    }
+    return NULL;
+}
+
+// streams reliable ACL packets with random payload once the link is active
+static void * controller_writer_thread(void * context){
+    (void) context;
+    static uint8_t stream[NUM_PACKETS * (2 * (ACL_PAYLOAD_LEN + 8) + 2)];
+    int stream_len = 0;
+    uint8_t acl_packet[4 + ACL_PAYLOAD_LEN];
+    acl_packet[0] = 0x01;
+    acl_packet[1] = 0x20;
+    acl_packet[2] = ACL_PAYLOAD_LEN & 0xff;
+    acl_packet[3] = ACL_PAYLOAD_LEN >> 8;
+    srand(1);
+    int i;
+    for (i = 0; i < NUM_PACKETS; i++){
+        int j;
+        for (j = 0; j < ACL_PAYLOAD_LEN; j++){
+            acl_packet[4+j] = (uint8_t) rand();
+        }
+        stream_len += h5_encode_frame(&stream[stream_len], 1, i & 0x07, HCI_ACL_DATA_PACKET, acl_packet, sizeof(acl_packet));
+    }
+
+    pthread_mutex_lock(&controller_write_mutex);
+    while (!controller_config_sent){
+        pthread_cond_wait(&controller_link_active, &controller_write_mutex);
+    }
+    controller_write(stream, stream_len);
+    pthread_mutex_unlock(&controller_write_mutex);
+    return NULL;
+}
+
+static void counting_block_received(void){
+    num_uart_callbacks++;
+    (*uart_block_received)();
+}
+
+static void counting_data_received(uint16_t len){
+    num_uart_callbacks++;
+    (*uart_data_received)(len);
+}
+
+static void counting_set_block_received(void (*handler)(void)){
+    uart_block_received = handler;
+    btstack_uart_block_posix_instance()->set_block_received(&counting_block_received);
+}
+
+static void counting_set_data_received(void (*handler)(uint16_t len)){
+    uart_data_received = handler;
+    btstack_uart_block_posix_instance()->set_data_received(&counting_data_received);
+}
+
+static void packet_handler(uint8_t packet_type, uint8_t *packet, uint16_t size){
+    switch (packet_type){
+        case HCI_EVENT_PACKET:
+            if (packet[0] != HCI_EVENT_TRANSPORT_PACKET_SENT) break;
+            if (start_ts.tv_sec) break;
+            // link active
+            clock_gettime(CLOCK_MONOTONIC, &start_ts);
+            num_uart_callbacks = 0;
+            break;
+        case HCI_ACL_DATA_PACKET:
+            num_packets_received++;
+            num_bytes_received += size;
+            if (num_packets_received < NUM_PACKETS) break;
+            {
+                double time_ms = time_since_start_ms();
+                printf("%-22s %6u packets, %8u bytes in %8.1f ms: %7.2f MB/s, %8u UART callbacks\n",
+                    uart_driver.receive_available ? "receive_available:" : "receive_block(1):",
+                    num_packets_received, num_bytes_received, time_ms, num_bytes_received / time_ms / 1000.0, num_uart_callbacks);
+                exit(0);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void run_benchmark(int streaming){
+    // fake controller on pty master
+    controller_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (controller_fd < 0 || grantpt(controller_fd) || unlockpt(controller_fd)){
+        printf("Cannot create pty\n");
+        exit(1);
+    }
+    struct termios toptions;
+    tcgetattr(controller_fd, &toptions);
+    cfmakeraw(&toptions);
+    tcsetattr(controller_fd, TCSANOW, &toptions);
+
+    pthread_t reader, writer;
+    pthread_create(&reader, NULL, &controller_reader_thread, NULL);
+    pthread_create(&writer, NULL, &controller_writer_thread, NULL);
+
+    // H5 with POSIX UART driver on pty slave
+    uart_driver = *btstack_uart_block_posix_instance();
+    uart_driver.set_block_received = &counting_set_block_received;
+    uart_driver.set_data_received  = &counting_set_data_received;
+    if (!streaming){
+        uart_driver.receive_available = NULL;
+        uart_driver.set_data_received = NULL;
+    }
+
+    static hci_transport_config_uart_t config = {
+        HCI_TRANSPORT_CONFIG_UART,
+        115200,
+        0,
+        0,
+        NULL,
+    };
+    config.device_name = ptsname(controller_fd);
+
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    const hci_transport_t * transport = hci_transport_h5_instance(&uart_driver);
+    transport->init(&config);
+    transport->register_packet_handler(&packet_handler);
+    if (transport->open()){
+        printf("Cannot open %s\n", config.device_name);
+        exit(1);
+    }
+    btstack_run_loop_execute();
+}
+
+int main(int argc, const char * argv[]){
+    (void) argc;
+    (void) argv;
+
+    hci_dump_enable_log_level(HCI_DUMP_LOG_LEVEL_INFO,  0);
+    hci_dump_enable_log_level(HCI_DUMP_LOG_LEVEL_ERROR, 0);
+
+    printf("H5: %u ACL packets with %u bytes payload via pty\n", NUM_PACKETS, ACL_PAYLOAD_LEN);
+    int streaming;
+    for (streaming = 0; streaming <= 1; streaming++){
+        // transport and run loop are singletons -> run each benchmark in separate process
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0){
+            run_benchmark(streaming);
+        }
+        int status;
+        waitpid(pid, &status, 0);
+    }
+    return 0;
+}
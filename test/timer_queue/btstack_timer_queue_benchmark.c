@@ -0,0 +1,119 @@
+/*
+ * Micro-benchmark: sorted linked list vs. timer queue
+ *
+ * Simulates a run loop with N active timers that are constantly re-armed (e.g. L2CAP RTX/ERTM,
+ * ATT and GATT timeouts) while the earliest timers expire.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "btstack_run_loop.h"
+#include "btstack_linked_list.h"
+
+#define NUM_OPERATIONS 200000
+#define MAX_TIMERS     1000
+
+static btstack_timer_source_t timers[MAX_TIMERS];
+
+// sorted linked list as used by run loop implementations before
+static btstack_linked_list_t timer_list;
+
+static void timer_list_add(btstack_timer_source_t *ts){
+    btstack_linked_item_t *it;
+    for (it = (btstack_linked_item_t *) &timer_list; it->next ; it = it->next){
+        btstack_timer_source_t * next = (btstack_timer_source_t *) it->next;
+        if (next == ts) return;
+        if (next->timeout > ts->timeout) break;
+    }
+    ts->item.next = it->next;
+    it->next = (btstack_linked_item_t *) ts;
+}
+
+static int timer_list_remove(btstack_timer_source_t *ts){
+    return btstack_linked_list_remove(&timer_list, (btstack_linked_item_t *) ts);
+}
+
+static btstack_timer_source_t * timer_list_first(void){
+    return (btstack_timer_source_t *) timer_list;
+}
+
+// timer queue
+static btstack_timer_queue_t timer_queue;
+
+static void timer_queue_add(btstack_timer_source_t *ts){
+    btstack_timer_queue_add(&timer_queue, ts);
+}
+
+static int timer_queue_remove(btstack_timer_source_t *ts){
+    return btstack_timer_queue_remove(&timer_queue, ts);
+}
+
+static btstack_timer_source_t * timer_queue_first(void){
+    return btstack_timer_queue_first(&timer_queue);
+}
+
+typedef struct {
+    const char * name;
+    void (*add)(btstack_timer_source_t * ts);
+    int  (*remove)(btstack_timer_source_t * ts);
+    btstack_timer_source_t * (*first)(void);
+} timer_impl_t;
+
+static const timer_impl_t impl_list  = { "sorted list", &timer_list_add,  &timer_list_remove,  &timer_list_first };
+static const timer_impl_t impl_queue = { "timer queue", &timer_queue_add, &timer_queue_remove, &timer_queue_first };
+
+static double time_now_s(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double run_benchmark(const timer_impl_t * impl, int num_timers){
+    timer_list = NULL;
+    btstack_timer_queue_init(&timer_queue);
+    memset(timers, 0, sizeof(timers));
+    srand(1);
+
+    uint32_t now = 0;
+    int i;
+    for (i=0;i<num_timers;i++){
+        timers[i].timeout = now + 100 + (rand() % 5000);
+        impl->add(&timers[i]);
+    }
+
+    double start = time_now_s();
+    int op;
+    for (op=0;op<NUM_OPERATIONS;op++){
+        // re-arm random timer
+        btstack_timer_source_t * ts = &timers[rand() % num_timers];
+        impl->remove(ts);
+        ts->timeout = now + 100 + (rand() % 5000);
+        impl->add(ts);
+        // advance time and expire timers, expired timers are re-armed as well
+        now++;
+        while (1){
+            ts = impl->first();
+            if (ts == NULL) break;
+            if ((int32_t)(ts->timeout - now) > 0) break;
+            impl->remove(ts);
+            ts->timeout = now + 100 + (rand() % 5000);
+            impl->add(ts);
+        }
+    }
+    return (time_now_s() - start) * 1e9 / NUM_OPERATIONS;
+}
+
+int main(void){
+    int sizes[] = { 10, 100, 1000 };
+    printf("%-8s %16s %16s\n", "timers", impl_list.name, impl_queue.name);
+    int i;
+    for (i=0;i<3;i++){
+        double list_ns  = run_benchmark(&impl_list,  sizes[i]);
+        double queue_ns = run_benchmark(&impl_queue, sizes[i]);
+        printf("%-8u %13.1f ns %13.1f ns\n", sizes[i], list_ns, queue_ns);
+    }
+    return 0;
+}
@@ -0,0 +1,205 @@
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+#include "btstack_run_loop.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_TIMERS 200
+
+static btstack_timer_queue_t queue;
+static btstack_timer_source_t timers[NUM_TIMERS];
+static int in_queue[NUM_TIMERS];
+
+static void set_timeout(int index, uint32_t timeout){
+    timers[index].timeout = timeout;
+}
+
+// returns timeout of earliest timer in reference set or -1
+static int64_t reference_min(void){
+    int64_t min = -1;
+    int i;
+    for (i=0;i<NUM_TIMERS;i++){
+        if (!in_queue[i]) continue;
+        if (min < 0 || timers[i].timeout < min){
+            min = timers[i].timeout;
+        }
+    }
+    return min;
+}
+
+TEST_GROUP(TimerQueue){
+    void setup(void){
+        btstack_timer_queue_init(&queue);
+        memset(timers, 0, sizeof(timers));
+        memset(in_queue, 0, sizeof(in_queue));
+    }
+};
+
+TEST(TimerQueue, Empty){
+    CHECK(btstack_timer_queue_first(&queue) == NULL);
+    CHECK_EQUAL(0, btstack_timer_queue_remove(&queue, &timers[0]));
+}
+
+TEST(TimerQueue, AddRemoveSingle){
+    set_timeout(0, 100);
+    CHECK_EQUAL(1, btstack_timer_queue_add(&queue, &timers[0]));
+    CHECK(btstack_timer_queue_first(&queue) == &timers[0]);
+    CHECK_EQUAL(1, btstack_timer_queue_remove(&queue, &timers[0]));
+    CHECK(btstack_timer_queue_first(&queue) == NULL);
+    CHECK_EQUAL(0, btstack_timer_queue_remove(&queue, &timers[0]));
+}
+
+TEST(TimerQueue, AddTwice){
+    set_timeout(0, 100);
+    set_timeout(1, 200);
+    CHECK_EQUAL(1, btstack_timer_queue_add(&queue, &timers[0]));
+    CHECK_EQUAL(1, btstack_timer_queue_add(&queue, &timers[1]));
+    CHECK_EQUAL(0, btstack_timer_queue_add(&queue, &timers[0]));
+    CHECK_EQUAL(0, btstack_timer_queue_add(&queue, &timers[1]));
+}
+
+TEST(TimerQueue, Order){
+    uint32_t timeouts[] = { 50, 10, 40, 20, 30, 60 };
+    int i;
+    for (i=0;i<6;i++){
+        set_timeout(i, timeouts[i]);
+        btstack_timer_queue_add(&queue, &timers[i]);
+    }
+    uint32_t expected = 10;
+    btstack_timer_source_t * ts;
+    while ((ts = btstack_timer_queue_first(&queue)) != NULL){
+        CHECK_EQUAL(expected, ts->timeout);
+        btstack_timer_queue_remove(&queue, ts);
+        expected += 10;
+    }
+    CHECK_EQUAL(70, expected);
+}
+
+TEST(TimerQueue, WrapAround){
+    set_timeout(0, 0xfffffff0);
+    set_timeout(1, 0x00000010);
+    btstack_timer_queue_add(&queue, &timers[1]);
+    btstack_timer_queue_add(&queue, &timers[0]);
+    CHECK(btstack_timer_queue_first(&queue) == &timers[0]);
+}
+
+TEST(TimerQueue, RemoveInner){
+    int i;
+    for (i=0;i<10;i++){
+        set_timeout(i, 100 + i);
+        btstack_timer_queue_add(&queue, &timers[i]);
+    }
+    // pop first to build up tree structure
+    btstack_timer_queue_remove(&queue, &timers[0]);
+    CHECK_EQUAL(1, btstack_timer_queue_remove(&queue, &timers[5]));
+    CHECK_EQUAL(1, btstack_timer_queue_remove(&queue, &timers[3]));
+    CHECK_EQUAL(0, btstack_timer_queue_remove(&queue, &timers[3]));
+    uint32_t expected[] = { 101, 102, 104, 106, 107, 108, 109 };
+    for (i=0;i<7;i++){
+        btstack_timer_source_t * ts = btstack_timer_queue_first(&queue);
+        CHECK_EQUAL(expected[i], ts->timeout);
+        btstack_timer_queue_remove(&queue, ts);
+    }
+    CHECK(btstack_timer_queue_first(&queue) == NULL);
+}
+
+TEST(TimerQueue, Random){
+    srand(1234);
+    int round;
+    for (round=0;round<20000;round++){
+        int index = rand() % NUM_TIMERS;
+        switch (rand() % 3){
+            case 0:
+                // re-arm timer
+                if (in_queue[index]){
+                    CHECK_EQUAL(1, btstack_timer_queue_remove(&queue, &timers[index]));
+                }
+                set_timeout(index, round + (rand() % 1000));
+                CHECK_EQUAL(1, btstack_timer_queue_add(&queue, &timers[index]));
+                in_queue[index] = 1;
+                break;
+            case 1:
+                // remove timer
+                CHECK_EQUAL(in_queue[index], btstack_timer_queue_remove(&queue, &timers[index]));
+                in_queue[index] = 0;
+                break;
+            default:
+                // expire first timer
+                if (btstack_timer_queue_first(&queue)){
+                    btstack_timer_source_t * ts = btstack_timer_queue_first(&queue);
+                    CHECK_EQUAL(reference_min(), ts->timeout);
+                    btstack_timer_queue_remove(&queue, ts);
+                    in_queue[ts - timers] = 0;
+                }
+                break;
+        }
+        btstack_timer_source_t * first = btstack_timer_queue_first(&queue);
+        if (first == NULL){
+            CHECK_EQUAL(-1, reference_min());
+        } else {
+            CHECK_EQUAL(reference_min(), first->timeout);
+        }
+    }
+}
+
+static void test_run_loop_init(void){
+}
+
+static void test_run_loop_set_timer(btstack_timer_source_t * ts, uint32_t timeout_in_ms){
+    ts->timeout = timeout_in_ms;
+}
+
+static const btstack_run_loop_t test_run_loop = {
+    &test_run_loop_init, NULL, NULL, NULL, NULL, &test_run_loop_set_timer, NULL, NULL, NULL, NULL, NULL, NULL, NULL
+};
+
+// re-arm queued timer as done by H5 (set, remove, add) and HCI (set, add) with other timers pending
+static void check_rearm_queued_timer(int remove_before_add){
+    int i;
+    for (i=0;i<8;i++){
+        set_timeout(i, 100 + 10 * i);
+        btstack_timer_queue_add(&queue, &timers[i]);
+        in_queue[i] = 1;
+    }
+    // pop first to build up tree structure
+    btstack_timer_queue_remove(&queue, &timers[0]);
+    in_queue[0] = 0;
+    // timer with children
+    btstack_run_loop_set_timer(&timers[2], 200);
+    if (remove_before_add){
+        CHECK_EQUAL(1, btstack_timer_queue_remove(&queue, &timers[2]));
+        CHECK_EQUAL(1, btstack_timer_queue_add(&queue, &timers[2]));
+    } else {
+        CHECK_EQUAL(0, btstack_timer_queue_add(&queue, &timers[2]));
+    }
+    // all timers expire once in order
+    int count = 0;
+    btstack_timer_source_t * ts;
+    while ((ts = btstack_timer_queue_first(&queue)) != NULL){
+        CHECK_EQUAL(reference_min(), ts->timeout);
+        CHECK_EQUAL(1, btstack_timer_queue_remove(&queue, ts));
+        in_queue[ts - timers] = 0;
+        count++;
+    }
+    CHECK_EQUAL(7, count);
+    CHECK_EQUAL(200, timers[2].timeout);
+}
+
+TEST(TimerQueue, ReArmQueuedTimerRemoveAdd){
+    check_rearm_queued_timer(1);
+}
+
+TEST(TimerQueue, ReArmQueuedTimerAdd){
+    check_rearm_queued_timer(0);
+}
+
+TEST(TimerQueue, SetTimerUsFallback){
+    btstack_run_loop_set_timer_us(&timers[0], 100000);
+    CHECK_EQUAL(100, timers[0].timeout);
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(&test_run_loop);
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,163 @@
+/*
+ * Startup time of POSIX TLV with 100k historical writes: replay of a file written by earlier versions
+ * without compaction, startup after compaction, tag lookup, and store with and without group commit
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_tlv.h"
+#include "btstack_tlv_posix.h"
+#include "btstack_util.h"
+#include "hci_dump.h"
+
+#define BENCHMARK_DB            "/tmp/tlv_posix_startup_benchmark.tlv"
+#define NUM_HISTORICAL_WRITES   100000
+#define NUM_TAGS                500
+#define NUM_LOOKUP_ROUNDS       200
+#define NUM_WRITE_THROUGH       1000
+
+static const btstack_tlv_t * tlv_impl;
+static btstack_tlv_posix_t   tlv_context;
+
+static double now_us(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+static long file_size(const char * path){
+    struct stat st;
+    if (stat(path, &st) != 0) return -1;
+    return (long) st.st_size;
+}
+
+static uint32_t tag_for_index(int i){
+    return 0x42540000 | i;
+}
+
+// 16..47 bytes, derived from write nr
+static int value_for_write(int write_nr, uint8_t * value){
+    int len = 16 + (write_nr % 32);
+    int i;
+    for (i=0;i<len;i++){
+        value[i] = (uint8_t) (write_nr + i);
+    }
+    big_endian_store_32(value, 0, write_nr);
+    return len;
+}
+
+// file as written by earlier versions: header and all records without CRC, never compacted
+static void create_legacy_file(void){
+    FILE * file = fopen(BENCHMARK_DB, "w");
+    uint8_t header[8];
+    memset(header, 0, sizeof(header));
+    strcpy((char *) header, "BTstack");
+    fwrite(header, 1, sizeof(header), file);
+    int i;
+    for (i=0;i<NUM_HISTORICAL_WRITES;i++){
+        uint8_t record[8 + 48];
+        int len = value_for_write(i, &record[8]);
+        big_endian_store_32(record, 0, tag_for_index(i % NUM_TAGS));
+        big_endian_store_32(record, 4, len);
+        fwrite(record, 1, 8 + len, file);
+    }
+    fclose(file);
+}
+
+static int verify_values(void){
+    int errors = 0;
+    int i;
+    for (i=0;i<NUM_TAGS;i++){
+        uint8_t value[48];
+        uint8_t expected[48];
+        int write_nr = NUM_HISTORICAL_WRITES - NUM_TAGS + i;
+        int len = value_for_write(write_nr, expected);
+        int size = tlv_impl->get_tag(&tlv_context, tag_for_index(i), value, sizeof(value));
+        if (size != len || memcmp(value, expected, len) != 0){
+            errors++;
+        }
+    }
+    return errors;
+}
+
+int main (int argc, const char * argv[]){
+    (void) argc;
+    (void) argv;
+    hci_dump_enable_log_level(HCI_DUMP_LOG_LEVEL_INFO, 0);
+    hci_dump_enable_log_level(HCI_DUMP_LOG_LEVEL_ERROR, 0);
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    int errors = 0;
+
+    printf("POSIX TLV, %u historical writes to %u tags\n", NUM_HISTORICAL_WRITES, NUM_TAGS);
+
+    // first start: replay complete history, convert and compact
+    create_legacy_file();
+    long legacy_size = file_size(BENCHMARK_DB);
+    double start = now_us();
+    tlv_impl = btstack_tlv_posix_init_instance(&tlv_context, BENCHMARK_DB);
+    double replay_us = now_us() - start;
+    errors += verify_values();
+    btstack_tlv_posix_deinit(&tlv_context);
+    printf("startup, replay history       %8.2f ms, file %8ld bytes\n", replay_us / 1000.0, legacy_size);
+
+    // next start: current values only
+    start = now_us();
+    tlv_impl = btstack_tlv_posix_init_instance(&tlv_context, BENCHMARK_DB);
+    double compacted_us = now_us() - start;
+    errors += verify_values();
+    printf("startup, after compaction     %8.2f ms, file %8ld bytes\n", compacted_us / 1000.0, file_size(BENCHMARK_DB));
+
+    // lookup
+    start = now_us();
+    int round;
+    int i;
+    uint32_t checksum = 0;
+    for (round=0;round<NUM_LOOKUP_ROUNDS;round++){
+        for (i=0;i<NUM_TAGS;i++){
+            uint8_t value[48];
+            checksum += tlv_impl->get_tag(&tlv_context, tag_for_index(i), value, sizeof(value));
+        }
+    }
+    double lookup_us = now_us() - start;
+    printf("get_tag                       %8.3f us per lookup (%u)\n", lookup_us / (NUM_LOOKUP_ROUNDS * NUM_TAGS), checksum);
+
+    // store with fsync for each write
+    start = now_us();
+    for (i=0;i<NUM_WRITE_THROUGH;i++){
+        uint8_t value[48];
+        int len = value_for_write(NUM_HISTORICAL_WRITES + i, value);
+        tlv_impl->store_tag(&tlv_context, tag_for_index(i % NUM_TAGS), value, len);
+    }
+    double write_through_us = now_us() - start;
+    printf("store_tag, sync each write    %8.3f us per store\n", write_through_us / NUM_WRITE_THROUGH);
+
+    // store with group commit, including compaction
+    btstack_tlv_posix_set_group_commit(&tlv_context, 1000);
+    start = now_us();
+    for (i=0;i<NUM_HISTORICAL_WRITES;i++){
+        uint8_t value[48];
+        int len = value_for_write(i, value);
+        tlv_impl->store_tag(&tlv_context, tag_for_index(i % NUM_TAGS), value, len);
+    }
+    btstack_tlv_posix_flush(&tlv_context);
+    double group_commit_us = now_us() - start;
+    printf("store_tag, group commit       %8.3f us per store, file %8ld bytes\n", group_commit_us / NUM_HISTORICAL_WRITES, file_size(BENCHMARK_DB));
+    errors += verify_values();
+
+    btstack_tlv_posix_deinit(&tlv_context);
+    unlink(BENCHMARK_DB);
+
+    if (errors){
+        printf("FAILED: %u errors\n", errors);
+        return 1;
+    }
+    return 0;
+}
@@ -8,7 +8,10 @@
 #include "btstack_util.h"
 #include "btstack_config.h"
 #include "btstack_debug.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
 #include <unistd.h>
+#include <sys/stat.h>
 
 #define TEST_DB "/tmp/test.tlv"
 
@@ -35,7 +38,7 @@ TEST_GROUP(BSTACK_TLV){
     void teardown(void){
     	log_info("teardown");
     	// close file
-    	fclose(btstack_tlv_context.file);
+    	btstack_tlv_posix_deinit(&btstack_tlv_context);
     }
 };
 
@@ -160,6 +163,171 @@ TEST(BSTACK_TLV, TestWriteResetRead){
     CHECK_EQUAL(buffer, data);
 }
 
+static long file_size(const char * path){
+	struct stat st;
+	if (stat(path, &st) != 0) return -1;
+	return (long) st.st_size;
+}
+
+static void write_legacy_record(FILE * file, uint32_t tag, const uint8_t * data, uint32_t len){
+	uint8_t header[8];
+	big_endian_store_32(header, 0, tag);
+	big_endian_store_32(header, 4, len);
+	fwrite(header, 1, sizeof(header), file);
+	fwrite(data, 1, len, file);
+}
+
+TEST(BSTACK_TLV, TestCRCError){
+	uint32_t tag_a = TAG('a','a','a','a');
+	uint32_t tag_b = TAG('b','b','b','b');
+	uint8_t  buffer = 1;
+	btstack_tlv_impl->store_tag(&btstack_tlv_context, tag_a, &buffer, 1);
+	buffer = 2;
+	btstack_tlv_impl->store_tag(&btstack_tlv_context, tag_b, &buffer, 1);
+	buffer = 3;
+	btstack_tlv_impl->store_tag(&btstack_tlv_context, tag_a, &buffer, 1);
+	btstack_tlv_posix_deinit(&btstack_tlv_context);
+
+	// corrupt value of last record
+	FILE * file = fopen(TEST_DB, "r+");
+	fseek(file, -5, SEEK_END);
+	fputc(7, file);
+	fclose(file);
+
+	btstack_tlv_impl = btstack_tlv_posix_init_instance(&btstack_tlv_context, TEST_DB);
+	btstack_tlv_impl->get_tag(&btstack_tlv_context, tag_a, &buffer, 1);
+	CHECK_EQUAL(1, buffer);
+	btstack_tlv_impl->get_tag(&btstack_tlv_context, tag_b, &buffer, 1);
+	CHECK_EQUAL(2, buffer);
+}
+
+TEST(BSTACK_TLV, TestTruncatedRecord){
+	uint32_t tag = TAG('a','b','c','d');
+	uint8_t  data[8];
+	memcpy(data, "01234567", 8);
+	btstack_tlv_impl->store_tag(&btstack_tlv_context, tag, data, 8);
+	data[0] = 'x';
+	btstack_tlv_impl->store_tag(&btstack_tlv_context, tag, data, 8);
+	btstack_tlv_posix_deinit(&btstack_tlv_context);
+
+	// interrupted write
+	CHECK_EQUAL(0, truncate(TEST_DB, file_size(TEST_DB) - 2));
+
+	btstack_tlv_impl = btstack_tlv_posix_init_instance(&btstack_tlv_context, TEST_DB);
+	uint8_t buffer[8];
+	CHECK_EQUAL(8, btstack_tlv_impl->get_tag(&btstack_tlv_context, tag, buffer, 8));
+	CHECK_EQUAL('0', buffer[0]);
+	// truncated record was removed
+	CHECK_EQUAL(8 + 8 + 8 + 4, file_size(TEST_DB));
+}
+
+TEST(BSTACK_TLV, TestLegacyFormat){
+	btstack_tlv_posix_deinit(&btstack_tlv_context);
+
+	// file without CRC
+	uint32_t tag_a = TAG('a','a','a','a');
+	uint32_t tag_b = TAG('b','b','b','b');
+	uint8_t  value = 1;
+	FILE * file = fopen(TEST_DB, "w");
+	uint8_t header[8];
+	memset(header, 0, sizeof(header));
+	strcpy((char *) header, "BTstack");
+	fwrite(header, 1, sizeof(header), file);
+	write_legacy_record(file, tag_a, &value, 1);
+	value = 2;
+	write_legacy_record(file, tag_b, &value, 1);
+	write_legacy_record(file, tag_a, NULL, 0);
+	value = 3;
+	write_legacy_record(file, tag_b, &value, 1);
+	fclose(file);
+
+	btstack_tlv_impl = btstack_tlv_posix_init_instance(&btstack_tlv_context, TEST_DB);
+	CHECK_EQUAL(0, btstack_tlv_impl->get_tag(&btstack_tlv_context, tag_a, NULL, 0));
+	CHECK_EQUAL(1, btstack_tlv_impl->get_tag(&btstack_tlv_context, tag_b, &value, 1));
+	CHECK_EQUAL(3, value);
+
+	// converted to records with CRC
+	CHECK_EQUAL(8 + 8 + 1 + 4, file_size(TEST_DB));
+	reopen_db();
+	CHECK_EQUAL(1, btstack_tlv_impl->get_tag(&btstack_tlv_context, tag_b, &value, 1));
+	CHECK_EQUAL(3, value);
+}
+
+TEST(BSTACK_TLV, TestCompaction){
+	uint32_t tag_a = TAG('a','a','a','a');
+	uint32_t tag_b = TAG('b','b','b','b');
+	uint8_t  data[100];
+	memset(data, 0, sizeof(data));
+	int i;
+	for (i=0;i<5000;i++){
+		big_endian_store_32(data, 0, i);
+		btstack_tlv_impl->store_tag(&btstack_tlv_context, (i & 1) ? tag_a : tag_b, data, sizeof(data));
+		// file does not grow without bound
+		CHECK(file_size(TEST_DB) < 20000);
+	}
+	reopen_db();
+	uint8_t buffer[100];
+	btstack_tlv_impl->get_tag(&btstack_tlv_context, tag_a, buffer, sizeof(buffer));
+	CHECK_EQUAL(4999, big_endian_read_32(buffer, 0));
+	btstack_tlv_impl->get_tag(&btstack_tlv_context, tag_b, buffer, sizeof(buffer));
+	CHECK_EQUAL(4998, big_endian_read_32(buffer, 0));
+
+	// explicit compaction
+	CHECK_EQUAL(0, btstack_tlv_posix_compact(&btstack_tlv_context));
+	CHECK_EQUAL(8 + 2 * (8 + 100 + 4), file_size(TEST_DB));
+}
+
+TEST(BSTACK_TLV, TestStoreSameValue){
+	uint32_t tag = TAG('a','b','c','d');
+	uint8_t  buffer = 7;
+	btstack_tlv_impl->store_tag(&btstack_tlv_context, tag, &buffer, 1);
+	long size = file_size(TEST_DB);
+	btstack_tlv_impl->store_tag(&btstack_tlv_context, tag, &buffer, 1);
+	CHECK_EQUAL(size, file_size(TEST_DB));
+}
+
+TEST(BSTACK_TLV, TestManyTags){
+	uint32_t i;
+	for (i=0;i<1000;i++){
+		uint8_t data[4];
+		big_endian_store_32(data, 0, i * 3);
+		btstack_tlv_impl->store_tag(&btstack_tlv_context, i * 0x10000, data, 4);
+	}
+	btstack_tlv_impl->delete_tag(&btstack_tlv_context, 500 * 0x10000);
+	reopen_db();
+	for (i=0;i<1000;i++){
+		uint8_t data[4];
+		int size = btstack_tlv_impl->get_tag(&btstack_tlv_context, i * 0x10000, data, 4);
+		if (i == 500){
+			CHECK_EQUAL(0, size);
+		} else {
+			CHECK_EQUAL(4, size);
+			CHECK_EQUAL(i * 3, big_endian_read_32(data, 0));
+		}
+	}
+}
+
+TEST(BSTACK_TLV, TestGroupCommit){
+	btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+	btstack_tlv_posix_set_group_commit(&btstack_tlv_context, 100);
+	uint32_t tag = TAG('a','b','c','d');
+	long size = file_size(TEST_DB);
+	uint8_t buffer;
+	for (buffer=0;buffer<10;buffer++){
+		btstack_tlv_impl->store_tag(&btstack_tlv_context, tag, &buffer, 1);
+	}
+	// not written yet
+	CHECK_EQUAL(size, file_size(TEST_DB));
+	btstack_tlv_posix_flush(&btstack_tlv_context);
+	CHECK_EQUAL(size + 10 * (8 + 1 + 4), file_size(TEST_DB));
+	// pending writes are flushed on deinit
+	btstack_tlv_impl->store_tag(&btstack_tlv_context, tag, &buffer, 1);
+	btstack_tlv_posix_deinit(&btstack_tlv_context);
+	btstack_tlv_impl = btstack_tlv_posix_init_instance(&btstack_tlv_context, TEST_DB);
+	btstack_tlv_impl->get_tag(&btstack_tlv_context, tag, &buffer, 1);
+	CHECK_EQUAL(10, buffer);
+}
+
 int main (int argc, const char * argv[]){
 	hci_dump_open("tlv_test.pklg", HCI_DUMP_PACKETLOGGER);
     return CommandLineTestRunner::RunAllTests(argc, argv);
@@ -844,6 +844,11 @@ def parse(fname_in, fin, fname_out, fout):
 def listHandles(fout):
     fout.write('\n\n')
     fout.write('//\n')
+    fout.write('// number of entries required for att_set_db_index\n')
+    fout.write('//\n')
+    fout.write('#define ATT_DB_INDEX_SIZE %u\n' % handle)
+    fout.write('\n')
+    fout.write('//\n')
     fout.write('// list service handle ranges\n')
     fout.write('//\n')
     for define in defines_for_services: